@@ -2,9 +2,24 @@
 #define AST_HPP
 
 #include "AST_enums.hpp"
+#include "astdump.h"
+#include "backend.h"
+#include "bytecode.h"
 #include "codegen.h"
+#include "consteval.h"
+#include "flatast.h"
+#include "hashcons.h"
+#include "interpreter.h"
+#include "inliner.h"
+#include "interproc.h"
+#include "log.h"
+#include "profile.h"
 #include "scoper.h"
+#include "simplify.h"
+#include "stats.h"
+#include "workpool.h"
 #include <cstdint>
+#include <functional>
 #include <iostream>
 #include <llvm-14/llvm/IR/BasicBlock.h>
 #include <llvm-14/llvm/IR/Constants.h>
@@ -15,6 +30,8 @@
 #include <llvm-14/llvm/IR/LLVMContext.h>
 #include <llvm-14/llvm/IR/Type.h>
 #include <llvm-14/llvm/IR/Value.h>
+#include <llvm-14/llvm/Support/TimeProfiler.h>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <type_traits>
@@ -24,32 +41,110 @@ using namespace std;
 
 using llvm::Value;
 
-static ScoperStack scoperStack;
-static CodeGenerator codeGenerator;
+class ASTNode;
 
-static map<string, llvm::BasicBlock *> labels;
+// Compiler state shared by every translation unit that includes this header.
+// The definitions live in c.y next to `root`.
+extern ScoperStack scoperStack;
+extern CodeGenerator codeGenerator;
 
-static llvm::Type *declaration_type = nullptr;
-static vector<llvm::Type *> function_params;
+// Counters added by --profile-generate, or the profile of --profile-use
+extern Profiler profiler;
 
-static int parameter_list_index = 0;
+extern map<string, llvm::BasicBlock *> labels;
 
-static bool get_as_lvalue = false;
+extern llvm::Type *declaration_type;
+extern vector<llvm::Type *> function_params;
 
-static bool global_is_variadic = false;
+extern int parameter_list_index;
 
-static bool am_i_initialising = false;
+extern bool get_as_lvalue;
 
-static llvm::BasicBlock *loop_block = nullptr;
-static llvm::BasicBlock *merge_block = nullptr;
+extern bool global_is_variadic;
 
-static llvm::Type *array_type = nullptr;
+extern bool am_i_initialising;
 
-static bool is_declaration_global = false;
+extern llvm::BasicBlock *loop_block;
+extern llvm::BasicBlock *merge_block;
 
-static SpecifierEnum dec_type_for_optimisation;
+extern llvm::Type *array_type;
 
-static bool constant_prop = true;
+extern bool is_declaration_global;
+
+// Storage class of the global declaration being lowered
+extern bool is_declaration_static;
+extern bool is_declaration_extern;
+
+// Optimiser state is per thread: function bodies are optimised in parallel.
+extern thread_local OptimisationContext optimisationContext;
+
+extern thread_local SpecifierEnum dec_type_for_optimisation;
+
+extern thread_local bool constant_prop;
+
+// Worker threads used to optimise function bodies (1 = serial)
+extern unsigned optimise_threads;
+
+// Runtime state for --interp
+extern Interpreter interpreter;
+
+// Bytecode being built for --vm and --emit-bytecode
+extern BytecodeCompiler bytecodeCompiler;
+
+// Structural ids of expressions, see ASTNode::expr_id
+extern ExprTable expr_table;
+
+// Dead code the optimiser removed, reported by cc
+extern DeadCodeStats dead_code_stats;
+
+// Nodes built, constants folded and lookups made, for --stats
+extern CompileStats compile_stats;
+
+// The categories of CC_LOG messages printed (--log)
+extern unsigned log_categories;
+
+// Calls to pure functions are evaluated at compile time
+extern PureFunctions pure_functions;
+
+// Largest number of expressions a fully unrolled loop may repeat (0 = off),
+// and the loops unrolled
+extern unsigned unroll_budget;
+extern UnrollStats unroll_stats;
+
+// Algebraic rules for arithmetic nodes, and their hits
+extern Simplifier simplifier;
+
+// Arguments of the calls between functions, and the clones they asked for
+// within the budget (in expressions copied, 0 = no clones)
+extern CallSites call_sites;
+extern unsigned specialise_budget;
+
+// Functions whose calls are inlined, and the largest body inlined without
+// `inline` (in nodes, 0 = only those)
+extern Inliner inliner;
+extern unsigned inline_size;
+
+// When set, every node constructed is recorded here so that a whole
+// declaration (including optimiser copies) can be released at once.
+extern vector<ASTNode *> *node_pool;
+
+// Applies the simplifier to `node`, the optimised copy of the arithmetic
+// node `original`; defined once every node type is
+static ASTNode *simplify_binary(const ASTNode *original, ASTNode *node);
+
+// The constant `value` in place of the expression `original`, counted as a
+// fold of its kind
+static ASTNode *fold(const ASTNode *original, const m_Value &value);
+
+// The body of function `name` in place of a call with arguments `args`, the
+// optimised copies of `original`; null when the call is not inlined
+static ASTNode *inline_call(const string &name,
+                            const vector<ASTNode *> &original,
+                            const vector<ASTNode *> &args);
+
+// `declarator;` declared with `declaration_specifiers`, e.g. a prototype
+static ASTNode *make_declaration(ASTNode *declaration_specifiers,
+                                 ASTNode *declarator);
 
 static void make_bool(llvm::Value *&conditionValue) {
 
@@ -87,7 +182,8 @@ static void make_store_compatible(llvm::Value *&lhsAddr,
               rhsValue,
               llvm ::IntegerType::get(lhsAddr->getContext(), lhsSize));
         }
-        cout << "Adjusted RHSValue size to match the type of lhsAddr" << endl;
+        CC_LOG(LOG_CASTS, "Resized the stored integer to " << lhsSize
+                                                           << " bits");
       }
     } else if (lhsAddr->getType()->getPointerElementType()->isDoubleTy() and
                rhsValue->getType()->isIntegerTy()) {
@@ -103,7 +199,7 @@ static void make_store_compatible(llvm::Value *&lhsAddr,
   if (lhsAddr->getType()->isPointerTy()) {
     if (rhsValue->getType() != lhsAddr->getType()->getPointerElementType()) {
       // Perform type casting of rhsValue to match the type of lhsAddr
-      cout << "Casting rhsValue to match the type of lhsAddr" << endl;
+      CC_LOG(LOG_CASTS, "Cast the stored value to the type of its address");
       rhsValue = codeGenerator.getBuilder().CreateBitOrPointerCast(
           rhsValue, lhsAddr->getType()->getPointerElementType());
     }
@@ -170,29 +266,67 @@ static void make_lhs_rhs_compatible(llvm::Value *&lhs, llvm::Value *&rhs) {
 
 class ASTNode {
 public:
-  ASTNode(NodeType type) : type(type) {}
+  ASTNode(NodeType type) : type(type) { track(); }
+
+  ASTNode(const ASTNode &other)
+      : variadic(other.variadic), children(other.children), type(other.type) {
+    track();
+  }
 
   virtual ~ASTNode() {}
 
   /* ASTNode(const ASTNode &) = delete; */
 
+  // Deletes every node recorded in the pool. Nodes never own their children,
+  // so each one is released exactly once.
+  static void release_pool(vector<ASTNode *> &pool) {
+    for (auto node : pool) {
+      delete node;
+    }
+    pool.clear();
+  }
+
   NodeType getNodeType() const { return type; }
 
-  virtual string dump_ast(int depth = 0) const = 0;
+  // Describes the subtree to `out`, see astdump.h
+  virtual void dump(AstWriter &out) const = 0;
+
+  // The subtree in `format`; text is uncoloured
+  string dump_ast(AstFormat format = AstFormat::Text) const {
+    ostringstream dumped;
+    dump(*make_ast_writer(format, dumped));
+    return dumped.str();
+  }
+
+  // The subtree laid out in flat arrays, see flatast.h
+  FlatAst flatten() const {
+    FlatAstBuilder builder;
+    dump(builder);
+    return builder.take();
+  }
   void addChild(ASTNode *child) { children.push_back(child); }
 
-  vector<ASTNode *> getChildren() { return children; }
+  const vector<ASTNode *> &getChildren() const { return children; }
+
+  // Calls `visit` on each child in the order dump() writes them. Lists keep
+  // theirs in `children`; other nodes name them as members and override this.
+  virtual void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : children) {
+      visit(child);
+    }
+  }
 
   ASTNode *disable_constant_prop() {
 
     constant_prop = false;
-    codeGenerator.constant_prop = false;
+    optimisationContext.constant_prop = false;
     return optimise();
   }
 
   ASTNode *enable_constant_prop() {
     constant_prop = true;
-    codeGenerator.constant_prop = true;
+    optimisationContext.constant_prop = true;
     return optimise();
   }
 
@@ -215,6 +349,11 @@ public:
 
   virtual m_Value get_for_optim() const { return get(); }
 
+  // Hash-consed structural id: two side-effect-free expressions have the
+  // same id exactly when they are structurally equal. Anything else gets a
+  // fresh id each time.
+  virtual uint32_t expr_id() const { return expr_table.unique(); }
+
   virtual llvm::Value *codegen() {
     cerr << "Codegen called for " << nodeTypeToString(type) << endl;
 
@@ -223,6 +362,138 @@ public:
 
   virtual ASTNode *optimise() const = 0;
 
+  // Executes the node directly (cc --interp), mirroring codegen()
+  virtual RValue interpret() {
+    cerr << "Interpret called for " << nodeTypeToString(type) << endl;
+
+    throw std::runtime_error("Unimplemented interpret() function.");
+  }
+
+  // Emits bytecode for the node (cc --vm), mirroring interpret()
+  virtual BcValue compileBytecode() {
+    cerr << "Compile bytecode called for " << nodeTypeToString(type) << endl;
+
+    throw std::runtime_error("Unimplemented compileBytecode() function.");
+  }
+
+  // Adds the node to the function's flow graph (flow.h). Anything that is
+  // not a statement of its own is an expression evaluated in order.
+  virtual void buildFlow() const { optimisationContext.flow.add(this); }
+
+  // Same as buildFlow(), noting the blocks the statement spans so that
+  // optimise() can drop it when none of them is reachable
+  void buildStatementFlow() const {
+    pair<int, int> mark = optimisationContext.flow.mark();
+    buildFlow();
+    optimisationContext.flow.span(this, mark);
+  }
+
+  // Evaluates the expression for the flow analysis: applies its effects
+  // through optimisationContext.flow and returns its value when constant.
+  // A node without an evaluation of its own may change anything.
+  virtual m_Value flow() const {
+    optimisationContext.flow.clobber();
+    return m_Value();
+  }
+
+  // Runs the node at compile time, inside a call to a pure function
+  // (consteval.h); anything without an evaluation of its own stops it
+  virtual m_Value evaluate(ConstEvaluation &evaluation) const {
+    throw ConstEvalError(nodeTypeToString(type) +
+                         " cannot be evaluated at compile time");
+  }
+
+  // Runs a function definition at compile time with the given arguments
+  virtual m_Value evaluateCall(ConstEvaluation &evaluation,
+                               const vector<m_Value> &args) const {
+    throw ConstEvalError("evaluateCall called on " + nodeTypeToString(type));
+  }
+
+  // Pushes {name, kind} of each parameter of a function declarator, for
+  // evaluateCall() and the parameters the flow analysis is seeded with
+  virtual void
+  constParams(vector<pair<string, FlowAnalysis::Kind>> &params) const {
+    throw ConstEvalError("Unsupported declarator " + nodeTypeToString(type));
+  }
+
+  // What declaration specifiers declare, for the flow analysis and the
+  // compile-time evaluator
+  virtual FlowAnalysis::Kind flowKind() const {
+    return FlowAnalysis::UNTRACKED;
+  }
+
+  // The operands of an arithmetic or bitwise node, for the simplifier
+  virtual bool binaryOperands(ASTNode *&lhs, ASTNode *&rhs) const {
+    return false;
+  }
+
+  // The variable a for loop initialisation sets, when it sets exactly one
+  virtual string inductionVariable() const { return ""; }
+
+  // A copy of a function definition or declarator for function `name`
+  virtual ASTNode *renamed(const string &name) const {
+    throw std::runtime_error("renamed called on " + nodeTypeToString(type));
+  }
+
+  // The prototype of a function definition, for function `name`
+  virtual ASTNode *prototype(const string &name) const {
+    throw std::runtime_error("prototype called on " + nodeTypeToString(type));
+  }
+
+  // Whether a declaration declares function `name`
+  virtual bool declaresFunction(const string &name) const { return false; }
+
+  // A copy of an expression in the body of a function being inlined, with
+  // the parameters replaced by the arguments of the call (inliner.h); null
+  // when it cannot be inlined. Sets `kind` to INT for an int, UNTRACKED
+  // for a comparison or a pointer.
+  virtual ASTNode *inlined(InlineFrame &frame,
+                           FlowAnalysis::Kind &kind) const {
+    return nullptr;
+  }
+
+  // Whether an expression can be evaluated even when its value is not used
+  // (ConditionalExpressionNode::codegen): it has no side effects, cannot
+  // trap and has at most `budget` nodes, which it takes from it
+  virtual bool branchless(unsigned &budget) const { return false; }
+
+  // Whether calls to a function definition can be inlined
+  virtual bool inlineFunction(Inliner::Function &function) const {
+    return false;
+  }
+
+  // Pushes each parameter of a function declarator, for the inliner;
+  // returns false when they cannot all be described
+  virtual bool inlineParams(vector<InlineParam> &params) const {
+    return false;
+  }
+
+  // The expression a function body is `return`ing, when that is all it is
+  virtual const ASTNode *returnedExpression() const { return nullptr; }
+
+  // What declaration specifiers declare a function to return, and whether
+  // they declare it inline or static
+  virtual FlowAnalysis::Kind returnKind() const {
+    return FlowAnalysis::UNTRACKED;
+  }
+  virtual bool declaresInline() const { return false; }
+  virtual bool declaresStatic() const { return false; }
+  virtual bool declaresExtern() const { return false; }
+
+  // Runs a function definition with the given arguments
+  virtual RValue invoke(vector<RValue> &args) {
+    throw std::runtime_error("invoke called on " + nodeTypeToString(type));
+  }
+
+  // Whether a goto to `name` lands on this statement
+  virtual bool definesLabel(const string &name) const { return false; }
+
+  // Pushes {name, type} of each parameter into interpreter.pending_params
+  virtual void collectFunctionParams() {
+    cout << "collectFunctionParams called on base class | "
+         << nodeTypeToString(type) << endl;
+  }
+
   virtual m_Value get_value_if_possible() const { return m_Value(); }
 
   virtual void buildFunctionParams(llvm::Function *function_decl) {
@@ -243,6 +514,25 @@ public:
     codeGenerator.global_module->print(out, nullptr);
   }
 
+  virtual void dump_bitcode(string out_filename, bool summary) final {
+    // Bitcode is linked and lowered by cc itself, always as PIC, so the
+    // literals of several files can be private and cannot clash
+    for (auto literal : codeGenerator.string_literals) {
+      literal->setLinkage(llvm::GlobalValue::PrivateLinkage);
+    }
+    write_bitcode(*codeGenerator.global_module, out_filename, summary);
+  }
+
+  virtual void dump_object(string out_filename, unsigned threads,
+                           llvm::CodeGenOpt::Level level) final {
+    // Objects are always PIC, so literals need not be exported; keeping
+    // them private also pins each one to the partition that uses it.
+    for (auto literal : codeGenerator.string_literals) {
+      literal->setLinkage(llvm::GlobalValue::PrivateLinkage);
+    }
+    emit_object(*codeGenerator.global_module, out_filename, threads, level);
+  }
+
   virtual llvm::Type *getValueType() {
     cout << "getValueType called on base class | " << nodeTypeToString(type)
          << endl;
@@ -263,31 +553,72 @@ public:
   bool variadic = false;
   vector<ASTNode *> children;
   NodeType type;
-};
 
-static std::string dumpParameters(const ASTNode *base,
-                                  std::vector<ASTNode *> vec_of_nodes,
-                                  int depth = 0, bool is_list = false) {
-  string result = formatSpacing(depth);
-  result += nodeTypeToString(base->getNodeType());
-  result += is_list ? "[ \n" : "{ \n";
+private:
+  void track() {
+    compile_stats.node(type);
+    if (node_pool) {
+      node_pool->push_back(this);
+    }
+  }
+};
 
-  for (auto child : vec_of_nodes) {
-    result += child->dump_ast(depth + 1);
-    result += is_list ? formatSpacing(depth) + ",\n" : "";
+// Writes `base` with `children` (its members, or its list) under it
+static void dumpParameters(const ASTNode *base,
+                           const std::vector<ASTNode *> &children,
+                           AstWriter &out, bool is_list = false) {
+  out.open(base->getNodeType(), is_list);
+  if (base->getNodeType() == NodeType::ParameterList) {
+    out.property("variadic", base->variadic ? "true" : "false");
   }
+  for (auto child : children) {
+    child->dump(out);
+  }
+  out.close();
+}
+
+// Copies a child of an expression being inlined, counting it
+static ASTNode *inline_expression(const ASTNode *node, InlineFrame &frame,
+                                  FlowAnalysis::Kind &kind) {
+  frame.size++;
+  return node->inlined(frame, kind);
+}
 
-  if (is_list) {
-    result[result.size() - 2] = ']';
-  } else {
-    result += formatSpacing(depth) + "} \n";
+// Copies both operands of an int operator being inlined
+static bool inline_operands(InlineFrame &frame, const ASTNode *lhs,
+                            const ASTNode *rhs, ASTNode *&new_lhs,
+                            ASTNode *&new_rhs) {
+  FlowAnalysis::Kind lhs_kind, rhs_kind;
+  new_lhs = inline_expression(lhs, frame, lhs_kind);
+  new_rhs = inline_expression(rhs, frame, rhs_kind);
+  return new_lhs && new_rhs && lhs_kind == FlowAnalysis::INT &&
+         rhs_kind == FlowAnalysis::INT;
+}
+
+// Takes one node from the budget of a branchless expression
+static bool branchless_node(unsigned &budget) {
+  if (budget == 0) {
+    return false;
   }
+  budget--;
+  return true;
+}
 
-  if (base->getNodeType() == NodeType::ParameterList) {
-    result += formatSpacing(depth) +
-              "Variadic: " + (base->variadic ? "true" : "false") + "\n";
+static bool branchless_operands(unsigned &budget, const ASTNode *lhs,
+                                const ASTNode *rhs) {
+  return branchless_node(budget) && lhs->branchless(budget) &&
+         rhs->branchless(budget);
+}
+
+// Counts a use of every variable `node` names without evaluating it, so
+// that the operand of sizeof keeps the declarations it refers to
+static void mention_variables(const ASTNode *node, FlowAnalysis &flow) {
+  if (node->getNodeType() == NodeType::Identifier) {
+    flow.current_value(node->get().s);
+    return;
   }
-  return result;
+  node->forEachChild(
+      [&](const ASTNode *child) { mention_variables(child, flow); });
 }
 
 // Helps prevent seg faults due to nullptr reference
@@ -296,12 +627,7 @@ class NullPtrNode : public ASTNode {
 public:
   NullPtrNode() : ASTNode(NodeType::Unimplemented) {}
 
-  string dump_ast(int depth = 0) const {
-    string result = "";
-    result += formatSpacing(depth);
-    result += "\n";
-    return result;
-  }
+  void dump(AstWriter &out) const { out.leaf(type, ""); }
 
   bool check_semantics() { return true; }
 
@@ -312,11 +638,26 @@ public:
 
   m_Value get_value_if_possible() const { return m_Value(); }
 
+  void buildFlow() const {}
+
+  m_Value flow() const { return m_Value(); }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const { return m_Value(); }
+
   llvm::Value *codegen() {
-    cout << "Codegen called for NullPtrNode " << endl;
+    CC_LOG(LOG_CODEGEN, "Codegen called for NullPtrNode");
     return nullptr;
   }
 
+  RValue interpret() {
+    return RValue(llvm::Type::getVoidTy(codeGenerator.getContext()), 0);
+  }
+
+  BcValue compileBytecode() {
+    return bytecodeCompiler.zero(
+        llvm::Type::getVoidTy(codeGenerator.getContext()));
+  }
+
   m_Value get() const {
     throw std::runtime_error("get() called on a NullPtr.");
   }
@@ -326,16 +667,29 @@ class IConstantNode : public ASTNode {
 public:
   IConstantNode(int value) : ASTNode(NodeType::IConstant), value(value) {}
 
-  string dump_ast(int depth = 0) const {
-    string result = formatSpacing(depth);
-    result += "Integer:" + to_string(value) + "\n";
-    return result;
-  }
+  void dump(AstWriter &out) const { out.leaf(type, to_string(value)); }
 
   vector<string> getPlainSymbol() const { return {}; }
 
   m_Value get_value_if_possible() const { return m_Value(value); }
 
+  m_Value flow() const { return get_value_if_possible(); }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    return get_value_if_possible();
+  }
+
+  uint32_t expr_id() const {
+    return expr_table.intern((int)type, value, "", {});
+  }
+
+  bool branchless(unsigned &budget) const { return branchless_node(budget); }
+
+  ASTNode *inlined(InlineFrame &frame, FlowAnalysis::Kind &kind) const {
+    kind = FlowAnalysis::INT;
+    return new IConstantNode(value);
+  }
+
   ASTNode *optimise() const {
     auto ret = new IConstantNode(*this);
     ret->value = value;
@@ -347,6 +701,15 @@ public:
                                   llvm::APInt(32, value));
   }
 
+  RValue interpret() {
+    return RValue(llvm::Type::getInt32Ty(codeGenerator.getContext()), value);
+  }
+
+  BcValue compileBytecode() {
+    return bytecodeCompiler.constant(
+        llvm::Type::getInt32Ty(codeGenerator.getContext()), value);
+  }
+
 public:
   int value;
 };
@@ -355,14 +718,25 @@ class FConstantNode : public ASTNode {
 public:
   FConstantNode(float value) : ASTNode(NodeType::FConstant), value(value) {}
 
-  string dump_ast(int depth = 0) const {
-    string result = formatSpacing(depth);
-    result += "Float:" + to_string(value) + "\n";
-    return result;
-  }
+  void dump(AstWriter &out) const { out.leaf(type, to_string(value)); }
 
   m_Value get_value_if_possible() const { return m_Value(value); }
 
+  m_Value flow() const { return get_value_if_possible(); }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    return get_value_if_possible();
+  }
+
+  uint32_t expr_id() const {
+    int64_t bits;
+    double widened = value;
+    memcpy(&bits, &widened, sizeof(bits));
+    return expr_table.intern((int)type, bits, "", {});
+  }
+
+  bool branchless(unsigned &budget) const { return branchless_node(budget); }
+
   ASTNode *optimise() const {
     auto ret = new FConstantNode(*this);
     ret->value = value;
@@ -381,6 +755,16 @@ public:
                                  llvm::APFloat(value));
   }
 
+  RValue interpret() {
+    return RValue::floating(llvm::Type::getDoubleTy(codeGenerator.getContext()),
+                            value);
+  }
+
+  BcValue compileBytecode() {
+    return bytecodeCompiler.constantDouble(
+        llvm::Type::getDoubleTy(codeGenerator.getContext()), value);
+  }
+
 public:
   float value;
 };
@@ -389,16 +773,18 @@ class StringNode : public ASTNode {
 public:
   StringNode(string value) : ASTNode(NodeType::String), value(value) {}
 
-  string dump_ast(int depth = 0) const {
-    string result = formatSpacing(depth);
-    result += "String Literal : " + value + " \n";
-    return result;
-  }
+  void dump(AstWriter &out) const { out.leaf(type, value); }
 
   m_Value get_value_if_possible() const { return m_Value(); }
 
+  m_Value flow() const { return m_Value(); }
+
   vector<string> getPlainSymbol() const { return {}; }
 
+  uint32_t expr_id() const {
+    return expr_table.intern((int)type, 0, value, {});
+  }
+
   ASTNode *optimise() const {
     auto ret = new StringNode(*this);
     ret->value = value;
@@ -411,7 +797,7 @@ public:
       char charValue = value[1]; // Assuming the character is the second
                                  // character after the single quote
                                  //
-      cout << "Hi, here to print " << charValue << endl;
+      CC_LOG(LOG_CODEGEN, "Character literal " << charValue);
 
       return llvm::ConstantInt::get(codeGenerator.getContext(),
                                     llvm::APInt(8, charValue));
@@ -419,7 +805,7 @@ public:
 
     value = convertRawString(value);
 
-    cout << "Hi, here to print " << value << endl;
+    CC_LOG(LOG_CODEGEN, "String literal " << value);
 
     llvm::LLVMContext &context = codeGenerator.global_module->getContext();
 
@@ -430,21 +816,55 @@ public:
         llvm::GlobalValue::ExternalLinkage, strConstant, "str");
 
     strVar->setConstant(false);
+    codeGenerator.string_literals.push_back(strVar);
 
     return codeGenerator.getBuilder().CreatePointerCast(
         strVar, codeGenerator.getBuilder().getInt8PtrTy());
   }
 
+  RValue interpret() {
+    llvm::LLVMContext &context = codeGenerator.getContext();
+    if (value[0] == '\'') {
+      return RValue(llvm::Type::getInt8Ty(context), (int8_t)value[1]);
+    }
+
+    // Each literal gets its own writable storage, like the global codegen
+    // emits for it
+    if (!storage) {
+      storage = make_shared<string>(convertRawString(value));
+    }
+    return RValue::pointer(llvm::Type::getInt8PtrTy(context), &(*storage)[0]);
+  }
+
+  BcValue compileBytecode() {
+    llvm::LLVMContext &context = codeGenerator.getContext();
+    if (value[0] == '\'') {
+      return bytecodeCompiler.constant(llvm::Type::getInt8Ty(context),
+                                       (int8_t)value[1]);
+    }
+
+    // Kept across recompilations of the enclosing function
+    if (data_offset == UINT32_MAX) {
+      data_offset = bytecodeCompiler.stringLiteral(convertRawString(value));
+    }
+    return bytecodeCompiler.dataAddress(llvm::Type::getInt8PtrTy(context),
+                                        data_offset);
+  }
+
 public:
   string value;
+
+private:
+  shared_ptr<string> storage;
+  uint32_t data_offset = UINT32_MAX;
 };
 
 class TranslationUnitNode : public ASTNode {
 public:
   TranslationUnitNode() : ASTNode(NodeType::TranslationUnit) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, children, depth, true);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, children, out, true);
   }
 
   bool check_semantics() {
@@ -462,11 +882,50 @@ public:
 
     auto ret = new TranslationUnitNode(*this);
 
+    // The calls of the last round seed parameters and ask for clones
+    set<string> defined;
+    for (auto child : children) {
+      if (child->getNodeType() == NodeType::FunctionDefinition) {
+        defined.insert(child->get().s);
+      }
+    }
+    for (auto &clone : call_sites.beginRound(defined, specialise_budget)) {
+      ret->specialise(clone.function, clone.clone);
+    }
+
+    // Calls may be evaluated against any function of this round, and
+    // inlined when it is small enough
+    map<string, const ASTNode *> functions;
+    map<string, Inliner::Function> inlinable;
+    for (auto child : ret->children) {
+      if (child->getNodeType() == NodeType::FunctionDefinition) {
+        functions[child->get().s] = child;
+        if (!child->inlineFunction(inlinable[child->get().s])) {
+          inlinable.erase(child->get().s);
+        }
+      }
+    }
+    pure_functions.define(std::move(functions));
+    inliner.define(std::move(inlinable));
+
+    // Global declarations are optimised in order on this thread; each
+    // function body is handed to the pool with a snapshot of the globals
+    // declared before it, so the result does not depend on scheduling.
+    WorkPool pool(optimise_threads);
     for (auto &child : ret->children) {
+      if (child->getNodeType() != NodeType::FunctionDefinition) {
+        child = optimise_external_declaration(child);
+        continue;
+      }
 
-      get_as_lvalue = false;
-      child = child->optimise();
+      ASTNode **slot = &child;
+      map<string, m_Value> globals = optimisationContext.globalValues();
+      pool.submit([slot, globals]() {
+        *slot = optimise_function_definition(*slot, globals);
+      });
     }
+    pool.wait();
+
     return ret;
   }
 
@@ -474,20 +933,114 @@ public:
 
     codeGenerator.resetAllContext();
 
+    for (auto child : children) {
+      codegen_external_declaration(child);
+    }
+
+    return nullptr;
+  }
+
+  // Registers every function, runs the global declarations in order and
+  // then calls main. Returns main's result.
+  RValue interpret() {
     for (auto child : children) {
       declaration_type = nullptr;
       function_params.clear();
       global_is_variadic = false;
-      labels.clear();
       get_as_lvalue = false;
       is_declaration_global = true;
-      child->codegen();
+      child->interpret();
     }
 
-    return nullptr;
+    InterpFunction *main_function = interpreter.findFunction("main");
+    if (!main_function || !main_function->definition) {
+      throw std::runtime_error("Function main not found.");
+    }
+    vector<RValue> args;
+    return main_function->definition->invoke(args);
+  }
+
+  // Global initialisers go into the module's init function in order;
+  // function bodies are compiled after the last declaration
+  BcValue compileBytecode() {
+    bytecodeCompiler.beginModule();
+    for (auto child : children) {
+      declaration_type = nullptr;
+      function_params.clear();
+      global_is_variadic = false;
+      get_as_lvalue = false;
+      is_declaration_global = true;
+      child->compileBytecode();
+      bytecodeCompiler.releaseTemps();
+    }
+    bytecodeCompiler.endModule();
+    return BcValue();
+  }
+
+  // Lowers a single function definition or global declaration into the
+  // global module. Used directly when declarations are streamed from the
+  // parser instead of being collected into a translation unit.
+  static void codegen_external_declaration(ASTNode *child) {
+    declaration_type = nullptr;
+    function_params.clear();
+    global_is_variadic = false;
+    labels.clear();
+    get_as_lvalue = false;
+    is_declaration_global = true;
+    child->codegen();
+  }
+
+  static ASTNode *optimise_external_declaration(const ASTNode *child) {
+    if (child->getNodeType() == NodeType::FunctionDefinition) {
+      return optimise_function_definition(child,
+                                          optimisationContext.globalValues());
+    }
+    get_as_lvalue = false;
+    return child->optimise();
+  }
+
+  // Optimises a function body in its own constant-propagation context, so
+  // that nothing it records (or an address-of inside it) leaks into the
+  // globals or into other functions.
+  static ASTNode *optimise_function_definition(
+      const ASTNode *child, const map<string, m_Value> &globals) {
+    llvm::TimeTraceScope scope("Optimise", child->get().s);
+    OptimisationContext outer = std::move(optimisationContext);
+    bool outer_constant_prop = constant_prop;
+
+    optimisationContext = OptimisationContext(globals);
+    constant_prop = true;
+    ASTNode *ret = child->optimise();
+    compile_stats.value_lookups += optimisationContext.lookups;
+    compile_stats.value_misses += optimisationContext.misses;
+
+    optimisationContext = std::move(outer);
+    constant_prop = outer_constant_prop;
+    return ret;
   }
 
   // Add member variables to hold information about translation units
+
+private:
+  // Adds a copy of the definition of `function` named `clone` after it, and
+  // the clone's prototype before the first declaration of `function`
+  void specialise(const string &function, const string &clone) {
+    size_t first = children.size();
+    for (size_t i = 0; i < children.size(); i++) {
+      ASTNode *child = children[i];
+      bool defines = child->getNodeType() == NodeType::FunctionDefinition &&
+                     child->get().s == function;
+      if (first == children.size() &&
+          (defines || child->declaresFunction(function))) {
+        first = i;
+      }
+      if (defines) {
+        children.insert(children.begin() + i + 1, child->renamed(clone));
+        children.insert(children.begin() + first, child->prototype(clone));
+        return;
+      }
+    }
+  }
 };
 
 // Node class for function definitions
@@ -502,21 +1055,119 @@ public:
         declaration_list(declaration_list),
         compound_statement(compound_statement) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this,
-                          {declaration_specifiers, declarator, declaration_list,
-                           compound_statement},
-                          depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this,
+                   {declaration_specifiers, declarator, declaration_list,
+                    compound_statement},
+                   out, false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {declaration_specifiers, declarator, declaration_list,
+                       compound_statement}) {
+      visit(child);
+    }
   }
 
+  // Parameters every call passes the same constant start out with it
   ASTNode *optimise() const {
     auto ret = new FunctionDefinitionNode(*this);
-    codeGenerator.pushContext();
+    string name = declarator->get().s;
+    vector<pair<string, FlowAnalysis::Kind>> params;
+    bool seedable = true;
+    try {
+      declarator->constParams(params);
+    } catch (const ConstEvalError &) {
+      seedable = false;
+    }
+    vector<m_Value> seeds = call_sites.seedsFor(name);
+    if (!seedable || seeds.size() != params.size()) {
+      seeds.clear();
+    }
+
+    optimisationContext.pushContext();
+    FlowAnalysis &flow = optimisationContext.flow;
+    flow.analyse(
+        [&]() {
+          for (size_t i = 0; i < seeds.size(); i++) {
+            if (params[i].second != FlowAnalysis::UNTRACKED &&
+                seeds[i].type != ActualValueType::NO_VALUE) {
+              flow.parameter(params[i].first, params[i].second, seeds[i]);
+            }
+          }
+          compound_statement->buildFlow();
+        },
+        [](const ASTNode *node) { return node->flow(); });
+    if (seedable) {
+      call_sites.define(name, flow.size());
+    }
     ret->compound_statement = compound_statement->optimise();
-    codeGenerator.popContext();
+    optimisationContext.flow.clear();
+    optimisationContext.popContext();
+    return ret;
+  }
+
+  m_Value get() const { return declarator->get(); }
+
+  bool declaresStatic() const {
+    return declaration_specifiers->declaresStatic();
+  }
+
+  // The body is copied once to size it and count the uses of parameters
+  bool inlineFunction(Inliner::Function &function) const {
+    const ASTNode *body = compound_statement->returnedExpression();
+    InlineFrame frame;
+    FlowAnalysis::Kind kind;
+    if (!body || declaration_list->getNodeType() != NodeType::Unimplemented ||
+        declaration_specifiers->returnKind() != FlowAnalysis::INT ||
+        !declarator->inlineParams(frame.params) ||
+        !inline_expression(body, frame, kind) || kind != FlowAnalysis::INT) {
+      return false;
+    }
+    if (frame.size > inline_size && !declaration_specifiers->declaresInline()) {
+      return false;
+    }
+    function.params = frame.params;
+    function.body = body;
+    return true;
+  }
+
+  ASTNode *renamed(const string &name) const {
+    auto ret = new FunctionDefinitionNode(*this);
+    ret->declarator = declarator->renamed(name);
     return ret;
   }
 
+  ASTNode *prototype(const string &name) const {
+    return make_declaration(declaration_specifiers, declarator->renamed(name));
+  }
+
+  // Falling off the end returns zero, as in codegen
+  m_Value evaluateCall(ConstEvaluation &evaluation,
+                       const vector<m_Value> &args) const {
+    FlowAnalysis::Kind returns = declaration_specifiers->flowKind();
+    if (returns == FlowAnalysis::UNTRACKED) {
+      throw ConstEvalError("Unsupported return type");
+    }
+    vector<pair<string, FlowAnalysis::Kind>> params;
+    declarator->constParams(params);
+    if (params.size() != args.size()) {
+      throw ConstEvalError("Wrong number of arguments");
+    }
+
+    size_t frame = evaluation.enterFrame();
+    for (size_t i = 0; i < params.size(); i++) {
+      evaluation.declare(params[i].first, params[i].second, args[i]);
+    }
+    compound_statement->evaluate(evaluation);
+    m_Value ret = evaluation.flow == ConstEvaluation::RETURN
+                      ? evaluation.return_value
+                      : m_Value(0);
+    evaluation.leaveFrame(frame);
+    return ConstEvaluation::convert(returns, evaluation.check(ret));
+  }
+
   bool check_semantics() {
 
     m_Value func_name = declarator->get();
@@ -557,6 +1208,7 @@ public:
     is_declaration_global = false;
 
     string func_name = declarator->get().s;
+    llvm::TimeTraceScope scope("Codegen", func_name);
 
     llvm::Type *func_ret_type = nullptr;
 
@@ -585,6 +1237,11 @@ public:
                                  func_name, codeGenerator.global_module.get());
     }
 
+    // A static function stays out of the symbol table of the object
+    if (declaration_specifiers->declaresStatic()) {
+      function_decl->setLinkage(llvm::GlobalValue::InternalLinkage);
+    }
+
     // Create a new basic block to start insertion into.
     llvm::BasicBlock *basic_block = llvm::BasicBlock::Create(
         codeGenerator.getContext(), "entry", function_decl);
@@ -594,6 +1251,7 @@ public:
     codeGenerator.pushContext();
 
     declarator->buildFunctionParams(function_decl);
+    profiler.beginFunction(codeGenerator.getBuilder(), function_decl);
 
     compound_statement->codegen();
 
@@ -607,50 +1265,127 @@ public:
       codeGenerator.getBuilder().CreateRet(
           llvm::Constant::getNullValue(func_ret_type));
     }
+    profiler.endFunction();
 
     return nullptr;
   }
 
-private:
-  ASTNode *declaration_specifiers;
-  ASTNode *declarator;
-  ASTNode *declaration_list;
-  ASTNode *compound_statement;
-};
+  // Only registers the function; invoke() runs it
+  RValue interpret() {
+    declaration_type = nullptr;
+    function_params.clear();
+    global_is_variadic = false;
+    is_declaration_global = false;
 
-class DeclarationSpecifiersNode : public ASTNode {
-public:
-  DeclarationSpecifiersNode() : ASTNode(NodeType::DeclarationSpecifiers) {}
+    string func_name = declarator->get().s;
+    InterpFunction *existing = interpreter.findFunction(func_name);
+    if (existing && existing->definition) {
+      throw std::runtime_error("Function " + func_name +
+                               " has already been defined.");
+    }
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, children, depth, true);
-  }
+    InterpFunction function;
+    if (existing) {
+      function.type = existing->type;
+    } else {
+      declaration_specifiers->getValueType();
+      declarator->modifyDeclarationType();
+      llvm::Type *func_ret_type = declaration_type;
+      declarator->fixFunctionParams();
+      function.type = llvm::FunctionType::get(func_ret_type, function_params,
+                                              global_is_variadic);
+    }
 
-  bool check_semantics() {
-    throw std::runtime_error(
-        "Checking Semantics for declaration specifiers does not make sense");
+    interpreter.pending_params.clear();
+    declarator->collectFunctionParams();
+    for (auto &param : interpreter.pending_params) {
+      function.params.push_back(
+          {interpreter.intern(param.first), param.second});
+    }
+    function.definition = this;
+
+    interpreter.functions[func_name] = function;
+    return RValue();
   }
 
-  ASTNode *optimise() const {
-    auto ret = new DeclarationSpecifiersNode(*this);
-    for (auto child : ret->children) {
-      child->optimise();
+  BcValue compileBytecode() {
+    declaration_type = nullptr;
+    function_params.clear();
+    global_is_variadic = false;
+    is_declaration_global = false;
+
+    string func_name = declarator->get().s;
+    BcFunction *existing = bytecodeCompiler.findFunction(func_name);
+    if (existing && existing->defined) {
+      throw std::runtime_error("Function " + func_name +
+                               " has already been defined.");
     }
-    return ret;
-    ;
+
+    llvm::FunctionType *function_type;
+    if (existing) {
+      function_type = existing->type;
+    } else {
+      declaration_specifiers->getValueType();
+      declarator->modifyDeclarationType();
+      llvm::Type *func_ret_type = declaration_type;
+      declarator->fixFunctionParams();
+      function_type = llvm::FunctionType::get(func_ret_type, function_params,
+                                              global_is_variadic);
+    }
+
+    interpreter.pending_params.clear();
+    declarator->collectFunctionParams();
+    bytecodeCompiler.defineFunction(
+        func_name, function_type, interpreter.pending_params,
+        [this]() {
+          get_as_lvalue = false;
+          compound_statement->compileBytecode();
+        });
+    return BcValue();
   }
 
-  llvm::Type *getValueType() {
+  RValue invoke(vector<RValue> &args) {
+    interpreter.checkStack();
+    const InterpFunction &function =
+        *interpreter.findFunction(declarator->get().s);
+    llvm::Type *func_ret_type = function.type->getReturnType();
 
-    for (auto child : children) {
-      llvm::Type *val = child->getValueType();
-      if (val != nullptr) {
-        declaration_type = val;
-      }
+    llvm::Type *outer_return_type = interpreter.return_type;
+    interpreter.return_type = func_ret_type;
+    size_t frame = interpreter.enterFrame();
+
+    for (size_t i = 0; i < function.params.size(); i++) {
+      llvm::Type *param_type = function.params[i].second;
+      RValue arg = i < args.size() ? args[i] : interp_zero(param_type);
+      interp_make_store_compatible(param_type, arg);
+      interp_store(interpreter.declare(function.params[i].first, param_type),
+                   arg);
     }
 
-    return declaration_type;
+    compound_statement->interpret();
+
+    interpreter.leaveFrame(frame);
+    interpreter.return_type = outer_return_type;
+
+    if (interpreter.flow == InterpFlow::GOTO) {
+      throw std::runtime_error("Label " + interpreter.goto_label +
+                               " not found.");
+    }
+
+    // Falling off the end returns a zero value, as in codegen
+    RValue ret = interp_zero(func_ret_type);
+    if (interpreter.flow == InterpFlow::RETURN) {
+      ret = interpreter.return_value;
+    }
+    interpreter.flow = InterpFlow::NORMAL;
+    return ret;
   }
+
+private:
+  ASTNode *declaration_specifiers;
+  ASTNode *declarator;
+  ASTNode *declaration_list;
+  ASTNode *compound_statement;
 };
 
 class SpecifierNode : public ASTNode {
@@ -658,12 +1393,8 @@ public:
   SpecifierNode(SpecifierEnum specifier)
       : ASTNode(NodeType::Specifier), specifier(specifier) {}
 
-  string dump_ast(int depth = 0) const {
-    string result = "";
-    result += formatSpacing(depth);
-    result += specifierEnumToString(specifier);
-    result += "\n";
-    return result;
+  void dump(AstWriter &out) const {
+    out.leaf(type, specifierEnumToString(specifier));
   }
 
   bool check_semantics() {
@@ -689,11 +1420,11 @@ public:
     llvm::Type *val = getCurrType(specifier, codeGenerator.getContext());
 
     if (val) {
-      cout << "For the specifer " << specifierEnumToString(specifier)
-           << " the type is " << val->getTypeID() << endl;
+      CC_LOG(LOG_TYPES, "Specifier " << specifierEnumToString(specifier)
+                                     << " has type id " << val->getTypeID());
     } else {
-      cout << "Bruh the val is null for " << specifierEnumToString(specifier)
-           << endl;
+      CC_LOG(LOG_TYPES, "Specifier " << specifierEnumToString(specifier)
+                                     << " has no type");
     }
 
     return val;
@@ -702,25 +1433,162 @@ public:
   SpecifierEnum specifier;
 };
 
+class DeclarationSpecifiersNode : public ASTNode {
+public:
+  DeclarationSpecifiersNode() : ASTNode(NodeType::DeclarationSpecifiers) {}
+
+  void dump(AstWriter &out) const {
+    dumpParameters(this, children, out, true);
+  }
+
+  bool check_semantics() {
+    throw std::runtime_error(
+        "Checking Semantics for declaration specifiers does not make sense");
+  }
+
+  ASTNode *optimise() const {
+    auto ret = new DeclarationSpecifiersNode(*this);
+    for (auto child : ret->children) {
+      child->optimise();
+    }
+    return ret;
+    ;
+  }
+
+  llvm::Type *getValueType() {
+
+    for (auto child : children) {
+      llvm::Type *val = child->getValueType();
+      if (val != nullptr) {
+        declaration_type = val;
+      }
+    }
+
+    return declaration_type;
+  }
+
+  // Plain int, float and double are tracked by the flow analysis (floats
+  // are doubles here); static variables keep their value between calls
+  FlowAnalysis::Kind flowKind() const { return kind(false); }
+
+  // Linkage and `inline` say nothing of the value a function returns
+  FlowAnalysis::Kind returnKind() const { return kind(true); }
+
+  bool declaresInline() const { return declares(SpecifierEnum::INLINE); }
+  bool declaresStatic() const { return declares(SpecifierEnum::STATIC); }
+  bool declaresExtern() const { return declares(SpecifierEnum::EXTERN); }
+
+private:
+  bool declares(SpecifierEnum specifier) const {
+    for (auto child : children) {
+      if (child->getNodeType() == NodeType::Specifier &&
+          dynamic_cast<SpecifierNode *>(child)->specifier == specifier) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  FlowAnalysis::Kind kind(bool function) const {
+    FlowAnalysis::Kind kind = FlowAnalysis::UNTRACKED;
+    for (auto child : children) {
+      if (child->getNodeType() != NodeType::Specifier) {
+        return FlowAnalysis::UNTRACKED;
+      }
+      switch (dynamic_cast<SpecifierNode *>(child)->specifier) {
+      case SpecifierEnum::INT:
+      case SpecifierEnum::FLOAT:
+      case SpecifierEnum::DOUBLE:
+        if (kind != FlowAnalysis::UNTRACKED) {
+          return FlowAnalysis::UNTRACKED;
+        }
+        kind = dynamic_cast<SpecifierNode *>(child)->specifier ==
+                       SpecifierEnum::INT
+                   ? FlowAnalysis::INT
+                   : FlowAnalysis::DOUBLE;
+        break;
+      case SpecifierEnum::CONST:
+      case SpecifierEnum::AUTO:
+      case SpecifierEnum::REGISTER:
+        break;
+      case SpecifierEnum::STATIC:
+      case SpecifierEnum::EXTERN:
+      case SpecifierEnum::INLINE:
+        if (!function) {
+          return FlowAnalysis::UNTRACKED;
+        }
+        break;
+      default:
+        return FlowAnalysis::UNTRACKED;
+      }
+    }
+    return kind;
+  }
+};
+
 class CompoundStatementNode : public ASTNode {
 
 public:
   CompoundStatementNode() : ASTNode(NodeType::CompoundStatement) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, children, depth, true);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, children, out, true);
   }
 
+  const ASTNode *returnedExpression() const {
+    return children.size() == 1 ? children[0]->returnedExpression() : nullptr;
+  }
+
+  // Statements no execution reaches are dropped; declarations stay, as a
+  // label after them may still use the names. So are expressions without
+  // effects and stores nothing reads.
   ASTNode *optimise() const {
+    FlowAnalysis &flow = optimisationContext.flow;
     auto ret = new CompoundStatementNode(*this);
-    codeGenerator.pushContext();
-    for (auto &child : ret->children) {
-      child = child->optimise();
+    ret->children.clear();
+    optimisationContext.pushContext();
+    for (auto child : children) {
+      if (child->getNodeType() != NodeType::Declaration && flow.dead(child)) {
+        dead_code_stats.unreachable++;
+        continue;
+      }
+      if (flow.pure(child)) {
+        dead_code_stats.unused++;
+        continue;
+      }
+      if (flow.dead_store(child)) {
+        dead_code_stats.stores++;
+        continue;
+      }
+      ASTNode *optimised = child->optimise();
+      if (optimised->getNodeType() != NodeType::Unimplemented) {
+        ret->children.push_back(optimised);
+      }
     }
-    codeGenerator.popContext();
+    optimisationContext.popContext();
     return ret;
   }
 
+  void buildFlow() const {
+    size_t scope = optimisationContext.flow.currentScope();
+    for (auto child : children) {
+      child->buildStatementFlow();
+    }
+    optimisationContext.flow.restoreScope(scope);
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    size_t scope = evaluation.enterScope();
+    for (auto child : children) {
+      child->evaluate(evaluation);
+      if (evaluation.flow != ConstEvaluation::NORMAL) {
+        break;
+      }
+    }
+    evaluation.leaveScope(scope);
+    return m_Value();
+  }
+
   bool check_semantics() {
     scoperStack.push();
     for (auto child : children) {
@@ -740,6 +1608,46 @@ public:
     codeGenerator.popContext();
     return nullptr;
   }
+
+  // A goto resumes at the matching label of this block, or leaves it for
+  // an enclosing one to resolve
+  RValue interpret() {
+    interpreter.pushScope();
+    size_t i = 0;
+    while (i < children.size()) {
+      children[i]->interpret();
+
+      if (interpreter.flow == InterpFlow::GOTO) {
+        size_t target = 0;
+        while (target < children.size() &&
+               !children[target]->definesLabel(interpreter.goto_label)) {
+          target++;
+        }
+        if (target < children.size()) {
+          interpreter.flow = InterpFlow::NORMAL;
+          i = target;
+          continue;
+        }
+      }
+
+      if (interpreter.flow != InterpFlow::NORMAL) {
+        break;
+      }
+      i++;
+    }
+    interpreter.popScope();
+    return RValue();
+  }
+
+  BcValue compileBytecode() {
+    bytecodeCompiler.pushScope();
+    for (auto child : children) {
+      child->compileBytecode();
+      bytecodeCompiler.releaseTemps();
+    }
+    bytecodeCompiler.popScope();
+    return BcValue();
+  }
 };
 
 class LabelStatementNode : public ASTNode {
@@ -747,8 +1655,15 @@ public:
   LabelStatementNode(ASTNode *label, ASTNode *statement)
       : ASTNode(NodeType::LabelStatement), label(label), statement(statement) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {label, statement}, depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {label, statement}, out, false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {label, statement}) {
+      visit(child);
+    }
   }
 
   m_Value get_value_if_possible() const { return m_Value(); }
@@ -758,6 +1673,19 @@ public:
     return ret;
   }
 
+  void buildFlow() const {
+    FlowAnalysis &flow = optimisationContext.flow;
+    int block = flow.labelBlock(label->get().s);
+    flow.jump(block);
+    flow.setBlock(block);
+    // A goto may have made the label's block already; the statement starts
+    // a new one, so that the label counts as part of it
+    int body = flow.newBlock();
+    flow.jump(body);
+    flow.setBlock(body);
+    statement->buildStatementFlow();
+  }
+
   Value *codegen() {
 
     m_Value label_name = label->get();
@@ -788,6 +1716,17 @@ public:
     return nullptr;
   }
 
+  bool definesLabel(const string &name) const {
+    return label->get().s == name || statement->definesLabel(name);
+  }
+
+  RValue interpret() { return statement->interpret(); }
+
+  BcValue compileBytecode() {
+    bytecodeCompiler.defineLabel(label->get().s);
+    return statement->compileBytecode();
+  }
+
 private:
   ASTNode *label;
   ASTNode *statement;
@@ -800,8 +1739,15 @@ public:
       : ASTNode(NodeType::CaseLabelStatement),
         constant_expression(constant_expression), statement(statement) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {constant_expression, statement}, depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {constant_expression, statement}, out, false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {constant_expression, statement}) {
+      visit(child);
+    }
   }
 
   m_Value get_value_if_possible() const { return m_Value(); }
@@ -829,8 +1775,13 @@ public:
     return ret;
   }
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {statement}, depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {statement}, out, false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    visit(statement);
   }
 
 public:
@@ -844,9 +1795,15 @@ public:
       : ASTNode(NodeType::IfElseStatement), expression(expression),
         statement(statement), else_statement(else_statement) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {expression, statement, else_statement}, depth,
-                          false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {expression, statement, else_statement}, out, false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {expression, statement, else_statement}) {
+      visit(child);
+    }
   }
 
   m_Value get_value_if_possible() const { return m_Value(); }
@@ -856,20 +1813,41 @@ public:
     auto ret = new IfElseStatementNode(*this);
 
     ret->expression = expression->optimise();
-    codeGenerator.pushContext();
+    optimisationContext.pushContext();
     ret->statement = statement->optimise();
-    codeGenerator.popContext();
-    codeGenerator.pushContext();
+    optimisationContext.popContext();
+    optimisationContext.pushContext();
     ret->else_statement = else_statement->optimise();
-    codeGenerator.popContext();
+    optimisationContext.popContext();
     m_Value val = expression->get_value_if_possible();
-    if (val.type == ActualValueType::INTEGER) {
-      return val.i ? ret->statement : ret->else_statement;
-    }
-    if (val.type == ActualValueType::FLOATING) {
-      return val.f ? ret->statement : ret->else_statement;
-    }
-    return ret;
+    if (val.type != ActualValueType::INTEGER &&
+        val.type != ActualValueType::FLOATING) {
+      return ret;
+    }
+    // Unless a goto still lands in the branch not taken
+    bool taken = val.type == ActualValueType::INTEGER ? val.i : val.f;
+    ASTNode *dropped = taken ? else_statement : statement;
+    if (optimisationContext.flow.active() &&
+        !optimisationContext.flow.dead(dropped) &&
+        dropped->getNodeType() != NodeType::Unimplemented) {
+      return ret;
+    }
+    return taken ? ret->statement : ret->else_statement;
+  }
+
+  void buildFlow() const {
+    FlowAnalysis &flow = optimisationContext.flow;
+    int then_block = flow.newBlock();
+    int else_block = flow.newBlock();
+    int join = flow.newBlock();
+    flow.branch(expression, then_block, else_block);
+    flow.setBlock(then_block);
+    statement->buildStatementFlow();
+    flow.jump(join);
+    flow.setBlock(else_block);
+    else_statement->buildStatementFlow();
+    flow.jump(join);
+    flow.setBlock(join);
   }
 
   bool check_semantics() {
@@ -891,6 +1869,15 @@ public:
     return true;
   }
 
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    if (evaluation.truth(expression->evaluate(evaluation))) {
+      statement->evaluate(evaluation);
+    } else {
+      else_statement->evaluate(evaluation);
+    }
+    return m_Value();
+  }
+
   Value *codegen() {
     llvm::Value *conditionValue = expression->codegen();
     if (!conditionValue) {
@@ -916,7 +1903,9 @@ public:
     llvm::BasicBlock *merge_block =
         llvm::BasicBlock::Create(codeGenerator.getContext(), "ifcont");
 
-    codeGenerator.getBuilder().CreateCondBr(condition, then_block, else_block);
+    codeGenerator.getBuilder().CreateCondBr(
+        condition, then_block, else_block,
+        profiler.branch(codeGenerator.getBuilder(), condition));
 
     codeGenerator.getBuilder().SetInsertPoint(then_block);
 
@@ -941,6 +1930,46 @@ public:
     return nullptr;
   }
 
+  RValue interpret() {
+    RValue conditionValue = expression->interpret();
+    if (conditionValue.type->isVoidTy()) {
+      throw std::runtime_error("Condition value is null");
+    }
+
+    if (interp_truthy(conditionValue)) {
+      interpreter.pushScope();
+      statement->interpret();
+      interpreter.popScope();
+    } else if (else_statement->getNodeType() != NodeType::Unimplemented) {
+      interpreter.pushScope();
+      else_statement->interpret();
+      interpreter.popScope();
+    }
+    return RValue();
+  }
+
+  BcValue compileBytecode() {
+    size_t to_else =
+        bytecodeCompiler.jumpIfFalse(expression->compileBytecode());
+
+    bytecodeCompiler.pushScope();
+    statement->compileBytecode();
+    bytecodeCompiler.popScope();
+
+    if (else_statement->getNodeType() == NodeType::Unimplemented) {
+      bytecodeCompiler.patch(to_else);
+      return BcValue();
+    }
+
+    size_t to_end = bytecodeCompiler.jump();
+    bytecodeCompiler.patch(to_else);
+    bytecodeCompiler.pushScope();
+    else_statement->compileBytecode();
+    bytecodeCompiler.popScope();
+    bytecodeCompiler.patch(to_end);
+    return BcValue();
+  }
+
 private:
   ASTNode *expression;
   ASTNode *statement;
@@ -953,20 +1982,67 @@ public:
       : ASTNode(NodeType::SwitchStatement), expression(expression),
         statement(statement) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {expression, statement}, depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {expression, statement}, out, false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {expression, statement}) {
+      visit(child);
+    }
   }
 
   m_Value get_value_if_possible() const { return m_Value(); }
   ASTNode *optimise() const {
     auto ret = new SwitchStatementNode(*this);
     ret->expression = expression->optimise();
-    codeGenerator.pushContext();
+    optimisationContext.pushContext();
     ret->statement = statement->optimise();
-    codeGenerator.popContext();
+    optimisationContext.popContext();
     return ret;
   }
 
+  // Same shape as the lowered switch: the first matching case's statement
+  // (or the default's) runs and leaves the switch
+  void buildFlow() const {
+    FlowAnalysis &flow = optimisationContext.flow;
+    size_t scope = flow.currentScope();
+    int dispatch = flow.beginSwitch(expression);
+    int end = flow.newBlock();
+    int otherwise = end;
+    flow.pushSwitch(end);
+    for (auto statement : statement->getChildren()) {
+      ASTNode *body = nullptr;
+      int block = -1;
+      if (statement->getNodeType() == NodeType::DefaultLabelStatement) {
+        if (otherwise != end) {
+          continue;
+        }
+        body = dynamic_cast<DefaultLabelStatementNode *>(statement)->statement;
+        block = otherwise = flow.newBlock();
+      } else if (statement->getNodeType() ==
+                 NodeType::CaseLabelStatement) {
+        CaseLabelStatementNode *caseNode =
+            dynamic_cast<CaseLabelStatementNode *>(statement);
+        body = caseNode->statement;
+        block = flow.newBlock();
+        flow.addCase(dispatch,
+                     caseNode->constant_expression->get_value_if_possible(),
+                     block);
+      } else {
+        continue;
+      }
+      flow.setBlock(block);
+      body->buildStatementFlow();
+      flow.jump(end);
+    }
+    flow.endSwitch(dispatch, otherwise);
+    flow.popTarget();
+    flow.setBlock(end);
+    flow.restoreScope(scope);
+  }
+
   bool check_semantics() {
     if (!expression->check_semantics()) {
       return false;
@@ -1001,9 +2077,13 @@ public:
     /* int numCases = statements.size(); */
     int numCases = 0;
     ASTNode *defaultCase = nullptr;
+    vector<llvm::ConstantInt *> caseValues;
     for (auto statement : statements) {
       if (statement->getNodeType() == NodeType::CaseLabelStatement) {
         numCases++;
+        caseValues.push_back(llvm::dyn_cast<llvm::ConstantInt>(
+            dynamic_cast<CaseLabelStatementNode *>(statement)
+                ->constant_expression->codegen()));
       } else if (statement->getNodeType() == NodeType::DefaultLabelStatement) {
         defaultCase = statement;
       }
@@ -1012,6 +2092,8 @@ public:
     llvm::BasicBlock *oldMergeBlock = merge_block;
     merge_block = loopmergeBlock;
 
+    llvm::MDNode *weights = profiler.switchCases(codeGenerator.getBuilder(),
+                                                 conditionValue, caseValues);
     llvm::SwitchInst *switchInst = codeGenerator.getBuilder().CreateSwitch(
         conditionValue, defaultBlock, numCases);
 
@@ -1041,6 +2123,9 @@ public:
           caseNode->constant_expression->codegen());
       switchInst->addCase(caseValue, caseBlock);
     }
+    if (weights) {
+      switchInst->setMetadata(llvm::LLVMContext::MD_prof, weights);
+    }
 
     // Generate LLVM IR code for the default case, if present
 
@@ -1064,6 +2149,106 @@ public:
     return nullptr;
   }
 
+  // Like the lowered switch, only the matching case's statement runs
+  RValue interpret() {
+    RValue conditionValue = expression->interpret();
+
+    interpreter.pushScope();
+    ASTNode *chosen = nullptr;
+    for (auto statement : statement->getChildren()) {
+      if (statement->getNodeType() == NodeType::DefaultLabelStatement) {
+        if (!chosen) {
+          chosen = statement;
+        }
+        continue;
+      } else if (statement->getNodeType() == NodeType::BreakStatement) {
+        continue;
+      }
+
+      CaseLabelStatementNode *caseNode =
+          dynamic_cast<CaseLabelStatementNode *>(statement);
+      if (!caseNode) {
+        throw std::runtime_error("Case node is null");
+      }
+
+      RValue caseValue = caseNode->constant_expression->interpret();
+      if (interp_truthy(
+              interp_binary(InterpOp::EQ, conditionValue, caseValue))) {
+        chosen = statement;
+        break;
+      }
+    }
+
+    if (chosen) {
+      if (chosen->getNodeType() == NodeType::DefaultLabelStatement) {
+        dynamic_cast<DefaultLabelStatementNode *>(chosen)->statement->interpret();
+      } else {
+        dynamic_cast<CaseLabelStatementNode *>(chosen)->statement->interpret();
+      }
+    }
+    interpreter.popScope();
+
+    if (interpreter.flow == InterpFlow::BREAK) {
+      interpreter.flow = InterpFlow::NORMAL;
+    }
+    return RValue();
+  }
+
+  // The cases are compared in order, then each case's statement is laid
+  // out with a jump to the end, so there is no fall-through
+  BcValue compileBytecode() {
+    BcValue conditionValue = expression->compileBytecode();
+
+    bytecodeCompiler.pushScope();
+    bytecodeCompiler.pushBreak();
+    ASTNode *default_statement = nullptr;
+    vector<pair<size_t, ASTNode *>> cases;
+    for (auto statement : statement->getChildren()) {
+      if (statement->getNodeType() == NodeType::DefaultLabelStatement) {
+        if (!default_statement) {
+          default_statement =
+              dynamic_cast<DefaultLabelStatementNode *>(statement)->statement;
+        }
+        continue;
+      } else if (statement->getNodeType() == NodeType::BreakStatement) {
+        continue;
+      }
+
+      CaseLabelStatementNode *caseNode =
+          dynamic_cast<CaseLabelStatementNode *>(statement);
+      if (!caseNode) {
+        throw std::runtime_error("Case node is null");
+      }
+
+      BcValue caseValue = caseNode->constant_expression->compileBytecode();
+      cases.push_back({bytecodeCompiler.jumpIfTrue(bytecodeCompiler.binary(
+                           InterpOp::EQ, conditionValue, caseValue)),
+                       caseNode->statement});
+    }
+
+    vector<size_t> to_end;
+    if (default_statement) {
+      cases.push_back({bytecodeCompiler.jump(), default_statement});
+    } else {
+      to_end.push_back(bytecodeCompiler.jump());
+    }
+
+    for (auto &taken : cases) {
+      bytecodeCompiler.patch(taken.first);
+      taken.second->compileBytecode();
+      bytecodeCompiler.releaseTemps();
+      to_end.push_back(bytecodeCompiler.jump());
+    }
+
+    size_t end = bytecodeCompiler.label();
+    for (size_t at : to_end) {
+      bytecodeCompiler.patchTo(at, end);
+    }
+    bytecodeCompiler.popBreak(end);
+    bytecodeCompiler.popScope();
+    return BcValue();
+  }
+
 private:
   ASTNode *expression;
   ASTNode *statement;
@@ -1075,26 +2260,35 @@ public:
       : ASTNode(NodeType::WhileStatement), expression(expression),
         statement(statement) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {expression, statement}, depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {expression, statement}, out, false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {expression, statement}) {
+      visit(child);
+    }
   }
 
   m_Value get_value_if_possible() const { return m_Value(); }
   ASTNode *optimise() const {
     auto ret = new WhileStatementNode(*this);
     auto expression_copy = expression->optimise();
-    codeGenerator.pushContext();
+    optimisationContext.pushContext();
     ret->statement = statement->optimise();
-    codeGenerator.popContext();
+    optimisationContext.popContext();
     m_Value val = expression_copy->get_value_if_possible();
+    bool body_dead = !optimisationContext.flow.active() ||
+                     optimisationContext.flow.dead(statement);
 
-    if (val.type == ActualValueType::INTEGER) {
+    if (val.type == ActualValueType::INTEGER && body_dead) {
       if (val.i == 0) {
         return new NullPtrNode();
       }
     }
 
-    if (val.type == ActualValueType::FLOATING) {
+    if (val.type == ActualValueType::FLOATING && body_dead) {
       if (val.f == 0) {
         return new NullPtrNode();
       }
@@ -1103,6 +2297,22 @@ public:
     return ret;
   }
 
+  void buildFlow() const {
+    FlowAnalysis &flow = optimisationContext.flow;
+    int head = flow.newBlock();
+    int body = flow.newBlock();
+    int end = flow.newBlock();
+    flow.jump(head);
+    flow.setBlock(head);
+    flow.branch(expression, body, end);
+    flow.setBlock(body);
+    flow.pushLoop(end, head);
+    statement->buildStatementFlow();
+    flow.popTarget();
+    flow.jump(head);
+    flow.setBlock(end);
+  }
+
   bool check_semantics() {
     if (!expression->check_semantics()) {
       return false;
@@ -1115,6 +2325,17 @@ public:
     return true;
   }
 
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    while (evaluation.truth(expression->evaluate(evaluation))) {
+      evaluation.step();
+      statement->evaluate(evaluation);
+      if (evaluation.endIteration()) {
+        break;
+      }
+    }
+    return m_Value();
+  }
+
   Value *codegen() {
     llvm::Function *function =
         codeGenerator.getBuilder().GetInsertBlock()->getParent();
@@ -1131,8 +2352,9 @@ public:
 
     make_bool(conditionValue);
 
-    codeGenerator.getBuilder().CreateCondBr(conditionValue, loopBlock,
-                                            mergeBlock);
+    codeGenerator.getBuilder().CreateCondBr(
+        conditionValue, loopBlock, mergeBlock,
+        profiler.branch(codeGenerator.getBuilder(), conditionValue));
     function->getBasicBlockList().push_back(loopBlock);
 
     codeGenerator.getBuilder().SetInsertPoint(loopBlock);
@@ -1155,27 +2377,65 @@ public:
     return nullptr;
   }
 
-private:
-  ASTNode *expression;
-  ASTNode *statement;
-};
-
-class DoWhileStatementNode : public ASTNode {
+  RValue interpret() {
+    while (interp_truthy(expression->interpret())) {
+      interpreter.pushScope();
+      statement->interpret();
+      interpreter.popScope();
+      if (interpreter.loopExits()) {
+        break;
+      }
+    }
+    return RValue();
+  }
+
+  BcValue compileBytecode() {
+    size_t top = bytecodeCompiler.label();
+    size_t to_end =
+        bytecodeCompiler.jumpIfFalse(expression->compileBytecode());
+
+    bytecodeCompiler.pushBreak();
+    bytecodeCompiler.pushContinue();
+    bytecodeCompiler.pushScope();
+    statement->compileBytecode();
+    bytecodeCompiler.popScope();
+    bytecodeCompiler.patchTo(bytecodeCompiler.jump(), top);
+
+    size_t end = bytecodeCompiler.label();
+    bytecodeCompiler.patchTo(to_end, end);
+    bytecodeCompiler.popContinue(top);
+    bytecodeCompiler.popBreak(end);
+    return BcValue();
+  }
+
+private:
+  ASTNode *expression;
+  ASTNode *statement;
+};
+
+class DoWhileStatementNode : public ASTNode {
 public:
   DoWhileStatementNode(ASTNode *expression, ASTNode *statement)
       : ASTNode(NodeType::DoWhileStatement), expression(expression),
         statement(statement) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {statement, expression}, depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {statement, expression}, out, false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {statement, expression}) {
+      visit(child);
+    }
   }
 
   m_Value get_value_if_possible() const { return m_Value(); }
   ASTNode *optimise() const {
     auto ret = new DoWhileStatementNode(*this);
-    codeGenerator.pushContext();
+    optimisationContext.pushContext();
     ret->statement = statement->optimise();
-    codeGenerator.popContext();
+    optimisationContext.popContext();
     // Can't do the same optimisation as while statement here because of break
     // and continue
 
@@ -1183,6 +2443,22 @@ public:
     ;
   }
 
+  void buildFlow() const {
+    FlowAnalysis &flow = optimisationContext.flow;
+    int body = flow.newBlock();
+    int condition = flow.newBlock();
+    int end = flow.newBlock();
+    flow.jump(body);
+    flow.setBlock(body);
+    flow.pushLoop(end, condition);
+    statement->buildStatementFlow();
+    flow.popTarget();
+    flow.jump(condition);
+    flow.setBlock(condition);
+    flow.branch(expression, body, end);
+    flow.setBlock(end);
+  }
+
   bool check_semantics() {
     if (!expression->check_semantics()) {
       return false;
@@ -1195,6 +2471,17 @@ public:
     return true;
   }
 
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    do {
+      evaluation.step();
+      statement->evaluate(evaluation);
+      if (evaluation.endIteration()) {
+        break;
+      }
+    } while (evaluation.truth(expression->evaluate(evaluation)));
+    return m_Value();
+  }
+
   Value *codegen() {
     llvm::Function *function =
         codeGenerator.getBuilder().GetInsertBlock()->getParent();
@@ -1228,8 +2515,9 @@ public:
 
     make_bool(conditionValue);
     // Create the loop condition branch instruction
-    codeGenerator.getBuilder().CreateCondBr(conditionValue, doBlock,
-                                            mergeBlock);
+    codeGenerator.getBuilder().CreateCondBr(
+        conditionValue, doBlock, mergeBlock,
+        profiler.branch(codeGenerator.getBuilder(), conditionValue));
 
     // Add merge block to the function
     function->getBasicBlockList().push_back(mergeBlock);
@@ -1238,6 +2526,37 @@ public:
     return nullptr;
   }
 
+  RValue interpret() {
+    do {
+      interpreter.pushScope();
+      statement->interpret();
+      interpreter.popScope();
+      if (interpreter.loopExits()) {
+        break;
+      }
+    } while (interp_truthy(expression->interpret()));
+    return RValue();
+  }
+
+  BcValue compileBytecode() {
+    size_t top = bytecodeCompiler.label();
+
+    bytecodeCompiler.pushBreak();
+    bytecodeCompiler.pushContinue();
+    bytecodeCompiler.pushScope();
+    statement->compileBytecode();
+    bytecodeCompiler.popScope();
+
+    size_t condition = bytecodeCompiler.label();
+    bytecodeCompiler.patchTo(
+        bytecodeCompiler.jumpIfTrue(expression->compileBytecode()), top);
+
+    size_t end = bytecodeCompiler.label();
+    bytecodeCompiler.popContinue(condition);
+    bytecodeCompiler.popBreak(end);
+    return BcValue();
+  }
+
 private:
   ASTNode *expression;
   ASTNode *statement;
@@ -1251,9 +2570,16 @@ public:
         expression2(expression2), expression3(expression3),
         statement(statement) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(
-        this, {expression1, expression2, expression3, statement}, depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(
+        this, {expression1, expression2, expression3, statement}, out, false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {expression1, expression2, expression3, statement}) {
+      visit(child);
+    }
   }
 
   m_Value get_value_if_possible() const { return m_Value(); }
@@ -1261,32 +2587,126 @@ public:
   ASTNode *optimise() const {
 
     auto ret = new ForStatementNode(*this);
-    codeGenerator.pushContext();
+    optimisationContext.pushContext();
     ret->expression1 = expression1->optimise();
-    codeGenerator.pushContext();
+    optimisationContext.pushContext();
     auto expression2_copy = expression2->optimise();
     ret->expression3 = expression3->optimise();
 
     m_Value val = expression2_copy->get_value_if_possible();
-
-    if (val.type == ActualValueType::INTEGER) {
-      if (val.i == 0) {
+    bool never = (val.type == ActualValueType::INTEGER && val.i == 0) ||
+                 (val.type == ActualValueType::FLOATING && val.f == 0);
+
+    if (never && (!optimisationContext.flow.active() ||
+                  optimisationContext.flow.dead(statement))) {
+      optimisationContext.popContext();
+      optimisationContext.popContext();
+      // The initialisation still runs, in a scope of its own
+      if (ret->expression1->getNodeType() == NodeType::Unimplemented) {
         return new NullPtrNode();
       }
+      auto init = new CompoundStatementNode();
+      init->addChild(ret->expression1);
+      return init;
     }
 
-    if (val.type == ActualValueType::FLOATING) {
-      if (val.f == 0) {
-        return new NullPtrNode();
-      }
+    ASTNode *unrolled = unroll(ret->expression1, expression2_copy);
+    if (unrolled) {
+      optimisationContext.popContext();
+      optimisationContext.popContext();
+      return unrolled;
     }
 
     ret->statement = statement->optimise();
-    codeGenerator.popContext();
-    codeGenerator.popContext();
+    optimisationContext.popContext();
+    optimisationContext.popContext();
+    return ret;
+  }
+
+  // Full unrolling: when the header alone fixes the trip count and the body
+  // leaves the induction variable alone, the loop becomes its
+  // initialisation followed by that many copies of the body and the step.
+  // The condition is pure, so it is dropped. The next round of constant
+  // propagation folds each copy with its own value of the variable.
+  ASTNode *unroll(ASTNode *init, const ASTNode *condition) const {
+    FlowAnalysis::Kind kind;
+    size_t size;
+    if (unroll_budget == 0 ||
+        condition->getNodeType() == NodeType::Unimplemented ||
+        !optimisationContext.flow.unrollable(this, kind, size) ||
+        kind != FlowAnalysis::INT) {
+      return nullptr;
+    }
+
+    // The header is run by the compile-time evaluator, which sees nothing
+    // but the induction variable
+    string name = expression1->inductionVariable();
+    size_t trips = 0;
+    try {
+      ConstEvaluation evaluation;
+      evaluation.declare(name, kind, m_Value());
+      init->evaluate(evaluation);
+      for (;;) {
+        m_Value before = evaluation.load(name);
+        bool taken = evaluation.truth(condition->evaluate(evaluation));
+        if (evaluation.load(name).i != before.i) {
+          return nullptr;
+        }
+        if (!taken) {
+          break;
+        }
+        if (++trips * std::max<size_t>(size, 1) > unroll_budget) {
+          return nullptr;
+        }
+        expression3->evaluate(evaluation);
+      }
+    } catch (const ConstEvalError &) {
+      return nullptr;
+    }
+
+    auto ret = new CompoundStatementNode();
+    if (init->getNodeType() != NodeType::Unimplemented) {
+      ret->addChild(init);
+    }
+    for (size_t i = 0; i < trips; i++) {
+      ret->addChild(statement->optimise());
+      if (expression3->getNodeType() != NodeType::Unimplemented) {
+        ret->addChild(expression3->optimise());
+      }
+    }
+    unroll_stats.loops++;
+    unroll_stats.iterations += trips;
     return ret;
   }
 
+  void buildFlow() const {
+    FlowAnalysis &flow = optimisationContext.flow;
+    size_t scope = flow.currentScope();
+    expression1->buildFlow();
+    int head = flow.newBlock();
+    int step = flow.newBlock();
+    int end = flow.newBlock();
+    flow.jump(head);
+    flow.setBlock(head);
+    int body = flow.newBlock();
+    if (expression2->getNodeType() == NodeType::Unimplemented) {
+      flow.jump(body);
+    } else {
+      flow.branch(expression2, body, end);
+    }
+    flow.setBlock(body);
+    flow.pushLoop(end, step);
+    statement->buildStatementFlow();
+    flow.popTarget();
+    flow.loop(this, expression1->inductionVariable(), body, step);
+    flow.jump(step);
+    flow.setBlock(step);
+    expression3->buildFlow();
+    flow.jump(head);
+    flow.setBlock(end);
+    flow.restoreScope(scope);
+  }
+
   bool check_semantics() {
 
     scoperStack.push();
@@ -1313,6 +2733,22 @@ public:
     return true;
   }
 
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    size_t scope = evaluation.enterScope();
+    expression1->evaluate(evaluation);
+    while (expression2->getNodeType() == NodeType::Unimplemented ||
+           evaluation.truth(expression2->evaluate(evaluation))) {
+      evaluation.step();
+      statement->evaluate(evaluation);
+      if (evaluation.endIteration()) {
+        break;
+      }
+      expression3->evaluate(evaluation);
+    }
+    evaluation.leaveScope(scope);
+    return m_Value();
+  }
+
   Value *codegen() {
     llvm::Function *function =
         codeGenerator.getBuilder().GetInsertBlock()->getParent();
@@ -1322,12 +2758,12 @@ public:
         codeGenerator.getContext(), "for.init", function);
     llvm::BasicBlock *loopConditionBlock = llvm::BasicBlock::Create(
         codeGenerator.getContext(), "for.cond", function);
-    llvm::BasicBlock *loopBodyBlock = llvm::BasicBlock::Create(
-        codeGenerator.getContext(), "for.body", function);
-    llvm::BasicBlock *loopIterBlock = llvm::BasicBlock::Create(
-        codeGenerator.getContext(), "for.iter", function);
-    llvm::BasicBlock *mergeBlock = llvm::BasicBlock::Create(
-        codeGenerator.getContext(), "for.merge", function);
+    llvm::BasicBlock *loopBodyBlock =
+        llvm::BasicBlock::Create(codeGenerator.getContext(), "for.body");
+    llvm::BasicBlock *loopIterBlock =
+        llvm::BasicBlock::Create(codeGenerator.getContext(), "for.iter");
+    llvm::BasicBlock *mergeBlock =
+        llvm::BasicBlock::Create(codeGenerator.getContext(), "for.merge");
 
     // Jump to the initialization block
     codeGenerator.getBuilder().CreateBr(initBlock);
@@ -1356,8 +2792,9 @@ public:
     }
     make_bool(conditionValue);
     // Create the loop condition branch instruction
-    codeGenerator.getBuilder().CreateCondBr(conditionValue, loopBodyBlock,
-                                            mergeBlock);
+    codeGenerator.getBuilder().CreateCondBr(
+        conditionValue, loopBodyBlock, mergeBlock,
+        profiler.branch(codeGenerator.getBuilder(), conditionValue));
 
     // Set the insert point to the loop body block
     function->getBasicBlockList().push_back(loopBodyBlock);
@@ -1398,6 +2835,65 @@ public:
     return nullptr;
   }
 
+  RValue interpret() {
+    interpreter.pushScope();
+    if (expression1->getNodeType() != NodeType::Unimplemented) {
+      expression1->interpret();
+    }
+
+    interpreter.pushScope();
+    while (expression2->getNodeType() == NodeType::Unimplemented ||
+           interp_truthy(expression2->interpret())) {
+      statement->interpret();
+      if (interpreter.loopExits()) {
+        break;
+      }
+      if (expression3->getNodeType() != NodeType::Unimplemented) {
+        expression3->interpret();
+      }
+    }
+    interpreter.popScope();
+    interpreter.popScope();
+    return RValue();
+  }
+
+  BcValue compileBytecode() {
+    bytecodeCompiler.pushScope();
+    if (expression1->getNodeType() != NodeType::Unimplemented) {
+      expression1->compileBytecode();
+      bytecodeCompiler.releaseTemps();
+    }
+
+    bytecodeCompiler.pushScope();
+    size_t top = bytecodeCompiler.label();
+    size_t to_end = SIZE_MAX;
+    if (expression2->getNodeType() != NodeType::Unimplemented) {
+      to_end = bytecodeCompiler.jumpIfFalse(expression2->compileBytecode());
+    }
+
+    bytecodeCompiler.pushBreak();
+    bytecodeCompiler.pushContinue();
+    statement->compileBytecode();
+    bytecodeCompiler.releaseTemps();
+
+    size_t step = bytecodeCompiler.label();
+    if (expression3->getNodeType() != NodeType::Unimplemented) {
+      expression3->compileBytecode();
+      bytecodeCompiler.releaseTemps();
+    }
+    bytecodeCompiler.patchTo(bytecodeCompiler.jump(), top);
+
+    size_t end = bytecodeCompiler.label();
+    if (to_end != SIZE_MAX) {
+      bytecodeCompiler.patchTo(to_end, end);
+    }
+    bytecodeCompiler.popContinue(step);
+    bytecodeCompiler.popBreak(end);
+    bytecodeCompiler.popScope();
+    bytecodeCompiler.popScope();
+    return BcValue();
+  }
+
 private:
   ASTNode *expression1;
   ASTNode *expression2;
@@ -1410,12 +2906,22 @@ public:
   GotoStatementNode(ASTNode *identifier)
       : ASTNode(NodeType::GotoStatement), identifier(identifier) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {identifier}, depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {identifier}, out, false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    visit(identifier);
   }
 
   ASTNode *optimise() const { return new GotoStatementNode(*this); }
 
+  void buildFlow() const {
+    FlowAnalysis &flow = optimisationContext.flow;
+    flow.jump(flow.labelBlock(identifier->get().s));
+  }
+
   m_Value get_value_if_possible() const { return m_Value(); }
 
   Value *codegen() {
@@ -1438,6 +2944,17 @@ public:
     return nullptr;
   }
 
+  RValue interpret() {
+    interpreter.goto_label = identifier->get().s;
+    interpreter.flow = InterpFlow::GOTO;
+    return RValue();
+  }
+
+  BcValue compileBytecode() {
+    bytecodeCompiler.emitGoto(identifier->get().s);
+    return BcValue();
+  }
+
 private:
   ASTNode *identifier;
 };
@@ -1446,13 +2963,27 @@ class ContinueStatementNode : public ASTNode {
 public:
   ContinueStatementNode() : ASTNode(NodeType::ContinueStatement) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {}, depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {}, out, false);
   }
 
   m_Value get_value_if_possible() const { return m_Value(); }
   ASTNode *optimise() const { return new ContinueStatementNode(*this); }
 
+  void buildFlow() const {
+    FlowAnalysis &flow = optimisationContext.flow;
+    if (flow.continueTarget() < 0) {
+      flow.stop();
+    } else {
+      flow.jump(flow.continueTarget());
+    }
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    evaluation.flow = ConstEvaluation::CONTINUE;
+    return m_Value();
+  }
+
   Value *codegen() {
 
     if (loop_block == nullptr) {
@@ -1462,19 +2993,43 @@ public:
     codeGenerator.getBuilder().CreateBr(loop_block);
     return nullptr;
   }
+
+  RValue interpret() {
+    interpreter.flow = InterpFlow::CONTINUE;
+    return RValue();
+  }
+
+  BcValue compileBytecode() {
+    bytecodeCompiler.emitContinue();
+    return BcValue();
+  }
 };
 
 class BreakStatementNode : public ASTNode {
 public:
   BreakStatementNode() : ASTNode(NodeType::BreakStatement) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {}, depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {}, out, false);
   }
 
   ASTNode *optimise() const { return new BreakStatementNode(*this); }
   m_Value get_value_if_possible() const { return m_Value(); }
 
+  void buildFlow() const {
+    FlowAnalysis &flow = optimisationContext.flow;
+    if (flow.breakTarget() < 0) {
+      flow.stop();
+    } else {
+      flow.jump(flow.breakTarget());
+    }
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    evaluation.flow = ConstEvaluation::BREAK;
+    return m_Value();
+  }
+
   Value *codegen() {
     if (merge_block == nullptr) {
       throw std::runtime_error("Break statement outside of loop");
@@ -1483,6 +3038,16 @@ public:
     codeGenerator.getBuilder().CreateBr(merge_block);
     return nullptr;
   }
+
+  RValue interpret() {
+    interpreter.flow = InterpFlow::BREAK;
+    return RValue();
+  }
+
+  BcValue compileBytecode() {
+    bytecodeCompiler.emitBreak();
+    return BcValue();
+  }
 };
 
 class ReturnStatementNode : public ASTNode {
@@ -1490,12 +3055,22 @@ public:
   ReturnStatementNode(ASTNode *expression)
       : ASTNode(NodeType::ReturnStatement), expression(expression) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {expression}, depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {expression}, out, false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    visit(expression);
   }
 
   bool check_semantics() { return expression->check_semantics(); }
 
+  const ASTNode *returnedExpression() const {
+    return expression->getNodeType() == NodeType::Unimplemented ? nullptr
+                                                                : expression;
+  }
+
   ASTNode *optimise() const {
     auto ret = new ReturnStatementNode(*this);
     ret->expression = expression->optimise();
@@ -1508,6 +3083,17 @@ public:
     return expression->get_value_if_possible();
   }
 
+  void buildFlow() const {
+    expression->buildFlow();
+    optimisationContext.flow.stop();
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    evaluation.return_value = expression->evaluate(evaluation);
+    evaluation.flow = ConstEvaluation::RETURN;
+    return m_Value();
+  }
+
   Value *codegen() {
     if (expression->getNodeType() != NodeType::Unimplemented) {
 
@@ -1530,6 +3116,35 @@ public:
     return codeGenerator.getBuilder().CreateRetVoid();
   }
 
+  RValue interpret() {
+    interpreter.return_value = interp_zero(interpreter.return_type);
+    if (expression->getNodeType() != NodeType::Unimplemented) {
+      RValue ret_val = expression->interpret();
+      if (!interpreter.return_type->isVoidTy()) {
+        interp_make_store_compatible(interpreter.return_type, ret_val);
+        interpreter.return_value = ret_val;
+      }
+    }
+    interpreter.flow = InterpFlow::RETURN;
+    return RValue();
+  }
+
+  BcValue compileBytecode() {
+    if (expression->getNodeType() == NodeType::Unimplemented) {
+      bytecodeCompiler.emitReturn(nullptr);
+      return BcValue();
+    }
+    BcValue ret_val = expression->compileBytecode();
+    llvm::Type *return_type = bytecodeCompiler.returnType();
+    if (return_type->isVoidTy()) {
+      bytecodeCompiler.emitReturn(nullptr);
+      return BcValue();
+    }
+    ret_val = bytecodeCompiler.makeStoreCompatible(return_type, ret_val);
+    bytecodeCompiler.emitReturn(&ret_val);
+    return BcValue();
+  }
+
 private:
   ASTNode *expression;
 };
@@ -1538,8 +3153,8 @@ class DeclarationListNode : public ASTNode {
 public:
   DeclarationListNode() : ASTNode(NodeType::DeclarationList) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, children, depth, true);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, children, out, true);
   }
 
   ASTNode *optimise() const {
@@ -1560,28 +3175,75 @@ public:
         declaration_specifiers(declaration_specifiers),
         init_declarator_list(init_declarator_list) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {declaration_specifiers, init_declarator_list},
-                          depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {declaration_specifiers, init_declarator_list}, out,
+                   false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {declaration_specifiers, init_declarator_list}) {
+      visit(child);
+    }
   }
 
   bool check_semantics() { return init_declarator_list->check_semantics(); }
 
+  // Nothing is left once every variable declared turns out unused
   ASTNode *optimise() const {
     auto ret = new DeclarationNode(*this);
     ret->declaration_specifiers = declaration_specifiers->optimise();
     ret->init_declarator_list = init_declarator_list->optimise();
+    if (!init_declarator_list->children.empty() &&
+        ret->init_declarator_list->children.empty()) {
+      return new NullPtrNode();
+    }
     return ret;
   }
 
+  void buildFlow() const {
+    optimisationContext.flow.declaring = declaration_specifiers->flowKind();
+    init_declarator_list->buildFlow();
+  }
+
+  string inductionVariable() const {
+    return init_declarator_list->inductionVariable();
+  }
+
+  bool declaresFunction(const string &name) const {
+    return init_declarator_list->declaresFunction(name);
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    evaluation.declaring = declaration_specifiers->flowKind();
+    init_declarator_list->evaluate(evaluation);
+    return m_Value();
+  }
+
   Value *codegen() {
 
     auto type_of_decl = declaration_specifiers->getValueType();
 
+    is_declaration_static = declaration_specifiers->declaresStatic();
+    is_declaration_extern = declaration_specifiers->declaresExtern();
     init_declarator_list->codegen();
+    is_declaration_static = false;
+    is_declaration_extern = false;
     return nullptr;
   }
 
+  RValue interpret() {
+    declaration_specifiers->getValueType();
+    init_declarator_list->interpret();
+    return RValue();
+  }
+
+  BcValue compileBytecode() {
+    declaration_specifiers->getValueType();
+    init_declarator_list->compileBytecode();
+    return BcValue();
+  }
+
 private:
   ASTNode *declaration_specifiers;
   ASTNode *init_declarator_list;
@@ -1594,23 +3256,82 @@ public:
       : ASTNode(NodeType::InitDeclartor), declarator(declarator),
         initializer(initializer) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {declarator, initializer}, depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {declarator, initializer}, out, false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {declarator, initializer}) {
+      visit(child);
+    }
   }
 
+  // An initial value nothing reads is not stored
   ASTNode *optimise() const {
     auto ret = new InitDeclartorNode(*this);
     ret->declarator = declarator->optimise();
     ret->initializer = initializer->optimise();
+    if (initializer->getNodeType() != NodeType::Unimplemented &&
+        optimisationContext.flow.dead_store(this)) {
+      dead_code_stats.stores++;
+      ret->initializer = new NullPtrNode();
+    }
 
     m_Value v = initializer->get_value_if_possible();
     m_Value name = declarator->get_for_optim();
 
-    codeGenerator.put_mval(name.s, v);
+    optimisationContext.put_mval(name.s, v);
 
     return ret;
   }
 
+  bool declaresFunction(const string &name) const {
+    return declarator->declaresFunction(name);
+  }
+
+  string inductionVariable() const {
+    if (declarator->getNodeType() != NodeType::Identifier ||
+        initializer->getNodeType() == NodeType::Unimplemented) {
+      return "";
+    }
+    return declarator->get().s;
+  }
+
+  // Only a plain name is tracked; an array or pointer declarator still
+  // hides an outer variable of the same name
+  void buildFlow() const {
+    FlowAnalysis &flow = optimisationContext.flow;
+    flow.declare(declarator->get().s,
+                 declarator->getNodeType() == NodeType::Identifier
+                     ? flow.declaring
+                     : FlowAnalysis::UNTRACKED);
+    flow.add(this);
+  }
+
+  m_Value flow() const {
+    FlowAnalysis &flow = optimisationContext.flow;
+    size_t effects = flow.effects;
+    m_Value value = initializer->flow();
+    if (declarator->getNodeType() == NodeType::Identifier) {
+      flow.write(declarator->get().s, value,
+                 flow.effects == effects ? this : nullptr);
+    }
+    return m_Value();
+  }
+
+  // The initialiser may call a function that declares variables of its own
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    if (declarator->getNodeType() != NodeType::Identifier) {
+      throw ConstEvalError("Unsupported declarator");
+    }
+    FlowAnalysis::Kind kind = evaluation.declaring;
+    m_Value value = initializer->evaluate(evaluation);
+    evaluation.declaring = kind;
+    evaluation.declare(declarator->get().s, kind, value);
+    return m_Value();
+  }
+
   bool check_semantics() {
 
     if (!declarator->check_semantics()) {
@@ -1661,7 +3382,7 @@ public:
       val = llvm::Constant::getNullValue(declaration_type_copy);
     }
 
-    cout << "Name " << declarator->get().s << endl;
+    CC_LOG(LOG_CODEGEN, "Declaration of " << declarator->get().s);
 
     llvm::Value *alloca = nullptr;
 
@@ -1678,11 +3399,35 @@ public:
         throw std::runtime_error(
             "Global variable must be initialized with a constant");
       }
+      // `long y = 6;`: the initializer has to have the variable's type
+      llvm::Type *init_type = init_val->getType();
+      if (init_type != declaration_type_copy &&
+          (init_type->isIntegerTy() || init_type->isFloatingPointTy()) &&
+          (declaration_type_copy->isIntegerTy() ||
+           declaration_type_copy->isFloatingPointTy())) {
+        init_val = llvm::ConstantExpr::getCast(
+            llvm::CastInst::getCastOpcode(init_val, true,
+                                          declaration_type_copy, true),
+            init_val, declaration_type_copy);
+      }
+
+      // An extern declaration only names the variable; a definition
+      // after it gives it its value
+      llvm::GlobalVariable *global =
+          codeGenerator.global_module->getGlobalVariable(name, true);
+      if (!global || !global->isDeclaration()) {
+        global = new llvm::GlobalVariable(
+            *codeGenerator.global_module, declaration_type_copy, false,
+            llvm::GlobalValue::ExternalLinkage, nullptr, name);
+      }
+      if (!is_declaration_extern) {
+        global->setInitializer(init_val);
+      }
+      if (is_declaration_static) {
+        global->setLinkage(llvm::GlobalValue::InternalLinkage);
+      }
+      alloca = global;
 
-      alloca = new llvm::GlobalVariable(
-          *codeGenerator.global_module, declaration_type_copy, false,
-          llvm::GlobalValue::ExternalLinkage, init_val, name);
-      
     } else {
       alloca = codeGenerator.getBuilder().CreateAlloca(declaration_type_copy,
                                                        nullptr, name);
@@ -1696,6 +3441,70 @@ public:
     return alloca;
   }
 
+  RValue interpret() {
+    llvm::Type *old_type = declaration_type;
+    array_type = nullptr;
+    declarator->modifyDeclarationType();
+    string name = declarator->get().s;
+
+    am_i_initialising = true;
+    declarator->interpret();
+    am_i_initialising = false;
+
+    llvm::Type *declaration_type_copy = declaration_type;
+    declaration_type = old_type;
+
+    if (array_type != nullptr) {
+      declaration_type_copy = array_type;
+    }
+
+    if (interpreter.findFunction(name)) {
+      return RValue();
+    }
+
+    // Storage starts zeroed, which covers arrays without an initialiser
+    char *addr =
+        interpreter.declare(interpreter.intern(name), declaration_type_copy);
+    if (initializer->getNodeType() != NodeType::Unimplemented) {
+      RValue val = initializer->interpret();
+      interp_make_store_compatible(declaration_type_copy, val);
+      interp_store(addr, val);
+    }
+    return RValue();
+  }
+
+  BcValue compileBytecode() {
+    llvm::Type *old_type = declaration_type;
+    array_type = nullptr;
+    declarator->modifyDeclarationType();
+    string name = declarator->get().s;
+
+    am_i_initialising = true;
+    declarator->compileBytecode();
+    am_i_initialising = false;
+
+    llvm::Type *declaration_type_copy = declaration_type;
+    declaration_type = old_type;
+
+    if (array_type != nullptr) {
+      declaration_type_copy = array_type;
+    }
+
+    if (bytecodeCompiler.findFunction(name)) {
+      return BcValue();
+    }
+
+    bool initialised = initializer->getNodeType() != NodeType::Unimplemented;
+    BcVariable var =
+        bytecodeCompiler.declare(name, declaration_type_copy, !initialised);
+    if (initialised) {
+      BcValue val = initializer->compileBytecode();
+      val = bytecodeCompiler.makeStoreCompatible(declaration_type_copy, val);
+      bytecodeCompiler.store(bytecodeCompiler.address(var), val);
+    }
+    return BcValue();
+  }
+
 private:
   ASTNode *declarator;
   ASTNode *initializer;
@@ -1705,8 +3514,8 @@ class InitDeclartorListNode : public ASTNode {
 public:
   InitDeclartorListNode() : ASTNode(NodeType::InitDeclartorList) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, children, depth, true);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, children, out, true);
   }
 
   bool check_semantics() {
@@ -1718,14 +3527,45 @@ public:
     return true;
   }
 
+  string inductionVariable() const {
+    return children.size() == 1 ? children[0]->inductionVariable() : "";
+  }
+
+  bool declaresFunction(const string &name) const {
+    for (auto child : children) {
+      if (child->declaresFunction(name)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
   ASTNode *optimise() const {
     auto ret = new InitDeclartorListNode(*this);
-    for (auto &child : ret->children) {
-      child = child->optimise();
+    ret->children.clear();
+    for (auto child : children) {
+      if (optimisationContext.flow.unused_variable(child)) {
+        dead_code_stats.locals++;
+        continue;
+      }
+      ret->children.push_back(child->optimise());
     }
     return ret;
   }
 
+  void buildFlow() const {
+    for (auto child : children) {
+      child->buildFlow();
+    }
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    for (auto child : children) {
+      child->evaluate(evaluation);
+    }
+    return m_Value();
+  }
+
   Value *codegen() {
     for (auto child : children) {
       llvm::Type *old_type = declaration_type;
@@ -1734,6 +3574,24 @@ public:
     }
     return nullptr;
   }
+
+  RValue interpret() {
+    for (auto child : children) {
+      llvm::Type *old_type = declaration_type;
+      child->interpret();
+      declaration_type = old_type;
+    }
+    return RValue();
+  }
+
+  BcValue compileBytecode() {
+    for (auto child : children) {
+      llvm::Type *old_type = declaration_type;
+      child->compileBytecode();
+      declaration_type = old_type;
+    }
+    return BcValue();
+  }
 };
 
 class DeclaratorNode : public ASTNode {
@@ -1742,13 +3600,15 @@ public:
       : ASTNode(NodeType::Declarator), pointer(pointer),
         direct_declarator(direct_declarator) {}
 
-  string dump_ast(int depth = 0) const {
-    string result = formatSpacing(depth) + "Declarator{\n";
-    result += pointer->dump_ast(depth + 1);
-    result += direct_declarator->dump_ast(depth + 1);
-    result += formatSpacing(depth);
-    result += "}\n";
-    return result;
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {pointer, direct_declarator}, out, false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {pointer, direct_declarator}) {
+      visit(child);
+    }
   }
 
   bool check_semantics() { return direct_declarator->check_semantics(); }
@@ -1759,6 +3619,24 @@ public:
 
   m_Value get() const { return direct_declarator->get(); }
 
+  void constParams(vector<pair<string, FlowAnalysis::Kind>> &params) const {
+    direct_declarator->constParams(params);
+  }
+
+  bool inlineParams(vector<InlineParam> &params) const {
+    return direct_declarator->inlineParams(params);
+  }
+
+  ASTNode *renamed(const string &name) const {
+    auto ret = new DeclaratorNode(*this);
+    ret->direct_declarator = direct_declarator->renamed(name);
+    return ret;
+  }
+
+  bool declaresFunction(const string &name) const {
+    return direct_declarator->declaresFunction(name);
+  }
+
   m_Value get_for_optim() const {
     m_Value val = direct_declarator->get_for_optim();
     val.s = pointer->get_for_optim().s + val.s;
@@ -1788,6 +3666,24 @@ public:
     return val_to_ret;
   }
 
+  void collectFunctionParams() { direct_declarator->collectFunctionParams(); }
+
+  RValue interpret() {
+    auto old_type = declaration_type;
+    pointer->modifyDeclarationType();
+    auto val_to_ret = direct_declarator->interpret();
+    declaration_type = old_type;
+    return val_to_ret;
+  }
+
+  BcValue compileBytecode() {
+    auto old_type = declaration_type;
+    pointer->modifyDeclarationType();
+    auto val_to_ret = direct_declarator->compileBytecode();
+    declaration_type = old_type;
+    return val_to_ret;
+  }
+
 private:
   ASTNode *pointer;
   ASTNode *direct_declarator;
@@ -1825,17 +3721,24 @@ public:
     return ret;
   }
 
-  string dump_ast(int depth = 0) const {
-    string result = formatSpacing(depth) + "Pointer*\n";
+  void dump(AstWriter &out) const {
+    out.open(type, false);
     if (pointer->getNodeType() != NodeType::Unimplemented) {
-      result += pointer->dump_ast(depth);
+      pointer->dump(out);
+    }
+    out.close();
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    if (pointer->getNodeType() != NodeType::Unimplemented) {
+      visit(pointer);
     }
-    return result;
   }
 
   void modifyDeclarationType() {
 
-    cout << "Modifying declaration type for pointer" << endl;
+    CC_LOG(LOG_TYPES, "Declarator is a pointer");
     declaration_type = llvm::PointerType::get(declaration_type, 0);
 
     if (pointer->getNodeType() != NodeType::Unimplemented) {
@@ -1854,9 +3757,16 @@ public:
       : ASTNode(NodeType::ArrayDeclarator),
         direct_declarator(direct_declarator),
         assignment_expression(assignment_expression) {}
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {direct_declarator, assignment_expression},
-                          depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {direct_declarator, assignment_expression}, out,
+                   false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {direct_declarator, assignment_expression}) {
+      visit(child);
+    }
   }
 
   void modifyDeclarationType() { direct_declarator->modifyDeclarationType(); }
@@ -1867,12 +3777,12 @@ public:
       return m_Value();
     m_Value val = get_for_optim();
 
-    return codeGenerator.get_mval(val.s);
+    return optimisationContext.get_mval(val.s);
   }
 
   m_Value get_for_optim() const {
     m_Value val = direct_declarator->get_for_optim();
-    val.s += "[" + assignment_expression->dump_ast() + "]";
+    val.s += "[#" + to_string(assignment_expression->expr_id()) + "]";
     return val;
   }
 
@@ -1926,6 +3836,51 @@ public:
     /* return alloca; */
   }
 
+  RValue interpret() {
+
+    direct_declarator->interpret();
+
+    uint64_t array_size_val = 0;
+    if (assignment_expression->getNodeType() != NodeType::Unimplemented) {
+      RValue array_size = assignment_expression->interpret();
+      if (!array_size.type->isIntegerTy()) {
+        throw std::runtime_error("Array size is not an integer");
+      }
+      array_size_val = array_size.i;
+    }
+
+    if (array_type == nullptr) {
+      array_type = declaration_type;
+    }
+
+    array_type = llvm::ArrayType::get(array_type, array_size_val);
+
+    return RValue();
+  }
+
+  // Frame layout is fixed at compile time, so the size has to be constant
+  BcValue compileBytecode() {
+
+    direct_declarator->compileBytecode();
+
+    uint64_t array_size_val = 0;
+    if (assignment_expression->getNodeType() != NodeType::Unimplemented) {
+      auto array_size = assignment_expression->get_value_if_possible();
+      if (array_size.type != ActualValueType::INTEGER) {
+        throw std::runtime_error("Array size is not an integer constant");
+      }
+      array_size_val = array_size.i;
+    }
+
+    if (array_type == nullptr) {
+      array_type = declaration_type;
+    }
+
+    array_type = llvm::ArrayType::get(array_type, array_size_val);
+
+    return BcValue();
+  }
+
 private:
   ASTNode *direct_declarator;
   ASTNode *assignment_expression;
@@ -1939,14 +3894,30 @@ public:
         direct_declarator(direct_declarator),
         parameter_type_list(parameter_type_list) {}
 
-  string dump_ast(int depth = 0) const {
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {direct_declarator, parameter_type_list}, out, false);
+  }
 
-    return dumpParameters(this, {direct_declarator, parameter_type_list}, depth,
-                          false);
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {direct_declarator, parameter_type_list}) {
+      visit(child);
+    }
   }
 
   m_Value get() const { return direct_declarator->get(); }
 
+  ASTNode *renamed(const string &name) const {
+    auto ret = new FunctionDeclarationNode(*this);
+    ret->direct_declarator = direct_declarator->renamed(name);
+    return ret;
+  }
+
+  bool declaresFunction(const string &name) const {
+    return direct_declarator->getNodeType() == NodeType::Identifier &&
+           direct_declarator->get().s == name;
+  }
+
   m_Value get_value_if_possible() const { return m_Value(); }
 
   ASTNode *optimise() const {
@@ -1977,6 +3948,17 @@ public:
     parameter_type_list->buildFunctionParams(function_decl);
   }
 
+  void constParams(vector<pair<string, FlowAnalysis::Kind>> &params) const {
+    if (parameter_type_list->getNodeType() != NodeType::Unimplemented) {
+      parameter_type_list->constParams(params);
+    }
+  }
+
+  bool inlineParams(vector<InlineParam> &params) const {
+    return parameter_type_list->getNodeType() == NodeType::Unimplemented ||
+           parameter_type_list->inlineParams(params);
+  }
+
   Value *codegen() {
 
     global_is_variadic = false;
@@ -2003,6 +3985,55 @@ public:
     return nullptr;
   }
 
+  void collectFunctionParams() {
+    if (parameter_type_list->getNodeType() == NodeType::Unimplemented) {
+      return;
+    }
+    parameter_type_list->collectFunctionParams();
+  }
+
+  // Records the prototype; its body is looked up when it is first called
+  RValue interpret() {
+
+    global_is_variadic = false;
+
+    string func_name = direct_declarator->get().s;
+    if (interpreter.findFunction(func_name)) {
+      return RValue();
+    }
+
+    llvm::Type *current_type = declaration_type;
+
+    function_params.clear();
+    fixFunctionParams();
+
+    InterpFunction function;
+    function.type = llvm::FunctionType::get(current_type, function_params,
+                                            global_is_variadic);
+    interpreter.functions[func_name] = function;
+    return RValue();
+  }
+
+  BcValue compileBytecode() {
+
+    global_is_variadic = false;
+
+    string func_name = direct_declarator->get().s;
+    if (bytecodeCompiler.findFunction(func_name)) {
+      return BcValue();
+    }
+
+    llvm::Type *current_type = declaration_type;
+
+    function_params.clear();
+    fixFunctionParams();
+
+    bytecodeCompiler.declareFunction(
+        func_name, llvm::FunctionType::get(current_type, function_params,
+                                           global_is_variadic));
+    return BcValue();
+  }
+
 private:
   ASTNode *direct_declarator;
   ASTNode *parameter_type_list;
@@ -2012,8 +4043,8 @@ class ParameterListNode : public ASTNode {
 public:
   ParameterListNode() : ASTNode(NodeType::ParameterList) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, children, depth, true);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, children, out, true);
   }
 
   m_Value get_value_if_possible() const { return m_Value(); }
@@ -2048,6 +4079,33 @@ public:
       parameter_list_index += 1;
     }
   }
+
+  void constParams(vector<pair<string, FlowAnalysis::Kind>> &params) const {
+    if (variadic) {
+      throw ConstEvalError("Variadic function");
+    }
+    for (auto child : children) {
+      child->constParams(params);
+    }
+  }
+
+  bool inlineParams(vector<InlineParam> &params) const {
+    if (variadic) {
+      return false;
+    }
+    for (auto child : children) {
+      if (!child->inlineParams(params)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void collectFunctionParams() {
+    for (auto child : children) {
+      child->collectFunctionParams();
+    }
+  }
 };
 
 class ParameterDeclarationNode : public ASTNode {
@@ -2064,9 +4122,15 @@ public:
 
   m_Value get_value_if_possible() const { return m_Value(); }
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {declaration_specifiers, declarator}, depth,
-                          false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {declaration_specifiers, declarator}, out, false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {declaration_specifiers, declarator}) {
+      visit(child);
+    }
   }
 
   bool check_semantics() { return declarator->check_semantics(); }
@@ -2091,6 +4155,44 @@ public:
     codeGenerator.getsymbolTable().add_to_carryover(name, p);
   }
 
+  void constParams(vector<pair<string, FlowAnalysis::Kind>> &params) const {
+    if (declarator->getNodeType() == NodeType::Unimplemented) {
+      return;
+    }
+    if (declarator->getNodeType() != NodeType::Identifier) {
+      params.push_back({declarator->get().s, FlowAnalysis::UNTRACKED});
+      return;
+    }
+    params.push_back({declarator->get().s, declaration_specifiers->flowKind()});
+  }
+
+  // An int, or a pointer to one
+  bool inlineParams(vector<InlineParam> &params) const {
+    if (declarator->getNodeType() == NodeType::Unimplemented) {
+      return true;
+    }
+    InlineParam param;
+    param.name = declarator->get().s;
+    param.kind = declaration_specifiers->flowKind();
+    param.pointer = declarator->getNodeType() != NodeType::Identifier;
+    if (param.kind != FlowAnalysis::INT ||
+        (param.pointer && declarator->get_for_optim().s != "*" + param.name)) {
+      return false;
+    }
+    params.push_back(param);
+    return true;
+  }
+
+  // `f(void)` has no named parameter to bind
+  void collectFunctionParams() {
+    if (declarator->getNodeType() == NodeType::Unimplemented) {
+      return;
+    }
+    declaration_type = declaration_specifiers->getValueType();
+    declarator->modifyDeclarationType();
+    interpreter.pending_params.push_back({declarator->get().s, declaration_type});
+  }
+
 private:
   ASTNode *declaration_specifiers;
   ASTNode *declarator;
@@ -2101,29 +4203,77 @@ public:
   IdentifierNode(std::string name)
       : ASTNode(NodeType::Identifier), name(name) {}
 
-  string dump_ast(int depth = 0) const {
-    string result = "";
-    result += formatSpacing(depth);
-    result += "Identifier: " + name + "\n";
-    return result;
-  }
+  void dump(AstWriter &out) const { out.leaf(type, name); }
 
   vector<string> getPlainSymbol() const { return {name}; }
 
   m_Value get() const { return m_Value(name); }
 
+  uint32_t expr_id() const { return expr_table.intern((int)type, 0, name, {}); }
+
   bool check_semantics() { return scoperStack.exists(name); }
 
   void modifyDeclarationType() {}
 
+  // Inside a function body, what the flow analysis found this read to be
   m_Value get_value_if_possible() const {
 
+    if (optimisationContext.flow.active())
+      return optimisationContext.flow.fact(this);
     if (!constant_prop)
       return m_Value();
-    return codeGenerator.get_mval(name);
+    return optimisationContext.get_mval(name);
+  }
+
+  // A function named here escapes the call sites seeding its parameters
+  m_Value flow() const {
+    FlowAnalysis &flow = optimisationContext.flow;
+    if (flow.replaying()) {
+      call_sites.escape(name);
+    }
+    return flow.read(this, name);
+  }
+
+  ASTNode *renamed(const string &name) const { return new IdentifierNode(name); }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    return evaluation.load(name);
+  }
+
+  bool branchless(unsigned &budget) const { return branchless_node(budget); }
+
+  // Only the parameters can be named. The argument replaces the first use;
+  // further ones copy it, when it is a constant or a variable.
+  ASTNode *inlined(InlineFrame &frame, FlowAnalysis::Kind &kind) const {
+    ASTNode *arg;
+    InlineParam *param = frame.find(name, arg);
+    if (!param) {
+      return nullptr;
+    }
+    kind = param->pointer ? FlowAnalysis::UNTRACKED : param->kind;
+    if (!arg) {
+      param->uses++;
+      return new IdentifierNode(name);
+    }
+    if (param->uses++ == 0) {
+      return arg;
+    }
+    if (arg->getNodeType() == NodeType::Identifier) {
+      return new IdentifierNode(arg->get().s);
+    }
+    m_Value value = arg->get_value_if_possible();
+    return value.type == ActualValueType::INTEGER ? new IConstantNode(value.i)
+                                                  : nullptr;
   }
 
   ASTNode *optimise() const {
+    m_Value v = optimisationContext.flow.fact(this);
+    if (v.type == ActualValueType::INTEGER) {
+      return fold(this, v);
+    }
+    if (v.type == ActualValueType::FLOATING) {
+      return fold(this, v);
+    }
     auto ret = new IdentifierNode(*this);
     return ret;
   }
@@ -2148,16 +4298,63 @@ public:
     return codeGenerator.getBuilder().CreateLoad(val_type, val, name.c_str());
   }
 
+  RValue interpret() {
+
+    if (am_i_initialising) {
+      return RValue();
+    }
+
+    if (interp_id == SIZE_MAX) {
+      interp_id = interpreter.intern(name);
+    }
+    const InterpVariable *val = interpreter.find(interp_id);
+
+    if (val == nullptr) {
+      throw std::runtime_error("Variable " + name + " has not been declared.");
+    }
+
+    if (get_as_lvalue) {
+      return RValue::pointer(val->address_type, val->addr);
+    }
+
+    return interp_load(val->addr, val->type);
+  }
+
+  BcValue compileBytecode() {
+
+    if (am_i_initialising) {
+      return BcValue();
+    }
+
+    const BcVariable *val = bytecodeCompiler.find(name);
+
+    if (val == nullptr && bytecodeCompiler.findFunction(name)) {
+      return bytecodeCompiler.trap(
+          llvm::Type::getInt8PtrTy(codeGenerator.getContext()),
+          "Function pointers are not supported");
+    }
+    if (val == nullptr) {
+      throw std::runtime_error("Variable " + name + " has not been declared.");
+    }
+
+    if (get_as_lvalue) {
+      return bytecodeCompiler.address(*val);
+    }
+
+    return bytecodeCompiler.load(bytecodeCompiler.address(*val));
+  }
+
 private:
   string name;
+  size_t interp_id = SIZE_MAX;
 };
 
 class ExpressionListNode : public ASTNode {
 public:
   ExpressionListNode() : ASTNode(NodeType::ExpressionList) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, children, depth, true);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, children, out, true);
   }
 
   m_Value get_value_if_possible() const {
@@ -2167,6 +4364,51 @@ public:
     return m_Value();
   }
 
+  string inductionVariable() const {
+    return children.size() == 1 ? children[0]->inductionVariable() : "";
+  }
+
+  m_Value flow() const {
+    m_Value value;
+    for (auto child : children) {
+      value = child->flow();
+    }
+    return value;
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    m_Value value;
+    for (auto child : children) {
+      value = child->evaluate(evaluation);
+    }
+    return value;
+  }
+
+  uint32_t expr_id() const {
+    vector<uint32_t> operands;
+    for (auto child : children) {
+      operands.push_back(child->expr_id());
+    }
+    return expr_table.intern((int)type, operands);
+  }
+
+  bool branchless(unsigned &budget) const {
+    return children.size() == 1 && children[0]->branchless(budget);
+  }
+
+  ASTNode *inlined(InlineFrame &frame, FlowAnalysis::Kind &kind) const {
+    if (children.size() != 1) {
+      return nullptr;
+    }
+    ASTNode *inner = inline_expression(children[0], frame, kind);
+    if (!inner) {
+      return nullptr;
+    }
+    auto ret = new ExpressionListNode();
+    ret->addChild(inner);
+    return ret;
+  }
+
   ASTNode *optimise() const {
     auto ret = new ExpressionListNode(*this);
     for (auto &child : ret->children) {
@@ -2200,6 +4442,24 @@ public:
     }
     return val;
   }
+
+  RValue interpret() {
+    RValue val;
+
+    for (auto child : children) {
+      val = child->interpret();
+    }
+    return val;
+  }
+
+  BcValue compileBytecode() {
+    BcValue val;
+
+    for (auto child : children) {
+      val = child->compileBytecode();
+    }
+    return val;
+  }
 };
 
 class AssignmentExpressionNode : public ASTNode {
@@ -2210,13 +4470,19 @@ public:
         unary_expression(unary_expression), assOp(assOp),
         assignment_expression(assignment_expression) {}
 
-  string dump_ast(int depth = 0) const {
-    string result = formatSpacing(depth);
-    result += assignmentOperatorToString(assOp) + "{ \n";
-    result += unary_expression->dump_ast(depth + 1);
-    result += assignment_expression->dump_ast(depth + 1);
-    result += formatSpacing(depth) + "} \n";
-    return result;
+  void dump(AstWriter &out) const {
+    out.open(type, false);
+    out.property("operator", assignmentOperatorToString(assOp));
+    unary_expression->dump(out);
+    assignment_expression->dump(out);
+    out.close();
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {unary_expression, assignment_expression}) {
+      visit(child);
+    }
   }
 
   bool check_semantics() {
@@ -2228,38 +4494,12 @@ public:
     return assignment_expression->getPlainSymbol();
   }
 
-  m_Value get_value_if_possible() const {
-    return unary_expression->get_value_if_possible();
-  }
-
-  ASTNode *optimise() const {
-
-    auto ret = new AssignmentExpressionNode(*this);
+  // Folding an assignment away would drop the store
+  m_Value get_value_if_possible() const { return m_Value(); }
 
-    /* vector<string> lhs_names = unary_expression->getPlainSymbol(); */
-    /* vector<string> rhs_names = assignment_expression->getPlainSymbol(); */
-
-    /* for (auto &name : rhs_names) { */
-    /*   if (name == "*") { */
-    /*     return ret; */
-    /*   } */
-    /* } */
-    /**/
-    /* for (auto &name : lhs_names) { */
-    /*   for (auto &name2 : rhs_names) { */
-    /*     if (name == name2) { */
-    /*       return ret; */
-    /*     } */
-    /*   } */
-    /* } */
-    /**/
-    m_Value lhs_name = unary_expression->get_for_optim();
-    ret->assignment_expression = assignment_expression->optimise();
-
-    m_Value rhs = ret->assignment_expression->get_value_if_possible();
-    m_Value lhs = ret->unary_expression->get_value_if_possible();
-
-    m_Value v = m_Value();
+  // Value stored by the operator, given the old value and the right side
+  m_Value combine(const m_Value &lhs, const m_Value &rhs) const {
+    m_Value v = m_Value();
 
     switch (assOp) {
     case AssignmentOperator::ASSIGN: {
@@ -2308,6 +4548,97 @@ public:
       break;
     }
     }
+    return v;
+  }
+
+  // The stored value is noted when the right side has no effects, so that
+  // optimise() can replace it with the constant
+  m_Value flow() const {
+    FlowAnalysis &flow = optimisationContext.flow;
+    size_t effects = flow.effects;
+    m_Value rhs = assignment_expression->flow();
+    if (unary_expression->getNodeType() != NodeType::Identifier) {
+      unary_expression->flow();
+      flow.effects++;
+      return m_Value();
+    }
+    string name = unary_expression->get().s;
+    m_Value v = assOp == AssignmentOperator::ASSIGN
+                    ? rhs
+                    : combine(flow.current_value(name), rhs);
+    bool pure = flow.effects == effects;
+    v = flow.write(name, v, pure ? this : nullptr);
+    if (pure) {
+      flow.note(this, v);
+    }
+    flow.effects++;
+    return v;
+  }
+
+  string inductionVariable() const {
+    if (assOp != AssignmentOperator::ASSIGN ||
+        unary_expression->getNodeType() != NodeType::Identifier) {
+      return "";
+    }
+    return unary_expression->get().s;
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    if (unary_expression->getNodeType() != NodeType::Identifier) {
+      throw ConstEvalError("Only locals can be assigned at compile time");
+    }
+    string name = unary_expression->get().s;
+    m_Value rhs = evaluation.check(assignment_expression->evaluate(evaluation));
+    if (assOp == AssignmentOperator::ASSIGN) {
+      return evaluation.store(name, rhs);
+    }
+    m_Value lhs = evaluation.load(name);
+    switch (assOp) {
+    case AssignmentOperator::DIV_ASSIGN:
+    case AssignmentOperator::MOD_ASSIGN:
+      evaluation.divisor(lhs, rhs);
+      break;
+    case AssignmentOperator::LEFT_ASSIGN:
+    case AssignmentOperator::RIGHT_ASSIGN:
+      evaluation.shift(rhs);
+      break;
+    default:
+      break;
+    }
+    return evaluation.store(name, combine(lhs, rhs));
+  }
+
+  ASTNode *optimise() const {
+
+    auto ret = new AssignmentExpressionNode(*this);
+
+    /* vector<string> lhs_names = unary_expression->getPlainSymbol(); */
+    /* vector<string> rhs_names = assignment_expression->getPlainSymbol(); */
+
+    /* for (auto &name : rhs_names) { */
+    /*   if (name == "*") { */
+    /*     return ret; */
+    /*   } */
+    /* } */
+    /**/
+    /* for (auto &name : lhs_names) { */
+    /*   for (auto &name2 : rhs_names) { */
+    /*     if (name == name2) { */
+    /*       return ret; */
+    /*     } */
+    /*   } */
+    /* } */
+    /**/
+    m_Value lhs_name = unary_expression->get_for_optim();
+    ret->assignment_expression = assignment_expression->optimise();
+
+    m_Value rhs = ret->assignment_expression->get_value_if_possible();
+    m_Value lhs = ret->unary_expression->get_value_if_possible();
+
+    m_Value v = combine(lhs, rhs);
+    if (v.type == ActualValueType::NO_VALUE) {
+      v = optimisationContext.flow.fact(this);
+    }
     if (v.type == ActualValueType::INTEGER) {
       ret->assOp = AssignmentOperator::ASSIGN;
       ret->assignment_expression = new IConstantNode(v.i);
@@ -2316,7 +4647,7 @@ public:
       ret->assignment_expression = new FConstantNode(v.f);
     }
 
-    codeGenerator.put_mval(lhs_name.s, v);
+    optimisationContext.put_mval(lhs_name.s, v);
 
     return ret;
   }
@@ -2480,6 +4811,130 @@ public:
     return rhsValue;
   }
 
+  RValue interpret() {
+    RValue rhsValue = assignment_expression->interpret();
+
+    get_as_lvalue = true;
+    RValue lhsAddr = unary_expression->interpret();
+    get_as_lvalue = false;
+
+    if (!lhsAddr.type->isPointerTy()) {
+      throw std::runtime_error("Assignment to a non-lvalue");
+    }
+    llvm::Type *lhsType = lhsAddr.type->getPointerElementType();
+
+    InterpOp op;
+    switch (assOp) {
+    case AssignmentOperator::ASSIGN:
+      interp_make_store_compatible(lhsType, rhsValue);
+      interp_store(lhsAddr.p, rhsValue);
+      return rhsValue;
+    case AssignmentOperator::MUL_ASSIGN:
+      op = InterpOp::MUL;
+      break;
+    case AssignmentOperator::DIV_ASSIGN:
+      op = InterpOp::DIV;
+      break;
+    case AssignmentOperator::MOD_ASSIGN:
+      op = InterpOp::MOD;
+      break;
+    case AssignmentOperator::ADD_ASSIGN:
+      op = InterpOp::ADD;
+      break;
+    case AssignmentOperator::SUB_ASSIGN:
+      op = InterpOp::SUB;
+      break;
+    case AssignmentOperator::LEFT_ASSIGN:
+      op = InterpOp::SHL;
+      break;
+    case AssignmentOperator::RIGHT_ASSIGN:
+      op = InterpOp::SHR;
+      break;
+    case AssignmentOperator::AND_ASSIGN:
+      op = InterpOp::AND;
+      break;
+    case AssignmentOperator::XOR_ASSIGN:
+      op = InterpOp::XOR;
+      break;
+    case AssignmentOperator::OR_ASSIGN:
+      op = InterpOp::OR;
+      break;
+    default:
+      throw std::runtime_error("Unsupported assignment operator.");
+    }
+
+    RValue lhsVal = interp_load(lhsAddr.p, lhsType);
+    RValue result = interp_binary(op, lhsVal, rhsValue);
+    interp_make_store_compatible(lhsType, result);
+    interp_store(lhsAddr.p, result);
+
+    // As in codegen, a compound assignment evaluates to its right-hand side
+    // after the operands were made compatible
+    if (!lhsVal.type->isPointerTy()) {
+      interp_make_lhs_rhs_compatible(lhsVal, rhsValue);
+    }
+    return rhsValue;
+  }
+
+  // A compound assignment evaluates to the stored value here, as in C: the
+  // right-hand side may have been folded into an immediate operand
+  BcValue compileBytecode() {
+    BcValue rhsValue = assignment_expression->compileBytecode();
+
+    get_as_lvalue = true;
+    BcValue lhsAddr = unary_expression->compileBytecode();
+    get_as_lvalue = false;
+
+    if (!lhsAddr.type->isPointerTy()) {
+      throw std::runtime_error("Assignment to a non-lvalue");
+    }
+    llvm::Type *lhsType = lhsAddr.type->getPointerElementType();
+
+    InterpOp op;
+    switch (assOp) {
+    case AssignmentOperator::ASSIGN:
+      return bytecodeCompiler.store(
+          lhsAddr, bytecodeCompiler.makeStoreCompatible(lhsType, rhsValue));
+    case AssignmentOperator::MUL_ASSIGN:
+      op = InterpOp::MUL;
+      break;
+    case AssignmentOperator::DIV_ASSIGN:
+      op = InterpOp::DIV;
+      break;
+    case AssignmentOperator::MOD_ASSIGN:
+      op = InterpOp::MOD;
+      break;
+    case AssignmentOperator::ADD_ASSIGN:
+      op = InterpOp::ADD;
+      break;
+    case AssignmentOperator::SUB_ASSIGN:
+      op = InterpOp::SUB;
+      break;
+    case AssignmentOperator::LEFT_ASSIGN:
+      op = InterpOp::SHL;
+      break;
+    case AssignmentOperator::RIGHT_ASSIGN:
+      op = InterpOp::SHR;
+      break;
+    case AssignmentOperator::AND_ASSIGN:
+      op = InterpOp::AND;
+      break;
+    case AssignmentOperator::XOR_ASSIGN:
+      op = InterpOp::XOR;
+      break;
+    case AssignmentOperator::OR_ASSIGN:
+      op = InterpOp::OR;
+      break;
+    default:
+      throw std::runtime_error("Unsupported assignment operator.");
+    }
+
+    BcValue result = bytecodeCompiler.binary(
+        op, bytecodeCompiler.load(lhsAddr), rhsValue);
+    return bytecodeCompiler.store(
+        lhsAddr, bytecodeCompiler.makeStoreCompatible(lhsType, result));
+  }
+
 private:
   ASTNode *unary_expression;
   AssignmentOperator assOp;
@@ -2492,8 +4947,15 @@ public:
       : ASTNode(NodeType::ArrayAccess), postfix_expression(postfix_expression),
         expression(expression) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {postfix_expression, expression}, depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {postfix_expression, expression}, out, false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {postfix_expression, expression}) {
+      visit(child);
+    }
   }
 
   vector<string> getPlainSymbol() const {
@@ -2511,9 +4973,14 @@ public:
 
   m_Value get() const { return postfix_expression->get(); }
 
+  uint32_t expr_id() const {
+    return expr_table.intern((int)type, {postfix_expression->expr_id(),
+                                         expression->expr_id()});
+  }
+
   m_Value get_for_optim() const {
     m_Value val = postfix_expression->get_for_optim();
-    val.s += "[" + expression->dump_ast() + "]";
+    val.s += "[#" + to_string(expression->expr_id()) + "]";
     return val;
   }
 
@@ -2522,8 +4989,35 @@ public:
     if (!constant_prop)
       return m_Value();
     m_Value v = get();
-    v.s += "[" + expression->dump_ast() + "]";
-    return codeGenerator.get_mval(v.s);
+    v.s += "[#" + to_string(expression->expr_id()) + "]";
+    return optimisationContext.get_mval(v.s);
+  }
+
+  // Elements are memory, which the flow analysis does not track
+  m_Value flow() const {
+    postfix_expression->flow();
+    expression->flow();
+    return m_Value();
+  }
+
+  // Only an int parameter indexed with an int is read
+  ASTNode *inlined(InlineFrame &frame, FlowAnalysis::Kind &kind) const {
+    ASTNode *arg;
+    InlineParam *param =
+        postfix_expression->getNodeType() == NodeType::Identifier
+            ? frame.find(postfix_expression->get().s, arg)
+            : nullptr;
+    if (!param || !param->pointer || param->kind != FlowAnalysis::INT) {
+      return nullptr;
+    }
+    FlowAnalysis::Kind base_kind, index_kind;
+    ASTNode *base = inline_expression(postfix_expression, frame, base_kind);
+    ASTNode *index = inline_expression(expression, frame, index_kind);
+    if (!base || !index || index_kind != FlowAnalysis::INT) {
+      return nullptr;
+    }
+    kind = FlowAnalysis::INT;
+    return new ArrayAccessNode(base, index);
   }
 
   ASTNode *optimise() const {
@@ -2537,7 +5031,7 @@ public:
 
   Value *codegen() {
 
-    cout << "Array access node" << endl;
+    CC_LOG(LOG_CODEGEN, "Array access");
 
     bool prev_get_as_lvalue = get_as_lvalue;
     get_as_lvalue = true;
@@ -2560,7 +5054,7 @@ public:
       llvm::Value *val_to_ret = codeGenerator.getBuilder().CreateGEP(
           element_type, postFixValue, {zero_val, indexValue}, "geparray");
 
-      cout << "Jeeelo" << endl;
+      CC_LOG(LOG_CODEGEN, "Array access indexes an array in place");
 
       if (get_as_lvalue)
         return val_to_ret;
@@ -2599,6 +5093,82 @@ public:
      */
   }
 
+  RValue interpret() {
+    bool prev_get_as_lvalue = get_as_lvalue;
+    get_as_lvalue = true;
+    RValue postFixValue = postfix_expression->interpret();
+    get_as_lvalue = false;
+    RValue indexValue = expression->interpret();
+    get_as_lvalue = prev_get_as_lvalue;
+
+    if (!postFixValue.type->isPointerTy()) {
+      throw std::runtime_error("Array access on non-pointer type");
+    }
+    if (!indexValue.type->isIntegerTy()) {
+      throw std::runtime_error("Array index is not an integer");
+    }
+
+    llvm::Type *element_type = postFixValue.type->getPointerElementType();
+    char *base = postFixValue.p;
+    if (llvm::isa<llvm::ArrayType>(element_type)) {
+      element_type = element_type->getArrayElementType();
+    } else {
+      RValue load_pointer = interp_load(base, element_type);
+      if (!load_pointer.type->isPointerTy()) {
+        throw std::runtime_error("Array access on non-pointer type");
+      }
+      base = load_pointer.p;
+      element_type = load_pointer.type->getPointerElementType();
+    }
+
+    char *address = base + indexValue.i * (int64_t)interp_size(element_type);
+    if (get_as_lvalue) {
+      return RValue::pointer(llvm::PointerType::get(element_type, 0), address);
+    }
+    return interp_load(address, element_type);
+  }
+
+  BcValue compileBytecode() {
+    return bytecodeCompiler.reuse(expr_id(), get_as_lvalue,
+                                  [this]() { return compileAccess(); });
+  }
+
+  BcValue compileAccess() {
+    bool prev_get_as_lvalue = get_as_lvalue;
+    get_as_lvalue = true;
+    BcValue postFixValue = postfix_expression->compileBytecode();
+    get_as_lvalue = false;
+    BcValue indexValue = expression->compileBytecode();
+    get_as_lvalue = prev_get_as_lvalue;
+
+    if (!postFixValue.type->isPointerTy()) {
+      throw std::runtime_error("Array access on non-pointer type");
+    }
+    if (!indexValue.type->isIntegerTy()) {
+      throw std::runtime_error("Array index is not an integer");
+    }
+
+    llvm::Type *element_type = postFixValue.type->getPointerElementType();
+    BcValue base = postFixValue;
+    if (llvm::isa<llvm::ArrayType>(element_type)) {
+      element_type = element_type->getArrayElementType();
+    } else {
+      base = bytecodeCompiler.load(postFixValue);
+      if (!base.type->isPointerTy()) {
+        throw std::runtime_error("Array access on non-pointer type");
+      }
+      element_type = base.type->getPointerElementType();
+    }
+
+    BcValue address = bytecodeCompiler.index(
+        BcValue(llvm::PointerType::get(element_type, 0), base.reg), indexValue,
+        interp_size(element_type));
+    if (get_as_lvalue) {
+      return address;
+    }
+    return bytecodeCompiler.load(address);
+  }
+
 private:
   ASTNode *postfix_expression;
   ASTNode *expression;
@@ -2611,9 +5181,16 @@ public:
       : ASTNode(NodeType::FunctionCall), postfix_expression(postfix_expression),
         argument_expression_list(argument_expression_list) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {postfix_expression, argument_expression_list},
-                          depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {postfix_expression, argument_expression_list}, out,
+                   false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {postfix_expression, argument_expression_list}) {
+      visit(child);
+    }
   }
 
   vector<string> getPlainSymbol() const { return {"*"}; }
@@ -2623,10 +5200,126 @@ public:
            argument_expression_list->check_semantics();
   }
 
-  m_Value get_value_if_possible() const { return m_Value(); }
-  ASTNode *optimise() const { 
-    auto ret = new FunctionCallNode(*this); 
+  // A call to a pure function with constant arguments is evaluated at
+  // compile time (consteval.h). FConstantNode only holds a float, so a
+  // result that is not one is left alone.
+  m_Value get_value_if_possible() const {
+    if (postfix_expression->getNodeType() != NodeType::Identifier) {
+      return m_Value();
+    }
+    string name = postfix_expression->get().s;
+    if (!pure_functions.definition(name)) {
+      return m_Value();
+    }
+    vector<m_Value> args;
+    for (auto arg : arguments()) {
+      m_Value value = arg->get_value_if_possible();
+      if (value.type != ActualValueType::INTEGER &&
+          value.type != ActualValueType::FLOATING) {
+        return m_Value();
+      }
+      args.push_back(value);
+    }
+
+    m_Value result;
+    string key = PureFunctions::callKey(name, args);
+    if (!pure_functions.remembered(key, result, true)) {
+      try {
+        ConstEvaluation evaluation;
+        result = call(evaluation, name, args);
+      } catch (const ConstEvalError &) {
+        pure_functions.remember(key, m_Value());
+        return m_Value();
+      }
+    }
+    if (result.type == ActualValueType::FLOATING &&
+        (double)(float)result.f != result.f) {
+      return m_Value();
+    }
+    return result;
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    if (postfix_expression->getNodeType() != NodeType::Identifier) {
+      throw ConstEvalError("Calls through function pointers are not "
+                           "evaluated");
+    }
+    vector<m_Value> args;
+    for (auto arg : arguments()) {
+      args.push_back(evaluation.check(arg->evaluate(evaluation)));
+    }
+    string name = postfix_expression->get().s;
+    m_Value result;
+    if (pure_functions.remembered(PureFunctions::callKey(name, args), result,
+                                  false)) {
+      return result;
+    }
+    return call(evaluation, name, args);
+  }
+
+  // Runs the definition of `name`; the result is remembered for later calls
+  static m_Value call(ConstEvaluation &evaluation, const string &name,
+                      const vector<m_Value> &args) {
+    const ASTNode *function = pure_functions.definition(name);
+    if (!function) {
+      throw ConstEvalError(name + " has no definition");
+    }
+    m_Value result = function->evaluateCall(evaluation, args);
+    pure_functions.remember(PureFunctions::callKey(name, args), result);
+    return result;
+  }
+
+  // A call cannot reach a tracked local, whose address is never taken; one
+  // evaluated at compile time has no effects at all. The arguments of any
+  // other direct call are recorded for the callee (interproc.h).
+  m_Value flow() const {
+    FlowAnalysis &flow = optimisationContext.flow;
+    vector<m_Value> args;
+    for (auto arg : arguments()) {
+      args.push_back(arg->flow());
+    }
+    m_Value value = get_value_if_possible();
+    if (value.type != ActualValueType::NO_VALUE) {
+      return value;
+    }
+    flow.effects++;
+    if (flow.replaying() &&
+        postfix_expression->getNodeType() == NodeType::Identifier) {
+      call_sites.call(postfix_expression->get().s, args);
+    }
+    return value;
+  }
+
+  ASTNode *optimise() const {
+    m_Value v = get_value_if_possible();
+    if (v.type == ActualValueType::INTEGER) {
+      return fold(this, v);
+    }
+    if (v.type == ActualValueType::FLOATING) {
+      return fold(this, v);
+    }
+    auto ret = new FunctionCallNode(*this);
     ret->argument_expression_list = argument_expression_list->optimise();
+
+    if (postfix_expression->getNodeType() == NodeType::Identifier) {
+      ASTNode *body = inline_call(postfix_expression->get().s, arguments(),
+                                  ret->arguments());
+      if (body) {
+        return body;
+      }
+    }
+
+    // A call with the constants of a clone calls the clone
+    if (postfix_expression->getNodeType() == NodeType::Identifier) {
+      vector<m_Value> args;
+      for (auto arg : ret->arguments()) {
+        args.push_back(arg->get_value_if_possible());
+      }
+      string clone = call_sites.cloneFor(postfix_expression->get().s, args);
+      if (!clone.empty()) {
+        ret->postfix_expression = new IdentifierNode(clone);
+      }
+    }
     return ret;
   }
 
@@ -2660,9 +5353,51 @@ public:
                                                  function_name + "_call");
   }
 
+  RValue interpret() {
+    string function_name = postfix_expression->get().s;
+
+    InterpFunction *function = interpreter.findFunction(function_name);
+
+    if (function == nullptr) {
+      throw std::runtime_error("Function " + function_name + " not found.");
+    }
+
+    vector<RValue> arguments;
+    for (auto arg : argument_expression_list->getChildren()) {
+      arguments.push_back(arg->interpret());
+    }
+
+    if (function->definition) {
+      return function->definition->invoke(arguments);
+    }
+    return interpreter.callNative(function_name, *function, arguments);
+  }
+
+  BcValue compileBytecode() {
+    // Only reached if the call runs, like the error interpret() raises
+    if (postfix_expression->getNodeType() != NodeType::Identifier) {
+      return bytecodeCompiler.trap(
+          llvm::Type::getInt32Ty(codeGenerator.getContext()),
+          "Calls through function pointers are not supported");
+    }
+
+    vector<BcValue> arguments;
+    for (auto arg : argument_expression_list->getChildren()) {
+      arguments.push_back(arg->compileBytecode());
+    }
+    return bytecodeCompiler.call(postfix_expression->get().s, arguments);
+  }
+
 private:
   ASTNode *postfix_expression;
   ASTNode *argument_expression_list;
+
+  vector<ASTNode *> arguments() const {
+    if (argument_expression_list->getNodeType() == NodeType::Unimplemented) {
+      return {};
+    }
+    return argument_expression_list->children;
+  }
 };
 
 class ArgumentExpressionListNode : public ASTNode {
@@ -2685,8 +5420,15 @@ public:
 
   m_Value get_value_if_possible() const { return m_Value(); }
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, children, depth, true);
+  m_Value flow() const {
+    for (auto child : children) {
+      child->flow();
+    }
+    return m_Value();
+  }
+
+  void dump(AstWriter &out) const {
+    dumpParameters(this, children, out, true);
   }
 };
 
@@ -2696,12 +5438,16 @@ public:
       : ASTNode(NodeType::UnaryExpressionNode),
         unary_expression(unary_expression), un_op(un_op) {}
 
-  string dump_ast(int depth = 0) const {
-    string result = formatSpacing(depth);
-    result += "Prefix: UnOp" + unaryOperatorToString(un_op) + "{ \n";
-    result += unary_expression->dump_ast(depth + 1);
-    result += formatSpacing(depth) + "} \n";
-    return result;
+  void dump(AstWriter &out) const {
+    out.open(type, false);
+    out.property("operator", unaryOperatorToString(un_op));
+    unary_expression->dump(out);
+    out.close();
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    visit(unary_expression);
   }
 
   vector<string> getPlainSymbol() const {
@@ -2709,6 +5455,14 @@ public:
   }
   m_Value get() const { return unary_expression->get(); }
 
+  uint32_t expr_id() const {
+    if (un_op == UnaryOperator::INC_OP || un_op == UnaryOperator::DEC_OP) {
+      return expr_table.unique();
+    }
+    return expr_table.intern((int)type, (int)un_op, "",
+                             {unary_expression->expr_id()});
+  }
+
   m_Value get_for_optim() const {
 
     string pref = un_op == UnaryOperator::MUL_OP ? "*" : "";
@@ -2728,7 +5482,7 @@ public:
       if (!constant_prop)
         return m_Value();
       m_Value name = get_for_optim();
-      return codeGenerator.get_mval(name.s);
+      return optimisationContext.get_mval(name.s);
     }
     case UnaryOperator::PLUS:
       return val;
@@ -2743,6 +5497,116 @@ public:
     }
   }
 
+  // The operand of ++, -- and & is not read as a value; a variable whose
+  // address is taken stops being tracked. The operand of sizeof is not
+  // evaluated, but the variables it names still need their declarations,
+  // however deeply they are parenthesised.
+  m_Value flow() const {
+    FlowAnalysis &flow = optimisationContext.flow;
+    bool named = unary_expression->getNodeType() == NodeType::Identifier;
+    switch (un_op) {
+    case UnaryOperator::SIZEOF:
+      mention_variables(unary_expression, flow);
+      return m_Value();
+    case UnaryOperator::ADDRESS_OF:
+      if (named) {
+        flow.escape(unary_expression->get().s);
+        if (flow.replaying()) {
+          call_sites.escape(unary_expression->get().s);
+        }
+      } else {
+        unary_expression->flow();
+      }
+      return m_Value();
+    case UnaryOperator::INC_OP:
+    case UnaryOperator::DEC_OP:
+      if (named) {
+        string name = unary_expression->get().s;
+        flow.write(name,
+                   flow.current_value(name) +
+                       m_Value(un_op == UnaryOperator::INC_OP ? 1 : -1),
+                   this);
+      } else {
+        unary_expression->flow();
+      }
+      flow.effects++;
+      return m_Value();
+    default:
+      unary_expression->flow();
+      return get_value_if_possible();
+    }
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    switch (un_op) {
+    case UnaryOperator::INC_OP:
+    case UnaryOperator::DEC_OP: {
+      if (unary_expression->getNodeType() != NodeType::Identifier) {
+        throw ConstEvalError("Only locals can be assigned at compile time");
+      }
+      string name = unary_expression->get().s;
+      return evaluation.store(
+          name, evaluation.load(name) +
+                    m_Value(un_op == UnaryOperator::INC_OP ? 1 : -1));
+    }
+    case UnaryOperator::PLUS:
+      return evaluation.check(unary_expression->evaluate(evaluation));
+    case UnaryOperator::MINUS:
+      return evaluation.check(-unary_expression->evaluate(evaluation));
+    case UnaryOperator::LOGICAL_NOT:
+      return evaluation.check(!unary_expression->evaluate(evaluation));
+    case UnaryOperator::BITWISE_NOT:
+      return evaluation.check(~unary_expression->evaluate(evaluation));
+    default:
+      throw ConstEvalError(unaryOperatorToString(un_op) +
+                           " cannot be evaluated at compile time");
+    }
+  }
+
+  // Neither `*` nor the operators that store are
+  bool branchless(unsigned &budget) const {
+    switch (un_op) {
+    case UnaryOperator::PLUS:
+    case UnaryOperator::MINUS:
+    case UnaryOperator::BITWISE_NOT:
+    case UnaryOperator::LOGICAL_NOT:
+      return branchless_node(budget) && unary_expression->branchless(budget);
+    default:
+      return false;
+    }
+  }
+
+  // `*p` reads an int parameter; `!` gives a comparison
+  ASTNode *inlined(InlineFrame &frame, FlowAnalysis::Kind &kind) const {
+    FlowAnalysis::Kind operand_kind;
+    ASTNode *arg;
+    InlineParam *param = nullptr;
+    switch (un_op) {
+    case UnaryOperator::MUL_OP:
+      param = unary_expression->getNodeType() == NodeType::Identifier
+                  ? frame.find(unary_expression->get().s, arg)
+                  : nullptr;
+      if (!param || !param->pointer || param->kind != FlowAnalysis::INT) {
+        return nullptr;
+      }
+      break;
+    case UnaryOperator::PLUS:
+    case UnaryOperator::MINUS:
+    case UnaryOperator::BITWISE_NOT:
+    case UnaryOperator::LOGICAL_NOT:
+      break;
+    default:
+      return nullptr;
+    }
+    ASTNode *operand = inline_expression(unary_expression, frame, operand_kind);
+    if (!operand || (!param && operand_kind != FlowAnalysis::INT)) {
+      return nullptr;
+    }
+    kind = un_op == UnaryOperator::LOGICAL_NOT ? FlowAnalysis::UNTRACKED
+                                               : FlowAnalysis::INT;
+    return new UnaryExpressionNode(un_op, operand);
+  }
+
   ASTNode *optimise() const {
 
     if (un_op == UnaryOperator::ADDRESS_OF) {
@@ -2754,11 +5618,11 @@ public:
 
     auto my_val = get_value_if_possible();
     if(my_val.type == ActualValueType::INTEGER){
-      return new IConstantNode(my_val.i);
+      return fold(this, my_val);
     }
 
     if(my_val.type == ActualValueType::FLOATING){
-      return new FConstantNode(my_val.f);
+      return fold(this, my_val);
     }
     return ret;
   }
@@ -2821,46 +5685,143 @@ public:
       return new_val;
     }
 
-    case UnaryOperator::SIZEOF:
-      return llvm::ConstantInt::get(
-          llvm::Type::getInt32Ty(codeGenerator.getContext()),
-          val->getType()->getPrimitiveSizeInBits() / 8, true);
+    case UnaryOperator::SIZEOF:
+      return llvm::ConstantInt::get(
+          llvm::Type::getInt32Ty(codeGenerator.getContext()),
+          val->getType()->getPrimitiveSizeInBits() / 8, true);
+
+    case UnaryOperator::ALIGNOF:
+      return llvm::ConstantInt::get(
+          llvm::Type::getInt32Ty(codeGenerator.getContext()),
+          val->getType()->getPrimitiveSizeInBits() / 8, true);
+
+    case UnaryOperator::ADDRESS_OF:
+      return val;
+
+    case UnaryOperator::MUL_OP:
+      return codeGenerator.getBuilder().CreateLoad(
+          val->getType()->getPointerElementType(), val, "deref");
+    case UnaryOperator::PLUS:
+      return val;
+    case UnaryOperator::MINUS: {
+      llvm::Value *zero = llvm::ConstantInt::get(
+          llvm::Type::getInt32Ty(codeGenerator.getContext()), 0);
+      make_lhs_rhs_compatible(val, zero);
+      return codeGenerator.getBuilder().CreateSub(zero, val, "neg");
+    }
+    case UnaryOperator::BITWISE_NOT:
+
+      return codeGenerator.getBuilder().CreateNot(val, "bitnot");
+    case UnaryOperator::LOGICAL_NOT: {
+      llvm::Value *zero = llvm::ConstantInt::get(
+          llvm::Type::getInt1Ty(codeGenerator.getContext()), 0);
+      make_lhs_rhs_compatible(val, zero);
+      Value *cmp = codeGenerator.getBuilder().CreateICmpNE(val, zero, "lognot");
+
+      Value *boolVal = codeGenerator.getBuilder().CreateZExt(
+          cmp, codeGenerator.getBuilder().getInt1Ty(), "lognotcmp");
+      return codeGenerator.getBuilder().CreateNot(boolVal, "lognot2");
+    }
+    }
+
+    return val;
+  }
+
+  RValue interpret() {
+    bool old_get_as_lvalue = get_as_lvalue;
+    if (un_op == UnaryOperator::INC_OP || un_op == UnaryOperator::DEC_OP ||
+        un_op == UnaryOperator::ADDRESS_OF) {
+      get_as_lvalue = true;
+    }
+    RValue val = unary_expression->interpret();
+    get_as_lvalue = old_get_as_lvalue;
+
+    llvm::LLVMContext &context = codeGenerator.getContext();
+
+    switch (un_op) {
+    case UnaryOperator::INC_OP:
+    case UnaryOperator::DEC_OP: {
+      llvm::Type *val_type = val.type->getPointerElementType();
+      RValue new_val = interp_step(interp_load(val.p, val_type),
+                                   un_op == UnaryOperator::INC_OP ? 1 : -1);
+      interp_store(val.p, new_val);
+      return new_val;
+    }
+    case UnaryOperator::SIZEOF:
+    case UnaryOperator::ALIGNOF:
+      return RValue(llvm::Type::getInt32Ty(context),
+                    val.type->isSized() ? interp_size(val.type) : 0);
+    case UnaryOperator::MUL_OP:
+      if (!val.type->isPointerTy()) {
+        throw std::runtime_error("Dereferencing a non-pointer");
+      }
+      return interp_load(val.p, val.type->getPointerElementType());
+    case UnaryOperator::MINUS:
+      return interp_binary(InterpOp::SUB,
+                           RValue(llvm::Type::getInt32Ty(context), 0), val);
+    case UnaryOperator::BITWISE_NOT:
+      if (!val.type->isIntegerTy()) {
+        throw std::runtime_error("Bitwise not of a non-integer");
+      }
+      return RValue(val.type, interp_wrap(~val.i, val.type));
+    case UnaryOperator::LOGICAL_NOT:
+      return RValue(llvm::Type::getInt1Ty(context), !interp_truthy(val));
+    default:
+      return val;
+    }
+  }
+
+  BcValue compileBytecode() {
+    return bytecodeCompiler.reuse(expr_id(), get_as_lvalue,
+                                  [this]() { return compileUnary(); });
+  }
+
+  BcValue compileUnary() {
+    bool old_get_as_lvalue = get_as_lvalue;
+    if (un_op == UnaryOperator::INC_OP || un_op == UnaryOperator::DEC_OP ||
+        un_op == UnaryOperator::ADDRESS_OF) {
+      get_as_lvalue = true;
+    }
+    BcValue val = unary_expression->compileBytecode();
+    get_as_lvalue = old_get_as_lvalue;
+
+    llvm::LLVMContext &context = codeGenerator.getContext();
 
+    switch (un_op) {
+    case UnaryOperator::INC_OP:
+    case UnaryOperator::DEC_OP: {
+      BcValue new_val =
+          bytecodeCompiler.step(bytecodeCompiler.load(val),
+                                un_op == UnaryOperator::INC_OP ? 1 : -1);
+      return bytecodeCompiler.store(val, new_val);
+    }
+    case UnaryOperator::SIZEOF:
     case UnaryOperator::ALIGNOF:
-      return llvm::ConstantInt::get(
-          llvm::Type::getInt32Ty(codeGenerator.getContext()),
-          val->getType()->getPrimitiveSizeInBits() / 8, true);
-
+      return bytecodeCompiler.constant(
+          llvm::Type::getInt32Ty(context),
+          val.type->isSized() ? interp_size(val.type) : 0);
+    case UnaryOperator::MUL_OP:
+      if (!val.type->isPointerTy()) {
+        throw std::runtime_error("Dereferencing a non-pointer");
+      }
+      return bytecodeCompiler.load(val);
+    case UnaryOperator::MINUS:
+      return bytecodeCompiler.binary(
+          InterpOp::SUB,
+          bytecodeCompiler.constant(llvm::Type::getInt32Ty(context), 0), val);
+    case UnaryOperator::BITWISE_NOT:
+      if (!val.type->isIntegerTy()) {
+        throw std::runtime_error("Bitwise not of a non-integer");
+      }
+      return bytecodeCompiler.bitwiseNot(val);
+    case UnaryOperator::LOGICAL_NOT:
+      return bytecodeCompiler.logicalNot(val);
     case UnaryOperator::ADDRESS_OF:
+      bytecodeCompiler.addressTaken(val);
       return val;
-
-    case UnaryOperator::MUL_OP:
-      return codeGenerator.getBuilder().CreateLoad(
-          val->getType()->getPointerElementType(), val, "deref");
-    case UnaryOperator::PLUS:
+    default:
       return val;
-    case UnaryOperator::MINUS: {
-      llvm::Value *zero = llvm::ConstantInt::get(
-          llvm::Type::getInt32Ty(codeGenerator.getContext()), 0);
-      make_lhs_rhs_compatible(val, zero);
-      return codeGenerator.getBuilder().CreateSub(zero, val, "neg");
     }
-    case UnaryOperator::BITWISE_NOT:
-
-      return codeGenerator.getBuilder().CreateNot(val, "bitnot");
-    case UnaryOperator::LOGICAL_NOT: {
-      llvm::Value *zero = llvm::ConstantInt::get(
-          llvm::Type::getInt1Ty(codeGenerator.getContext()), 0);
-      make_lhs_rhs_compatible(val, zero);
-      Value *cmp = codeGenerator.getBuilder().CreateICmpNE(val, zero, "lognot");
-
-      Value *boolVal = codeGenerator.getBuilder().CreateZExt(
-          cmp, codeGenerator.getBuilder().getInt1Ty(), "lognotcmp");
-      return codeGenerator.getBuilder().CreateNot(boolVal, "lognot2");
-    }
-    }
-
-    return val;
   }
 
 private:
@@ -2874,16 +5835,29 @@ public:
       : ASTNode(NodeType::PostfixExpression),
         primary_expression(primary_expression), postFixOp(postFixOp) {}
 
-  string dump_ast(int depth = 0) const {
-    string result = formatSpacing(depth);
-    result += unaryOperatorToString(postFixOp) + "{ \n";
-    result += primary_expression->dump_ast(depth + 1);
-    result += formatSpacing(depth) + "} \n";
-    return result;
+  void dump(AstWriter &out) const {
+    out.open(type, false);
+    out.property("operator", unaryOperatorToString(postFixOp));
+    primary_expression->dump(out);
+    out.close();
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    visit(primary_expression);
   }
 
   m_Value get() const { return primary_expression->get(); }
 
+  uint32_t expr_id() const {
+    if (postFixOp == UnaryOperator::INC_OP ||
+        postFixOp == UnaryOperator::DEC_OP) {
+      return expr_table.unique();
+    }
+    return expr_table.intern((int)type, (int)postFixOp, "",
+                             {primary_expression->expr_id()});
+  }
+
   vector<string> getPlainSymbol() const {
     return primary_expression->getPlainSymbol();
   }
@@ -2894,6 +5868,32 @@ public:
     return ret;
   }
 
+  m_Value flow() const {
+    FlowAnalysis &flow = optimisationContext.flow;
+    if (primary_expression->getNodeType() == NodeType::Identifier) {
+      string name = primary_expression->get().s;
+      flow.write(name,
+                 flow.current_value(name) +
+                     m_Value(postFixOp == UnaryOperator::INC_OP ? 1 : -1),
+                 this);
+    } else {
+      primary_expression->flow();
+    }
+    flow.effects++;
+    return m_Value();
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    if (primary_expression->getNodeType() != NodeType::Identifier) {
+      throw ConstEvalError("Only locals can be assigned at compile time");
+    }
+    string name = primary_expression->get().s;
+    m_Value old = evaluation.load(name);
+    evaluation.store(
+        name, old + m_Value(postFixOp == UnaryOperator::INC_OP ? 1 : -1));
+    return old;
+  }
+
   m_Value get_value_if_possible() const { return m_Value(); }
 
   bool check_semantics() { return primary_expression->check_semantics(); }
@@ -2965,11 +5965,111 @@ public:
     }
   }
 
+  RValue interpret() {
+    bool old_get_as_lvalue = get_as_lvalue;
+    if (postFixOp == UnaryOperator::INC_OP ||
+        postFixOp == UnaryOperator::DEC_OP) {
+      get_as_lvalue = true;
+    }
+    RValue val = primary_expression->interpret();
+    get_as_lvalue = old_get_as_lvalue;
+
+    if (postFixOp != UnaryOperator::INC_OP &&
+        postFixOp != UnaryOperator::DEC_OP) {
+      return val;
+    }
+
+    RValue old_val = interp_load(val.p, val.type->getPointerElementType());
+    interp_store(val.p, interp_step(old_val, postFixOp == UnaryOperator::INC_OP
+                                                 ? 1
+                                                 : -1));
+    return old_val;
+  }
+
+  BcValue compileBytecode() {
+    bool old_get_as_lvalue = get_as_lvalue;
+    if (postFixOp == UnaryOperator::INC_OP ||
+        postFixOp == UnaryOperator::DEC_OP) {
+      get_as_lvalue = true;
+    }
+    BcValue val = primary_expression->compileBytecode();
+    get_as_lvalue = old_get_as_lvalue;
+
+    if (postFixOp != UnaryOperator::INC_OP &&
+        postFixOp != UnaryOperator::DEC_OP) {
+      return val;
+    }
+
+    // The old value is copied out first, since a register variable is
+    // updated in place
+    BcValue old_val = bytecodeCompiler.copy(bytecodeCompiler.load(val));
+    bytecodeCompiler.store(
+        val, bytecodeCompiler.step(old_val, postFixOp == UnaryOperator::INC_OP
+                                                ? 1
+                                                : -1));
+    return old_val;
+  }
+
 private:
   ASTNode *primary_expression;
   UnaryOperator postFixOp;
 };
 
+// The type both operands of a `?:` are converted to. An int constant 0 or
+// 1 next to an i1 becomes an i1, as in `a && b < c`; otherwise it is the
+// type an operator would use.
+static llvm::Type *common_arm_type(llvm::Value *lhs, llvm::Value *rhs) {
+  llvm::Type *lhs_type = lhs->getType();
+  llvm::Type *rhs_type = rhs->getType();
+  auto boolean = [](llvm::Value *value) {
+    auto *constant = llvm::dyn_cast<llvm::ConstantInt>(value);
+    return constant && (constant->isZero() || constant->isOne());
+  };
+
+  if (lhs_type == rhs_type) {
+    return lhs_type;
+  }
+  if (lhs_type->isIntegerTy(1) && boolean(rhs)) {
+    return lhs_type;
+  }
+  if (rhs_type->isIntegerTy(1) && boolean(lhs)) {
+    return rhs_type;
+  }
+  if (lhs_type->isDoubleTy() || rhs_type->isDoubleTy()) {
+    return llvm::Type::getDoubleTy(codeGenerator.getContext());
+  }
+  if (lhs_type->isIntegerTy() && rhs_type->isIntegerTy()) {
+    return lhs_type->getIntegerBitWidth() > rhs_type->getIntegerBitWidth()
+               ? lhs_type
+               : rhs_type;
+  }
+  return lhs_type;
+}
+
+static llvm::Value *convert_arm(llvm::Value *value, llvm::Type *type) {
+  llvm::Type *value_type = value->getType();
+  if (value_type == type) {
+    return value;
+  }
+  if (type->isIntegerTy(1) && llvm::isa<llvm::ConstantInt>(value)) {
+    return llvm::ConstantInt::get(
+        type, !llvm::cast<llvm::ConstantInt>(value)->isZero());
+  }
+  if (value_type->isIntegerTy() && type->isDoubleTy()) {
+    if (value_type->isIntegerTy(1)) {
+      return codeGenerator.getBuilder().CreateUIToFP(value, type, "armcast");
+    }
+    return codeGenerator.getBuilder().CreateSIToFP(value, type, "armcast");
+  }
+  if (value_type->isIntegerTy() && type->isIntegerTy()) {
+    return value_type->isIntegerTy(1)
+               ? codeGenerator.getBuilder().CreateZExt(value, type, "armext")
+               : codeGenerator.getBuilder().CreateSExtOrTrunc(value, type,
+                                                               "armext");
+  }
+  return codeGenerator.getBuilder().CreateBitOrPointerCast(value, type);
+}
+
 class ConditionalExpressionNode : public ASTNode {
 public:
   ConditionalExpressionNode(ASTNode *logical_or_expression, ASTNode *expression,
@@ -2978,10 +6078,27 @@ public:
         logical_or_expression(logical_or_expression), expression(expression),
         conditional_expression(conditional_expression) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(
-        this, {logical_or_expression, expression, conditional_expression},
-        depth, false);
+  // Operands with at most this many nodes may be evaluated both
+  static constexpr unsigned BRANCHLESS_SIZE = 6;
+
+  void dump(AstWriter &out) const {
+    dumpParameters(
+        this, {logical_or_expression, expression, conditional_expression}, out,
+        false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child :
+         {logical_or_expression, expression, conditional_expression}) {
+      visit(child);
+    }
+  }
+
+  uint32_t expr_id() const {
+    return expr_table.intern((int)type, {logical_or_expression->expr_id(),
+                                         expression->expr_id(),
+                                         conditional_expression->expr_id()});
   }
 
   bool check_semantics() {
@@ -3022,6 +6139,55 @@ public:
     return m_Value();
   }
 
+  // Only the arm taken is evaluated; when either may be, both are and the
+  // states after them are merged
+  m_Value flow() const {
+    FlowAnalysis &flow = optimisationContext.flow;
+    m_Value condition = logical_or_expression->flow();
+    if (condition.type == ActualValueType::INTEGER ||
+        condition.type == ActualValueType::FLOATING) {
+      bool taken =
+          condition.type == ActualValueType::INTEGER ? condition.i : condition.f;
+      return (taken ? expression : conditional_expression)->flow();
+    }
+    vector<FlowValue> before = flow.snapshot();
+    flow.conditional++;
+    expression->flow();
+    vector<FlowValue> after_true = flow.snapshot();
+    flow.restore(before);
+    conditional_expression->flow();
+    flow.conditional--;
+    flow.join(after_true);
+    return m_Value();
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    bool taken = evaluation.truth(logical_or_expression->evaluate(evaluation));
+    return (taken ? expression : conditional_expression)->evaluate(evaluation);
+  }
+
+  bool branchless(unsigned &budget) const {
+    return branchless_node(budget) &&
+           logical_or_expression->branchless(budget) &&
+           expression->branchless(budget) &&
+           conditional_expression->branchless(budget);
+  }
+
+  ASTNode *inlined(InlineFrame &frame, FlowAnalysis::Kind &kind) const {
+    FlowAnalysis::Kind condition_kind, true_kind, false_kind;
+    ASTNode *condition =
+        inline_expression(logical_or_expression, frame, condition_kind);
+    ASTNode *if_true = inline_expression(expression, frame, true_kind);
+    ASTNode *if_false =
+        inline_expression(conditional_expression, frame, false_kind);
+    if (!condition || !if_true || !if_false ||
+        true_kind != FlowAnalysis::INT || false_kind != FlowAnalysis::INT) {
+      return nullptr;
+    }
+    kind = FlowAnalysis::INT;
+    return new ConditionalExpressionNode(condition, if_true, if_false);
+  }
+
   ASTNode *optimise() const {
 
     auto ret = new ConditionalExpressionNode(*this);
@@ -3050,6 +6216,10 @@ public:
     return ret;
   }
 
+  // When both operands are branchless they are both evaluated and one is
+  // selected, with `and`/`or` for && and || on comparisons. Otherwise only
+  // the chosen one is, which keeps the order of side effects and leaves
+  // out traps (e.g. `p && p[0]`).
   Value *codegen() {
 
     Value *conditionValue = logical_or_expression->codegen();
@@ -3067,6 +6237,39 @@ public:
         llvm::ConstantInt::get(
             llvm::Type::getInt1Ty(codeGenerator.getContext()), 0, true),
         "ifcond");
+    llvm::MDNode *weights =
+        profiler.branch(codeGenerator.getBuilder(), condition);
+
+    unsigned then_budget = BRANCHLESS_SIZE;
+    unsigned else_budget = BRANCHLESS_SIZE;
+    if (expression->branchless(then_budget) &&
+        conditional_expression->branchless(else_budget)) {
+      Value *thenValue = expression->codegen();
+      Value *elseValue = conditional_expression->codegen();
+      llvm::Type *type = common_arm_type(thenValue, elseValue);
+      thenValue = convert_arm(thenValue, type);
+      elseValue = convert_arm(elseValue, type);
+
+      if (type->isIntegerTy(1)) {
+        auto *then_constant = llvm::dyn_cast<llvm::ConstantInt>(thenValue);
+        auto *else_constant = llvm::dyn_cast<llvm::ConstantInt>(elseValue);
+        if (else_constant && else_constant->isZero()) {
+          return codeGenerator.getBuilder().CreateAnd(condition, thenValue,
+                                                      "and");
+        }
+        if (then_constant && then_constant->isOne()) {
+          return codeGenerator.getBuilder().CreateOr(condition, elseValue,
+                                                     "or");
+        }
+      }
+      Value *select = codeGenerator.getBuilder().CreateSelect(
+          condition, thenValue, elseValue, "select");
+      if (weights && llvm::isa<llvm::Instruction>(select)) {
+        llvm::cast<llvm::Instruction>(select)->setMetadata(
+            llvm::LLVMContext::MD_prof, weights);
+      }
+      return select;
+    }
 
     llvm::Function *function =
         codeGenerator.getBuilder().GetInsertBlock()->getParent();
@@ -3078,19 +6281,26 @@ public:
     llvm::BasicBlock *merge_block =
         llvm::BasicBlock::Create(codeGenerator.getContext(), "ifcont");
 
-    codeGenerator.getBuilder().CreateCondBr(condition, then_block, else_block);
+    codeGenerator.getBuilder().CreateCondBr(condition, then_block, else_block,
+                                            weights);
 
+    // The operands may add blocks of their own, so each branches to the
+    // merge block from wherever it ends, once both types are known
     codeGenerator.getBuilder().SetInsertPoint(then_block);
     Value *thenValue = expression->codegen();
-    codeGenerator.getBuilder().CreateBr(
-        merge_block); // Branch to merge block after executing thenBlock
+    llvm::BasicBlock *then_end = codeGenerator.getBuilder().GetInsertBlock();
 
-    // Set insertion point for the "else" block
     function->getBasicBlockList().push_back(else_block);
     codeGenerator.getBuilder().SetInsertPoint(else_block);
     Value *elseValue = conditional_expression->codegen();
-    codeGenerator.getBuilder().CreateBr(
-        merge_block); // Branch to merge block after executing elseBlock
+    llvm::BasicBlock *else_end = codeGenerator.getBuilder().GetInsertBlock();
+
+    llvm::Type *type = common_arm_type(thenValue, elseValue);
+    elseValue = convert_arm(elseValue, type);
+    codeGenerator.getBuilder().CreateBr(merge_block);
+    codeGenerator.getBuilder().SetInsertPoint(then_end);
+    thenValue = convert_arm(thenValue, type);
+    codeGenerator.getBuilder().CreateBr(merge_block);
 
     // Set insertion point for the merge block
     function->getBasicBlockList().push_back(merge_block);
@@ -3098,13 +6308,42 @@ public:
 
     // Create phi node to merge the results from thenBlock and elseBlock
     llvm::PHINode *phiNode =
-        codeGenerator.getBuilder().CreatePHI(thenValue->getType(), 2, "iftmp");
-    phiNode->addIncoming(thenValue, then_block);
-    phiNode->addIncoming(elseValue, else_block);
+        codeGenerator.getBuilder().CreatePHI(type, 2, "iftmp");
+    phiNode->addIncoming(thenValue, then_end);
+    phiNode->addIncoming(elseValue, else_end);
 
     return phiNode;
   }
 
+  // Only the chosen operand is evaluated, which also makes && and ||
+  // short-circuit
+  RValue interpret() {
+    if (interp_truthy(logical_or_expression->interpret())) {
+      return expression->interpret();
+    }
+    return conditional_expression->interpret();
+  }
+
+  // Both operands end up in one register, with the type of the first
+  BcValue compileBytecode() {
+    size_t to_else = bytecodeCompiler.jumpIfFalse(
+        logical_or_expression->compileBytecode());
+    uint16_t result = bytecodeCompiler.temp();
+
+    BcValue thenValue = expression->compileBytecode();
+    bytecodeCompiler.move(result, thenValue);
+    size_t to_end = bytecodeCompiler.jump();
+
+    bytecodeCompiler.patch(to_else);
+    BcValue elseValue = conditional_expression->compileBytecode();
+    if (!thenValue.type->isVoidTy() && elseValue.type != thenValue.type) {
+      elseValue = bytecodeCompiler.cast(elseValue, thenValue.type);
+    }
+    bytecodeCompiler.move(result, elseValue);
+    bytecodeCompiler.patch(to_end);
+    return BcValue(thenValue.type, result);
+  }
+
 private:
   ASTNode *logical_or_expression;
   ASTNode *expression;
@@ -3181,9 +6420,16 @@ public:
         inclusive_or_expression(inclusive_or_expression),
         exclusive_or_expression(exclusive_or_expression) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(
-        this, {inclusive_or_expression, exclusive_or_expression}, depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(
+        this, {inclusive_or_expression, exclusive_or_expression}, out, false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {inclusive_or_expression, exclusive_or_expression}) {
+      visit(child);
+    }
   }
 
   vector<string> getPlainSymbol() const {
@@ -3215,6 +6461,38 @@ public:
     return lhs;
   }
 
+  m_Value flow() const {
+    inclusive_or_expression->flow();
+    exclusive_or_expression->flow();
+    return get_value_if_possible();
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    m_Value lhs = inclusive_or_expression->evaluate(evaluation);
+    m_Value rhs = exclusive_or_expression->evaluate(evaluation);
+    return evaluation.check(lhs | rhs);
+  }
+
+  bool binaryOperands(ASTNode *&lhs, ASTNode *&rhs) const {
+    lhs = inclusive_or_expression;
+    rhs = exclusive_or_expression;
+    return true;
+  }
+
+  bool branchless(unsigned &budget) const {
+    return branchless_operands(budget, inclusive_or_expression,
+                               exclusive_or_expression);
+  }
+
+  ASTNode *inlined(InlineFrame &frame, FlowAnalysis::Kind &kind) const {
+    ASTNode *lhs, *rhs;
+    if (!inline_operands(frame, inclusive_or_expression, exclusive_or_expression, lhs, rhs)) {
+      return nullptr;
+    }
+    kind = FlowAnalysis::INT;
+    return new InclusiveOrExpressionNode(lhs, rhs);
+  }
+
   ASTNode *optimise() const {
     auto ret = new InclusiveOrExpressionNode(*this);
     ret->inclusive_or_expression = inclusive_or_expression->optimise();
@@ -3223,13 +6501,13 @@ public:
     m_Value v = get_value_if_possible();
 
     if (v.type == ActualValueType::INTEGER) {
-      return new IConstantNode(v.i);
+      return fold(this, v);
     }
 
     if (v.type == ActualValueType::FLOATING) {
-      return new FConstantNode(v.f);
+      return fold(this, v);
     }
-    return ret;
+    return simplify_binary(this, ret);
   }
 
   Value *codegen() {
@@ -3246,6 +6524,25 @@ public:
     return codeGenerator.getBuilder().CreateOr(lhs, rhs, "or");
   }
 
+  RValue interpret() {
+    RValue lhs = inclusive_or_expression->interpret();
+    RValue rhs = exclusive_or_expression->interpret();
+    return interp_binary(InterpOp::OR, lhs, rhs);
+  }
+
+  uint32_t expr_id() const {
+    return expr_table.intern((int)type, {inclusive_or_expression->expr_id(),
+                                         exclusive_or_expression->expr_id()});
+  }
+
+  BcValue compileBytecode() {
+    return bytecodeCompiler.reuse(expr_id(), get_as_lvalue, [this]() {
+      BcValue lhs = inclusive_or_expression->compileBytecode();
+      BcValue rhs = exclusive_or_expression->compileBytecode();
+      return bytecodeCompiler.binary(InterpOp::OR, lhs, rhs);
+    });
+  }
+
 private:
   ASTNode *inclusive_or_expression;
   ASTNode *exclusive_or_expression;
@@ -3259,9 +6556,15 @@ public:
         exclusive_or_expression(exclusive_or_expression),
         and_expression(and_expression) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {exclusive_or_expression, and_expression},
-                          depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {exclusive_or_expression, and_expression}, out, false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {exclusive_or_expression, and_expression}) {
+      visit(child);
+    }
   }
 
   bool check_semantics() {
@@ -3291,6 +6594,37 @@ public:
     return lhs;
   }
 
+  m_Value flow() const {
+    exclusive_or_expression->flow();
+    and_expression->flow();
+    return get_value_if_possible();
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    m_Value lhs = exclusive_or_expression->evaluate(evaluation);
+    m_Value rhs = and_expression->evaluate(evaluation);
+    return evaluation.check(lhs ^ rhs);
+  }
+
+  bool binaryOperands(ASTNode *&lhs, ASTNode *&rhs) const {
+    lhs = exclusive_or_expression;
+    rhs = and_expression;
+    return true;
+  }
+
+  bool branchless(unsigned &budget) const {
+    return branchless_operands(budget, exclusive_or_expression, and_expression);
+  }
+
+  ASTNode *inlined(InlineFrame &frame, FlowAnalysis::Kind &kind) const {
+    ASTNode *lhs, *rhs;
+    if (!inline_operands(frame, exclusive_or_expression, and_expression, lhs, rhs)) {
+      return nullptr;
+    }
+    kind = FlowAnalysis::INT;
+    return new ExclusiveOrExpressionNode(lhs, rhs);
+  }
+
   ASTNode *optimise() const {
     auto ret = new ExclusiveOrExpressionNode(*this);
     ret->exclusive_or_expression = exclusive_or_expression->optimise();
@@ -3299,13 +6633,13 @@ public:
     m_Value v = get_value_if_possible();
 
     if (v.type == ActualValueType::INTEGER) {
-      return new IConstantNode(v.i);
+      return fold(this, v);
     }
 
     if (v.type == ActualValueType::FLOATING) {
-      return new FConstantNode(v.f);
+      return fold(this, v);
     }
-    return ret;
+    return simplify_binary(this, ret);
   }
 
   Value *codegen() {
@@ -3322,6 +6656,25 @@ public:
     return codeGenerator.getBuilder().CreateXor(lhs, rhs, "xor");
   }
 
+  RValue interpret() {
+    RValue lhs = exclusive_or_expression->interpret();
+    RValue rhs = and_expression->interpret();
+    return interp_binary(InterpOp::XOR, lhs, rhs);
+  }
+
+  uint32_t expr_id() const {
+    return expr_table.intern((int)type, {exclusive_or_expression->expr_id(),
+                                         and_expression->expr_id()});
+  }
+
+  BcValue compileBytecode() {
+    return bytecodeCompiler.reuse(expr_id(), get_as_lvalue, [this]() {
+      BcValue lhs = exclusive_or_expression->compileBytecode();
+      BcValue rhs = and_expression->compileBytecode();
+      return bytecodeCompiler.binary(InterpOp::XOR, lhs, rhs);
+    });
+  }
+
 private:
   ASTNode *exclusive_or_expression;
   ASTNode *and_expression;
@@ -3333,9 +6686,15 @@ public:
       : ASTNode(NodeType::AndExpression), and_expression(and_expression),
         equality_expression(equality_expression) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {and_expression, equality_expression}, depth,
-                          false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {and_expression, equality_expression}, out, false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {and_expression, equality_expression}) {
+      visit(child);
+    }
   }
 
   bool check_semantics() {
@@ -3365,18 +6724,49 @@ public:
     return lhs;
   }
 
+  m_Value flow() const {
+    and_expression->flow();
+    equality_expression->flow();
+    return get_value_if_possible();
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    m_Value lhs = and_expression->evaluate(evaluation);
+    m_Value rhs = equality_expression->evaluate(evaluation);
+    return evaluation.check(lhs & rhs);
+  }
+
+  bool binaryOperands(ASTNode *&lhs, ASTNode *&rhs) const {
+    lhs = and_expression;
+    rhs = equality_expression;
+    return true;
+  }
+
+  bool branchless(unsigned &budget) const {
+    return branchless_operands(budget, and_expression, equality_expression);
+  }
+
+  ASTNode *inlined(InlineFrame &frame, FlowAnalysis::Kind &kind) const {
+    ASTNode *lhs, *rhs;
+    if (!inline_operands(frame, and_expression, equality_expression, lhs, rhs)) {
+      return nullptr;
+    }
+    kind = FlowAnalysis::INT;
+    return new AndExpressionNode(lhs, rhs);
+  }
+
   ASTNode *optimise() const {
     auto ret = new AndExpressionNode(*this);
     ret->and_expression = and_expression->optimise();
     ret->equality_expression = equality_expression->optimise();
     m_Value v = get_value_if_possible();
     if (v.type == ActualValueType::INTEGER) {
-      return new IConstantNode(v.i);
+      return fold(this, v);
     }
     if (v.type == ActualValueType::FLOATING) {
-      return new FConstantNode(v.f);
+      return fold(this, v);
     }
-    return ret;
+    return simplify_binary(this, ret);
   }
 
   Value *codegen() {
@@ -3393,6 +6783,25 @@ public:
     return codeGenerator.getBuilder().CreateAnd(lhs, rhs, "and");
   }
 
+  RValue interpret() {
+    RValue lhs = and_expression->interpret();
+    RValue rhs = equality_expression->interpret();
+    return interp_binary(InterpOp::AND, lhs, rhs);
+  }
+
+  uint32_t expr_id() const {
+    return expr_table.intern((int)type, {and_expression->expr_id(),
+                                         equality_expression->expr_id()});
+  }
+
+  BcValue compileBytecode() {
+    return bytecodeCompiler.reuse(expr_id(), get_as_lvalue, [this]() {
+      BcValue lhs = and_expression->compileBytecode();
+      BcValue rhs = equality_expression->compileBytecode();
+      return bytecodeCompiler.binary(InterpOp::AND, lhs, rhs);
+    });
+  }
+
 private:
   ASTNode *and_expression;
   ASTNode *equality_expression;
@@ -3406,9 +6815,16 @@ public:
         equality_expression(equality_expression),
         relational_expression(relational_expression) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {equality_expression, relational_expression},
-                          depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {equality_expression, relational_expression}, out,
+                   false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {equality_expression, relational_expression}) {
+      visit(child);
+    }
   }
 
   vector<string> getPlainSymbol() const {
@@ -3430,16 +6846,42 @@ public:
     return (lhs == rhs);
   }
 
+  m_Value flow() const {
+    equality_expression->flow();
+    relational_expression->flow();
+    return get_value_if_possible();
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    m_Value lhs = equality_expression->evaluate(evaluation);
+    m_Value rhs = relational_expression->evaluate(evaluation);
+    return evaluation.check(lhs == rhs);
+  }
+
+  bool branchless(unsigned &budget) const {
+    return branchless_operands(budget, equality_expression,
+                               relational_expression);
+  }
+
+  ASTNode *inlined(InlineFrame &frame, FlowAnalysis::Kind &kind) const {
+    ASTNode *lhs, *rhs;
+    if (!inline_operands(frame, equality_expression, relational_expression, lhs, rhs)) {
+      return nullptr;
+    }
+    kind = FlowAnalysis::UNTRACKED;
+    return new EqualityExpressionNode(lhs, rhs);
+  }
+
   ASTNode *optimise() const {
     auto ret = new EqualityExpressionNode(*this);
     ret->equality_expression = equality_expression->optimise();
     ret->relational_expression = relational_expression->optimise();
     m_Value v = get_value_if_possible();
     if (v.type == ActualValueType::INTEGER) {
-      return new IConstantNode(v.i);
+      return fold(this, v);
     }
     if (v.type == ActualValueType::FLOATING) {
-      return new FConstantNode(v.f);
+      return fold(this, v);
     }
     return ret;
   }
@@ -3456,6 +6898,25 @@ public:
     return codeGenerator.getBuilder().CreateICmpEQ(lhs, rhs, "equal");
   }
 
+  RValue interpret() {
+    RValue lhs = equality_expression->interpret();
+    RValue rhs = relational_expression->interpret();
+    return interp_binary(InterpOp::EQ, lhs, rhs);
+  }
+
+  uint32_t expr_id() const {
+    return expr_table.intern((int)type, {equality_expression->expr_id(),
+                                         relational_expression->expr_id()});
+  }
+
+  BcValue compileBytecode() {
+    return bytecodeCompiler.reuse(expr_id(), get_as_lvalue, [this]() {
+      BcValue lhs = equality_expression->compileBytecode();
+      BcValue rhs = relational_expression->compileBytecode();
+      return bytecodeCompiler.binary(InterpOp::EQ, lhs, rhs);
+    });
+  }
+
 private:
   ASTNode *equality_expression;
   ASTNode *relational_expression;
@@ -3469,9 +6930,16 @@ public:
         equality_expression(equality_expression),
         relational_expression(relational_expression) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {equality_expression, relational_expression},
-                          depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {equality_expression, relational_expression}, out,
+                   false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {equality_expression, relational_expression}) {
+      visit(child);
+    }
   }
 
   vector<string> getPlainSymbol() const {
@@ -3493,16 +6961,42 @@ public:
     return (lhs != rhs);
   }
 
+  m_Value flow() const {
+    equality_expression->flow();
+    relational_expression->flow();
+    return get_value_if_possible();
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    m_Value lhs = equality_expression->evaluate(evaluation);
+    m_Value rhs = relational_expression->evaluate(evaluation);
+    return evaluation.check(lhs != rhs);
+  }
+
+  bool branchless(unsigned &budget) const {
+    return branchless_operands(budget, equality_expression,
+                               relational_expression);
+  }
+
+  ASTNode *inlined(InlineFrame &frame, FlowAnalysis::Kind &kind) const {
+    ASTNode *lhs, *rhs;
+    if (!inline_operands(frame, equality_expression, relational_expression, lhs, rhs)) {
+      return nullptr;
+    }
+    kind = FlowAnalysis::UNTRACKED;
+    return new NonEqualityExpressionNode(lhs, rhs);
+  }
+
   ASTNode *optimise() const {
     auto ret = new NonEqualityExpressionNode(*this);
     ret->equality_expression = equality_expression->optimise();
     ret->relational_expression = relational_expression->optimise();
     m_Value v = get_value_if_possible();
     if (v.type == ActualValueType::INTEGER) {
-      return new IConstantNode(v.i);
+      return fold(this, v);
     }
     if (v.type == ActualValueType::FLOATING) {
-      return new FConstantNode(v.f);
+      return fold(this, v);
     }
 
     return ret;
@@ -3520,6 +7014,25 @@ public:
     return codeGenerator.getBuilder().CreateICmpNE(lhs, rhs, "nequal");
   }
 
+  RValue interpret() {
+    RValue lhs = equality_expression->interpret();
+    RValue rhs = relational_expression->interpret();
+    return interp_binary(InterpOp::NE, lhs, rhs);
+  }
+
+  uint32_t expr_id() const {
+    return expr_table.intern((int)type, {equality_expression->expr_id(),
+                                         relational_expression->expr_id()});
+  }
+
+  BcValue compileBytecode() {
+    return bytecodeCompiler.reuse(expr_id(), get_as_lvalue, [this]() {
+      BcValue lhs = equality_expression->compileBytecode();
+      BcValue rhs = relational_expression->compileBytecode();
+      return bytecodeCompiler.binary(InterpOp::NE, lhs, rhs);
+    });
+  }
+
 private:
   ASTNode *equality_expression;
   ASTNode *relational_expression;
@@ -3533,9 +7046,15 @@ public:
         relational_expression(relational_expression),
         shift_expression(shift_expression) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {relational_expression, shift_expression},
-                          depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {relational_expression, shift_expression}, out, false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {relational_expression, shift_expression}) {
+      visit(child);
+    }
   }
 
   vector<string> getPlainSymbol() const {
@@ -3550,11 +7069,36 @@ public:
            shift_expression->check_semantics();
   }
 
-  m_Value get_value_if_possible() const {
-    m_Value lhs = relational_expression->get_value_if_possible();
-    m_Value rhs = shift_expression->get_value_if_possible();
+  m_Value get_value_if_possible() const {
+    m_Value lhs = relational_expression->get_value_if_possible();
+    m_Value rhs = shift_expression->get_value_if_possible();
+
+    return (lhs < rhs);
+  }
+
+  m_Value flow() const {
+    relational_expression->flow();
+    shift_expression->flow();
+    return get_value_if_possible();
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    m_Value lhs = relational_expression->evaluate(evaluation);
+    m_Value rhs = shift_expression->evaluate(evaluation);
+    return evaluation.check(lhs < rhs);
+  }
+
+  bool branchless(unsigned &budget) const {
+    return branchless_operands(budget, relational_expression, shift_expression);
+  }
 
-    return (lhs < rhs);
+  ASTNode *inlined(InlineFrame &frame, FlowAnalysis::Kind &kind) const {
+    ASTNode *lhs, *rhs;
+    if (!inline_operands(frame, relational_expression, shift_expression, lhs, rhs)) {
+      return nullptr;
+    }
+    kind = FlowAnalysis::UNTRACKED;
+    return new LessThanExpressionNode(lhs, rhs);
   }
 
   ASTNode *optimise() const {
@@ -3564,10 +7108,10 @@ public:
 
     m_Value v = get_value_if_possible();
     if (v.type == ActualValueType::INTEGER) {
-      return new IConstantNode(v.i);
+      return fold(this, v);
     }
     if (v.type == ActualValueType::FLOATING) {
-      return new FConstantNode(v.f);
+      return fold(this, v);
     }
     return ret;
   }
@@ -3584,6 +7128,25 @@ public:
     return codeGenerator.getBuilder().CreateICmpSLT(lhs, rhs, "lt");
   }
 
+  RValue interpret() {
+    RValue lhs = relational_expression->interpret();
+    RValue rhs = shift_expression->interpret();
+    return interp_binary(InterpOp::LT, lhs, rhs);
+  }
+
+  uint32_t expr_id() const {
+    return expr_table.intern((int)type, {relational_expression->expr_id(),
+                                         shift_expression->expr_id()});
+  }
+
+  BcValue compileBytecode() {
+    return bytecodeCompiler.reuse(expr_id(), get_as_lvalue, [this]() {
+      BcValue lhs = relational_expression->compileBytecode();
+      BcValue rhs = shift_expression->compileBytecode();
+      return bytecodeCompiler.binary(InterpOp::LT, lhs, rhs);
+    });
+  }
+
 private:
   ASTNode *relational_expression;
   ASTNode *shift_expression;
@@ -3597,9 +7160,15 @@ public:
         relational_expression(relational_expression),
         shift_expression(shift_expression) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {relational_expression, shift_expression},
-                          depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {relational_expression, shift_expression}, out, false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {relational_expression, shift_expression}) {
+      visit(child);
+    }
   }
 
   vector<string> getPlainSymbol() const {
@@ -3620,6 +7189,31 @@ public:
     return (lhs > rhs);
   }
 
+  m_Value flow() const {
+    relational_expression->flow();
+    shift_expression->flow();
+    return get_value_if_possible();
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    m_Value lhs = relational_expression->evaluate(evaluation);
+    m_Value rhs = shift_expression->evaluate(evaluation);
+    return evaluation.check(lhs > rhs);
+  }
+
+  bool branchless(unsigned &budget) const {
+    return branchless_operands(budget, relational_expression, shift_expression);
+  }
+
+  ASTNode *inlined(InlineFrame &frame, FlowAnalysis::Kind &kind) const {
+    ASTNode *lhs, *rhs;
+    if (!inline_operands(frame, relational_expression, shift_expression, lhs, rhs)) {
+      return nullptr;
+    }
+    kind = FlowAnalysis::UNTRACKED;
+    return new GreaterThanExpressionNode(lhs, rhs);
+  }
+
   ASTNode *optimise() const {
     auto ret = new GreaterThanExpressionNode(*this);
     ret->relational_expression = relational_expression->optimise();
@@ -3627,10 +7221,10 @@ public:
 
     m_Value v = get_value_if_possible();
     if (v.type == ActualValueType::INTEGER) {
-      return new IConstantNode(v.i);
+      return fold(this, v);
     }
     if (v.type == ActualValueType::FLOATING) {
-      return new FConstantNode(v.f);
+      return fold(this, v);
     }
     return ret;
   }
@@ -3647,6 +7241,25 @@ public:
     return codeGenerator.getBuilder().CreateICmpSGT(lhs, rhs, "gt");
   }
 
+  RValue interpret() {
+    RValue lhs = relational_expression->interpret();
+    RValue rhs = shift_expression->interpret();
+    return interp_binary(InterpOp::GT, lhs, rhs);
+  }
+
+  uint32_t expr_id() const {
+    return expr_table.intern((int)type, {relational_expression->expr_id(),
+                                         shift_expression->expr_id()});
+  }
+
+  BcValue compileBytecode() {
+    return bytecodeCompiler.reuse(expr_id(), get_as_lvalue, [this]() {
+      BcValue lhs = relational_expression->compileBytecode();
+      BcValue rhs = shift_expression->compileBytecode();
+      return bytecodeCompiler.binary(InterpOp::GT, lhs, rhs);
+    });
+  }
+
 private:
   ASTNode *relational_expression;
   ASTNode *shift_expression;
@@ -3660,9 +7273,15 @@ public:
         relational_expression(relational_expression),
         shift_expression(shift_expression) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {relational_expression, shift_expression},
-                          depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {relational_expression, shift_expression}, out, false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {relational_expression, shift_expression}) {
+      visit(child);
+    }
   }
 
   vector<string> getPlainSymbol() const {
@@ -3683,6 +7302,31 @@ public:
     return (lhs <= rhs);
   }
 
+  m_Value flow() const {
+    relational_expression->flow();
+    shift_expression->flow();
+    return get_value_if_possible();
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    m_Value lhs = relational_expression->evaluate(evaluation);
+    m_Value rhs = shift_expression->evaluate(evaluation);
+    return evaluation.check(lhs <= rhs);
+  }
+
+  bool branchless(unsigned &budget) const {
+    return branchless_operands(budget, relational_expression, shift_expression);
+  }
+
+  ASTNode *inlined(InlineFrame &frame, FlowAnalysis::Kind &kind) const {
+    ASTNode *lhs, *rhs;
+    if (!inline_operands(frame, relational_expression, shift_expression, lhs, rhs)) {
+      return nullptr;
+    }
+    kind = FlowAnalysis::UNTRACKED;
+    return new LessOrEqualExpressionNode(lhs, rhs);
+  }
+
   ASTNode *optimise() const {
     auto ret = new LessOrEqualExpressionNode(*this);
     ret->relational_expression = relational_expression->optimise();
@@ -3690,10 +7334,10 @@ public:
 
     m_Value v = get_value_if_possible();
     if (v.type == ActualValueType::INTEGER) {
-      return new IConstantNode(v.i);
+      return fold(this, v);
     }
     if (v.type == ActualValueType::FLOATING) {
-      return new FConstantNode(v.f);
+      return fold(this, v);
     }
     return ret;
   }
@@ -3709,6 +7353,25 @@ public:
     return codeGenerator.getBuilder().CreateICmpSLE(lhs, rhs, "le");
   }
 
+  RValue interpret() {
+    RValue lhs = relational_expression->interpret();
+    RValue rhs = shift_expression->interpret();
+    return interp_binary(InterpOp::LE, lhs, rhs);
+  }
+
+  uint32_t expr_id() const {
+    return expr_table.intern((int)type, {relational_expression->expr_id(),
+                                         shift_expression->expr_id()});
+  }
+
+  BcValue compileBytecode() {
+    return bytecodeCompiler.reuse(expr_id(), get_as_lvalue, [this]() {
+      BcValue lhs = relational_expression->compileBytecode();
+      BcValue rhs = shift_expression->compileBytecode();
+      return bytecodeCompiler.binary(InterpOp::LE, lhs, rhs);
+    });
+  }
+
 private:
   ASTNode *relational_expression;
   ASTNode *shift_expression;
@@ -3722,9 +7385,15 @@ public:
         relational_expression(relational_expression),
         shift_expression(shift_expression) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {relational_expression, shift_expression},
-                          depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {relational_expression, shift_expression}, out, false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {relational_expression, shift_expression}) {
+      visit(child);
+    }
   }
 
   vector<string> getPlainSymbol() const {
@@ -3745,6 +7414,31 @@ public:
     return (lhs >= rhs);
   }
 
+  m_Value flow() const {
+    relational_expression->flow();
+    shift_expression->flow();
+    return get_value_if_possible();
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    m_Value lhs = relational_expression->evaluate(evaluation);
+    m_Value rhs = shift_expression->evaluate(evaluation);
+    return evaluation.check(lhs >= rhs);
+  }
+
+  bool branchless(unsigned &budget) const {
+    return branchless_operands(budget, relational_expression, shift_expression);
+  }
+
+  ASTNode *inlined(InlineFrame &frame, FlowAnalysis::Kind &kind) const {
+    ASTNode *lhs, *rhs;
+    if (!inline_operands(frame, relational_expression, shift_expression, lhs, rhs)) {
+      return nullptr;
+    }
+    kind = FlowAnalysis::UNTRACKED;
+    return new GreaterOrEqualExpressionNode(lhs, rhs);
+  }
+
   ASTNode *optimise() const {
     auto ret = new GreaterOrEqualExpressionNode(*this);
     ret->relational_expression = relational_expression->optimise();
@@ -3752,10 +7446,10 @@ public:
 
     m_Value v = get_value_if_possible();
     if (v.type == ActualValueType::INTEGER) {
-      return new IConstantNode(v.i);
+      return fold(this, v);
     }
     if (v.type == ActualValueType::FLOATING) {
-      return new FConstantNode(v.f);
+      return fold(this, v);
     }
     return ret;
   }
@@ -3772,6 +7466,25 @@ public:
     return codeGenerator.getBuilder().CreateICmpSGE(lhs, rhs, "ge");
   }
 
+  RValue interpret() {
+    RValue lhs = relational_expression->interpret();
+    RValue rhs = shift_expression->interpret();
+    return interp_binary(InterpOp::GE, lhs, rhs);
+  }
+
+  uint32_t expr_id() const {
+    return expr_table.intern((int)type, {relational_expression->expr_id(),
+                                         shift_expression->expr_id()});
+  }
+
+  BcValue compileBytecode() {
+    return bytecodeCompiler.reuse(expr_id(), get_as_lvalue, [this]() {
+      BcValue lhs = relational_expression->compileBytecode();
+      BcValue rhs = shift_expression->compileBytecode();
+      return bytecodeCompiler.binary(InterpOp::GE, lhs, rhs);
+    });
+  }
+
 private:
   ASTNode *relational_expression;
   ASTNode *shift_expression;
@@ -3785,9 +7498,15 @@ public:
         shift_expression(shift_expression),
         additive_expression(additive_expression) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {shift_expression, additive_expression}, depth,
-                          false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {shift_expression, additive_expression}, out, false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {shift_expression, additive_expression}) {
+      visit(child);
+    }
   }
 
   vector<string> getPlainSymbol() const {
@@ -3808,18 +7527,45 @@ public:
     return (lhs << rhs);
   }
 
+  m_Value flow() const {
+    shift_expression->flow();
+    additive_expression->flow();
+    return get_value_if_possible();
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    m_Value lhs = shift_expression->evaluate(evaluation);
+    m_Value rhs = additive_expression->evaluate(evaluation);
+    return evaluation.check(lhs << evaluation.shift(rhs));
+  }
+
+  bool binaryOperands(ASTNode *&lhs, ASTNode *&rhs) const {
+    lhs = shift_expression;
+    rhs = additive_expression;
+    return true;
+  }
+
+  ASTNode *inlined(InlineFrame &frame, FlowAnalysis::Kind &kind) const {
+    ASTNode *lhs, *rhs;
+    if (!inline_operands(frame, shift_expression, additive_expression, lhs, rhs)) {
+      return nullptr;
+    }
+    kind = FlowAnalysis::INT;
+    return new LeftShiftExpressionNode(lhs, rhs);
+  }
+
   ASTNode *optimise() const {
     auto ret = new LeftShiftExpressionNode(*this);
     ret->shift_expression = shift_expression->optimise();
     ret->additive_expression = additive_expression->optimise();
     m_Value v = get_value_if_possible();
     if (v.type == ActualValueType::INTEGER) {
-      return new IConstantNode(v.i);
+      return fold(this, v);
     }
     if (v.type == ActualValueType::FLOATING) {
-      return new FConstantNode(v.f);
+      return fold(this, v);
     }
-    return ret;
+    return simplify_binary(this, ret);
   }
 
   Value *codegen() {
@@ -3835,6 +7581,25 @@ public:
     return codeGenerator.getBuilder().CreateShl(lhs, rhs, "shl");
   }
 
+  RValue interpret() {
+    RValue lhs = shift_expression->interpret();
+    RValue rhs = additive_expression->interpret();
+    return interp_binary(InterpOp::SHL, lhs, rhs);
+  }
+
+  uint32_t expr_id() const {
+    return expr_table.intern((int)type, {shift_expression->expr_id(),
+                                         additive_expression->expr_id()});
+  }
+
+  BcValue compileBytecode() {
+    return bytecodeCompiler.reuse(expr_id(), get_as_lvalue, [this]() {
+      BcValue lhs = shift_expression->compileBytecode();
+      BcValue rhs = additive_expression->compileBytecode();
+      return bytecodeCompiler.binary(InterpOp::SHL, lhs, rhs);
+    });
+  }
+
 private:
   ASTNode *shift_expression;
   ASTNode *additive_expression;
@@ -3848,9 +7613,15 @@ public:
         shift_expression(shift_expression),
         additive_expression(additive_expression) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {shift_expression, additive_expression}, depth,
-                          false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {shift_expression, additive_expression}, out, false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {shift_expression, additive_expression}) {
+      visit(child);
+    }
   }
 
   vector<string> getPlainSymbol() const {
@@ -3866,18 +7637,45 @@ public:
     return (lhs >> rhs);
   }
 
+  m_Value flow() const {
+    shift_expression->flow();
+    additive_expression->flow();
+    return get_value_if_possible();
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    m_Value lhs = shift_expression->evaluate(evaluation);
+    m_Value rhs = additive_expression->evaluate(evaluation);
+    return evaluation.check(lhs >> evaluation.shift(rhs));
+  }
+
+  bool binaryOperands(ASTNode *&lhs, ASTNode *&rhs) const {
+    lhs = shift_expression;
+    rhs = additive_expression;
+    return true;
+  }
+
+  ASTNode *inlined(InlineFrame &frame, FlowAnalysis::Kind &kind) const {
+    ASTNode *lhs, *rhs;
+    if (!inline_operands(frame, shift_expression, additive_expression, lhs, rhs)) {
+      return nullptr;
+    }
+    kind = FlowAnalysis::INT;
+    return new RightShiftExpressionNode(lhs, rhs);
+  }
+
   ASTNode *optimise() const {
     auto ret = new RightShiftExpressionNode(*this);
     ret->shift_expression = shift_expression->optimise();
     ret->additive_expression = additive_expression->optimise();
     m_Value v = get_value_if_possible();
     if (v.type != ActualValueType::NO_VALUE) {
-      return new IConstantNode(v.i);
+      return fold(this, v);
     }
     if (v.type == ActualValueType::FLOATING) {
-      return new FConstantNode(v.f);
+      return fold(this, v);
     }
-    return ret;
+    return simplify_binary(this, ret);
   }
   bool check_semantics() {
     return shift_expression->check_semantics() &&
@@ -3896,6 +7694,25 @@ public:
     return codeGenerator.getBuilder().CreateAShr(lhs, rhs, "ashr");
   }
 
+  RValue interpret() {
+    RValue lhs = shift_expression->interpret();
+    RValue rhs = additive_expression->interpret();
+    return interp_binary(InterpOp::SHR, lhs, rhs);
+  }
+
+  uint32_t expr_id() const {
+    return expr_table.intern((int)type, {shift_expression->expr_id(),
+                                         additive_expression->expr_id()});
+  }
+
+  BcValue compileBytecode() {
+    return bytecodeCompiler.reuse(expr_id(), get_as_lvalue, [this]() {
+      BcValue lhs = shift_expression->compileBytecode();
+      BcValue rhs = additive_expression->compileBytecode();
+      return bytecodeCompiler.binary(InterpOp::SHR, lhs, rhs);
+    });
+  }
+
 private:
   ASTNode *shift_expression;
   ASTNode *additive_expression;
@@ -3909,9 +7726,16 @@ public:
         additive_expression(additive_expression),
         multiplicative_expression(multiplicative_expression) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(
-        this, {additive_expression, multiplicative_expression}, depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {additive_expression, multiplicative_expression}, out,
+                   false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {additive_expression, multiplicative_expression}) {
+      visit(child);
+    }
   }
 
   vector<string> getPlainSymbol() const {
@@ -3932,18 +7756,50 @@ public:
     return (lhs + rhs);
   }
 
+  m_Value flow() const {
+    additive_expression->flow();
+    multiplicative_expression->flow();
+    return get_value_if_possible();
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    m_Value lhs = additive_expression->evaluate(evaluation);
+    m_Value rhs = multiplicative_expression->evaluate(evaluation);
+    return evaluation.check(lhs + rhs);
+  }
+
+  bool binaryOperands(ASTNode *&lhs, ASTNode *&rhs) const {
+    lhs = additive_expression;
+    rhs = multiplicative_expression;
+    return true;
+  }
+
+  bool branchless(unsigned &budget) const {
+    return branchless_operands(budget, additive_expression,
+                               multiplicative_expression);
+  }
+
+  ASTNode *inlined(InlineFrame &frame, FlowAnalysis::Kind &kind) const {
+    ASTNode *lhs, *rhs;
+    if (!inline_operands(frame, additive_expression, multiplicative_expression, lhs, rhs)) {
+      return nullptr;
+    }
+    kind = FlowAnalysis::INT;
+    return new AdditiveExpressionNode(lhs, rhs);
+  }
+
   ASTNode *optimise() const {
     auto ret = new AdditiveExpressionNode(*this);
     ret->additive_expression = additive_expression->optimise();
     ret->multiplicative_expression = multiplicative_expression->optimise();
     m_Value v = get_value_if_possible();
     if (v.type == ActualValueType::INTEGER) {
-      return new IConstantNode(v.i);
+      return fold(this, v);
     }
     if (v.type == ActualValueType::FLOATING) {
-      return new FConstantNode(v.f);
+      return fold(this, v);
     }
-    return ret;
+    return simplify_binary(this, ret);
   }
 
   Value *codegen() {
@@ -3955,6 +7811,25 @@ public:
     return codeGenerator.getBuilder().CreateAdd(lhs, rhs, "add");
   }
 
+  RValue interpret() {
+    RValue lhs = additive_expression->interpret();
+    RValue rhs = multiplicative_expression->interpret();
+    return interp_binary(InterpOp::ADD, lhs, rhs);
+  }
+
+  uint32_t expr_id() const {
+    return expr_table.intern((int)type, {additive_expression->expr_id(),
+                                         multiplicative_expression->expr_id()});
+  }
+
+  BcValue compileBytecode() {
+    return bytecodeCompiler.reuse(expr_id(), get_as_lvalue, [this]() {
+      BcValue lhs = additive_expression->compileBytecode();
+      BcValue rhs = multiplicative_expression->compileBytecode();
+      return bytecodeCompiler.binary(InterpOp::ADD, lhs, rhs);
+    });
+  }
+
 private:
   ASTNode *additive_expression;
   ASTNode *multiplicative_expression;
@@ -3968,9 +7843,16 @@ public:
         additive_expression(additive_expression),
         multiplicative_expression(multiplicative_expression) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(
-        this, {additive_expression, multiplicative_expression}, depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {additive_expression, multiplicative_expression}, out,
+                   false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {additive_expression, multiplicative_expression}) {
+      visit(child);
+    }
   }
 
   vector<string> getPlainSymbol() const {
@@ -3991,18 +7873,50 @@ public:
     return (lhs - rhs);
   }
 
+  m_Value flow() const {
+    additive_expression->flow();
+    multiplicative_expression->flow();
+    return get_value_if_possible();
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    m_Value lhs = additive_expression->evaluate(evaluation);
+    m_Value rhs = multiplicative_expression->evaluate(evaluation);
+    return evaluation.check(lhs - rhs);
+  }
+
+  bool binaryOperands(ASTNode *&lhs, ASTNode *&rhs) const {
+    lhs = additive_expression;
+    rhs = multiplicative_expression;
+    return true;
+  }
+
+  bool branchless(unsigned &budget) const {
+    return branchless_operands(budget, additive_expression,
+                               multiplicative_expression);
+  }
+
+  ASTNode *inlined(InlineFrame &frame, FlowAnalysis::Kind &kind) const {
+    ASTNode *lhs, *rhs;
+    if (!inline_operands(frame, additive_expression, multiplicative_expression, lhs, rhs)) {
+      return nullptr;
+    }
+    kind = FlowAnalysis::INT;
+    return new SubExpressionNode(lhs, rhs);
+  }
+
   ASTNode *optimise() const {
     auto ret = new SubExpressionNode(*this);
     ret->additive_expression = additive_expression->optimise();
     ret->multiplicative_expression = multiplicative_expression->optimise();
     m_Value v = get_value_if_possible();
     if (v.type == ActualValueType::INTEGER) {
-      return new IConstantNode(v.i);
+      return fold(this, v);
     }
     if (v.type == ActualValueType::FLOATING) {
-      return new FConstantNode(v.f);
+      return fold(this, v);
     }
-    return ret;
+    return simplify_binary(this, ret);
   }
 
   Value *codegen() {
@@ -4014,6 +7928,25 @@ public:
     return codeGenerator.getBuilder().CreateSub(lhs, rhs, "sub");
   }
 
+  RValue interpret() {
+    RValue lhs = additive_expression->interpret();
+    RValue rhs = multiplicative_expression->interpret();
+    return interp_binary(InterpOp::SUB, lhs, rhs);
+  }
+
+  uint32_t expr_id() const {
+    return expr_table.intern((int)type, {additive_expression->expr_id(),
+                                         multiplicative_expression->expr_id()});
+  }
+
+  BcValue compileBytecode() {
+    return bytecodeCompiler.reuse(expr_id(), get_as_lvalue, [this]() {
+      BcValue lhs = additive_expression->compileBytecode();
+      BcValue rhs = multiplicative_expression->compileBytecode();
+      return bytecodeCompiler.binary(InterpOp::SUB, lhs, rhs);
+    });
+  }
+
 private:
   ASTNode *additive_expression;
   ASTNode *multiplicative_expression;
@@ -4027,9 +7960,16 @@ public:
         multiplicative_expression(multiplicative_expression),
         cast_expression(cast_expression) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {multiplicative_expression, cast_expression},
-                          depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {multiplicative_expression, cast_expression}, out,
+                   false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {multiplicative_expression, cast_expression}) {
+      visit(child);
+    }
   }
 
   vector<string> getPlainSymbol() const {
@@ -4050,18 +7990,50 @@ public:
     return (lhs * rhs);
   }
 
+  m_Value flow() const {
+    multiplicative_expression->flow();
+    cast_expression->flow();
+    return get_value_if_possible();
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    m_Value lhs = multiplicative_expression->evaluate(evaluation);
+    m_Value rhs = cast_expression->evaluate(evaluation);
+    return evaluation.check(lhs * rhs);
+  }
+
+  bool binaryOperands(ASTNode *&lhs, ASTNode *&rhs) const {
+    lhs = multiplicative_expression;
+    rhs = cast_expression;
+    return true;
+  }
+
+  bool branchless(unsigned &budget) const {
+    return branchless_operands(budget, multiplicative_expression,
+                               cast_expression);
+  }
+
+  ASTNode *inlined(InlineFrame &frame, FlowAnalysis::Kind &kind) const {
+    ASTNode *lhs, *rhs;
+    if (!inline_operands(frame, multiplicative_expression, cast_expression, lhs, rhs)) {
+      return nullptr;
+    }
+    kind = FlowAnalysis::INT;
+    return new MultiplicativeExpressionNode(lhs, rhs);
+  }
+
   ASTNode *optimise() const {
     auto ret = new MultiplicativeExpressionNode(*this);
     ret->multiplicative_expression = multiplicative_expression->optimise();
     ret->cast_expression = cast_expression->optimise();
     m_Value v = get_value_if_possible();
     if (v.type == ActualValueType::INTEGER) {
-      return new IConstantNode(v.i);
+      return fold(this, v);
     }
     if (v.type == ActualValueType::FLOATING) {
-      return new FConstantNode(v.f);
+      return fold(this, v);
     }
-    return ret;
+    return simplify_binary(this, ret);
   }
   Value *codegen() {
     Value *lhs = multiplicative_expression->codegen();
@@ -4071,6 +8043,25 @@ public:
     return codeGenerator.getBuilder().CreateMul(lhs, rhs, "mul");
   }
 
+  RValue interpret() {
+    RValue lhs = multiplicative_expression->interpret();
+    RValue rhs = cast_expression->interpret();
+    return interp_binary(InterpOp::MUL, lhs, rhs);
+  }
+
+  uint32_t expr_id() const {
+    return expr_table.intern((int)type, {multiplicative_expression->expr_id(),
+                                         cast_expression->expr_id()});
+  }
+
+  BcValue compileBytecode() {
+    return bytecodeCompiler.reuse(expr_id(), get_as_lvalue, [this]() {
+      BcValue lhs = multiplicative_expression->compileBytecode();
+      BcValue rhs = cast_expression->compileBytecode();
+      return bytecodeCompiler.binary(InterpOp::MUL, lhs, rhs);
+    });
+  }
+
 private:
   ASTNode *multiplicative_expression;
   ASTNode *cast_expression;
@@ -4084,9 +8075,16 @@ public:
         multiplicative_expression(multiplicative_expression),
         cast_expression(cast_expression) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {multiplicative_expression, cast_expression},
-                          depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {multiplicative_expression, cast_expression}, out,
+                   false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {multiplicative_expression, cast_expression}) {
+      visit(child);
+    }
   }
 
   vector<string> getPlainSymbol() const {
@@ -4106,18 +8104,45 @@ public:
     return (lhs / rhs);
   }
 
+  m_Value flow() const {
+    multiplicative_expression->flow();
+    cast_expression->flow();
+    return get_value_if_possible();
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    m_Value lhs = multiplicative_expression->evaluate(evaluation);
+    m_Value rhs = cast_expression->evaluate(evaluation);
+    return evaluation.check(lhs / evaluation.divisor(lhs, rhs));
+  }
+
+  bool binaryOperands(ASTNode *&lhs, ASTNode *&rhs) const {
+    lhs = multiplicative_expression;
+    rhs = cast_expression;
+    return true;
+  }
+
+  ASTNode *inlined(InlineFrame &frame, FlowAnalysis::Kind &kind) const {
+    ASTNode *lhs, *rhs;
+    if (!inline_operands(frame, multiplicative_expression, cast_expression, lhs, rhs)) {
+      return nullptr;
+    }
+    kind = FlowAnalysis::INT;
+    return new DivExpressionNode(lhs, rhs);
+  }
+
   ASTNode *optimise() const {
     auto ret = new DivExpressionNode(*this);
     ret->multiplicative_expression = multiplicative_expression->optimise();
     ret->cast_expression = cast_expression->optimise();
     m_Value v = get_value_if_possible();
     if (v.type == ActualValueType::INTEGER) {
-      return new IConstantNode(v.i);
+      return fold(this, v);
     }
     if (v.type == ActualValueType::FLOATING) {
-      return new FConstantNode(v.f);
+      return fold(this, v);
     }
-    return ret;
+    return simplify_binary(this, ret);
   }
 
   Value *codegen() {
@@ -4128,6 +8153,25 @@ public:
     return codeGenerator.getBuilder().CreateSDiv(lhs, rhs, "div");
   }
 
+  RValue interpret() {
+    RValue lhs = multiplicative_expression->interpret();
+    RValue rhs = cast_expression->interpret();
+    return interp_binary(InterpOp::DIV, lhs, rhs);
+  }
+
+  uint32_t expr_id() const {
+    return expr_table.intern((int)type, {multiplicative_expression->expr_id(),
+                                         cast_expression->expr_id()});
+  }
+
+  BcValue compileBytecode() {
+    return bytecodeCompiler.reuse(expr_id(), get_as_lvalue, [this]() {
+      BcValue lhs = multiplicative_expression->compileBytecode();
+      BcValue rhs = cast_expression->compileBytecode();
+      return bytecodeCompiler.binary(InterpOp::DIV, lhs, rhs);
+    });
+  }
+
 private:
   ASTNode *multiplicative_expression;
   ASTNode *cast_expression;
@@ -4141,9 +8185,16 @@ public:
         multiplicative_expression(multiplicative_expression),
         cast_expression(cast_expression) {}
 
-  string dump_ast(int depth = 0) const {
-    return dumpParameters(this, {multiplicative_expression, cast_expression},
-                          depth, false);
+  void dump(AstWriter &out) const {
+    dumpParameters(this, {multiplicative_expression, cast_expression}, out,
+                   false);
+  }
+
+  void
+  forEachChild(const std::function<void(const ASTNode *)> &visit) const {
+    for (auto child : {multiplicative_expression, cast_expression}) {
+      visit(child);
+    }
   }
 
   vector<string> getPlainSymbol() const {
@@ -4162,6 +8213,33 @@ public:
     return (lhs % rhs);
   }
 
+  m_Value flow() const {
+    multiplicative_expression->flow();
+    cast_expression->flow();
+    return get_value_if_possible();
+  }
+
+  m_Value evaluate(ConstEvaluation &evaluation) const {
+    m_Value lhs = multiplicative_expression->evaluate(evaluation);
+    m_Value rhs = cast_expression->evaluate(evaluation);
+    return evaluation.check(lhs % evaluation.divisor(lhs, rhs));
+  }
+
+  bool binaryOperands(ASTNode *&lhs, ASTNode *&rhs) const {
+    lhs = multiplicative_expression;
+    rhs = cast_expression;
+    return true;
+  }
+
+  ASTNode *inlined(InlineFrame &frame, FlowAnalysis::Kind &kind) const {
+    ASTNode *lhs, *rhs;
+    if (!inline_operands(frame, multiplicative_expression, cast_expression, lhs, rhs)) {
+      return nullptr;
+    }
+    kind = FlowAnalysis::INT;
+    return new ModExpressionNode(lhs, rhs);
+  }
+
   ASTNode *optimise() const {
     auto ret = new ModExpressionNode(*this);
     ret->multiplicative_expression = multiplicative_expression->optimise();
@@ -4169,12 +8247,12 @@ public:
 
     m_Value v = get_value_if_possible();
     if (v.type == ActualValueType::INTEGER) {
-      return new IConstantNode(v.i);
+      return fold(this, v);
     }
     if (v.type == ActualValueType::FLOATING) {
-      return new FConstantNode(v.f);
+      return fold(this, v);
     }
-    return ret;
+    return simplify_binary(this, ret);
   }
 
   Value *codegen() {
@@ -4190,9 +8268,198 @@ public:
     return codeGenerator.getBuilder().CreateSRem(lhs, rhs, "mod");
   }
 
+  RValue interpret() {
+    RValue lhs = multiplicative_expression->interpret();
+    RValue rhs = cast_expression->interpret();
+    return interp_binary(InterpOp::MOD, lhs, rhs);
+  }
+
+  uint32_t expr_id() const {
+    return expr_table.intern((int)type, {multiplicative_expression->expr_id(),
+                                         cast_expression->expr_id()});
+  }
+
+  BcValue compileBytecode() {
+    return bytecodeCompiler.reuse(expr_id(), get_as_lvalue, [this]() {
+      BcValue lhs = multiplicative_expression->compileBytecode();
+      BcValue rhs = cast_expression->compileBytecode();
+      return bytecodeCompiler.binary(InterpOp::MOD, lhs, rhs);
+    });
+  }
+
 private:
   ASTNode *multiplicative_expression;
   ASTNode *cast_expression;
 };
 
+static ASTNode *make_binary(NodeType op, ASTNode *lhs, ASTNode *rhs) {
+  switch (op) {
+  case NodeType::InclusiveOrExpression:
+    return new InclusiveOrExpressionNode(lhs, rhs);
+  case NodeType::ExclusiveOrExpression:
+    return new ExclusiveOrExpressionNode(lhs, rhs);
+  case NodeType::AndExpression:
+    return new AndExpressionNode(lhs, rhs);
+  case NodeType::LeftShiftExpression:
+    return new LeftShiftExpressionNode(lhs, rhs);
+  case NodeType::RightShiftExpression:
+    return new RightShiftExpressionNode(lhs, rhs);
+  case NodeType::AdditiveExpression:
+    return new AdditiveExpressionNode(lhs, rhs);
+  case NodeType::SubExpression:
+    return new SubExpressionNode(lhs, rhs);
+  case NodeType::MultiplicativeExpression:
+    return new MultiplicativeExpressionNode(lhs, rhs);
+  case NodeType::DivExpression:
+    return new DivExpressionNode(lhs, rhs);
+  case NodeType::ModExpression:
+    return new ModExpressionNode(lhs, rhs);
+  default:
+    throw std::runtime_error("make_binary: " + nodeTypeToString(op));
+  }
+}
+
+// Whether the expression has type int. Only int locals tracked by the
+// flow analysis are known among the variables. Comparisons are left out:
+// codegen gives them an i1, which the other operators do not all take.
+static bool integral_expression(const ASTNode *node) {
+  ASTNode *lhs, *rhs;
+  switch (node->getNodeType()) {
+  case NodeType::IConstant:
+    return true;
+  case NodeType::Identifier:
+    return optimisationContext.flow.kind(node) == FlowAnalysis::INT;
+  case NodeType::ExpressionList:
+    return node->children.size() == 1 &&
+           integral_expression(node->children[0]);
+  default:
+    return node->binaryOperands(lhs, rhs) && integral_expression(lhs) &&
+           integral_expression(rhs);
+  }
+}
+
+// Whether an int expression is known not to be negative
+static bool nonnegative_expression(const ASTNode *node) {
+  m_Value v = node->get_value_if_possible();
+  if (v.type == ActualValueType::INTEGER) {
+    return v.i >= 0;
+  }
+  ASTNode *lhs, *rhs;
+  switch (node->getNodeType()) {
+  case NodeType::ExpressionList:
+    return node->children.size() == 1 &&
+           nonnegative_expression(node->children[0]);
+  case NodeType::AndExpression:
+    node->binaryOperands(lhs, rhs);
+    return nonnegative_expression(lhs) || nonnegative_expression(rhs);
+  case NodeType::RightShiftExpression:
+  case NodeType::DivExpression:
+    node->binaryOperands(lhs, rhs);
+    return nonnegative_expression(lhs) && nonnegative_expression(rhs);
+  default:
+    return false;
+  }
+}
+
+// `node` is the optimised copy of `original`, whose subtree is what the
+// flow analysis knows the types of
+static Operand describe_operand(const ASTNode *original, ASTNode *node) {
+  // Looks through parentheses
+  const ASTNode *inner = node;
+  while (inner->getNodeType() == NodeType::ExpressionList &&
+         inner->children.size() == 1) {
+    inner = inner->children[0];
+  }
+
+  Operand operand;
+  operand.node = node;
+  operand.value = node->get_value_if_possible();
+  // Expressions with side effects take a fresh id each time
+  uint32_t id = inner->expr_id();
+  operand.id = id == inner->expr_id() ? id : 0;
+  operand.integral = integral_expression(original);
+  operand.nonnegative = operand.integral && nonnegative_expression(node);
+
+  ASTNode *lhs, *rhs;
+  if (inner->binaryOperands(lhs, rhs)) {
+    operand.op = inner->getNodeType();
+    operand.inner = lhs;
+    operand.inner_value = rhs->get_value_if_possible();
+  }
+  return operand;
+}
+
+static ASTNode *fold(const ASTNode *original, const m_Value &value) {
+  compile_stats.fold(original->getNodeType());
+  if (value.type == ActualValueType::FLOATING) {
+    return new FConstantNode(value.f);
+  }
+  return new IConstantNode(value.i);
+}
+
+static ASTNode *simplify_binary(const ASTNode *original, ASTNode *node) {
+  ASTNode *original_lhs, *original_rhs, *lhs, *rhs;
+  original->binaryOperands(original_lhs, original_rhs);
+  node->binaryOperands(lhs, rhs);
+  Rewrite rewrite =
+      simplifier.simplify(node->getNodeType(),
+                          describe_operand(original_lhs, lhs),
+                          describe_operand(original_rhs, rhs));
+  switch (rewrite.kind) {
+  case Rewrite::OPERAND:
+    return rewrite.node;
+  case Rewrite::CONSTANT:
+    return fold(original, rewrite.value);
+  case Rewrite::BINARY:
+    return make_binary(rewrite.op, rewrite.node,
+                       new IConstantNode(rewrite.value.i));
+  default:
+    return node;
+  }
+}
+
+static ASTNode *make_declaration(ASTNode *declaration_specifiers,
+                                 ASTNode *declarator) {
+  auto list = new InitDeclartorListNode();
+  list->addChild(new InitDeclartorNode(declarator, new NullPtrNode()));
+  return new DeclarationNode(declaration_specifiers, list);
+}
+
+static ASTNode *inline_call(const string &name,
+                            const vector<ASTNode *> &original,
+                            const vector<ASTNode *> &args) {
+  Inliner::Function function;
+  if (!inliner.find(name, function) ||
+      function.params.size() != args.size()) {
+    return nullptr;
+  }
+  for (size_t i = 0; i < args.size(); i++) {
+    const InlineParam &param = function.params[i];
+    bool variable = original[i]->getNodeType() == NodeType::Identifier;
+    bool constant =
+        args[i]->get_value_if_possible().type == ActualValueType::INTEGER;
+    if (param.pointer ? !variable
+                      : !(constant || integral_expression(original[i]))) {
+      return nullptr;
+    }
+    if (param.uses > 1 && args[i]->getNodeType() != NodeType::Identifier &&
+        args[i]->getNodeType() != NodeType::IConstant) {
+      return nullptr;
+    }
+  }
+
+  InlineFrame frame;
+  frame.params = function.params;
+  for (InlineParam &param : frame.params) {
+    param.uses = 0;
+  }
+  frame.args = args;
+  FlowAnalysis::Kind kind;
+  ASTNode *body = inline_expression(function.body, frame, kind);
+  if (body) {
+    inliner.inlined();
+  }
+  return body;
+}
+
 #endif
@@ -383,41 +383,6 @@ static std::string nodeTypeToString(NodeType type) {
   }
 }
 
-// static string formatSpacing(int depth) {
-//     string result = "";
-//     for (int i = 0; i < depth; i++) {
-//         result += "  ";
-//     }
-//     return result;
-// }
-
-static std::string formatSpacing(int depth) {
-  std::string result = "";
-  for (int i = 0; i < depth; i++) {
-    switch (i % 5) { // Using 5 different colors
-    case 0:
-      result += "\033[38;2;1;22;30m";
-      break;
-    case 1:
-      result += "\033[38;2;18;69;89m";
-      break;
-    case 2:
-      result += "\033[38;2;89;131;146m";
-      break;
-    case 3:
-      result += "\033[38;2;174;195;176m";
-      break;
-    case 4:
-      result += "\033[38;2;239;246;224m";
-      break;
-    }
-    result += i == depth - 1 ? " ┣━" : " ┃ ";
-  }
-  // Reset color to default
-  result += "\033[0m";
-  return result;
-}
-
 static std::string convertRawString(const std::string &raw) {
   std::string result;
   bool escape = false;
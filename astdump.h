@@ -0,0 +1,226 @@
+#ifndef INCLUDE_CC_ASTDUMP_H_
+#define INCLUDE_CC_ASTDUMP_H_
+
+#include "AST_enums.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Output of --dump-ast. A node describes itself to an AstWriter as events in
+// pre-order: open() a node, give its properties, dump its children, close()
+// it; nodes without children are a single leaf(). Writers stream each event
+// straight to an ostream, so a dump is linear in the size of the tree.
+enum class AstFormat { Text, Json, Binary };
+
+class AstWriter {
+public:
+  virtual ~AstWriter() {}
+
+  // Starts a node; its properties and children follow until close()
+  virtual void open(NodeType type, bool is_list) = 0;
+  virtual void close() = 0;
+
+  // A node without children, with an optional value (a name, a constant)
+  virtual void leaf(NodeType type, const string &value) = 0;
+
+  // A named attribute of the open node, given before its children
+  virtual void property(const string &name, const string &value) = 0;
+};
+
+// A JSON string literal holding `text`
+static string json_string(const string &text) {
+  string json = "\"";
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      json += '\\';
+      json += c;
+    } else if ((unsigned char)c < 0x20) {
+      char escape[8];
+      snprintf(escape, sizeof(escape), "\\u%04x", c);
+      json += escape;
+    } else {
+      json += c;
+    }
+  }
+  return json + "\"";
+}
+
+// The indented tree read by people. Guides are coloured with 24-bit escapes
+// only when `colour`, i.e. when writing to a terminal.
+class TextAstWriter : public AstWriter {
+public:
+  TextAstWriter(ostream &out, bool colour) : out(out), colour(colour) {}
+
+  void open(NodeType type, bool is_list) {
+    separate();
+    indent(open_lists.size());
+    out << nodeTypeToString(type) << (is_list ? "[\n" : "{\n");
+    open_lists.push_back(is_list);
+    children.push_back(0);
+  }
+
+  void close() {
+    bool is_list = open_lists.back();
+    open_lists.pop_back();
+    children.pop_back();
+    indent(open_lists.size());
+    out << (is_list ? "]\n" : "}\n");
+  }
+
+  void leaf(NodeType type, const string &value) {
+    separate();
+    indent(open_lists.size());
+    out << nodeTypeToString(type);
+    if (!value.empty()) {
+      out << ": " << value;
+    }
+    out << '\n';
+  }
+
+  void property(const string &name, const string &value) {
+    indent(open_lists.size());
+    out << name << ": " << value << '\n';
+  }
+
+private:
+  // Writes the "," line between the elements of a list
+  void separate() {
+    if (children.empty()) {
+      return;
+    }
+    if (children.back()++ && open_lists.back()) {
+      indent(open_lists.size() - 1);
+      out << ",\n";
+    }
+  }
+
+  void indent(size_t depth) {
+    static const char *const palette[] = {
+        "\033[38;2;1;22;30m", "\033[38;2;18;69;89m", "\033[38;2;89;131;146m",
+        "\033[38;2;174;195;176m", "\033[38;2;239;246;224m"};
+    for (size_t i = 0; i < depth; i++) {
+      if (colour) {
+        out << palette[i % 5];
+      }
+      out << (i == depth - 1 ? " ┣━" : " ┃ ");
+    }
+    if (colour && depth) {
+      out << "\033[0m";
+    }
+  }
+
+  ostream &out;
+  bool colour;
+  vector<bool> open_lists;
+  vector<size_t> children;
+};
+
+// One compact JSON object per node:
+//   {"type":"...","list":true,"<property>":"...","children":[...]}
+//   {"type":"...","value":"..."}
+// "list" is only present on list nodes, "children" only when there are any.
+class JsonAstWriter : public AstWriter {
+public:
+  JsonAstWriter(ostream &out) : out(out) {}
+
+  void open(NodeType type, bool is_list) {
+    separate();
+    out << "{\"type\":\"" << nodeTypeToString(type) << '"';
+    if (is_list) {
+      out << ",\"list\":true";
+    }
+    children.push_back(0);
+  }
+
+  void close() {
+    out << (children.back() ? "]}" : "}");
+    children.pop_back();
+  }
+
+  void leaf(NodeType type, const string &value) {
+    separate();
+    out << "{\"type\":\"" << nodeTypeToString(type) << '"';
+    if (!value.empty()) {
+      out << ",\"value\":" << json_string(value);
+    }
+    out << '}';
+  }
+
+  void property(const string &name, const string &value) {
+    out << ',' << json_string(name) << ':' << json_string(value);
+  }
+
+private:
+  void separate() {
+    if (!children.empty()) {
+      out << (children.back()++ ? "," : ",\"children\":[");
+    }
+  }
+
+  ostream &out;
+  vector<size_t> children;
+};
+
+// A byte stream for tools that load large trees. After the 6-byte header
+// "CCAST\1" each event is a tag byte followed by its operands:
+//   'O' type:u8 is_list:u8     open
+//   'C'                        close
+//   'L' type:u8 value:str      leaf
+//   'P' name:str value:str     property
+// where a str is its length as an unsigned LEB128 followed by the bytes, and
+// type is the NodeType enumerator.
+class BinaryAstWriter : public AstWriter {
+public:
+  BinaryAstWriter(ostream &out) : out(out) { out.write("CCAST\1", 6); }
+
+  void open(NodeType type, bool is_list) {
+    out.put('O');
+    out.put((char)type);
+    out.put((char)is_list);
+  }
+
+  void close() { out.put('C'); }
+
+  void leaf(NodeType type, const string &value) {
+    out.put('L');
+    out.put((char)type);
+    str(value);
+  }
+
+  void property(const string &name, const string &value) {
+    out.put('P');
+    str(name);
+    str(value);
+  }
+
+private:
+  void str(const string &text) {
+    uint64_t size = text.size();
+    do {
+      uint8_t byte = size & 0x7f;
+      size >>= 7;
+      out.put((char)(size ? byte | 0x80 : byte));
+    } while (size);
+    out.write(text.data(), text.size());
+  }
+
+  ostream &out;
+};
+
+static unique_ptr<AstWriter> make_ast_writer(AstFormat format, ostream &out,
+                                             bool colour = false) {
+  switch (format) {
+  case AstFormat::Json:
+    return unique_ptr<AstWriter>(new JsonAstWriter(out));
+  case AstFormat::Binary:
+    return unique_ptr<AstWriter>(new BinaryAstWriter(out));
+  default:
+    return unique_ptr<AstWriter>(new TextAstWriter(out, colour));
+  }
+}
+
+#endif // INCLUDE_CC_ASTDUMP_H_
@@ -0,0 +1,296 @@
+#ifndef INCLUDE_CC_BACKEND_H_
+#define INCLUDE_CC_BACKEND_H_
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Analysis/ModuleSummaryAnalysis.h"
+#include "llvm/Analysis/ProfileSummaryInfo.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/CodeGen/ParallelCG.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/MC/TargetRegistry.h"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/Passes/StandardInstrumentations.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Program.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Target/TargetOptions.h"
+#include "llvm/Transforms/IPO/Internalize.h"
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+using namespace std;
+
+// PIC so that the objects can be linked with -pie, like the llc route. At
+// CodeGenOpt::None instructions are selected by FastISel and registers
+// allocated by the fast allocator.
+static unique_ptr<llvm::TargetMachine> createHostTargetMachine(
+    llvm::CodeGenOpt::Level level = llvm::CodeGenOpt::Default) {
+  string triple = llvm::sys::getDefaultTargetTriple();
+  string error;
+  const llvm::Target *target = llvm::TargetRegistry::lookupTarget(triple, error);
+  if (!target) {
+    throw std::runtime_error("No target for " + triple + ": " + error);
+  }
+
+  llvm::TargetOptions options;
+  return unique_ptr<llvm::TargetMachine>(target->createTargetMachine(
+      triple, "generic", "", options, llvm::Reloc::PIC_, llvm::None, level));
+}
+
+// Codegen can leave instructions after a block's terminator. Re-parsing the
+// printed IR turns them into unreachable blocks, so llc never sees them; in
+// memory they have to be dropped before the module is lowered.
+static void drop_code_after_terminators(llvm::Module &module) {
+  for (auto &function : module) {
+    for (auto &block : function) {
+      llvm::Instruction *terminator = nullptr;
+      for (auto &instruction : block) {
+        if (instruction.isTerminator()) {
+          terminator = &instruction;
+          break;
+        }
+      }
+      if (!terminator) {
+        continue;
+      }
+
+      while (&block.back() != terminator) {
+        llvm::Instruction &dead = block.back();
+        if (!dead.use_empty()) {
+          dead.replaceAllUsesWith(llvm::UndefValue::get(dead.getType()));
+        }
+        dead.eraseFromParent();
+      }
+    }
+  }
+}
+
+// A copy of `module` read back from bitcode, into the same context. The
+// builder's own modules have crashed LLVM passes on IR that passes the
+// verifier, and tearing them down can double free, so `module` is leaked.
+static unique_ptr<llvm::Module> reload(unique_ptr<llvm::Module> module) {
+  drop_code_after_terminators(*module);
+  llvm::SmallString<0> bitcode;
+  llvm::raw_svector_ostream bitcode_out(bitcode);
+  llvm::WriteBitcodeToFile(*module, bitcode_out);
+
+  llvm::Expected<unique_ptr<llvm::Module>> copy = llvm::parseBitcodeFile(
+      llvm::MemoryBufferRef(bitcode.str(), module->getName()),
+      module->getContext());
+  if (!copy) {
+    throw std::runtime_error("Cannot reload " + module->getName().str() +
+                             ": " + llvm::toString(copy.takeError()));
+  }
+  module.release();
+  return std::move(*copy);
+}
+
+// Writes `module` as bitcode. Function bodies are always indexed by offset,
+// so a reader can load them lazily; with `summary` the file also carries a
+// module summary (the call graph and references of every function), which
+// lets tools such as llvm-lto plan a link without loading the bodies.
+static void write_bitcode(llvm::Module &module, const string &out_filename,
+                          bool summary) {
+  drop_code_after_terminators(module);
+  std::error_code EC;
+  llvm::raw_fd_ostream out(out_filename, EC, llvm::sys::fs::OF_None);
+  if (EC) {
+    throw std::runtime_error("Cannot open " + out_filename);
+  }
+  if (!summary) {
+    llvm::WriteBitcodeToFile(module, out);
+    return;
+  }
+  llvm::ProfileSummaryInfo profile(module);
+  llvm::ModuleSummaryIndex index =
+      llvm::buildModuleSummaryIndex(module, nullptr, &profile);
+  llvm::WriteBitcodeToFile(module, out, false, &index);
+}
+
+// Opens a bitcode file into `context`. Only the module's globals are read
+// here; function bodies are loaded when they are first needed, by the
+// linker or by Module::materializeAll().
+static unique_ptr<llvm::Module> read_bitcode(const string &file,
+                                             llvm::LLVMContext &context) {
+  llvm::ErrorOr<unique_ptr<llvm::MemoryBuffer>> buffer =
+      llvm::MemoryBuffer::getFile(file);
+  if (!buffer) {
+    throw std::runtime_error("Cannot open " + file + ": " +
+                             buffer.getError().message());
+  }
+  llvm::Expected<unique_ptr<llvm::Module>> module =
+      llvm::getOwningLazyBitcodeModule(std::move(*buffer), context);
+  if (!module) {
+    throw std::runtime_error("Cannot read " + file + ": " +
+                             llvm::toString(module.takeError()));
+  }
+  return std::move(*module);
+}
+
+// --whole-program: links the modules of every translation unit into one,
+// in which only main stays visible, and with `optimise` runs LLVM's
+// link-time pipeline over it, so that calls between translation units can
+// be inlined and their arguments propagated. The modules are built by the
+// compiler and passed through reload(), or read from bitcode files, all in
+// `context`.
+static unique_ptr<llvm::Module>
+link_whole_program(vector<unique_ptr<llvm::Module>> modules,
+                   llvm::LLVMContext &context, bool optimise) {
+  auto program = make_unique<llvm::Module>("global_module", context);
+  llvm::Linker linker(*program);
+  for (unique_ptr<llvm::Module> &module : modules) {
+    string name = module->getModuleIdentifier();
+    if (linker.linkInModule(std::move(module))) {
+      throw std::runtime_error("Cannot link " + name);
+    }
+  }
+
+  llvm::internalizeModule(*program, [](const llvm::GlobalValue &value) {
+    return value.getName() == "main";
+  });
+
+  string errors;
+  llvm::raw_string_ostream errors_out(errors);
+  if (llvm::verifyModule(*program, &errors_out)) {
+    throw std::runtime_error("Linked module is invalid: " + errors_out.str());
+  }
+  if (!optimise) {
+    return program;
+  }
+
+  llvm::LoopAnalysisManager loops;
+  llvm::FunctionAnalysisManager functions;
+  llvm::CGSCCAnalysisManager cgscc;
+  llvm::ModuleAnalysisManager module_analyses;
+  // Reports the passes under -ftime-report and traces them under
+  // -ftime-trace
+  llvm::PassInstrumentationCallbacks instrumentation;
+  llvm::StandardInstrumentations standard(false);
+  standard.registerCallbacks(instrumentation, &functions);
+  llvm::PassBuilder builder(nullptr, llvm::PipelineTuningOptions(),
+                            llvm::None, &instrumentation);
+  builder.registerModuleAnalyses(module_analyses);
+  builder.registerCGSCCAnalyses(cgscc);
+  builder.registerFunctionAnalyses(functions);
+  builder.registerLoopAnalyses(loops);
+  builder.crossRegisterProxies(loops, functions, cgscc, module_analyses);
+  builder.buildLTODefaultPipeline(llvm::OptimizationLevel::O2, nullptr)
+      .run(*program, module_analyses);
+  return program;
+}
+
+static void remove_files(const vector<string> &files) {
+  for (auto &file : files) {
+    llvm::sys::fs::remove(file);
+  }
+}
+
+// Merges the partial objects into `out_filename` with `ld -r`
+static void link_partitions(const vector<string> &partitions,
+                            const string &out_filename) {
+  llvm::ErrorOr<string> ld = llvm::sys::findProgramByName("ld");
+  if (!ld) {
+    throw std::runtime_error("Cannot find ld to link the partitions");
+  }
+  vector<llvm::StringRef> argv = {*ld, "-r", "-o", out_filename};
+  argv.insert(argv.end(), partitions.begin(), partitions.end());
+  string error;
+  int status =
+      llvm::sys::ExecuteAndWait(*ld, argv, llvm::None, {}, 0, 0, &error);
+  if (status != 0) {
+    throw std::runtime_error(
+        "Linking partitions failed: " +
+        (status < 0 ? error : "ld exited with " + to_string(status)));
+  }
+}
+
+// Lowers `module` to a single object file. With more than one thread the
+// module is split by function, the partitions go through instruction
+// selection and register allocation concurrently (each in its own
+// LLVMContext), and the partial objects are merged with `ld -r`.
+static void emit_object(llvm::Module &module, const string &out_filename,
+                        unsigned threads, llvm::CodeGenOpt::Level level) {
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+
+  drop_code_after_terminators(module);
+
+  unique_ptr<llvm::TargetMachine> target_machine =
+      createHostTargetMachine(level);
+  module.setTargetTriple(target_machine->getTargetTriple().str());
+  module.setDataLayout(target_machine->createDataLayout());
+
+  std::error_code EC;
+
+  if (threads <= 1) {
+    llvm::raw_fd_ostream out(out_filename, EC, llvm::sys::fs::OF_None);
+    if (EC) {
+      throw std::runtime_error("Cannot open " + out_filename);
+    }
+
+    // Lower a copy read back from bitcode, exactly as every partition of
+    // the parallel path is: the builder's own module has crashed
+    // CodeGenPrepare on IR that passes the verifier.
+    llvm::SmallString<0> bitcode;
+    llvm::raw_svector_ostream bitcode_out(bitcode);
+    llvm::WriteBitcodeToFile(module, bitcode_out);
+
+    llvm::LLVMContext context;
+    llvm::Expected<unique_ptr<llvm::Module>> copy = llvm::parseBitcodeFile(
+        llvm::MemoryBufferRef(bitcode.str(), module.getName()), context);
+    if (!copy) {
+      throw std::runtime_error("Cannot reload " + module.getName().str() +
+                               ": " + llvm::toString(copy.takeError()));
+    }
+
+    llvm::legacy::PassManager pass_manager;
+    if (target_machine->addPassesToEmitFile(pass_manager, out, nullptr,
+                                            llvm::CGFT_ObjectFile)) {
+      throw std::runtime_error("Target cannot emit object files");
+    }
+    pass_manager.run(**copy);
+    return;
+  }
+
+  vector<string> partitions;
+  try {
+    vector<unique_ptr<llvm::raw_fd_ostream>> streams;
+    vector<llvm::raw_pwrite_stream *> outs;
+    for (unsigned i = 0; i < threads; i++) {
+      partitions.push_back(out_filename + ".part" + to_string(i));
+      streams.push_back(make_unique<llvm::raw_fd_ostream>(
+          partitions.back(), EC, llvm::sys::fs::OF_None));
+      if (EC) {
+        throw std::runtime_error("Cannot open " + partitions.back());
+      }
+      outs.push_back(streams.back().get());
+    }
+
+    // Private globals (string literals) stay in the same partition as every
+    // function or global that refers to them, so splitting adds no exported
+    // symbols.
+    llvm::splitCodeGen(
+        module, outs, {}, [level]() { return createHostTargetMachine(level); },
+        llvm::CGFT_ObjectFile, true);
+    streams.clear();
+
+    link_partitions(partitions, out_filename);
+  } catch (...) {
+    remove_files(partitions);
+    throw;
+  }
+  remove_files(partitions);
+}
+
+#endif // INCLUDE_CC_BACKEND_H_
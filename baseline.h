@@ -0,0 +1,772 @@
+#ifndef INCLUDE_CC_BASELINE_H_
+#define INCLUDE_CC_BASELINE_H_
+
+#include "bytecode.h"
+#include "vm.h"
+#include <csetjmp>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <dlfcn.h>
+#include <initializer_list>
+#include <memory>
+#include <pthread.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <vector>
+using namespace std;
+
+// Baseline x86-64 backend (--baseline). The optimised AST is lowered to
+// bytecode as for --vm, then every instruction is replaced by a fixed
+// template of machine code, with its registers and offsets patched in, in
+// one pass per function and without LLVM. The code runs from an executable
+// buffer in-process.
+//
+// The VM's registers become 8-byte stack slots of the native frame,
+// addressed from rbx, and its frame memory follows them, addressed from
+// r12. Nothing is kept in machine registers between instructions. A call
+// passes the address of its argument slots in rdi and the callee copies
+// them into its own slots; the result comes back in rax. Natives are
+// called directly with the SysV ABI.
+//
+// Errors the VM would throw (division by zero, traps, running out of
+// stack) jump back out of the program, which then fails like on the VM.
+class BaselineCompiler {
+public:
+  explicit BaselineCompiler(const BcImage &image) : image(image) {
+    const BcHeader &header = image.header();
+    globals = make_unique<char[]>(header.globals_size ? header.globals_size
+                                                      : 1);
+    entries.resize(header.function_count);
+    for (uint32_t f = 0; f < header.function_count; f++) {
+      if (image.functions()[f].code_size) {
+        function(f);
+      }
+    }
+    for (auto &call : calls) {
+      patch(call.first, entries[call.second]);
+    }
+
+    size = (code.size() + 4095) & ~size_t(4095);
+    void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+      throw std::runtime_error("Cannot map memory for native code");
+    }
+    memcpy(memory, code.data(), code.size());
+    if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+      munmap(memory, size);
+      throw std::runtime_error("Cannot make native code executable");
+    }
+    text = (uint8_t *)memory;
+  }
+
+  ~BaselineCompiler() {
+    if (text) {
+      munmap(text, size);
+    }
+  }
+
+  size_t codeSize() const { return code.size(); }
+
+  // Runs the global initialisers, then main, on a thread with a stack as
+  // large as the VM's; returns main's result
+  int64_t run() {
+    const size_t stack_size = 256 << 20;
+    void *stack = mmap(nullptr, stack_size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (stack == MAP_FAILED) {
+      throw std::runtime_error("Cannot map the native stack");
+    }
+    // Natives called near the limit still have room to run
+    stack_limit = (uintptr_t)stack + (1 << 20);
+
+    pthread_attr_t attr;
+    pthread_t thread;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack, stack_size);
+    int status = pthread_create(&thread, &attr, &BaselineCompiler::start,
+                                this);
+    pthread_attr_destroy(&attr);
+    if (status == 0) {
+      pthread_join(thread, nullptr);
+    }
+    munmap(stack, stack_size);
+    if (status != 0) {
+      throw std::runtime_error("Cannot start the native thread");
+    }
+    if (trap_message) {
+      throw std::runtime_error(trap_message);
+    }
+    return result;
+  }
+
+private:
+  enum Reg {
+    RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSP = 4, RBP = 5, RSI = 6, RDI = 7,
+    R8 = 8, R9 = 9, R11 = 11, R12 = 12
+  };
+
+  // Condition codes, as in the low nibble of jcc and setcc
+  enum Cond {
+    CC_B = 0x2, CC_AE = 0x3, CC_E = 0x4, CC_NE = 0x5, CC_BE = 0x6, CC_A = 0x7,
+    CC_P = 0xa, CC_NP = 0xb, CC_L = 0xc, CC_GE = 0xd, CC_LE = 0xe, CC_G = 0xf
+  };
+
+  typedef int64_t (*Entry)(BcSlot *args);
+
+  const BcImage &image;
+  unique_ptr<char[]> globals;
+  vector<uint8_t> code;
+  uint8_t *text = nullptr;
+  size_t size = 0;
+
+  // Offset of each function's code, and the rel32 fields of calls to patch
+  // with them
+  vector<size_t> entries;
+  vector<pair<size_t, uint32_t>> calls;
+  // Messages of natives that are missing, for their traps
+  deque<string> messages;
+
+  int64_t result = 0;
+
+  // The program runs on one thread at a time, so its traps can go through
+  // statics the generated code refers to by address
+  static uintptr_t stack_limit;
+  static jmp_buf *trap_target;
+  static const char *trap_message;
+
+  static void *start(void *self) {
+    BaselineCompiler &compiler = *(BaselineCompiler *)self;
+    const BcHeader &header = compiler.image.header();
+    jmp_buf target;
+    trap_target = &target;
+    trap_message = nullptr;
+    if (setjmp(target) == 0) {
+      vector<BcSlot> args(
+          compiler.image.functions()[header.main_function].param_count + 1);
+      memset(args.data(), 0, args.size() * sizeof(BcSlot));
+      compiler.entry(header.init_function)(args.data());
+      compiler.result = compiler.entry(header.main_function)(args.data());
+    }
+    trap_target = nullptr;
+    return nullptr;
+  }
+
+  static void trap(const char *message) {
+    trap_message = message;
+    longjmp(*trap_target, 1);
+  }
+
+  Entry entry(uint32_t function) const {
+    return (Entry)(text + entries[function]);
+  }
+
+  // Encoding
+
+  void byte(uint8_t b) { code.push_back(b); }
+
+  void bytes(std::initializer_list<uint8_t> list) {
+    code.insert(code.end(), list.begin(), list.end());
+  }
+
+  void u32(uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+      byte(v >> (8 * i));
+    }
+  }
+
+  void rex(bool w, int reg, int base) {
+    uint8_t prefix = 0x40 | (w ? 8 : 0) | (reg & 8 ? 4 : 0) | (base & 8 ? 1 : 0);
+    if (prefix != 0x40) {
+      byte(prefix);
+    }
+  }
+
+  // `opcode reg, [base + disp]`, after the legacy `prefix` (66, F2) if any
+  void mem(std::initializer_list<uint8_t> prefix, bool w,
+           std::initializer_list<uint8_t> opcode, int reg, int base,
+           int32_t disp) {
+    bytes(prefix);
+    rex(w, reg, base);
+    bytes(opcode);
+    byte(0x80 | (reg & 7) << 3 | (base & 7));
+    if ((base & 7) == RSP) {
+      byte(0x24);
+    }
+    u32(disp);
+  }
+
+  // `opcode reg, rm` between registers
+  void regs(std::initializer_list<uint8_t> prefix, bool w,
+            std::initializer_list<uint8_t> opcode, int reg, int rm) {
+    bytes(prefix);
+    rex(w, reg, rm);
+    bytes(opcode);
+    byte(0xc0 | (reg & 7) << 3 | (rm & 7));
+  }
+
+  static int32_t slot(uint16_t reg) { return 8 * (int32_t)reg; }
+
+  void load(int reg, uint16_t from) { mem({}, true, {0x8b}, reg, RBX, slot(from)); }
+
+  void store(uint16_t to, int reg) { mem({}, true, {0x89}, reg, RBX, slot(to)); }
+
+  void movabs(int reg, uint64_t value) {
+    rex(true, 0, reg);
+    byte(0xb8 | (reg & 7));
+    for (int i = 0; i < 8; i++) {
+      byte(value >> (8 * i));
+    }
+  }
+
+  // `op rax, [slot]` for the ALU ops encoded as op r64, r/m64
+  void alu(uint8_t op, const BcInsn &insn) {
+    load(RAX, insn.b);
+    mem({}, true, {op}, RAX, RBX, slot(insn.c));
+    store(insn.a, RAX);
+  }
+
+  // The same on the low 32 bits, sign-extended back to the slot
+  void alu32(std::initializer_list<uint8_t> op, const BcInsn &insn) {
+    mem({}, false, {0x8b}, RAX, RBX, slot(insn.b));
+    mem({}, false, op, RAX, RBX, slot(insn.c));
+    signExtend32();
+    store(insn.a, RAX);
+  }
+
+  void signExtend32() { regs({}, true, {0x63}, RAX, RAX); }
+
+  // rax = condition ? 1 : 0, from the flags
+  void setFlag(Cond cond) {
+    regs({}, false, {0x0f, (uint8_t)(0x90 | cond)}, 0, RAX);
+    regs({}, false, {0x0f, 0xb6}, RAX, RAX);
+  }
+
+  // Two conditions combined with `and` (0x22) or `or` (0x0a)
+  void setFlags(Cond first, uint8_t op, Cond second) {
+    regs({}, false, {0x0f, (uint8_t)(0x90 | first)}, 0, RAX);
+    regs({}, false, {0x0f, (uint8_t)(0x90 | second)}, 0, RCX);
+    regs({}, false, {op}, RAX, RCX);
+    regs({}, false, {0x0f, 0xb6}, RAX, RAX);
+  }
+
+  void compare(Cond cond, const BcInsn &insn) {
+    load(RAX, insn.b);
+    mem({}, true, {0x3b}, RAX, RBX, slot(insn.c));
+    setFlag(cond);
+    store(insn.a, RAX);
+  }
+
+  // ucomisd of slot `x` with slot `y`, then the flag
+  void compareDouble(Cond cond, uint16_t x, uint16_t y, uint16_t to) {
+    mem({0xf2}, false, {0x0f, 0x10}, 0, RBX, slot(x));
+    mem({0x66}, false, {0x0f, 0x2e}, 0, RBX, slot(y));
+    setFlag(cond);
+    store(to, RAX);
+  }
+
+  void arithmeticDouble(uint8_t op, const BcInsn &insn) {
+    mem({0xf2}, false, {0x0f, 0x10}, 0, RBX, slot(insn.b));
+    mem({0xf2}, false, {0x0f, op}, 0, RBX, slot(insn.c));
+    mem({0xf2}, false, {0x0f, 0x11}, 0, RBX, slot(insn.a));
+  }
+
+  // A jcc or jmp whose rel32 is patched later; returns its position
+  size_t jump(int cond) {
+    if (cond < 0) {
+      byte(0xe9);
+    } else {
+      bytes({0x0f, (uint8_t)(0x80 | cond)});
+    }
+    u32(0);
+    return code.size() - 4;
+  }
+
+  void patch(size_t at, size_t target) {
+    int32_t offset = (int32_t)(target - (at + 4));
+    memcpy(&code[at], &offset, 4);
+  }
+
+  void callAbsolute(const void *function) {
+    movabs(R11, (uint64_t)function);
+    regs({}, false, {0xff}, 2, R11);
+  }
+
+  void emitTrap(const char *message) {
+    movabs(RDI, (uint64_t)message);
+    callAbsolute((const void *)&BaselineCompiler::trap);
+  }
+
+  // Functions
+
+  void function(uint32_t index) {
+    const BcFunctionEntry &function = image.functions()[index];
+    const BcInsn *insns = image.code() + function.code_start;
+    int32_t register_bytes = (slot(function.register_count) + 15) & ~15;
+    int32_t frame_bytes = (function.frame_size + 15) & ~15;
+
+    entries[index] = code.size();
+    bytes({0x55, 0x48, 0x89, 0xe5, 0x53, 0x41, 0x54}); // push rbp, rbx, r12
+    rex(true, 0, RSP);
+    bytes({0x81, 0xec}); // sub rsp, imm32
+    u32(register_bytes + frame_bytes);
+    regs({}, true, {0x89}, RSP, RBX);
+    mem({}, true, {0x8d}, R12, RSP, register_bytes);
+
+    movabs(RAX, (uint64_t)&stack_limit);
+    mem({}, true, {0x3b}, RSP, RAX, 0);
+    size_t room = jump(CC_AE);
+    emitTrap("Stack overflow");
+    patch(room, code.size());
+
+    for (uint16_t i = 0; i < function.param_count; i++) {
+      mem({}, true, {0x8b}, RAX, RDI, slot(i));
+      store(i, RAX);
+    }
+
+    vector<size_t> labels(function.code_size);
+    vector<pair<size_t, uint32_t>> branches;
+    for (uint32_t pc = 0; pc < function.code_size; pc++) {
+      labels[pc] = code.size();
+      const BcInsn &insn = insns[pc];
+      if (bc_is_fused_branch(insn.op)) {
+        load(RAX, insn.a);
+        mem({}, true, {0x3b}, RAX, RBX, slot(insn.b));
+        static const Cond conds[] = {CC_E, CC_NE, CC_L, CC_G, CC_LE, CC_GE};
+        branches.push_back(
+            {jump(conds[insn.op - BC_JEQ]), pc + insns[pc + 1].imm()});
+        pc++;
+        labels[pc] = code.size();
+        continue;
+      }
+      if (insn.op == BC_JMP || insn.op == BC_JZ || insn.op == BC_JNZ) {
+        int cond = -1;
+        if (insn.op != BC_JMP) {
+          mem({}, true, {0x83}, 7, RBX, slot(insn.a)); // cmp qword, 0
+          byte(0);
+          cond = insn.op == BC_JZ ? CC_E : CC_NE;
+        }
+        branches.push_back({jump(cond), pc + insn.imm()});
+        continue;
+      }
+      instruction(insn);
+    }
+    for (auto &branch : branches) {
+      patch(branch.first, labels[branch.second]);
+    }
+  }
+
+  void epilogue() {
+    mem({}, true, {0x8d}, RSP, RBP, -16);
+    bytes({0x41, 0x5c, 0x5b, 0x5d, 0xc3}); // pop r12, rbx, rbp; ret
+  }
+
+  void instruction(const BcInsn &insn) {
+    int16_t simm16 = (int16_t)insn.c;
+    switch (insn.op) {
+    case BC_MOV:
+      load(RAX, insn.b);
+      store(insn.a, RAX);
+      break;
+    case BC_LOADI:
+      mem({}, true, {0xc7}, 0, RBX, slot(insn.a));
+      u32(insn.imm());
+      break;
+    case BC_LOADK:
+      movabs(RAX, image.constants()[insn.imm()]);
+      store(insn.a, RAX);
+      break;
+    case BC_GADDR:
+      movabs(RAX, (uint64_t)(globals.get() + insn.imm()));
+      store(insn.a, RAX);
+      break;
+    case BC_DADDR:
+      movabs(RAX, (uint64_t)(image.data() + insn.imm()));
+      store(insn.a, RAX);
+      break;
+    case BC_FADDR:
+      mem({}, true, {0x8d}, RAX, R12, insn.imm());
+      store(insn.a, RAX);
+      break;
+    case BC_ZERO:
+      load(RDI, insn.a);
+      regs({}, false, {0x31}, RSI, RSI);
+      movabs(RDX, (uint32_t)insn.imm());
+      callAbsolute((const void *)&memset);
+      break;
+
+    case BC_ADD:
+      alu(0x03, insn);
+      break;
+    case BC_SUB:
+      alu(0x2b, insn);
+      break;
+    case BC_AND:
+      alu(0x23, insn);
+      break;
+    case BC_OR:
+      alu(0x0b, insn);
+      break;
+    case BC_XOR:
+      alu(0x33, insn);
+      break;
+    case BC_MUL:
+      load(RAX, insn.b);
+      mem({}, true, {0x0f, 0xaf}, RAX, RBX, slot(insn.c));
+      store(insn.a, RAX);
+      break;
+    case BC_DIV:
+    case BC_MOD: {
+      load(RCX, insn.c);
+      regs({}, true, {0x85}, RCX, RCX);
+      size_t nonzero = jump(CC_NE);
+      emitTrap("Division by zero");
+      patch(nonzero, code.size());
+      // x / -1 is -x and x % -1 is 0, even for the most negative x
+      regs({}, true, {0x83}, 7, RCX); // cmp rcx, -1
+      byte(0xff);
+      size_t divide = jump(CC_NE);
+      if (insn.op == BC_DIV) {
+        load(RAX, insn.b);
+        regs({}, true, {0xf7}, 3, RAX); // neg rax
+      } else {
+        regs({}, false, {0x31}, RAX, RAX);
+      }
+      size_t done = jump(-1);
+      patch(divide, code.size());
+      load(RAX, insn.b);
+      bytes({0x48, 0x99}); // cqo
+      regs({}, true, {0xf7}, 7, RCX); // idiv rcx
+      if (insn.op == BC_MOD) {
+        regs({}, true, {0x89}, RDX, RAX);
+      }
+      patch(done, code.size());
+      store(insn.a, RAX);
+      break;
+    }
+    case BC_ADDW:
+      alu32({0x03}, insn);
+      break;
+    case BC_SUBW:
+      alu32({0x2b}, insn);
+      break;
+    case BC_MULW:
+      alu32({0x0f, 0xaf}, insn);
+      break;
+    case BC_ADDI:
+      load(RAX, insn.b);
+      regs({}, true, {0x81}, 0, RAX);
+      u32(simm16);
+      store(insn.a, RAX);
+      break;
+    case BC_ADDIW:
+      load(RAX, insn.b);
+      regs({}, false, {0x81}, 0, RAX);
+      u32(simm16);
+      signExtend32();
+      store(insn.a, RAX);
+      break;
+    case BC_MULI:
+      load(RAX, insn.b);
+      regs({}, true, {0x69}, RAX, RAX);
+      u32(simm16);
+      store(insn.a, RAX);
+      break;
+    case BC_SHL:
+    case BC_SHR:
+      load(RAX, insn.b);
+      load(RCX, insn.c);
+      regs({}, true, {0xd3}, insn.op == BC_SHL ? 4 : 7, RAX);
+      store(insn.a, RAX);
+      break;
+    case BC_NOT:
+      load(RAX, insn.b);
+      regs({}, true, {0xf7}, 2, RAX);
+      store(insn.a, RAX);
+      break;
+
+    case BC_SEXT8:
+      mem({}, true, {0x0f, 0xbe}, RAX, RBX, slot(insn.b));
+      store(insn.a, RAX);
+      break;
+    case BC_SEXT16:
+      mem({}, true, {0x0f, 0xbf}, RAX, RBX, slot(insn.b));
+      store(insn.a, RAX);
+      break;
+    case BC_SEXT32:
+      mem({}, true, {0x63}, RAX, RBX, slot(insn.b));
+      store(insn.a, RAX);
+      break;
+    case BC_ZEXT8:
+      mem({}, false, {0x0f, 0xb6}, RAX, RBX, slot(insn.b));
+      store(insn.a, RAX);
+      break;
+    case BC_ZEXT16:
+      mem({}, false, {0x0f, 0xb7}, RAX, RBX, slot(insn.b));
+      store(insn.a, RAX);
+      break;
+    case BC_ZEXT32:
+      mem({}, false, {0x8b}, RAX, RBX, slot(insn.b));
+      store(insn.a, RAX);
+      break;
+    case BC_TRUNC1:
+      load(RAX, insn.b);
+      regs({}, false, {0x83}, 4, RAX); // and eax, 1
+      byte(1);
+      store(insn.a, RAX);
+      break;
+
+    case BC_EQ:
+      compare(CC_E, insn);
+      break;
+    case BC_NE:
+      compare(CC_NE, insn);
+      break;
+    case BC_LT:
+      compare(CC_L, insn);
+      break;
+    case BC_GT:
+      compare(CC_G, insn);
+      break;
+    case BC_LE:
+      compare(CC_LE, insn);
+      break;
+    case BC_GE:
+      compare(CC_GE, insn);
+      break;
+    case BC_LTU:
+      compare(CC_B, insn);
+      break;
+    case BC_GTU:
+      compare(CC_A, insn);
+      break;
+    case BC_LEU:
+      compare(CC_BE, insn);
+      break;
+    case BC_GEU:
+      compare(CC_AE, insn);
+      break;
+    case BC_EQZ:
+    case BC_NEZ:
+      mem({}, true, {0x83}, 7, RBX, slot(insn.b)); // cmp qword, 0
+      byte(0);
+      setFlag(insn.op == BC_EQZ ? CC_E : CC_NE);
+      store(insn.a, RAX);
+      break;
+
+    case BC_FADD:
+      arithmeticDouble(0x58, insn);
+      break;
+    case BC_FSUB:
+      arithmeticDouble(0x5c, insn);
+      break;
+    case BC_FMUL:
+      arithmeticDouble(0x59, insn);
+      break;
+    case BC_FDIV:
+      arithmeticDouble(0x5e, insn);
+      break;
+    // Unordered operands set ZF, PF and CF: equality needs PF clear, and
+    // the orderings are tested as above/above-or-equal with the operands
+    // swapped as needed
+    case BC_FEQ:
+      mem({0xf2}, false, {0x0f, 0x10}, 0, RBX, slot(insn.b));
+      mem({0x66}, false, {0x0f, 0x2e}, 0, RBX, slot(insn.c));
+      setFlags(CC_E, 0x22, CC_NP);
+      store(insn.a, RAX);
+      break;
+    case BC_FNE:
+      mem({0xf2}, false, {0x0f, 0x10}, 0, RBX, slot(insn.b));
+      mem({0x66}, false, {0x0f, 0x2e}, 0, RBX, slot(insn.c));
+      setFlags(CC_NE, 0x22, CC_NP);
+      store(insn.a, RAX);
+      break;
+    case BC_FLT:
+      compareDouble(CC_A, insn.c, insn.b, insn.a);
+      break;
+    case BC_FGT:
+      compareDouble(CC_A, insn.b, insn.c, insn.a);
+      break;
+    case BC_FLE:
+      compareDouble(CC_AE, insn.c, insn.b, insn.a);
+      break;
+    case BC_FGE:
+      compareDouble(CC_AE, insn.b, insn.c, insn.a);
+      break;
+    case BC_FNEZ:
+      mem({0xf2}, false, {0x0f, 0x10}, 0, RBX, slot(insn.b));
+      regs({0x66}, false, {0x0f, 0x57}, 1, 1); // xorpd xmm1, xmm1
+      regs({0x66}, false, {0x0f, 0x2e}, 0, 1);
+      setFlags(CC_NE, 0x0a, CC_P);
+      store(insn.a, RAX);
+      break;
+    case BC_I2F:
+      mem({0xf2}, true, {0x0f, 0x2a}, 0, RBX, slot(insn.b));
+      mem({0xf2}, false, {0x0f, 0x11}, 0, RBX, slot(insn.a));
+      break;
+    case BC_F2I:
+      mem({0xf2}, true, {0x0f, 0x2c}, RAX, RBX, slot(insn.b));
+      store(insn.a, RAX);
+      break;
+
+    case BC_LD1:
+      load(RCX, insn.b);
+      mem({}, false, {0x0f, 0xb6}, RAX, RCX, insn.c);
+      regs({}, false, {0x83}, 4, RAX);
+      byte(1);
+      store(insn.a, RAX);
+      break;
+    case BC_LD8:
+      load(RCX, insn.b);
+      mem({}, true, {0x0f, 0xbe}, RAX, RCX, insn.c);
+      store(insn.a, RAX);
+      break;
+    case BC_LD16:
+      load(RCX, insn.b);
+      mem({}, true, {0x0f, 0xbf}, RAX, RCX, insn.c);
+      store(insn.a, RAX);
+      break;
+    case BC_LD32:
+      load(RCX, insn.b);
+      mem({}, true, {0x63}, RAX, RCX, insn.c);
+      store(insn.a, RAX);
+      break;
+    case BC_LD64:
+      load(RCX, insn.b);
+      mem({}, true, {0x8b}, RAX, RCX, insn.c);
+      store(insn.a, RAX);
+      break;
+    case BC_ST8:
+      load(RCX, insn.b);
+      load(RAX, insn.a);
+      mem({}, false, {0x88}, RAX, RCX, insn.c);
+      break;
+    case BC_ST16:
+      load(RCX, insn.b);
+      load(RAX, insn.a);
+      mem({0x66}, false, {0x89}, RAX, RCX, insn.c);
+      break;
+    case BC_ST32:
+      load(RCX, insn.b);
+      load(RAX, insn.a);
+      mem({}, false, {0x89}, RAX, RCX, insn.c);
+      break;
+    case BC_ST64:
+      load(RCX, insn.b);
+      load(RAX, insn.a);
+      mem({}, true, {0x89}, RAX, RCX, insn.c);
+      break;
+
+    case BC_CALL:
+      mem({}, true, {0x8d}, RDI, RBX, slot(insn.b));
+      byte(0xe8);
+      u32(0);
+      calls.push_back({code.size() - 4, insn.c});
+      store(insn.a, RAX);
+      break;
+    case BC_CALLN:
+      native(insn);
+      break;
+    case BC_RET:
+      load(RAX, insn.a);
+      epilogue();
+      break;
+    case BC_RETZ:
+      regs({}, false, {0x31}, RAX, RAX);
+      epilogue();
+      break;
+    case BC_TRAP:
+      emitTrap(image.string(insn.imm()));
+      break;
+    default:
+      throw std::runtime_error(string("No native code for ") +
+                               bc_op_name(insn.op));
+    }
+  }
+
+  // A call of a native through the SysV ABI: integers and pointers in six
+  // registers, doubles in eight, the rest on the stack; al holds the number
+  // of vector registers for variadic callees
+  void native(const BcInsn &insn) {
+    const BcImportEntry &import = image.imports()[insn.c];
+    const char *name = image.string(import.name);
+    const char *kinds = image.string(import.kinds);
+    void *function = dlsym(RTLD_DEFAULT, name);
+    if (!function) {
+      messages.push_back("Function " + string(name) + " is not defined.");
+      emitTrap(messages.back().c_str());
+      return;
+    }
+
+    static const Reg integer_regs[] = {RDI, RSI, RDX, RCX, R8, R9};
+    vector<uint16_t> on_stack;
+    unsigned integers = 0, doubles = 0;
+    for (uint16_t i = 0; i < import.arg_count; i++) {
+      bool is_double = kinds[i + 1] == BK_F64;
+      if ((is_double && doubles == 8) || (!is_double && integers == 6)) {
+        on_stack.push_back(insn.b + i);
+      } else if (is_double) {
+        doubles++;
+      } else {
+        integers++;
+      }
+    }
+
+    int32_t stack_bytes = slot(on_stack.size() + on_stack.size() % 2);
+    if (on_stack.size() % 2) {
+      regs({}, true, {0x83}, 5, RSP); // sub rsp, 8
+      byte(8);
+    }
+    for (auto it = on_stack.rbegin(); it != on_stack.rend(); ++it) {
+      mem({}, false, {0xff}, 6, RBX, slot(*it)); // push qword
+    }
+    integers = doubles = 0;
+    for (uint16_t i = 0; i < import.arg_count; i++) {
+      bool is_double = kinds[i + 1] == BK_F64;
+      if (is_double && doubles < 8) {
+        mem({0xf2}, false, {0x0f, 0x10}, doubles++, RBX, slot(insn.b + i));
+      } else if (!is_double && integers < 6) {
+        load(integer_regs[integers++], insn.b + i);
+      }
+    }
+    bytes({0xb8});
+    u32(doubles);
+    callAbsolute(function);
+    if (stack_bytes) {
+      regs({}, true, {0x81}, 0, RSP); // add rsp, imm32
+      u32(stack_bytes);
+    }
+
+    switch ((uint8_t)kinds[0]) {
+    case BK_I1:
+      regs({}, false, {0x83}, 4, RAX);
+      byte(1);
+      break;
+    case BK_I8:
+      regs({}, true, {0x0f, 0xbe}, RAX, RAX);
+      break;
+    case BK_I16:
+      regs({}, true, {0x0f, 0xbf}, RAX, RAX);
+      break;
+    case BK_I32:
+      signExtend32();
+      break;
+    case BK_F64:
+      mem({0xf2}, false, {0x0f, 0x11}, 0, RBX, slot(insn.a));
+      return;
+    case BK_VOID:
+      regs({}, false, {0x31}, RAX, RAX);
+      break;
+    }
+    store(insn.a, RAX);
+  }
+};
+
+uintptr_t BaselineCompiler::stack_limit = 0;
+jmp_buf *BaselineCompiler::trap_target = nullptr;
+const char *BaselineCompiler::trap_message = nullptr;
+
+#endif // INCLUDE_CC_BASELINE_H_
@@ -0,0 +1,69 @@
+import json
+import os
+import re
+import subprocess
+import sys
+
+# Throughput of optimise and codegen on large translation units, against
+# how fast the same AST can be walked as pointer nodes and as a FlatAst
+# (cc --bench-ast). Pass function counts to choose the sizes.
+
+SIZES = [int(n) for n in sys.argv[1:]] or [250, 1000, 4000]
+RUNS = 3
+
+
+def generate(path, functions):
+    with open(path, 'w') as f:
+        f.write("int printf(const char *format, ...);\n\n")
+        for i in range(functions):
+            f.write(f"int f{i}(int n) {{\n")
+            f.write("  int acc = 0;\n")
+            f.write("  int i;\n")
+            f.write("  for (i = 0; i < n; i++) {\n")
+            f.write(f"    if (i % {i % 7 + 2} == 0) {{\n")
+            f.write(f"      acc = acc + i * {i + 1} - (n ^ i) * (acc & {i});\n")
+            f.write("    } else {\n")
+            f.write(f"      acc = acc - (i ^ {i});\n")
+            f.write("    }\n")
+            f.write("  }\n")
+            f.write("  return acc;\n")
+            f.write("}\n\n")
+        f.write("int main() {\n")
+        f.write(f'  printf("%d\\n", f{functions - 1}(10));\n')
+        f.write("  return 0;\n")
+        f.write("}\n")
+
+
+def compile_once(c_file):
+    output = subprocess.run(['./cc', c_file, '--bench-ast',
+                             '--stats=bench_ast.stats.json',
+                             '-o', 'bench_ast.ll'],
+                            capture_output=True, check=True).stdout.decode()
+    walks = re.search(r"AST bench: (\d+) nodes, depth \d+; pointer walk "
+                      r"([\d.]+) ms, flatten ([\d.]+) ms, flat walk "
+                      r"([\d.]+) ms", output)
+    with open('bench_ast.stats.json') as f:
+        phases = {phase['name']: phase['ms']
+                  for phase in json.load(f)['phases'] if phase['depth'] == 0}
+    return (int(walks.group(1)), phases['optimise'], phases['codegen'],
+            float(walks.group(2)), float(walks.group(3)),
+            float(walks.group(4)))
+
+
+if __name__ == '__main__':
+    c_file = 'bench_ast.c'
+    print(f"best of {RUNS} runs")
+    for functions in SIZES:
+        generate(c_file, functions)
+        runs = [compile_once(c_file) for _ in range(RUNS)]
+        nodes = runs[0][0]
+        optimise, codegen, pointer, flatten, flat = \
+            [min(run[i] for run in runs) for i in range(1, 6)]
+        print(f"{functions} functions, {nodes} nodes: "
+              f"optimise {optimise:.1f} ms, codegen {codegen:.1f} ms "
+              f"({nodes / (optimise + codegen):.0f} nodes/ms); "
+              f"pointer walk {pointer:.2f} ms, flat walk {flat:.2f} ms "
+              f"({pointer / flat:.1f}x), flatten {flatten:.2f} ms")
+
+    for f in [c_file, 'bench_ast.ll', 'bench_ast.stats.json']:
+        os.remove(f)
@@ -0,0 +1,72 @@
+import os
+import subprocess
+import sys
+import time
+
+# Scaling benchmark for the parallel backend (cc -c --backend-threads=N).
+# Generates a translation unit with many independent functions, compiles it
+# to an object file at each thread count and checks the linked program.
+
+FUNCTIONS = int(sys.argv[1]) if len(sys.argv) > 1 else 400
+THREADS = [1, 2, 4, 8]
+RUNS = 3
+
+
+def generate(path):
+    with open(path, 'w') as f:
+        f.write("int printf(const char *format, ...);\n\n")
+        for i in range(FUNCTIONS):
+            f.write(f"int f{i}(int n) {{\n")
+            f.write("  int acc = 0;\n")
+            f.write("  int i;\n")
+            f.write("  for (i = 0; i < n; i++) {\n")
+            f.write(f"    if (i % {i % 7 + 2} == 0) {{\n")
+            f.write(f"      acc = acc + i * {i + 1};\n")
+            f.write("    } else {\n")
+            f.write(f"      acc = acc - (i ^ {i});\n")
+            f.write("    }\n")
+            f.write("  }\n")
+            f.write(f'  printf("f{i} %d\\n", acc);\n')
+            f.write("  return acc;\n")
+            f.write("}\n\n")
+        f.write("int main() {\n")
+        f.write("  int total = 0;\n")
+        for i in range(FUNCTIONS):
+            f.write(f"  total = total + f{i}(10);\n")
+        f.write('  printf("total %d\\n", total);\n')
+        f.write("  return 0;\n")
+        f.write("}\n")
+
+
+def compile_and_run(c_file, threads):
+    best = None
+    for _ in range(RUNS):
+        start = time.perf_counter()
+        subprocess.run(['./cc', c_file, '-c', '-o', 'bench.o',
+                        f'--backend-threads={threads}'],
+                       stdout=subprocess.DEVNULL, check=True)
+        elapsed = time.perf_counter() - start
+        best = elapsed if best is None else min(best, elapsed)
+
+    subprocess.run(['clang', 'bench.o', '-o', 'bench.out', '-pie'], check=True)
+    output = subprocess.run(['./bench.out'], capture_output=True,
+                            check=True).stdout
+    return best, output
+
+
+if __name__ == '__main__':
+    c_file = 'bench_backend.c'
+    generate(c_file)
+    print(f"{FUNCTIONS} functions, best of {RUNS} runs")
+
+    baseline_time, baseline_output = None, None
+    for threads in THREADS:
+        elapsed, output = compile_and_run(c_file, threads)
+        if baseline_time is None:
+            baseline_time, baseline_output = elapsed, output
+        assert output == baseline_output, f"Output differs at {threads} threads"
+        print(f"threads={threads}: {elapsed:.3f}s "
+              f"(speedup {baseline_time / elapsed:.2f}x)")
+
+    for f in [c_file, 'bench.o', 'bench.out']:
+        os.remove(f)
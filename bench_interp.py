@@ -0,0 +1,80 @@
+import os
+import subprocess
+import sys
+import time
+
+# Start-up-to-exit latency of `cc --interp` and `cc --vm` against the LLVM
+# path (cc -> llc -> link -> run), over the stress programs all of them get
+# right. Pass program paths to restrict the set.
+
+LINKER = os.environ.get('LINKER', 'clang')
+RUNS = 3
+
+
+def timed(commands):
+    best, output = None, None
+    for _ in range(RUNS):
+        start = time.perf_counter()
+        for command in commands:
+            result = subprocess.run(command, capture_output=True, timeout=60)
+            if result.returncode != 0:
+                return None, None
+        elapsed = time.perf_counter() - start
+        best = elapsed if best is None else min(best, elapsed)
+        output = result.stdout.decode(errors='replace').strip()
+    return best, output
+
+
+def llvm_path(c_file):
+    return timed([['./cc', c_file],
+                  ['llc', '-filetype=obj', 'a.ll', '-o', 'a.o'],
+                  [LINKER, 'a.o', '-o', 'a.out', '-pie'],
+                  ['./a.out']])
+
+
+def interp_path(c_file):
+    return timed([['./cc', c_file, '--interp']])
+
+
+def vm_path(c_file):
+    return timed([['./cc', c_file, '--vm']])
+
+
+if __name__ == '__main__':
+    programs = sys.argv[1:] or sorted(
+        os.path.join('stress', f) for f in os.listdir('stress')
+        if f.endswith('.c'))
+
+    total_llvm, total_interp, total_vm, count = 0.0, 0.0, 0.0, 0
+    for c_file in programs:
+        with open(c_file + '.expected') as f:
+            expected = f.read().strip()
+        try:
+            llvm_time, llvm_output = llvm_path(c_file)
+            interp_time, interp_output = interp_path(c_file)
+            vm_time, vm_output = vm_path(c_file)
+        except subprocess.TimeoutExpired:
+            continue
+        if (llvm_output != expected or interp_output != expected
+                or vm_output != expected):
+            continue
+
+        total_llvm += llvm_time
+        total_interp += interp_time
+        total_vm += vm_time
+        count += 1
+        print(f"{c_file}: llvm {llvm_time * 1000:.1f}ms, "
+              f"interp {interp_time * 1000:.1f}ms "
+              f"({llvm_time / interp_time:.1f}x), "
+              f"vm {vm_time * 1000:.1f}ms ({llvm_time / vm_time:.1f}x)")
+
+    print(f"{count} programs, best of {RUNS} runs each: "
+          f"llvm {total_llvm:.3f}s, interp {total_interp:.3f}s, "
+          f"vm {total_vm:.3f}s")
+    if count:
+        print(f"interp is {total_llvm / total_interp:.1f}x faster end to end, "
+              f"vm {total_llvm / total_vm:.1f}x")
+
+    for f in ['a.ll', 'a.o', 'a.out']:
+        if os.path.exists(f):
+            os.remove(f)
@@ -0,0 +1,1710 @@
+#ifndef INCLUDE_CC_BYTECODE_H_
+#define INCLUDE_CC_BYTECODE_H_
+
+#include "interpreter.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Type.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+// Instruction set of the register VM (--vm). Registers are 64-bit slots
+// holding an integer (sign-extended from its C width, like RValue), a
+// double or a pointer. `a` is the destination, except for stores (value),
+// ZERO (address), branches and RET; `b` and `c` are sources, or together a
+// signed 32-bit immediate. Branch offsets are relative to the branch. The
+// fused compare-and-branch ops (JEQ..JGE) compare a with b and take their
+// offset from the extension word that follows them.
+#define BC_OPCODES(X)                                                          \
+  X(MOV)                                                                       \
+  X(LOADI)                                                                     \
+  X(LOADK)                                                                     \
+  X(GADDR)                                                                     \
+  X(DADDR)                                                                     \
+  X(FADDR)                                                                     \
+  X(ZERO)                                                                      \
+  X(ADD)                                                                       \
+  X(SUB)                                                                       \
+  X(MUL)                                                                       \
+  X(DIV)                                                                       \
+  X(MOD)                                                                       \
+  X(ADDW)                                                                      \
+  X(SUBW)                                                                      \
+  X(MULW)                                                                      \
+  X(ADDI)                                                                      \
+  X(ADDIW)                                                                     \
+  X(MULI)                                                                      \
+  X(AND)                                                                       \
+  X(OR)                                                                        \
+  X(XOR)                                                                       \
+  X(SHL)                                                                       \
+  X(SHR)                                                                       \
+  X(NOT)                                                                       \
+  X(SEXT8)                                                                     \
+  X(SEXT16)                                                                    \
+  X(SEXT32)                                                                    \
+  X(ZEXT8)                                                                     \
+  X(ZEXT16)                                                                    \
+  X(ZEXT32)                                                                    \
+  X(TRUNC1)                                                                    \
+  X(EQ)                                                                        \
+  X(NE)                                                                        \
+  X(LT)                                                                        \
+  X(GT)                                                                        \
+  X(LE)                                                                        \
+  X(GE)                                                                        \
+  X(LTU)                                                                       \
+  X(GTU)                                                                       \
+  X(LEU)                                                                       \
+  X(GEU)                                                                       \
+  X(EQZ)                                                                       \
+  X(NEZ)                                                                       \
+  X(FADD)                                                                      \
+  X(FSUB)                                                                      \
+  X(FMUL)                                                                      \
+  X(FDIV)                                                                      \
+  X(FEQ)                                                                       \
+  X(FNE)                                                                       \
+  X(FLT)                                                                       \
+  X(FGT)                                                                       \
+  X(FLE)                                                                       \
+  X(FGE)                                                                       \
+  X(FNEZ)                                                                      \
+  X(I2F)                                                                       \
+  X(F2I)                                                                       \
+  X(LD1)                                                                       \
+  X(LD8)                                                                       \
+  X(LD16)                                                                      \
+  X(LD32)                                                                      \
+  X(LD64)                                                                      \
+  X(ST8)                                                                       \
+  X(ST16)                                                                      \
+  X(ST32)                                                                      \
+  X(ST64)                                                                      \
+  X(JMP)                                                                       \
+  X(JZ)                                                                        \
+  X(JNZ)                                                                       \
+  X(JEQ)                                                                       \
+  X(JNE)                                                                       \
+  X(JLT)                                                                       \
+  X(JGT)                                                                       \
+  X(JLE)                                                                       \
+  X(JGE)                                                                       \
+  X(CALL)                                                                      \
+  X(CALLN)                                                                     \
+  X(RET)                                                                       \
+  X(RETZ)                                                                      \
+  X(TRAP)
+
+enum BcOp : uint16_t {
+#define BC_ENUM(name) BC_##name,
+  BC_OPCODES(BC_ENUM)
+#undef BC_ENUM
+      BC_OP_COUNT
+};
+
+static const char *bc_op_name(uint16_t op) {
+  static const char *const names[] = {
+#define BC_NAME(name) #name,
+      BC_OPCODES(BC_NAME)
+#undef BC_NAME
+  };
+  return op < BC_OP_COUNT ? names[op] : "?";
+}
+
+struct BcInsn {
+  uint16_t op;
+  uint16_t a;
+  uint16_t b;
+  uint16_t c;
+
+  int32_t imm() const { return (int32_t)((uint32_t)b | (uint32_t)c << 16); }
+
+  void setImm(int32_t imm) {
+    b = (uint32_t)imm & 0xffff;
+    c = (uint32_t)imm >> 16;
+  }
+};
+static_assert(sizeof(BcInsn) == 8, "instructions are one 64-bit word");
+
+static bool bc_is_fused_branch(uint16_t op) {
+  return op >= BC_JEQ && op <= BC_JGE;
+}
+
+static bool bc_is_branch(uint16_t op) {
+  return op == BC_JMP || op == BC_JZ || op == BC_JNZ || bc_is_fused_branch(op);
+}
+
+// Whether the instruction writes register a
+static bool bc_writes_a(uint16_t op) {
+  switch (op) {
+  case BC_ZERO:
+  case BC_ST8:
+  case BC_ST16:
+  case BC_ST32:
+  case BC_ST64:
+  case BC_RET:
+  case BC_RETZ:
+  case BC_TRAP:
+    return false;
+  default:
+    return !bc_is_branch(op);
+  }
+}
+
+// The operands an instruction uses as registers; the others are immediates,
+// offsets or indices. The argument window b of CALL and CALLN is checked
+// against the callee separately.
+enum : uint8_t { BC_REG_A = 1, BC_REG_B = 2, BC_REG_C = 4 };
+
+static uint8_t bc_register_operands(uint16_t op) {
+  switch (op) {
+  case BC_LOADI:
+  case BC_LOADK:
+  case BC_GADDR:
+  case BC_DADDR:
+  case BC_FADDR:
+  case BC_ZERO:
+  case BC_JZ:
+  case BC_JNZ:
+  case BC_CALL:
+  case BC_CALLN:
+  case BC_RET:
+    return BC_REG_A;
+  case BC_JMP:
+  case BC_RETZ:
+  case BC_TRAP:
+    return 0;
+  case BC_MOV:
+  case BC_ADDI:
+  case BC_ADDIW:
+  case BC_MULI:
+  case BC_NOT:
+  case BC_SEXT8:
+  case BC_SEXT16:
+  case BC_SEXT32:
+  case BC_ZEXT8:
+  case BC_ZEXT16:
+  case BC_ZEXT32:
+  case BC_TRUNC1:
+  case BC_EQZ:
+  case BC_NEZ:
+  case BC_FNEZ:
+  case BC_I2F:
+  case BC_F2I:
+  case BC_LD1:
+  case BC_LD8:
+  case BC_LD16:
+  case BC_LD32:
+  case BC_LD64:
+  case BC_ST8:
+  case BC_ST16:
+  case BC_ST32:
+  case BC_ST64:
+    return BC_REG_A | BC_REG_B;
+  default:
+    return bc_is_fused_branch(op) ? BC_REG_A | BC_REG_B
+                                  : BC_REG_A | BC_REG_B | BC_REG_C;
+  }
+}
+
+// Value kinds of native call signatures
+enum BcKind : uint8_t { BK_VOID, BK_I1, BK_I8, BK_I16, BK_I32, BK_I64,
+                        BK_PTR, BK_F64 };
+
+static BcKind bc_kind(llvm::Type *type) {
+  if (type->isVoidTy()) {
+    return BK_VOID;
+  }
+  if (type->isPointerTy()) {
+    return BK_PTR;
+  }
+  if (type->isDoubleTy()) {
+    return BK_F64;
+  }
+  if (type->isIntegerTy()) {
+    switch (type->getIntegerBitWidth()) {
+    case 1:
+      return BK_I1;
+    case 8:
+      return BK_I8;
+    case 16:
+      return BK_I16;
+    case 32:
+      return BK_I32;
+    case 64:
+      return BK_I64;
+    }
+  }
+  throw std::runtime_error("Type cannot be passed to a native function");
+}
+
+// On-disk layout. Sections are 8-byte aligned and addressed by offsets
+// from the start of the image, so a file can be mapped and run in place.
+static const char bc_magic[4] = {'C', 'C', 'B', 'C'};
+static const uint32_t bc_version = 2;
+
+struct BcHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t function_count;
+  uint32_t import_count;
+  uint32_t init_function;
+  uint32_t main_function;
+  uint64_t image_size;
+  uint64_t globals_size;
+  uint64_t functions_offset;
+  uint64_t imports_offset;
+  uint64_t code_offset;
+  uint64_t code_count;
+  uint64_t constants_offset;
+  uint64_t constant_count;
+  uint64_t data_offset;
+  uint64_t data_size;
+  uint64_t strings_offset;
+  uint64_t strings_size;
+  uint64_t checksum; // bc_checksum() of the rest of the image
+};
+
+// FNV-1a over the 64-bit words of an image, skipping the checksum field.
+// It catches a corrupted or partly written file, including the immediates
+// (load and store offsets) no structural check can judge; it is not a
+// signature against an image crafted on purpose.
+static uint64_t bc_checksum(const char *image, size_t size) {
+  uint64_t hash = 0xcbf29ce484222325;
+  for (size_t at = 0; at + 8 <= size; at += 8) {
+    if (at == offsetof(BcHeader, checksum)) {
+      continue;
+    }
+    uint64_t word;
+    memcpy(&word, image + at, 8);
+    hash = (hash ^ word) * 0x100000001b3;
+  }
+  return hash;
+}
+
+struct BcFunctionEntry {
+  uint32_t name; // offset into the string table
+  uint32_t code_start;
+  uint32_t code_size; // 0 for functions that are only declared
+  uint32_t frame_size;
+  uint16_t register_count;
+  uint16_t param_count;
+  uint32_t reserved;
+};
+
+// A native function at one call signature: printf(char *, int) and
+// printf(char *, double) are separate imports
+struct BcImportEntry {
+  uint32_t name;
+  uint32_t kinds; // offset into the string table: return kind, then args
+  uint16_t arg_count;
+  uint16_t fixed_count;
+  uint8_t variadic;
+  uint8_t reserved[3];
+};
+
+// A complete bytecode module, either built in memory or mapped from a file
+class BcImage {
+public:
+  static unique_ptr<BcImage> fromBytes(vector<char> bytes) {
+    unique_ptr<BcImage> image(new BcImage());
+    image->owned = std::move(bytes);
+    image->base = image->owned.data();
+    image->size = image->owned.size();
+    image->validate();
+    return image;
+  }
+
+  // Private writable mapping: string literals may be written to, but the
+  // writes never reach the file
+  static unique_ptr<BcImage> map(const string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("Cannot open " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(BcHeader)) {
+      close(fd);
+      throw std::runtime_error(path + " is not a bytecode image");
+    }
+    void *addr = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+      throw std::runtime_error("Cannot map " + path);
+    }
+
+    unique_ptr<BcImage> image(new BcImage());
+    image->base = (char *)addr;
+    image->size = st.st_size;
+    image->mapped = true;
+    image->validate();
+    return image;
+  }
+
+  ~BcImage() {
+    if (mapped) {
+      munmap(base, size);
+    }
+  }
+
+  void write(const string &path) const {
+    FILE *out = fopen(path.c_str(), "wb");
+    if (!out || fwrite(base, 1, size, out) != size || fclose(out) != 0) {
+      throw std::runtime_error("Cannot write " + path);
+    }
+  }
+
+  const BcHeader &header() const { return *(const BcHeader *)base; }
+
+  const BcFunctionEntry *functions() const {
+    return (const BcFunctionEntry *)(base + header().functions_offset);
+  }
+
+  const BcImportEntry *imports() const {
+    return (const BcImportEntry *)(base + header().imports_offset);
+  }
+
+  const BcInsn *code() const {
+    return (const BcInsn *)(base + header().code_offset);
+  }
+
+  const int64_t *constants() const {
+    return (const int64_t *)(base + header().constants_offset);
+  }
+
+  char *data() const { return base + header().data_offset; }
+
+  const char *string(uint32_t offset) const {
+    return base + header().strings_offset + offset;
+  }
+
+private:
+  BcImage() = default;
+
+  vector<char> owned;
+  char *base = nullptr;
+  size_t size = 0;
+  bool mapped = false;
+
+  bool inside(uint64_t offset, uint64_t count, uint64_t element) const {
+    return offset % 8 == 0 && offset <= size &&
+           count <= (size - offset) / element;
+  }
+
+  bool stringInside(uint32_t offset, uint64_t length) const {
+    return offset <= header().strings_size &&
+           length <= header().strings_size - offset;
+  }
+
+  // A stale, truncated or corrupted cache file is rejected here rather than
+  // crashing the VM: the checksum must match, sections must lie inside the
+  // image, and every branch, call and register operand must stay inside its
+  // function.
+  void validate() const {
+    const BcHeader &h = header();
+    if (size < sizeof(BcHeader) || memcmp(h.magic, bc_magic, 4) != 0 ||
+        h.version != bc_version || h.image_size != size) {
+      throw std::runtime_error("Not a bytecode image of this version");
+    }
+    if (size % 8 != 0 || h.checksum != bc_checksum(base, size)) {
+      throw std::runtime_error("Bytecode image is corrupted");
+    }
+    if (!inside(h.functions_offset, h.function_count,
+                sizeof(BcFunctionEntry)) ||
+        !inside(h.imports_offset, h.import_count, sizeof(BcImportEntry)) ||
+        !inside(h.code_offset, h.code_count, sizeof(BcInsn)) ||
+        !inside(h.constants_offset, h.constant_count, sizeof(int64_t)) ||
+        !inside(h.data_offset, h.data_size, 1) ||
+        !inside(h.strings_offset, h.strings_size, 1) ||
+        h.strings_size == 0 || base[h.strings_offset + h.strings_size - 1]) {
+      throw std::runtime_error("Bytecode image is truncated");
+    }
+    if (h.init_function >= h.function_count ||
+        h.main_function >= h.function_count) {
+      throw std::runtime_error("Bytecode image has no entry point");
+    }
+
+    for (uint32_t i = 0; i < h.import_count; i++) {
+      const BcImportEntry &import = imports()[i];
+      if (!stringInside(import.name, 1) ||
+          !stringInside(import.kinds, import.arg_count + 1)) {
+        throw std::runtime_error("Bytecode import is malformed");
+      }
+    }
+
+    for (uint32_t f = 0; f < h.function_count; f++) {
+      const BcFunctionEntry &function = functions()[f];
+      if (!stringInside(function.name, 1) ||
+          function.code_start > h.code_count ||
+          function.code_size > h.code_count - function.code_start ||
+          function.param_count > function.register_count) {
+        throw std::runtime_error("Bytecode function is malformed");
+      }
+      if (function.code_size == 0) {
+        continue;
+      }
+      if (code()[function.code_start + function.code_size - 1].op != BC_RET &&
+          code()[function.code_start + function.code_size - 1].op !=
+              BC_RETZ) {
+        throw std::runtime_error("Bytecode function does not return");
+      }
+
+      const BcInsn *insns = code() + function.code_start;
+      for (uint32_t pc = 0; pc < function.code_size; pc++) {
+        const BcInsn &insn = insns[pc];
+        if (insn.op >= BC_OP_COUNT) {
+          throw std::runtime_error("Bad opcode in bytecode image");
+        }
+        uint8_t registers = bc_register_operands(insn.op);
+        if (((registers & BC_REG_A) && insn.a >= function.register_count) ||
+            ((registers & BC_REG_B) && insn.b >= function.register_count) ||
+            ((registers & BC_REG_C) && insn.c >= function.register_count)) {
+          throw std::runtime_error("Bad register in bytecode image");
+        }
+        if (bc_is_branch(insn.op)) {
+          int64_t offset = bc_is_fused_branch(insn.op) && pc + 1 < function.code_size
+                               ? insns[pc + 1].imm()
+                               : insn.imm();
+          int64_t target = (int64_t)pc + offset;
+          if ((bc_is_fused_branch(insn.op) && pc + 1 >= function.code_size) ||
+              target < 0 || target >= function.code_size) {
+            throw std::runtime_error("Bad branch in bytecode image");
+          }
+          if (bc_is_fused_branch(insn.op)) {
+            pc++;
+          }
+        }
+        if ((insn.op == BC_CALL &&
+             (insn.c >= h.function_count ||
+              functions()[insn.c].code_size == 0 ||
+              insn.b + functions()[insn.c].param_count >
+                  function.register_count)) ||
+            (insn.op == BC_CALLN &&
+             (insn.c >= h.import_count ||
+              insn.b + imports()[insn.c].arg_count >
+                  function.register_count)) ||
+            (insn.op == BC_LOADK && (uint32_t)insn.imm() >= h.constant_count) ||
+            (insn.op == BC_DADDR && (uint32_t)insn.imm() > h.data_size) ||
+            (insn.op == BC_GADDR && (uint32_t)insn.imm() > h.globals_size) ||
+            (insn.op == BC_FADDR && (uint32_t)insn.imm() > function.frame_size) ||
+            (insn.op == BC_TRAP && !stringInside(insn.imm(), 1))) {
+          throw std::runtime_error("Bad operand in bytecode image");
+        }
+      }
+    }
+  }
+};
+
+static string bc_disassemble(const BcImage &image) {
+  string result;
+  char line[128];
+  const BcHeader &h = image.header();
+  for (uint32_t f = 0; f < h.function_count; f++) {
+    const BcFunctionEntry &function = image.functions()[f];
+    if (function.code_size == 0) {
+      continue;
+    }
+    snprintf(line, sizeof(line), "%s: %u registers, %u bytes of frame\n",
+             image.string(function.name), function.register_count,
+             function.frame_size);
+    result += line;
+    const BcInsn *insns = image.code() + function.code_start;
+    for (uint32_t pc = 0; pc < function.code_size; pc++) {
+      const BcInsn &insn = insns[pc];
+      snprintf(line, sizeof(line), "  %5u  %-7s a=%u b=%u c=%u imm=%d\n", pc,
+               bc_op_name(insn.op), insn.a, insn.b, insn.c, insn.imm());
+      result += line;
+      if (bc_is_fused_branch(insn.op)) {
+        pc++;
+        snprintf(line, sizeof(line), "  %5u  -> %d\n", pc, insns[pc].imm());
+        result += line;
+      }
+    }
+  }
+  return result;
+}
+
+// A value computed into a register while compiling, with its C type.
+// Lvalues are pointer-typed; for a variable that lives in a register the
+// lvalue is that register itself (in_register) rather than an address.
+struct BcValue {
+  llvm::Type *type = nullptr;
+  uint16_t reg = 0;
+  bool in_register = false;
+  // Ordinal of the register variable an in_register lvalue refers to
+  int variable = -1;
+
+  BcValue() = default;
+  BcValue(llvm::Type *type, uint16_t reg) : type(type), reg(reg) {}
+};
+
+struct BcVariable {
+  llvm::Type *type;
+  llvm::Type *address_type;
+  bool in_register;
+  bool global;
+  uint16_t reg;
+  uint32_t offset;
+  int ordinal;
+};
+
+struct BcFunction {
+  string name;
+  llvm::FunctionType *type = nullptr;
+  vector<pair<string, llvm::Type *>> params;
+  bool defined = false;
+  vector<BcInsn> code;
+  uint16_t register_count = 0;
+  uint32_t frame_size = 0;
+};
+
+// Lowers the optimised AST to bytecode. Nodes call into this from their
+// compileBytecode() the same way interpret() uses the interp_* helpers;
+// the conversions are the same, only emitted instead of performed.
+//
+// Scalar locals live in registers unless their address is taken; when a
+// function turns out to take the address of a register variable it is
+// compiled again with that variable in frame memory.
+class BytecodeCompiler {
+public:
+  // Function bodies are compiled once every declaration has been seen, so
+  // calls can refer to functions defined further down
+  vector<std::function<void()>> pending_bodies;
+
+  void beginModule() {
+    functions.clear();
+    function_index.clear();
+    pending_bodies.clear();
+    imports.clear();
+    import_index.clear();
+    constants.clear();
+    constant_index.clear();
+    data.clear();
+    strings.clear();
+    string_index.clear();
+    globals_size = 0;
+    ids.clear();
+    globals.clear();
+
+    functions.push_back(BcFunction());
+    functions[0].name = "(init)";
+    functions[0].defined = true;
+    beginFunction(0);
+    marks.clear();
+  }
+
+  // Finishes the global initialisers, then compiles every function body
+  void endModule() {
+    emit(BC_RETZ, 0, 0, 0);
+    finishFunction();
+
+    for (auto &body : pending_bodies) {
+      body();
+    }
+    pending_bodies.clear();
+
+    auto main = function_index.find("main");
+    if (main == function_index.end() || !functions[main->second].defined) {
+      throw std::runtime_error("Function main not found.");
+    }
+  }
+
+  vector<char> image() {
+    auto align = [](vector<char> &bytes) {
+      bytes.resize((bytes.size() + 7) & ~size_t(7));
+    };
+    auto append = [&align](vector<char> &bytes, const void *p, size_t n) {
+      uint64_t offset = bytes.size();
+      bytes.insert(bytes.end(), (const char *)p, (const char *)p + n);
+      align(bytes);
+      return offset;
+    };
+
+    BcHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, bc_magic, 4);
+    header.version = bc_version;
+    header.function_count = functions.size();
+    header.import_count = imports.size();
+    header.init_function = 0;
+    header.main_function = function_index.at("main");
+    header.globals_size = globals_size;
+
+    vector<BcFunctionEntry> entries;
+    vector<BcInsn> code;
+    for (auto &function : functions) {
+      BcFunctionEntry entry;
+      memset(&entry, 0, sizeof(entry));
+      entry.name = internString(function.name);
+      entry.code_start = code.size();
+      entry.code_size = function.defined ? function.code.size() : 0;
+      entry.frame_size = function.frame_size;
+      entry.register_count = function.register_count;
+      entry.param_count = function.params.size();
+      if (function.defined) {
+        code.insert(code.end(), function.code.begin(), function.code.end());
+      }
+      entries.push_back(entry);
+    }
+
+    vector<char> bytes(sizeof(BcHeader));
+    align(bytes);
+    header.functions_offset = append(
+        bytes, entries.data(), entries.size() * sizeof(BcFunctionEntry));
+    header.imports_offset = append(bytes, imports.data(),
+                                   imports.size() * sizeof(BcImportEntry));
+    header.code_offset =
+        append(bytes, code.data(), code.size() * sizeof(BcInsn));
+    header.code_count = code.size();
+    header.constants_offset =
+        append(bytes, constants.data(), constants.size() * sizeof(int64_t));
+    header.constant_count = constants.size();
+    header.data_offset = append(bytes, data.data(), data.size());
+    header.data_size = data.size();
+    header.strings_offset = append(bytes, strings.data(), strings.size());
+    header.strings_size = strings.size();
+    header.image_size = bytes.size();
+    memcpy(bytes.data(), &header, sizeof(header));
+    header.checksum = bc_checksum(bytes.data(), bytes.size());
+    memcpy(bytes.data(), &header, sizeof(header));
+    return bytes;
+  }
+
+  // Where each global variable lives in the VM's globals block
+  map<string, uint32_t> globalOffsets() const {
+    map<string, uint32_t> offsets;
+    for (auto &id : ids) {
+      if (id.second < globals.size() && globals[id.second].first) {
+        offsets[id.first] = globals[id.second].second.offset;
+      }
+    }
+    return offsets;
+  }
+
+  // Functions
+
+  const vector<BcFunction> &functionList() const { return functions; }
+
+  void declareFunction(const string &name, llvm::FunctionType *type) {
+    if (function_index.count(name)) {
+      return;
+    }
+    if (functions.size() > UINT16_MAX) {
+      throw std::runtime_error("Too many functions for bytecode");
+    }
+    function_index[name] = functions.size();
+    functions.push_back(BcFunction());
+    functions.back().name = name;
+    functions.back().type = type;
+  }
+
+  BcFunction *findFunction(const string &name) {
+    auto it = function_index.find(name);
+    return it == function_index.end() ? nullptr : &functions[it->second];
+  }
+
+  // Registers a definition; `body` emits its statements once every
+  // function of the translation unit is known
+  void defineFunction(const string &name, llvm::FunctionType *type,
+                      const vector<pair<string, llvm::Type *>> &params,
+                      std::function<void()> body) {
+    declareFunction(name, type);
+    size_t index = function_index[name];
+    functions[index].params = params;
+    functions[index].defined = true;
+    pending_bodies.push_back([this, index, body]() {
+      address_taken.clear();
+      do {
+        retry = false;
+        beginFunction(index);
+        for (auto &param : functions[index].params) {
+          declareParam(param.first, param.second);
+        }
+        body();
+        emit(BC_RETZ, 0, 0, 0);
+        for (auto &pending : gotos) {
+          auto label = labels.find(pending.second);
+          if (label == labels.end()) {
+            throw std::runtime_error("Label " + pending.second +
+                                     " not found.");
+          }
+          patchTo(pending.first, label->second);
+        }
+      } while (retry);
+      finishFunction();
+    });
+  }
+
+  llvm::Type *returnType() const {
+    return functions[current].type->getReturnType();
+  }
+
+  BcValue call(const string &name, vector<BcValue> args) {
+    BcFunction *function = findFunction(name);
+    if (function == nullptr) {
+      throw std::runtime_error("Function " + name + " not found.");
+    }
+    llvm::FunctionType *type = function->type;
+    llvm::LLVMContext &context = type->getContext();
+
+    if (function->defined) {
+      vector<BcValue> params;
+      for (size_t i = 0; i < function->params.size(); i++) {
+        llvm::Type *param_type = function->params[i].second;
+        params.push_back(i < args.size()
+                             ? makeStoreCompatible(param_type, args[i])
+                             : zero(param_type));
+      }
+      uint16_t base = window(params);
+      available.clear();
+      emit(BC_CALL, base, base, function_index[name]);
+      return BcValue(type->getReturnType(), base);
+    }
+
+    // Same conversions as Interpreter::callNative
+    unsigned fixed = type->getNumParams();
+    if (args.size() < fixed) {
+      throw std::runtime_error("Function " + name +
+                               " called with too few arguments.");
+    }
+    string kinds(1, (char)bc_kind(type->getReturnType()));
+    for (size_t i = 0; i < args.size(); i++) {
+      if (i < fixed) {
+        args[i] = makeStoreCompatible(type->getParamType(i), args[i]);
+      } else if (args[i].type->isIntegerTy() &&
+                 args[i].type->getIntegerBitWidth() < 32) {
+        args[i] = cast(args[i], llvm::Type::getInt32Ty(context),
+                       args[i].type->getIntegerBitWidth() != 1);
+      }
+      kinds += (char)bc_kind(args[i].type);
+    }
+
+    BcImportEntry import;
+    memset(&import, 0, sizeof(import));
+    import.name = internString(name);
+    import.kinds = internString(kinds);
+    import.arg_count = args.size();
+    import.fixed_count = fixed;
+    import.variadic = type->isVarArg();
+    auto key = make_pair(import.name, import.kinds);
+    auto it = import_index.find(key);
+    if (it == import_index.end()) {
+      if (imports.size() > UINT16_MAX) {
+        throw std::runtime_error("Too many native calls for bytecode");
+      }
+      it = import_index.emplace(key, imports.size()).first;
+      imports.push_back(import);
+    }
+
+    uint16_t base = window(args);
+    available.clear();
+    emit(BC_CALLN, base, base, it->second);
+    return BcValue(type->getReturnType(), base);
+  }
+
+  void emitReturn(BcValue *value) {
+    if (value) {
+      emit(BC_RET, value->reg, 0, 0);
+    } else {
+      emit(BC_RETZ, 0, 0, 0);
+    }
+  }
+
+  // Scopes and variables
+
+  void pushScope() {
+    marks.push_back({bindings.size(), next_reg, var_top, frame_top});
+  }
+
+  void popScope() {
+    available.clear();
+    bindings.resize(marks.back().bindings);
+    next_reg = marks.back().next_reg;
+    var_top = marks.back().var_top;
+    frame_top = marks.back().frame_top;
+    marks.pop_back();
+  }
+
+  // Temporaries never outlive the statement that computed them
+  void releaseTemps() {
+    next_reg = var_top;
+    available.clear();
+  }
+
+  // Common subexpressions: the register holding a side-effect-free
+  // expression, keyed by its hash-consed id, is reused until a store, a
+  // call, a jump target or the end of the statement
+  BcValue reuse(uint32_t id, bool lvalue,
+                const std::function<BcValue()> &compute) {
+    uint64_t key = (uint64_t)id << 1 | lvalue;
+    auto it = available.find(key);
+    if (it != available.end()) {
+      return it->second;
+    }
+    BcValue val = compute();
+    if (val.type) {
+      available[key] = val;
+    }
+    return val;
+  }
+
+  // The instruction computing `reg` is being folded away
+  void forget(uint16_t reg) {
+    for (auto it = available.begin(); it != available.end();) {
+      it = it->second.reg == reg ? available.erase(it) : std::next(it);
+    }
+  }
+
+  // Outside of any scope the variable is a global. Storage starts zeroed
+  // when `zeroed` is set, as in the interpreter.
+  BcVariable declare(const string &name, llvm::Type *type, bool zeroed) {
+    available.clear();
+    size_t id = intern(name);
+    uint64_t size = type->isSized() ? interp_size(type) : 0;
+    BcVariable var = {type, llvm::PointerType::get(type, 0), false, false,
+                      0, 0, -1};
+
+    if (marks.empty()) {
+      var.global = true;
+      globals_size = (globals_size + 15) & ~uint64_t(15);
+      var.offset = globals_size;
+      globals_size += size;
+      if (id >= globals.size()) {
+        globals.resize(id + 1);
+      }
+      globals[id] = {true, var};
+      return var;
+    }
+
+    var.ordinal = next_ordinal++;
+    if (isScalar(type) && !address_taken.count(var.ordinal)) {
+      var.in_register = true;
+      var.reg = newVariableRegister();
+      if (zeroed) {
+        emit(BC_LOADI, var.reg, 0, 0);
+      }
+    } else {
+      var.offset = allocateFrame(size);
+      if (zeroed && size) {
+        uint16_t addr = temp();
+        emitImm(BC_FADDR, addr, var.offset);
+        emitImm(BC_ZERO, addr, size);
+      }
+    }
+    bindings.push_back({id, var});
+    return var;
+  }
+
+  const BcVariable *find(const string &name) {
+    size_t id = intern(name);
+    for (size_t i = bindings.size(); i-- > 0;) {
+      if (bindings[i].first == id) {
+        return &bindings[i].second;
+      }
+    }
+    if (id < globals.size() && globals[id].first) {
+      return &globals[id].second;
+    }
+    return nullptr;
+  }
+
+  BcValue address(const BcVariable &var) {
+    BcValue addr(var.address_type, 0);
+    if (var.in_register) {
+      addr.reg = var.reg;
+      addr.in_register = true;
+      addr.variable = var.ordinal;
+      return addr;
+    }
+    addr.reg = temp();
+    emitImm(var.global ? BC_GADDR : BC_FADDR, addr.reg, var.offset);
+    return addr;
+  }
+
+  // `&x` of a register variable: x moves to frame memory and the function
+  // is compiled again
+  void addressTaken(const BcValue &lvalue) {
+    if (lvalue.in_register) {
+      address_taken.insert(lvalue.variable);
+      retry = true;
+    }
+  }
+
+  // Same as interp_load: arrays are used through a pointer to their first
+  // element
+  BcValue load(const BcValue &addr) {
+    llvm::Type *type = addr.type->getPointerElementType();
+    if (addr.in_register) {
+      return BcValue(type, addr.reg);
+    }
+    if (type->isArrayTy()) {
+      return BcValue(llvm::PointerType::get(type->getArrayElementType(), 0),
+                     addr.reg);
+    }
+    BcValue val(type, temp());
+    emit(loadOp(type), val.reg, addr.reg, 0);
+    return val;
+  }
+
+  // Returns where the stored value now lives: a value computed just before
+  // into a temporary is redirected straight into a register variable
+  BcValue store(const BcValue &addr, const BcValue &value) {
+    available.clear();
+    if (!addr.in_register) {
+      emit(storeOp(value.type), value.reg, addr.reg, 0);
+      return value;
+    }
+    BcValue stored(value.type, addr.reg);
+    if (value.reg == addr.reg) {
+      return stored;
+    }
+    if (isTemp(value.reg) && !code().empty() && last_label != code().size() &&
+        bc_writes_a(code().back().op) && code().back().a == value.reg) {
+      code().back().a = addr.reg;
+      return stored;
+    }
+    emit(BC_MOV, addr.reg, value.reg, 0);
+    return stored;
+  }
+
+  // Constants and literals
+
+  BcValue constant(llvm::Type *type, int64_t value) {
+    BcValue val(type, temp());
+    if (value == (int32_t)value) {
+      emitImm(BC_LOADI, val.reg, value);
+    } else {
+      emitImm(BC_LOADK, val.reg, constantIndex(value));
+    }
+    return val;
+  }
+
+  BcValue constantDouble(llvm::Type *type, double value) {
+    int64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    BcValue val(type, temp());
+    if (bits == 0) {
+      emitImm(BC_LOADI, val.reg, 0);
+    } else {
+      emitImm(BC_LOADK, val.reg, constantIndex(bits));
+    }
+    return val;
+  }
+
+  BcValue zero(llvm::Type *type) { return constant(type, 0); }
+
+  // Each literal gets its own writable copy in the data section
+  uint32_t stringLiteral(const string &value) {
+    uint32_t offset = data.size();
+    data.insert(data.end(), value.begin(), value.end());
+    data.push_back('\0');
+    return offset;
+  }
+
+  BcValue dataAddress(llvm::Type *type, uint32_t offset) {
+    BcValue val(type, temp());
+    emitImm(BC_DADDR, val.reg, offset);
+    return val;
+  }
+
+  // Raises `message` when executed; used where the interpreter would throw
+  BcValue trap(llvm::Type *type, const string &message) {
+    emitImm(BC_TRAP, 0, internString(message));
+    return BcValue(type, temp());
+  }
+
+  // Conversions, mirroring interp_cast and friends
+
+  BcValue cast(const BcValue &v, llvm::Type *to, bool sign = true) {
+    if (v.type == to) {
+      return v;
+    }
+    bool from_fp = v.type->isDoubleTy();
+    bool to_fp = to->isDoubleTy();
+    if (from_fp && to_fp) {
+      return BcValue(to, v.reg);
+    }
+    if (from_fp) {
+      if (!to->isIntegerTy()) {
+        return zero(to);
+      }
+      BcValue val(to, temp());
+      emit(BC_F2I, val.reg, v.reg, 0);
+      return wrap(val);
+    }
+    if (to_fp) {
+      BcValue val(to, temp());
+      emit(BC_I2F, val.reg, v.reg, 0);
+      return val;
+    }
+    if (to->isPointerTy()) {
+      return BcValue(to, v.reg);
+    }
+    if (to->isIntegerTy() && (v.type->isIntegerTy() ||
+                              v.type->isPointerTy() || v.type->isVoidTy())) {
+      unsigned from_bits =
+          v.type->isIntegerTy() ? v.type->getIntegerBitWidth() : 64;
+      unsigned to_bits = to->getIntegerBitWidth();
+      BcValue val(to, v.reg);
+      if (!sign && from_bits < 64 && from_bits > 1 && to_bits > from_bits) {
+        val.reg = temp();
+        emit(from_bits == 8    ? BC_ZEXT8
+             : from_bits == 16 ? BC_ZEXT16
+                               : BC_ZEXT32,
+             val.reg, v.reg, 0);
+        return val;
+      }
+      if (to_bits < from_bits) {
+        return wrap(val, true);
+      }
+      return val;
+    }
+    throw std::runtime_error("Cannot convert between these types");
+  }
+
+  BcValue makeBool(const BcValue &v) {
+    llvm::Type *i1 = llvm::Type::getInt1Ty(v.type->getContext());
+    if (v.type->isIntegerTy() && v.type != i1) {
+      BcValue val(i1, temp());
+      emit(BC_NEZ, val.reg, v.reg, 0);
+      return val;
+    }
+    if (v.type->isDoubleTy()) {
+      BcValue val(i1, temp());
+      emit(BC_FNEZ, val.reg, v.reg, 0);
+      return val;
+    }
+    return v;
+  }
+
+  BcValue makeStoreCompatible(llvm::Type *dest, const BcValue &v) {
+    if (dest->isIntegerTy() && v.type->isIntegerTy()) {
+      return cast(v, dest, false);
+    }
+    return cast(v, dest);
+  }
+
+  void makeLhsRhsCompatible(BcValue &lhs, BcValue &rhs) {
+    if (lhs.type->isDoubleTy() || rhs.type->isDoubleTy()) {
+      llvm::Type *d = llvm::Type::getDoubleTy(lhs.type->getContext());
+      lhs = cast(lhs, d);
+      rhs = cast(rhs, d);
+      return;
+    }
+
+    if (lhs.type->isIntegerTy() && rhs.type->isIntegerTy()) {
+      unsigned lhs_bits = lhs.type->getIntegerBitWidth();
+      unsigned rhs_bits = rhs.type->getIntegerBitWidth();
+      if (lhs_bits < rhs_bits) {
+        lhs = cast(lhs, rhs.type, lhs_bits != 1);
+      } else if (rhs_bits < lhs_bits) {
+        rhs = cast(rhs, lhs.type, rhs_bits != 1);
+      }
+    }
+    if (lhs.type != rhs.type) {
+      rhs = cast(rhs, lhs.type);
+    }
+  }
+
+  // Mirrors interp_binary
+  BcValue binary(InterpOp op, BcValue lhs, BcValue rhs) {
+    llvm::LLVMContext &context = lhs.type->getContext();
+
+    if (op == InterpOp::ADD || op == InterpOp::SUB) {
+      if (lhs.type->isPointerTy() && rhs.type->isIntegerTy()) {
+        return offsetPointer(lhs, rhs, interp_stride(lhs.type),
+                             op == InterpOp::SUB);
+      }
+      if (op == InterpOp::ADD && lhs.type->isIntegerTy() &&
+          rhs.type->isPointerTy()) {
+        return offsetPointer(rhs, lhs, interp_stride(rhs.type), false);
+      }
+      if (op == InterpOp::SUB && lhs.type->isPointerTy() &&
+          rhs.type->isPointerTy()) {
+        llvm::Type *i64 = llvm::Type::getInt64Ty(context);
+        BcValue diff = emit3(BC_SUB, i64, lhs, rhs);
+        int64_t stride = interp_stride(lhs.type);
+        if (stride == 1) {
+          return diff;
+        }
+        return emit3(BC_DIV, i64, diff, constant(i64, stride));
+      }
+    }
+
+    bool bitwise = op == InterpOp::SHL || op == InterpOp::SHR ||
+                   op == InterpOp::AND || op == InterpOp::OR ||
+                   op == InterpOp::XOR || op == InterpOp::MOD;
+    if (bitwise && (!lhs.type->isIntegerTy() || !rhs.type->isIntegerTy())) {
+      return trap(lhs.type, "lhs or rhs is not an integer");
+    }
+
+    if (op == InterpOp::SHL || op == InterpOp::SHR) {
+      return wrap(
+          emit3(op == InterpOp::SHL ? BC_SHL : BC_SHR, lhs.type, lhs, rhs));
+    }
+
+    makeLhsRhsCompatible(lhs, rhs);
+    llvm::Type *i1 = llvm::Type::getInt1Ty(context);
+
+    if (lhs.type->isPointerTy()) {
+      switch (op) {
+      case InterpOp::EQ:
+        return emit3(BC_EQ, i1, lhs, rhs);
+      case InterpOp::NE:
+        return emit3(BC_NE, i1, lhs, rhs);
+      case InterpOp::LT:
+        return emit3(BC_LTU, i1, lhs, rhs);
+      case InterpOp::GT:
+        return emit3(BC_GTU, i1, lhs, rhs);
+      case InterpOp::LE:
+        return emit3(BC_LEU, i1, lhs, rhs);
+      case InterpOp::GE:
+        return emit3(BC_GEU, i1, lhs, rhs);
+      default:
+        return trap(lhs.type, "Unsupported operation on pointers");
+      }
+    }
+
+    if (lhs.type->isDoubleTy()) {
+      switch (op) {
+      case InterpOp::ADD:
+        return emit3(BC_FADD, lhs.type, lhs, rhs);
+      case InterpOp::SUB:
+        return emit3(BC_FSUB, lhs.type, lhs, rhs);
+      case InterpOp::MUL:
+        return emit3(BC_FMUL, lhs.type, lhs, rhs);
+      case InterpOp::DIV:
+        return emit3(BC_FDIV, lhs.type, lhs, rhs);
+      case InterpOp::EQ:
+        return emit3(BC_FEQ, i1, lhs, rhs);
+      case InterpOp::NE:
+        return emit3(BC_FNE, i1, lhs, rhs);
+      case InterpOp::LT:
+        return emit3(BC_FLT, i1, lhs, rhs);
+      case InterpOp::GT:
+        return emit3(BC_FGT, i1, lhs, rhs);
+      case InterpOp::LE:
+        return emit3(BC_FLE, i1, lhs, rhs);
+      case InterpOp::GE:
+        return emit3(BC_FGE, i1, lhs, rhs);
+      default:
+        return trap(lhs.type, "Unsupported operation on doubles");
+      }
+    }
+
+    if (!lhs.type->isIntegerTy()) {
+      return trap(lhs.type, "Unsupported integer operation");
+    }
+    unsigned bits = lhs.type->getIntegerBitWidth();
+    switch (op) {
+    case InterpOp::ADD:
+      if (bits == 32 || bits == 64) {
+        int64_t k;
+        if (immediate(rhs, k)) {
+          return emitImm3(bits == 32 ? BC_ADDIW : BC_ADDI, lhs, k);
+        }
+        if (immediate(lhs, k)) {
+          return emitImm3(bits == 32 ? BC_ADDIW : BC_ADDI, rhs, k);
+        }
+        return emit3(bits == 32 ? BC_ADDW : BC_ADD, lhs.type, lhs, rhs);
+      }
+      return wrap(emit3(BC_ADD, lhs.type, lhs, rhs));
+    case InterpOp::SUB:
+      if (bits == 32 || bits == 64) {
+        int64_t k;
+        if (immediate(rhs, k) && k != INT16_MIN) {
+          return emitImm3(bits == 32 ? BC_ADDIW : BC_ADDI, lhs, -k);
+        }
+        return emit3(bits == 32 ? BC_SUBW : BC_SUB, lhs.type, lhs, rhs);
+      }
+      return wrap(emit3(BC_SUB, lhs.type, lhs, rhs));
+    case InterpOp::MUL:
+      if (bits == 32) {
+        return emit3(BC_MULW, lhs.type, lhs, rhs);
+      }
+      return wrap(emit3(BC_MUL, lhs.type, lhs, rhs));
+    case InterpOp::DIV:
+      return wrap(emit3(BC_DIV, lhs.type, lhs, rhs));
+    case InterpOp::MOD:
+      return emit3(BC_MOD, lhs.type, lhs, rhs);
+    case InterpOp::AND:
+      return emit3(BC_AND, lhs.type, lhs, rhs);
+    case InterpOp::OR:
+      return emit3(BC_OR, lhs.type, lhs, rhs);
+    case InterpOp::XOR:
+      return emit3(BC_XOR, lhs.type, lhs, rhs);
+    case InterpOp::EQ:
+      return emit3(BC_EQ, i1, lhs, rhs);
+    case InterpOp::NE:
+      return emit3(BC_NE, i1, lhs, rhs);
+    case InterpOp::LT:
+      return emit3(BC_LT, i1, lhs, rhs);
+    case InterpOp::GT:
+      return emit3(BC_GT, i1, lhs, rhs);
+    case InterpOp::LE:
+      return emit3(BC_LE, i1, lhs, rhs);
+    case InterpOp::GE:
+      return emit3(BC_GE, i1, lhs, rhs);
+    default:
+      return trap(lhs.type, "Unsupported integer operation");
+    }
+  }
+
+  // ++ and -- on a loaded value; pointers move by one element
+  BcValue step(const BcValue &v, int delta) {
+    llvm::LLVMContext &context = v.type->getContext();
+    if (v.type->isPointerTy()) {
+      return offsetPointer(v, constant(llvm::Type::getInt64Ty(context), delta),
+                           interp_stride(v.type), false);
+    }
+    if (v.type->isDoubleTy()) {
+      return emit3(BC_FADD, v.type, v, constantDouble(v.type, delta));
+    }
+    return binary(InterpOp::ADD, v, constant(v.type, delta));
+  }
+
+  BcValue bitwiseNot(const BcValue &v) {
+    BcValue val(v.type, temp());
+    emit(BC_NOT, val.reg, v.reg, 0);
+    return val;
+  }
+
+  BcValue logicalNot(const BcValue &v) {
+    BcValue val(llvm::Type::getInt1Ty(v.type->getContext()), temp());
+    if (v.type->isDoubleTy()) {
+      emit(BC_FNEZ, val.reg, v.reg, 0);
+      emit(BC_EQZ, val.reg, val.reg, 0);
+    } else {
+      emit(BC_EQZ, val.reg, v.reg, 0);
+    }
+    return val;
+  }
+
+  // base + index * stride, for array subscripts
+  BcValue index(const BcValue &base, const BcValue &index, int64_t stride) {
+    return offsetPointer(base, index, stride, false);
+  }
+
+  BcValue copy(const BcValue &v) {
+    BcValue val(v.type, temp());
+    emit(BC_MOV, val.reg, v.reg, 0);
+    return val;
+  }
+
+  void move(uint16_t to, const BcValue &v) {
+    if (to != v.reg) {
+      emit(BC_MOV, to, v.reg, 0);
+    }
+  }
+
+  uint16_t temp() {
+    if (next_reg == UINT16_MAX) {
+      throw std::runtime_error("Function needs too many registers");
+    }
+    uint16_t reg = next_reg++;
+    if (next_reg > functions[current].register_count) {
+      functions[current].register_count = next_reg;
+    }
+    return reg;
+  }
+
+  // Control flow. Jumps return their position so they can be patched once
+  // the target is known; label() marks a position as a jump target.
+
+  size_t label() {
+    available.clear();
+    last_label = code().size();
+    return last_label;
+  }
+
+  size_t jump() { return emitImm(BC_JMP, 0, 0); }
+
+  size_t jumpIfFalse(const BcValue &cond) { return branch(cond, false); }
+
+  size_t jumpIfTrue(const BcValue &cond) { return branch(cond, true); }
+
+  void patchTo(size_t at, size_t target) {
+    int32_t offset = (int64_t)target - (int64_t)at;
+    if (bc_is_fused_branch(code()[at].op)) {
+      code()[at + 1].setImm(offset);
+    } else {
+      code()[at].setImm(offset);
+    }
+  }
+
+  void patch(size_t at) { patchTo(at, label()); }
+
+  void pushBreak() { breaks.push_back({}); }
+
+  void popBreak(size_t target) {
+    for (size_t at : breaks.back()) {
+      patchTo(at, target);
+    }
+    breaks.pop_back();
+  }
+
+  void pushContinue() { continues.push_back({}); }
+
+  void popContinue(size_t target) {
+    for (size_t at : continues.back()) {
+      patchTo(at, target);
+    }
+    continues.pop_back();
+  }
+
+  void emitBreak() {
+    if (breaks.empty()) {
+      throw std::runtime_error("Break statement outside of loop");
+    }
+    breaks.back().push_back(jump());
+  }
+
+  void emitContinue() {
+    if (continues.empty()) {
+      throw std::runtime_error("Continue statement outside of loop");
+    }
+    continues.back().push_back(jump());
+  }
+
+  void defineLabel(const string &name) { labels[name] = label(); }
+
+  void emitGoto(const string &name) { gotos.push_back({jump(), name}); }
+
+private:
+  struct Mark {
+    size_t bindings;
+    uint16_t next_reg;
+    uint16_t var_top;
+    uint32_t frame_top;
+  };
+
+  vector<BcFunction> functions;
+  map<string, size_t> function_index;
+  size_t current = 0;
+
+  vector<BcImportEntry> imports;
+  map<pair<uint32_t, uint32_t>, size_t> import_index;
+  vector<int64_t> constants;
+  unordered_map<int64_t, uint32_t> constant_index;
+  string data;
+  string strings;
+  unordered_map<string, uint32_t> string_index;
+  uint64_t globals_size = 0;
+
+  unordered_map<string, size_t> ids;
+  vector<pair<bool, BcVariable>> globals;
+
+  // Per function
+  vector<pair<size_t, BcVariable>> bindings;
+  vector<Mark> marks;
+  uint16_t next_reg = 0;
+  uint16_t var_top = 0;
+  uint32_t frame_top = 0;
+  int next_ordinal = 0;
+  set<int> address_taken;
+  bool retry = false;
+  size_t last_label = SIZE_MAX;
+  vector<vector<size_t>> breaks;
+  vector<vector<size_t>> continues;
+  map<string, size_t> labels;
+  vector<pair<size_t, string>> gotos;
+  unordered_map<uint64_t, BcValue> available;
+
+  vector<BcInsn> &code() { return functions[current].code; }
+
+  void beginFunction(size_t index) {
+    current = index;
+    functions[index].code.clear();
+    functions[index].register_count = 0;
+    functions[index].frame_size = 0;
+    bindings.clear();
+    marks.clear();
+    next_reg = var_top = 0;
+    frame_top = 0;
+    next_ordinal = 0;
+    last_label = SIZE_MAX;
+    available.clear();
+    breaks.clear();
+    continues.clear();
+    labels.clear();
+    gotos.clear();
+    pushScope();
+  }
+
+  void finishFunction() {
+    marks.clear();
+    bindings.clear();
+    current = 0;
+  }
+
+  size_t intern(const string &name) {
+    auto it = ids.find(name);
+    if (it != ids.end()) {
+      return it->second;
+    }
+    size_t id = ids.size();
+    ids.emplace(name, id);
+    return id;
+  }
+
+  uint32_t internString(const string &value) {
+    auto it = string_index.find(value);
+    if (it != string_index.end()) {
+      return it->second;
+    }
+    uint32_t offset = strings.size();
+    strings.append(value);
+    strings.push_back('\0');
+    string_index.emplace(value, offset);
+    return offset;
+  }
+
+  uint32_t constantIndex(int64_t value) {
+    auto it = constant_index.find(value);
+    if (it != constant_index.end()) {
+      return it->second;
+    }
+    uint32_t index = constants.size();
+    constants.push_back(value);
+    constant_index.emplace(value, index);
+    return index;
+  }
+
+  static bool isScalar(llvm::Type *type) {
+    return type->isIntegerTy() || type->isPointerTy() || type->isDoubleTy();
+  }
+
+  bool isTemp(uint16_t reg) const { return reg >= var_top; }
+
+  uint16_t newVariableRegister() {
+    uint16_t reg = temp();
+    var_top = next_reg;
+    return reg;
+  }
+
+  // Parameters arrive in the first registers of the callee's window
+  void declareParam(const string &name, llvm::Type *type) {
+    BcVariable var = {type, llvm::PointerType::get(type, 0), false, false,
+                      0, 0, next_ordinal++};
+    uint16_t reg = newVariableRegister();
+    if (!address_taken.count(var.ordinal)) {
+      var.in_register = true;
+      var.reg = reg;
+    } else {
+      var.offset = allocateFrame(interp_size(type));
+      uint16_t addr = temp();
+      emitImm(BC_FADDR, addr, var.offset);
+      emit(storeOp(type), reg, addr, 0);
+      releaseTemps();
+    }
+    bindings.push_back({intern(name), var});
+  }
+
+  uint32_t allocateFrame(uint64_t size) {
+    uint32_t offset = (frame_top + 15) & ~uint32_t(15);
+    if ((uint64_t)offset + size > INT32_MAX) {
+      throw std::runtime_error("Function frame is too large");
+    }
+    frame_top = offset + size;
+    if (frame_top > functions[current].frame_size) {
+      functions[current].frame_size = frame_top;
+    }
+    return offset;
+  }
+
+  size_t emit(uint16_t op, uint16_t a, uint16_t b, uint16_t c) {
+    code().push_back({op, a, b, c});
+    return code().size() - 1;
+  }
+
+  size_t emitImm(uint16_t op, uint16_t a, int64_t imm) {
+    if (imm != (int32_t)imm) {
+      throw std::runtime_error("Bytecode immediate out of range");
+    }
+    BcInsn insn = {op, a, 0, 0};
+    insn.setImm(imm);
+    code().push_back(insn);
+    return code().size() - 1;
+  }
+
+  BcValue emit3(uint16_t op, llvm::Type *type, const BcValue &lhs,
+                const BcValue &rhs) {
+    BcValue val(type, temp());
+    emit(op, val.reg, lhs.reg, rhs.reg);
+    return val;
+  }
+
+  BcValue emitImm3(uint16_t op, const BcValue &lhs, int64_t k) {
+    BcValue val(lhs.type, temp());
+    emit(op, val.reg, lhs.reg, (uint16_t)(int16_t)k);
+    return val;
+  }
+
+  // Whether v is a small constant loaded by the last instruction; if so
+  // the load is dropped and the caller folds k into an immediate operand
+  bool immediate(const BcValue &v, int64_t &k) {
+    if (code().empty() || last_label == code().size() || !isTemp(v.reg)) {
+      return false;
+    }
+    const BcInsn &last = code().back();
+    if (last.op != BC_LOADI || last.a != v.reg || last.imm() < INT16_MIN ||
+        last.imm() > INT16_MAX) {
+      return false;
+    }
+    k = last.imm();
+    forget(last.a);
+    code().pop_back();
+    return true;
+  }
+
+  BcValue wrap(const BcValue &v, bool into_temp = false) {
+    if (!v.type->isIntegerTy()) {
+      return v;
+    }
+    uint16_t op;
+    switch (v.type->getIntegerBitWidth()) {
+    case 1:
+      op = BC_TRUNC1;
+      break;
+    case 8:
+      op = BC_SEXT8;
+      break;
+    case 16:
+      op = BC_SEXT16;
+      break;
+    case 32:
+      op = BC_SEXT32;
+      break;
+    default:
+      return v;
+    }
+    BcValue val(v.type, into_temp || !isTemp(v.reg) ? temp() : v.reg);
+    emit(op, val.reg, v.reg, 0);
+    return val;
+  }
+
+  BcValue offsetPointer(const BcValue &pointer, const BcValue &index,
+                        int64_t stride, bool subtract) {
+    int64_t k;
+    if (immediate(index, k)) {
+      int64_t offset = (subtract ? -k : k) * stride;
+      if (offset >= INT16_MIN && offset <= INT16_MAX) {
+        return emitImm3(BC_ADDI, pointer, offset);
+      }
+      BcValue scaled =
+          constant(llvm::Type::getInt64Ty(pointer.type->getContext()), offset);
+      return emit3(BC_ADD, pointer.type, pointer, scaled);
+    }
+
+    BcValue scaled = index;
+    if (stride != 1) {
+      scaled = BcValue(index.type, temp());
+      if (stride <= INT16_MAX) {
+        emit(BC_MULI, scaled.reg, index.reg, stride);
+      } else {
+        BcValue factor = constant(index.type, stride);
+        emit(BC_MUL, scaled.reg, index.reg, factor.reg);
+      }
+    }
+    return emit3(subtract ? BC_SUB : BC_ADD, pointer.type, pointer, scaled);
+  }
+
+  size_t branch(const BcValue &cond, bool when) {
+    if (cond.type->isVoidTy()) {
+      throw std::runtime_error("Condition value is null");
+    }
+    BcValue value = cond.type->isDoubleTy() ? makeBool(cond) : cond;
+
+    // Fold a comparison computed just before into the branch
+    if (!code().empty() && last_label != code().size() &&
+        isTemp(value.reg) && code().back().a == value.reg &&
+        code().back().op >= BC_EQ && code().back().op <= BC_GE) {
+      static const uint16_t taken[] = {BC_JEQ, BC_JNE, BC_JLT,
+                                       BC_JGT, BC_JLE, BC_JGE};
+      static const uint16_t inverse[] = {BC_JNE, BC_JEQ, BC_JGE,
+                                         BC_JLE, BC_JGT, BC_JLT};
+      BcInsn compare = code().back();
+      forget(compare.a);
+      code().pop_back();
+      uint16_t op = (when ? taken : inverse)[compare.op - BC_EQ];
+      size_t at = emit(op, compare.b, compare.c, 0);
+      emitImm(BC_JMP, 0, 0); // extension word holding the offset
+      return at;
+    }
+
+    return emitImm(when ? BC_JNZ : BC_JZ, value.reg, 0);
+  }
+
+  uint16_t window(const vector<BcValue> &args) {
+    uint16_t base = next_reg;
+    for (size_t i = 0; i < args.size(); i++) {
+      temp();
+    }
+    if (args.empty()) {
+      temp();
+    }
+    for (size_t i = 0; i < args.size(); i++) {
+      move(base + i, args[i]);
+    }
+    return base;
+  }
+
+  static uint16_t loadOp(llvm::Type *type) {
+    if (type->isPointerTy() || type->isDoubleTy()) {
+      return BC_LD64;
+    }
+    if (type->isIntegerTy()) {
+      switch (type->getIntegerBitWidth()) {
+      case 1:
+        return BC_LD1;
+      case 8:
+        return BC_LD8;
+      case 16:
+        return BC_LD16;
+      case 32:
+        return BC_LD32;
+      case 64:
+        return BC_LD64;
+      }
+    }
+    throw std::runtime_error("Cannot load a value of this type");
+  }
+
+  static uint16_t storeOp(llvm::Type *type) {
+    if (type->isPointerTy() || type->isDoubleTy()) {
+      return BC_ST64;
+    }
+    if (type->isIntegerTy()) {
+      switch (type->getIntegerBitWidth()) {
+      case 1:
+      case 8:
+        return BC_ST8;
+      case 16:
+        return BC_ST16;
+      case 32:
+        return BC_ST32;
+      case 64:
+        return BC_ST64;
+      }
+    }
+    throw std::runtime_error("Cannot store a value of this type");
+  }
+};
+
+#endif // INCLUDE_CC_BYTECODE_H_
@@ -141,7 +141,7 @@ extern int yydebug;
 #if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
 union YYSTYPE
 {
-#line 22 "c.y"
+#line 112 "c.y"
 
 	ASTNode* base_node;
 	char* str;
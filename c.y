@@ -17,6 +17,96 @@ extern "C" FILE *yyin;
 void yyerror(const char *s);
 
 ASTNode* root = NULL;
+
+// When set, each external declaration is handed over as soon as it is
+// reduced instead of being collected under `root`.
+void (*stream_declaration)(ASTNode *) = NULL;
+
+ScoperStack scoperStack;
+CodeGenerator codeGenerator;
+
+Profiler profiler;
+
+map<string, llvm::BasicBlock *> labels;
+
+llvm::Type *declaration_type = nullptr;
+vector<llvm::Type *> function_params;
+
+int parameter_list_index = 0;
+
+bool get_as_lvalue = false;
+
+bool global_is_variadic = false;
+
+bool am_i_initialising = false;
+
+llvm::BasicBlock *loop_block = nullptr;
+llvm::BasicBlock *merge_block = nullptr;
+
+llvm::Type *array_type = nullptr;
+
+bool is_declaration_global = false;
+
+bool is_declaration_static = false;
+
+bool is_declaration_extern = false;
+
+thread_local OptimisationContext optimisationContext;
+
+thread_local SpecifierEnum dec_type_for_optimisation;
+
+thread_local bool constant_prop = true;
+
+unsigned optimise_threads = 1;
+
+ExprTable expr_table;
+
+DeadCodeStats dead_code_stats;
+
+CompileStats compile_stats;
+
+unsigned log_categories = 0;
+
+PureFunctions pure_functions;
+
+unsigned unroll_budget = 64;
+
+UnrollStats unroll_stats;
+
+Simplifier simplifier;
+
+CallSites call_sites;
+
+unsigned specialise_budget = 200;
+
+Inliner inliner;
+
+unsigned inline_size = 12;
+
+Interpreter interpreter;
+
+BytecodeCompiler bytecodeCompiler;
+
+vector<ASTNode *> *node_pool = nullptr;
+
+// The driver may create `root` up front (streaming mode) so that it is not
+// released together with the first declaration.
+static ASTNode *translation_unit_root()
+{
+	if (root == NULL) {
+		root = new TranslationUnitNode();
+	}
+	return root;
+}
+
+static void add_external_declaration(ASTNode *unit, ASTNode *declaration)
+{
+	if (stream_declaration) {
+		stream_declaration(declaration);
+	} else {
+		unit->addChild(declaration);
+	}
+}
 %}
 
 %union {
@@ -558,8 +648,8 @@ jump_statement
 	;
 
 translation_unit
-	: external_declaration {$$ = new TranslationUnitNode() ;root = $$; root->addChild($1);}
-	| translation_unit external_declaration {$$ = $1; $1->addChild($2);}
+	: external_declaration {$$ = translation_unit_root(); add_external_declaration($$, $1);}
+	| translation_unit external_declaration {$$ = $1; add_external_declaration($1, $2);}
 	;
 
 external_declaration
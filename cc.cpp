@@ -1,53 +1,925 @@
 #include "AST.hpp"
+#include "baseline.h"
 #include "c.tab.hpp"
+#include "llvm/IR/PassTimingInfo.h"
+#include "llvm/Pass.h"
 #include "scoper.h"
+#include "tier.h"
+#include "vm.h"
 #include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <new>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <sys/resource.h>
+#include <unistd.h>
 extern "C" int yylex();
 int yyparse();
 extern "C" FILE *yyin;
+void yyrestart(FILE *input_file);
 
 extern "C" ASTNode *root;
+extern void (*stream_declaration)(ASTNode *);
+
+static bool optimise = true;
+static bool dump_ast = false;
+static AstFormat dump_format = AstFormat::Text;
+static bool bench_ast = false;
+static bool skipSemantics = true;
+static bool object_output = false;
+static bool bitcode_output = false;
+static bool bitcode_summary = false;
+static unsigned backend_threads = 1;
+static llvm::CodeGenOpt::Level backend_level = llvm::CodeGenOpt::Default;
+static bool fast_compile = false;
+static bool time_report = false;
+// Only -ftime-report times each LLVM pass; --fast-compile keeps it cheap
+static bool time_passes = false;
+static string trace_filename;
+static string stats_filename;
+static vector<string> stats_sources;
+static bool interpret = false;
+static bool run_vm = false;
+static bool emit_bytecode = false;
+static bool run_bytecode = false;
+static bool dump_bytecode = false;
+static bool tiered = false;
+static bool run_baseline = false;
+static uint32_t tier_threshold = 10000;
 
 static void usage() {
   std::cout << "Usage: cc <prog.c>" << std::endl;
+  std::cout << "       cc --whole-program <prog.c>... " << std::endl;
+  std::cout << "<prog.c> can also be LLVM bitcode written by --emit-bc "
+               "(named *.bc), which is only linked and lowered"
+            << std::endl;
   std::cout << "Additional arguments:" << std::endl;
   std::cout << "-o <filename>: Specify output file" << std::endl;
   std::cout << "--no-optimise: Disable optimization" << std::endl;
+  std::cout << "-c: Emit an object file (default a.o) instead of LLVM IR"
+            << std::endl;
+  std::cout << "--emit-bc: Emit LLVM bitcode (default a.bc) instead of "
+               "textual IR"
+            << std::endl;
+  std::cout << "--emit-bc=summary: Like --emit-bc, and add a module "
+               "summary index of the functions' calls and references"
+            << std::endl;
+  std::cout << "--backend-threads=<n>: With -c, split the module by function "
+               "and lower the parts on n threads"
+            << std::endl;
+
+  std::cout << "--fast-compile: For debug builds: no AST optimisation, an "
+               "object file (default a.o) from the fastest instruction "
+               "selector and register allocator, and the time of each phase"
+            << std::endl;
 
-  std::cout << "--dump-ast: Dump abstract syntax tree" << std::endl;
+  std::cout << "-ftime-report: Print the time of each phase, and of each "
+               "LLVM pass to stderr"
+            << std::endl;
+  std::cout << "-ftime-trace[=<file>]: Write the phases, and the work on "
+               "each function within them, as Chrome trace events (default "
+               "the output file with a .json extension)"
+            << std::endl;
+  std::cout << "--stats[=<file>]: Write the nodes, constant folds, optimiser "
+               "rounds, symbol lookups, IR size, allocations and peak RSS "
+               "of the compile as JSON (default the output file with a "
+               ".stats.json extension)"
+            << std::endl;
+  std::cout << "--log[=<category>,...]: Trace the compiler's work to stderr: "
+               "codegen, types, casts or all (the default)"
+            << std::endl;
+  std::cout << "--dump-ast[=text|json|binary]: Dump the abstract syntax tree "
+               "before and after optimise, as text on stdout or appended to "
+               "<source-stem>.ast.<ext> and <source-stem>.opt.ast.<ext> "
+               "(<ext> is json or bin)"
+            << std::endl;
+  std::cout << "--bench-ast: Time walks of the parsed AST against its flat "
+               "(index-based) copy"
+            << std::endl;
+  std::cout << "--stream: Optimise and lower each declaration as soon as it "
+               "is parsed, then free its AST"
+            << std::endl;
+  std::cout << "--optimise-threads=<n>: Optimise function bodies on n "
+               "threads (default: one per core)"
+            << std::endl;
+  std::cout << "--unroll-budget=<n>: Fully unroll loops with a constant trip "
+               "count while trips times body size stays within n "
+               "(default 64, 0 disables)"
+            << std::endl;
+  std::cout << "--specialise-budget=<n>: Clone functions for the constant "
+               "arguments of their calls while the clones copy at most n "
+               "expressions (default 200, 0 disables)"
+            << std::endl;
+  std::cout << "--inline-size=<n>: Inline calls to functions that only "
+               "return an expression of at most n nodes (default 12, 0 "
+               "leaves only functions declared inline)"
+            << std::endl;
+  std::cout << "--interp: Run the program by walking the optimised AST "
+               "instead of emitting code"
+            << std::endl;
+  std::cout << "--vm: Compile the optimised AST to bytecode and run it on "
+               "the register VM"
+            << std::endl;
+  std::cout << "--emit-bytecode: Write the bytecode image (default a.ccbc) "
+               "instead of LLVM IR"
+            << std::endl;
+  std::cout << "--run-bytecode: <prog> is a bytecode image written by "
+               "--emit-bytecode; map it and run it"
+            << std::endl;
+  std::cout << "--dump-bytecode: Print the bytecode before running or "
+               "writing it"
+            << std::endl;
+  std::cout << "--tiered: Like --vm, but functions that get hot are compiled "
+               "to native code in the background and called from then on"
+            << std::endl;
+  std::cout << "--baseline: Like --vm, but translate the bytecode to x86-64 "
+               "machine code without LLVM and run that"
+            << std::endl;
+  std::cout << "--tier-threshold=<n>: Calls plus loop iterations after "
+               "which a function counts as hot (default 10000)"
+            << std::endl;
+  std::cout << "--profile-generate[=<file>]: Count function calls and "
+               "branch outcomes, and have the program write them to file "
+               "(default a.ccprof) when it exits"
+            << std::endl;
+  std::cout << "--profile-use=<file>: Annotate functions and branches with "
+               "the counts in a profile written by --profile-generate"
+            << std::endl;
+  std::cout << "--whole-program: Compile every <prog.c> into one object "
+               "(default a.o, or bitcode with --emit-bc), linked in-process "
+               "with only main visible and optimised as a whole"
+            << std::endl;
   std::cout << "--semantics: Explicit Checking for semantics, this is merged with codegen step and should not be used" << std::endl;
 }
 
+// --stats counts the C++ allocations of each phase, LLVM's included
+static std::atomic<uint64_t> allocations{0};
+
+void *operator new(size_t size) {
+  if (compile_stats.enabled) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (void *memory = malloc(size ? size : 1)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept { free(memory); }
+
+void operator delete(void *memory, size_t) noexcept { free(memory); }
+
+static long peak_rss_kb() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+// -ftime-report: the wall time of each phase of the compiler, printed as a
+// table. Phases nest, like the rounds of the optimiser. Under -ftime-trace
+// every phase is also an event of the trace, around the per-function events
+// of the optimiser, codegen and LLVM's passes. Under --stats each phase
+// also records the allocations and nodes it made, and the peak RSS by its
+// end.
+class PhaseTimes {
+public:
+  void begin(const string &phase) {
+    open.push_back(phases.size());
+    phases.push_back({phase, open.size() - 1,
+                      std::chrono::steady_clock::now(), 0,
+                      allocations.load(std::memory_order_relaxed), 0,
+                      compile_stats.nodeCounts()});
+    if (llvm::timeTraceProfilerEnabled()) {
+      llvm::timeTraceProfilerBegin(phase, "");
+    }
+  }
+
+  void end() {
+    Phase &phase = phases[open.back()];
+    open.pop_back();
+    phase.ms = std::chrono::duration<double, std::milli>(
+                   std::chrono::steady_clock::now() - phase.start)
+                   .count();
+    phase.allocations =
+        allocations.load(std::memory_order_relaxed) - phase.allocations;
+    phase.peak_rss_kb = peak_rss_kb();
+    vector<uint64_t> nodes = compile_stats.nodeCounts();
+    for (size_t i = 0; i < nodes.size(); i++) {
+      phase.nodes[i] = nodes[i] - phase.nodes[i];
+    }
+    if (llvm::timeTraceProfilerEnabled()) {
+      llvm::timeTraceProfilerEnd();
+    }
+  }
+
+  void report() const {
+    double total = 0;
+    for (auto &phase : phases) {
+      total += phase.depth == 0 ? phase.ms : 0;
+    }
+    printf("Time report:\n");
+    printf("  %-36s %10s %7s\n", "phase", "ms", "%");
+    for (auto &phase : phases) {
+      int indent = 2 * phase.depth;
+      printf("  %*s%-*s %10.3f %6.1f%%\n", indent, "", 36 - indent,
+             phase.name.c_str(), phase.ms,
+             total > 0 ? 100 * phase.ms / total : 0.0);
+    }
+    printf("  %-36s %10.3f\n", "total", total);
+  }
+
+  // The phases as a JSON array, for --stats
+  string json() const {
+    string json = "[";
+    for (auto &phase : phases) {
+      char times[128];
+      snprintf(times, sizeof(times),
+               "\"depth\": %zu, \"ms\": %.3f, \"allocations\": %llu, "
+               "\"peak_rss_kb\": %ld",
+               phase.depth, phase.ms, (unsigned long long)phase.allocations,
+               phase.peak_rss_kb);
+      json += (json.size() > 1 ? ",\n    {\"name\": " : "\n    {\"name\": ") +
+              json_string(phase.name) + ", " + times +
+              ", \"nodes\": " + stats_by_kind(phase.nodes) + "}";
+    }
+    return json + "\n  ]";
+  }
+
+  // The nodes the first `name` phase made (the AST, for "parse")
+  vector<uint64_t> nodes(const string &name) const {
+    for (auto &phase : phases) {
+      if (phase.name == name) {
+        return phase.nodes;
+      }
+    }
+    return vector<uint64_t>(CompileStats::KINDS);
+  }
+
+private:
+  struct Phase {
+    string name;
+    size_t depth;
+    std::chrono::steady_clock::time_point start;
+    double ms;
+    uint64_t allocations;
+    long peak_rss_kb;
+    vector<uint64_t> nodes;
+  };
+
+  vector<Phase> phases;
+  vector<size_t> open;
+};
+
+static PhaseTimes phase_times;
+
+// --stats: the rounds optimise() ran, and the blocks and instructions of
+// each function of the module lowered (in JSON)
+static unsigned optimise_rounds = 0;
+static string ir_stats = "{}";
+
+static void count_ir(const llvm::Module &module) {
+  uint64_t blocks = 0, instructions = 0;
+  string functions;
+  for (const llvm::Function &function : module) {
+    if (function.isDeclaration()) {
+      continue;
+    }
+    uint64_t function_instructions = function.getInstructionCount();
+    blocks += function.size();
+    instructions += function_instructions;
+    functions += (functions.empty() ? "\n      " : ",\n      ") +
+                 json_string(function.getName().str()) +
+                 ": {\"blocks\": " + to_string(function.size()) +
+                 ", \"instructions\": " + to_string(function_instructions) +
+                 "}";
+  }
+  ir_stats = "{\"blocks\": " + to_string(blocks) +
+             ", \"instructions\": " + to_string(instructions) +
+             ", \"functions\": {" + functions +
+             (functions.empty() ? "}}" : "\n    }}");
+}
+
+static void write_stats(const vector<string> &sources) {
+  string source_list;
+  for (const string &source : sources) {
+    source_list += (source_list.empty() ? "" : ", ") + json_string(source);
+  }
+  vector<uint64_t> folds(CompileStats::KINDS);
+  for (size_t i = 0; i < folds.size(); i++) {
+    folds[i] = compile_stats.folds[i].load();
+  }
+
+  FILE *out = fopen(stats_filename.c_str(), "w");
+  if (!out) {
+    std::cerr << "Error: Cannot open " << stats_filename << std::endl;
+    return;
+  }
+  fprintf(out, "{\n");
+  fprintf(out, "  \"sources\": [%s],\n", source_list.c_str());
+  fprintf(out, "  \"ast_nodes\": %s,\n",
+          stats_by_kind(phase_times.nodes("parse")).c_str());
+  fprintf(out, "  \"optimise_rounds\": %u,\n", optimise_rounds);
+  fprintf(out, "  \"constant_folds\": %s,\n", stats_by_kind(folds).c_str());
+  fprintf(out,
+          "  \"symbol_table\": {\"codegen_lookups\": %llu, "
+          "\"codegen_scope_misses\": %llu, \"optimiser_lookups\": %llu, "
+          "\"optimiser_misses\": %llu},\n",
+          (unsigned long long)codeGenerator.symbol_lookups,
+          (unsigned long long)codeGenerator.symbol_misses,
+          (unsigned long long)compile_stats.value_lookups.load(),
+          (unsigned long long)compile_stats.value_misses.load());
+  fprintf(out, "  \"ir\": %s,\n", ir_stats.c_str());
+  fprintf(out, "  \"phases\": %s\n", phase_times.json().c_str());
+  fprintf(out, "}\n");
+  fclose(out);
+}
+
+// Prints the time report and writes the time trace and the statistics,
+// once the compiler is done
+static void report_phases() {
+  if (time_report) {
+    phase_times.report();
+    fflush(stdout);
+  }
+  if (time_passes) {
+    llvm::reportAndResetTimings();
+  }
+  if (llvm::timeTraceProfilerEnabled()) {
+    if (llvm::Error error = llvm::timeTraceProfilerWrite(trace_filename, "")) {
+      std::cerr << "Error: " << llvm::toString(std::move(error)) << std::endl;
+    }
+    llvm::timeTraceProfilerCleanup();
+  }
+  if (compile_stats.enabled) {
+    write_stats(stats_sources);
+  }
+}
+
+static void write_output(const string &out_filename) {
+  if (compile_stats.enabled) {
+    count_ir(*codeGenerator.global_module);
+  }
+  profiler.finish(*codeGenerator.global_module,
+                  codeGenerator.string_literals);
+  profiler.report();
+  if (object_output) {
+    phase_times.begin("object");
+    root->dump_object(out_filename, backend_threads, backend_level);
+  } else if (bitcode_output) {
+    phase_times.begin("bitcode");
+    root->dump_bitcode(out_filename, bitcode_summary);
+  } else {
+    phase_times.begin("IR");
+    root->dump_llvm(out_filename);
+  }
+  phase_times.end();
+}
+
+// --dump-ast of the tree parsed from `source`. Text is streamed to stdout
+// under `heading`, coloured on a terminal. JSON (a line per tree) and binary
+// trees are appended to a file named after the source and the stage.
+static void dump_tree(const ASTNode *node, const string &heading,
+                      const string &source, bool optimised) {
+  if (dump_format == AstFormat::Text) {
+    printf("%s:\n\n", heading.c_str());
+    TextAstWriter writer(std::cout, isatty(STDOUT_FILENO));
+    node->dump(writer);
+    std::cout << std::endl;
+    return;
+  }
+
+  static std::map<string, unique_ptr<std::ofstream>> files;
+  string filename = source.substr(0, source.rfind('.')) +
+                    (optimised ? ".opt" : "") +
+                    (dump_format == AstFormat::Json ? ".ast.json" : ".ast.bin");
+  unique_ptr<std::ofstream> &file = files[filename];
+  if (!file) {
+    file.reset(new std::ofstream(filename, std::ios::binary));
+    if (!*file) {
+      std::cerr << "Error: Cannot open " << filename << std::endl;
+      exit(1);
+    }
+  }
+  node->dump(*make_ast_writer(dump_format, *file));
+  if (dump_format == AstFormat::Json) {
+    *file << '\n';
+  }
+  file->flush();
+}
+
+// The nodes of a tree counted by kind, and its depth
+struct AstShape {
+  vector<uint64_t> kinds = vector<uint64_t>(CompileStats::KINDS);
+  size_t depth = 0;
+};
+
+// Finds the shape by recursing through the children of each node: the walk
+// every pass over the pointer AST makes
+static void pointer_ast_shape(const ASTNode *node, size_t depth,
+                              AstShape &shape) {
+  shape.kinds[(size_t)node->getNodeType()]++;
+  shape.depth = std::max(shape.depth, depth);
+  node->forEachChild([&](const ASTNode *child) {
+    pointer_ast_shape(child, depth + 1, shape);
+  });
+}
+
+// The same walk over a FlatAst: a scan of its arrays
+static AstShape flat_ast_shape(const FlatAst &ast) {
+  AstShape shape;
+  vector<FlatAst::Id> open;
+  for (FlatAst::Id n = 0; n < ast.size(); n++) {
+    while (!open.empty() && open.back() == n) {
+      open.pop_back();
+    }
+    shape.kinds[(size_t)ast.type(n)]++;
+    shape.depth = std::max(shape.depth, open.size() + 1);
+    if (!ast.isLeaf(n)) {
+      open.push_back(ast.end(n));
+    }
+  }
+  return shape;
+}
+
+// --bench-ast: the best of several walks of the parsed tree as pointer
+// nodes and as a FlatAst, and the cost of flattening it
+static void bench_ast_walks(const ASTNode *root) {
+  const int runs = 5;
+  auto best_ms = [&](const std::function<void()> &walk) {
+    double best = 0;
+    for (int i = 0; i < runs; i++) {
+      auto start = std::chrono::steady_clock::now();
+      walk();
+      double ms = std::chrono::duration<double, std::milli>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+      best = i == 0 ? ms : std::min(best, ms);
+    }
+    return best;
+  };
+
+  AstShape pointer_shape, flat_shape;
+  FlatAst flat;
+  double pointer_ms = best_ms([&] {
+    pointer_shape = AstShape();
+    pointer_ast_shape(root, 1, pointer_shape);
+  });
+  double flatten_ms = best_ms([&] { flat = root->flatten(); });
+  double flat_ms = best_ms([&] { flat_shape = flat_ast_shape(flat); });
+  if (pointer_shape.kinds != flat_shape.kinds ||
+      pointer_shape.depth != flat_shape.depth) {
+    std::cerr << "Error: the pointer and flat walks disagree on the AST"
+              << std::endl;
+    exit(1);
+  }
+
+  printf("AST bench: %zu nodes, depth %zu; pointer walk %.3f ms, flatten "
+         "%.3f ms, flat walk %.3f ms (%.1fx)\n",
+         flat.size(), flat_shape.depth, pointer_ms, flatten_ms, flat_ms,
+         flat_ms > 0 ? pointer_ms / flat_ms : 0.0);
+}
+
+// Runs optimise() until the dumped AST stops changing and the calls recorded
+// would not seed or clone anything new (at most ~100 rounds)
+static ASTNode *optimise_to_fixed_point(ASTNode *node,
+                                        ASTNode *(*round)(const ASTNode *)) {
+  ASTNode *old = new NullPtrNode();
+  string old_dump = old->dump_ast(AstFormat::Binary);
+  int i = 0;
+  while (old_dump != node->dump_ast(AstFormat::Binary) ||
+         call_sites.pending()) {
+    old_dump = node->dump_ast(AstFormat::Binary);
+    optimise_rounds++;
+    phase_times.begin("round " + to_string(i + 1));
+    node = round(node);
+    phase_times.end();
+    if (i > 100) {
+      break;
+    }
+    i++;
+  }
+  return node;
+}
+
+static ASTNode *optimise_translation_unit(const ASTNode *node) {
+  return node->optimise();
+}
+
+static void report_optimisations() {
+  printf("Dead code removed: %u unreachable statements, %u unused "
+         "expressions, %u dead stores, %u unused locals\n",
+         dead_code_stats.unreachable.load(), dead_code_stats.unused.load(),
+         dead_code_stats.stores.load(), dead_code_stats.locals.load());
+  printf("Loops unrolled: %u, %u iterations\n", unroll_stats.loops.load(),
+         unroll_stats.iterations.load());
+  simplifier.report();
+  call_sites.report();
+  inliner.report();
+}
+
+// Runs main() of the program through `run_program` and exits with its
+// return value. The program writes to `program_stdout`; anything the
+// compiler prints meanwhile is dropped.
+static void run_main(const char *tag, int program_stdout,
+                     std::chrono::steady_clock::time_point start,
+                     const std::function<int()> &run_program) {
+  report_phases();
+  std::streambuf *chatter = std::cout.rdbuf(nullptr);
+  fflush(stdout);
+  dup2(program_stdout, 1);
+
+  int status;
+  try {
+    status = run_program();
+  } catch (const std::exception &e) {
+    fflush(stdout);
+    std::cout.rdbuf(chatter);
+    std::cerr << tag << ": " << e.what() << std::endl;
+    exit(1);
+  }
+
+  fflush(stdout);
+  std::cout.rdbuf(chatter);
+
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  fprintf(stderr, "%s: main returned %d, %.3f ms from start-up to exit\n",
+          tag, status, elapsed.count());
+  exit(status);
+}
+
+static void run_image(const BcImage &image, int program_stdout,
+                      std::chrono::steady_clock::time_point start) {
+  if (dump_bytecode) {
+    std::cerr << bc_disassemble(image);
+  }
+  if (run_baseline) {
+    auto translate = std::chrono::steady_clock::now();
+    unique_ptr<BaselineCompiler> compiler;
+    try {
+      compiler = make_unique<BaselineCompiler>(image);
+    } catch (const std::exception &e) {
+      std::cerr << "baseline: " << e.what() << std::endl;
+      exit(1);
+    }
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - translate;
+    fprintf(stderr, "baseline: %zu bytes of x86-64 in %.3f ms\n",
+            compiler->codeSize(), elapsed.count());
+    run_main("baseline", program_stdout, start,
+             [&compiler]() { return (int)compiler->run(); });
+  }
+  run_main("vm", program_stdout, start, [&image]() {
+    BytecodeVM vm(image);
+    if (!tiered) {
+      return (int)vm.run();
+    }
+    TierCompiler tier(vm, bytecodeCompiler, []() -> llvm::Module & {
+      root->codegen();
+      return *codeGenerator.global_module;
+    });
+    vm.countHeat(tier_threshold,
+                 [&tier](uint32_t function) { tier.hot(function); });
+    return (int)vm.run();
+  });
+}
+
+// Streaming mode: every external declaration is optimised and lowered the
+// moment the parser reduces it, and all nodes it allocated (including the
+// optimiser's copies) are released before parsing continues.
+static vector<ASTNode *> declaration_pool;
+static string streamed_source;
+
+static void compile_streamed_declaration(ASTNode *declaration) {
+  if (dump_ast) {
+    dump_tree(declaration, "AST", streamed_source, false);
+  }
+
+  if (!skipSemantics && !declaration->check_semantics()) {
+    printf("Scoping Failed\n");
+    exit(1);
+  }
+
+  if (optimise) {
+    declaration = optimise_to_fixed_point(
+        declaration, TranslationUnitNode::optimise_external_declaration);
+  }
+
+  if (dump_ast) {
+    dump_tree(declaration, "AST->After optimise", streamed_source, true);
+  }
+
+  TranslationUnitNode::codegen_external_declaration(declaration);
+  ASTNode::release_pool(declaration_pool);
+}
+
+static bool is_bitcode(const string &source) {
+  return source.size() > 3 && source.compare(source.size() - 3, 3, ".bc") == 0;
+}
+
+// A bitcode source is not compiled again, only written out as IR, bitcode
+// or an object
+static void convert_bitcode(const string &source, const string &out_filename) {
+  cout << "prog_filename = " << source << endl;
+  try {
+    codeGenerator.global_module =
+        read_bitcode(source, codeGenerator.getContext());
+    if (llvm::Error error = codeGenerator.global_module->materializeAll()) {
+      throw std::runtime_error("Cannot read " + source + ": " +
+                               llvm::toString(std::move(error)));
+    }
+  } catch (const std::exception &e) {
+    std::cout << "Error: " << e.what() << std::endl;
+    exit(1);
+  }
+  root = new TranslationUnitNode();
+  write_output(out_filename);
+  report_phases();
+}
+
+// The functions units[unit] defines that another unit declares, and so
+// may call. Bitcode sources have no unit; the functions they declare are
+// in `bitcode_calls`.
+static set<string> external_functions(const vector<ASTNode *> &units,
+                                      size_t unit,
+                                      const set<string> &bitcode_calls) {
+  set<string> result;
+  for (ASTNode *child : units[unit]->getChildren()) {
+    if (child->getNodeType() != NodeType::FunctionDefinition) {
+      continue;
+    }
+    string name = child->get().s;
+    if (bitcode_calls.count(name)) {
+      result.insert(name);
+    }
+    for (size_t other = 0; other < units.size(); other++) {
+      if (other == unit || !units[other]) {
+        continue;
+      }
+      for (ASTNode *declaration : units[other]->getChildren()) {
+        if (declaration->declaresFunction(name)) {
+          result.insert(name);
+        }
+      }
+    }
+  }
+  return result;
+}
+
+// The functions of a translation unit compiled on its own that another
+// one linked with it may call: all but main and the static ones
+static set<string> exported_functions(ASTNode *unit) {
+  set<string> result;
+  for (ASTNode *child : unit->getChildren()) {
+    if (child->getNodeType() == NodeType::FunctionDefinition &&
+        !child->declaresStatic() && child->get().s != "main") {
+      result.insert(child->get().s);
+    }
+  }
+  return result;
+}
+
+// Whole-program mode: every source is parsed, optimised and lowered into a
+// module of its own, then the modules are linked into one. The optimiser
+// state carried between rounds is reset for each source, and the functions
+// other sources call are not assumed to be called only from their own.
+// Bitcode sources join the link as they are.
+static void compile_whole_program(const vector<string> &sources,
+                                  const string &out_filename) {
+  vector<ASTNode *> units;
+  vector<unique_ptr<llvm::Module>> modules(sources.size());
+  set<string> bitcode_calls;
+  phase_times.begin("parse");
+  for (size_t i = 0; i < sources.size(); i++) {
+    const string &source = sources[i];
+    cout << "prog_filename = " << source << endl;
+    if (is_bitcode(source)) {
+      try {
+        modules[i] = read_bitcode(source, codeGenerator.getContext());
+      } catch (const std::exception &e) {
+        std::cout << "Error: " << e.what() << std::endl;
+        exit(1);
+      }
+      for (llvm::Function &function : *modules[i]) {
+        if (function.isDeclaration()) {
+          bitcode_calls.insert(function.getName().str());
+        }
+      }
+      units.push_back(nullptr);
+      continue;
+    }
+    yyin = fopen(source.c_str(), "r");
+    if (!yyin) {
+      std::cout << "Error: Cannot open " << source << std::endl;
+      exit(1);
+    }
+    yyrestart(yyin);
+    root = nullptr;
+    if (yyparse() != 0) {
+      printf("Parsing %s failed\n", source.c_str());
+      exit(1);
+    }
+    fclose(yyin);
+    units.push_back(root ? root : new TranslationUnitNode());
+  }
+  printf("Parsing successful\n");
+  phase_times.end();
+
+  for (size_t i = 0; i < units.size(); i++) {
+    if (!units[i]) {
+      continue;
+    }
+    phase_times.begin(sources[i]);
+    root = units[i];
+    if (dump_ast) {
+      dump_tree(root, "AST of " + sources[i], sources[i], false);
+    }
+    if (!skipSemantics) {
+      phase_times.begin("semantics");
+      if (!root->check_semantics()) {
+        printf("Scoping Failed\n");
+        exit(1);
+      }
+      phase_times.end();
+    }
+
+    call_sites.reset();
+    call_sites.external(external_functions(units, i, bitcode_calls));
+    pure_functions.reset();
+    optimisationContext = OptimisationContext();
+    if (optimise) {
+      phase_times.begin("optimise");
+      root = optimise_to_fixed_point(root, optimise_translation_unit);
+      phase_times.end();
+    }
+    if (dump_ast) {
+      dump_tree(root, "AST->After optimise", sources[i], true);
+    }
+
+    try {
+      phase_times.begin("codegen");
+      root->codegen();
+      modules[i] = reload(codeGenerator.takeModule(
+          i + 1 < units.size() ? sources[i + 1] : "global_module"));
+      phase_times.end();
+    } catch (const std::exception &e) {
+      std::cout << "Error: " << sources[i] << ": " << e.what() << std::endl;
+      exit(1);
+    }
+    phase_times.end();
+  }
+  if (optimise) {
+    report_optimisations();
+  }
+
+  try {
+    phase_times.begin(optimise ? "link and LTO" : "link");
+    codeGenerator.global_module = link_whole_program(
+        std::move(modules), codeGenerator.getContext(), optimise);
+    phase_times.end();
+  } catch (const std::exception &e) {
+    std::cout << "Error: " << e.what() << std::endl;
+    exit(1);
+  }
+  if (!root) {
+    root = new TranslationUnitNode();
+  }
+  write_output(out_filename);
+  report_phases();
+}
+
 int main(int argc, char **argv) {
 
+  auto start = std::chrono::steady_clock::now();
+
   bool unknownArgument = false;
   bool hasProgC = false;
-  bool skipSemantics = true;
+  bool stream = false;
+  bool has_out_filename = false;
+  bool whole_program = false;
+  bool time_trace = false;
+  vector<string> sources;
+  bool profile_generate = false;
+  std::string profile_filename;
 
   std::string out_filename = "a.ll";
-  bool optimise = true;
-  bool dump_ast = false;
   std::string prog_filename;
 
-  cout << "argc = " << argc << endl;
+  optimise_threads = std::thread::hardware_concurrency();
 
   for (int i = 1; i < argc; ++i) {
     std::string arg = argv[i];
     if (arg == "-o" && i + 1 < argc) {
       out_filename = argv[i + 1];
+      has_out_filename = true;
       i++;
+    } else if (arg == "-c") {
+      object_output = true;
+    } else if (arg == "--emit-bc") {
+      bitcode_output = true;
+    } else if (arg == "--emit-bc=summary") {
+      bitcode_output = true;
+      bitcode_summary = true;
+    } else if (arg.rfind("--backend-threads=", 0) == 0) {
+      backend_threads = std::stoul(arg.substr(strlen("--backend-threads=")));
     } else if (arg == "--no-optimise") { // Check for --optimise flag
       optimise = false;
+    } else if (arg == "-ftime-report") {
+      time_report = true;
+      time_passes = true;
+    } else if (arg == "-ftime-trace") {
+      trace_filename = "";
+      time_trace = true;
+    } else if (arg.rfind("-ftime-trace=", 0) == 0) {
+      trace_filename = arg.substr(strlen("-ftime-trace="));
+      time_trace = true;
+    } else if (arg == "--log") {
+      log_categories = LOG_ALL;
+    } else if (arg.rfind("--log=", 0) == 0) {
+      try {
+        log_categories |= parse_log_categories(arg.substr(strlen("--log=")));
+      } catch (const std::exception &e) {
+        std::cout << "Error: " << e.what() << std::endl;
+        exit(1);
+      }
+    } else if (arg == "--stats") {
+      stats_filename = "";
+      compile_stats.enabled = true;
+    } else if (arg.rfind("--stats=", 0) == 0) {
+      stats_filename = arg.substr(strlen("--stats="));
+      compile_stats.enabled = true;
+    } else if (arg == "--fast-compile") {
+      fast_compile = true;
     } else if (arg == "--dump-ast") { // Check for --dump-ast flag
       dump_ast = true;
+    } else if (arg.rfind("--dump-ast=", 0) == 0) {
+      string format = arg.substr(strlen("--dump-ast="));
+      if (format == "text") {
+        dump_format = AstFormat::Text;
+      } else if (format == "json") {
+        dump_format = AstFormat::Json;
+      } else if (format == "binary") {
+        dump_format = AstFormat::Binary;
+      } else {
+        std::cout << "Error: Unknown AST format " << format << std::endl;
+        exit(1);
+      }
+      dump_ast = true;
+    } else if (arg == "--bench-ast") {
+      bench_ast = true;
+    } else if (arg == "--stream") {
+      stream = true;
+    } else if (arg.rfind("--optimise-threads=", 0) == 0) {
+      optimise_threads = std::stoul(arg.substr(strlen("--optimise-threads=")));
+    } else if (arg.rfind("--unroll-budget=", 0) == 0) {
+      unroll_budget = std::stoul(arg.substr(strlen("--unroll-budget=")));
+    } else if (arg.rfind("--specialise-budget=", 0) == 0) {
+      specialise_budget =
+          std::stoul(arg.substr(strlen("--specialise-budget=")));
+    } else if (arg.rfind("--inline-size=", 0) == 0) {
+      inline_size = std::stoul(arg.substr(strlen("--inline-size=")));
+    } else if (arg == "--interp") {
+      interpret = true;
+    } else if (arg == "--vm") {
+      run_vm = true;
+    } else if (arg == "--emit-bytecode") {
+      emit_bytecode = true;
+    } else if (arg == "--run-bytecode") {
+      run_bytecode = true;
+    } else if (arg == "--dump-bytecode") {
+      dump_bytecode = true;
+    } else if (arg == "--tiered") {
+      tiered = true;
+    } else if (arg == "--baseline") {
+      run_baseline = true;
+    } else if (arg.rfind("--tier-threshold=", 0) == 0) {
+      tier_threshold = std::stoul(arg.substr(strlen("--tier-threshold=")));
+    } else if (arg == "--profile-generate") {
+      profile_generate = true;
+      profile_filename = "a.ccprof";
+    } else if (arg.rfind("--profile-generate=", 0) == 0) {
+      profile_generate = true;
+      profile_filename = arg.substr(strlen("--profile-generate="));
+    } else if (arg.rfind("--profile-use=", 0) == 0) {
+      profile_generate = false;
+      profile_filename = arg.substr(strlen("--profile-use="));
+    } else if (arg == "--whole-program") {
+      whole_program = true;
     } else if (arg == "--semantics") {
       skipSemantics = false;
     } else if (!hasProgC) { // Check for <prog.c>
       hasProgC = true;
       prog_filename = arg;
+      sources.push_back(arg);
+    } else if (arg.rfind("--", 0) != 0) {
+      sources.push_back(arg);
     } else {
       unknownArgument = true;
     }
@@ -59,16 +931,185 @@ int main(int argc, char **argv) {
     return 1;
   }
 
+  if (sources.size() > 1 && !whole_program) {
+    unknownArgument = true;
+  }
+
   if (unknownArgument) {
     std::cout << "Error: Unknown Argument Specified" << std::endl;
     usage();
     exit(1);
   }
+
+  if (whole_program) {
+    if (stream || interpret || run_vm || tiered || run_baseline ||
+        emit_bytecode || run_bytecode || profile_generate) {
+      std::cout << "Error: --whole-program cannot be combined with --stream, "
+                   "--profile-generate, --interp or the bytecode modes"
+                << std::endl;
+      exit(1);
+    }
+    object_output = !bitcode_output;
+  }
+
+  if (bench_ast && (whole_program || stream)) {
+    std::cout << "Error: --bench-ast walks the AST of one source, it cannot be "
+                 "combined with --whole-program or --stream"
+              << std::endl;
+    exit(1);
+  }
+
+  if (fast_compile) {
+    if (whole_program || bitcode_output || stream || interpret || run_vm ||
+        run_baseline || emit_bytecode || run_bytecode) {
+      std::cout << "Error: --fast-compile only writes the object of one "
+                   "source, it cannot be combined with --whole-program, "
+                   "--emit-bc, --stream, --interp or the bytecode modes"
+                << std::endl;
+      exit(1);
+    }
+    optimise = false;
+    object_output = true;
+    backend_level = llvm::CodeGenOpt::None;
+    time_report = true;
+  }
+
+  if (object_output && bitcode_output) {
+    std::cout << "Error: -c and --emit-bc both choose the output, give one"
+              << std::endl;
+    exit(1);
+  }
+  if (object_output && !has_out_filename) {
+    out_filename = "a.o";
+  }
+  if (bitcode_output && !has_out_filename) {
+    out_filename = "a.bc";
+  }
+  if (emit_bytecode && !has_out_filename) {
+    out_filename = "a.ccbc";
+  }
+
+  if (time_passes) {
+    llvm::TimePassesIsEnabled = true;
+  }
+  if (time_trace) {
+    if (trace_filename.empty()) {
+      trace_filename =
+          out_filename.substr(0, out_filename.rfind('.')) + ".json";
+    }
+    llvm::timeTraceProfilerInitialize(time_trace_granularity, "cc");
+  }
+  if (compile_stats.enabled) {
+    if (stats_filename.empty()) {
+      stats_filename =
+          out_filename.substr(0, out_filename.rfind('.')) + ".stats.json";
+    }
+    stats_sources = sources;
+  }
+
+  if (tiered && run_bytecode) {
+    std::cout << "Error: --tiered compiles from the source, it cannot be "
+                 "combined with --run-bytecode"
+              << std::endl;
+    exit(1);
+  }
+  if (run_baseline && (tiered || interpret || emit_bytecode)) {
+    std::cout << "Error: --baseline runs the program itself, it cannot be "
+                 "combined with --tiered, --interp or --emit-bytecode"
+              << std::endl;
+    exit(1);
+  }
+#if !defined(__x86_64__)
+  if (run_baseline) {
+    std::cout << "Error: --baseline only generates x86-64 code" << std::endl;
+    exit(1);
+  }
+#endif
+  run_vm = run_vm || tiered || run_baseline;
+
+  if ((interpret || run_vm || emit_bytecode || run_bytecode) && stream) {
+    std::cout << "Error: --interp and the bytecode modes need the whole "
+                 "translation unit, they cannot be combined with --stream"
+              << std::endl;
+    exit(1);
+  }
+
+  if (!profile_filename.empty() &&
+      (interpret || run_vm || emit_bytecode || run_bytecode)) {
+    std::cout << "Error: profiles are only generated and used for LLVM "
+                 "output, not with --interp or the bytecode modes"
+              << std::endl;
+    exit(1);
+  }
+  if (profile_generate) {
+    profiler.generate(profile_filename);
+  } else if (!profile_filename.empty()) {
+    try {
+      profiler.use(profile_filename);
+    } catch (const std::exception &e) {
+      std::cout << "Error: " << e.what() << std::endl;
+      exit(1);
+    }
+  }
+
+  // When the program runs in-process stdout belongs to it, so the
+  // compiler's own output goes to stderr from here on
+  int program_stdout = 1;
+  if (interpret || run_vm || run_bytecode) {
+    fflush(stdout);
+    program_stdout = dup(1);
+    dup2(2, 1);
+  }
+
+  if (run_bytecode) {
+    unique_ptr<BcImage> image;
+    try {
+      image = BcImage::map(prog_filename);
+    } catch (const std::exception &e) {
+      std::cerr << "vm: " << e.what() << std::endl;
+      exit(1);
+    }
+    run_image(*image, program_stdout, start);
+  }
+
+  cout << "argc = " << argc << endl;
+
+  if (whole_program) {
+    compile_whole_program(sources, out_filename);
+    exit(0);
+  }
+
+  if (is_bitcode(prog_filename)) {
+    if (stream || interpret || run_vm || emit_bytecode ||
+        !profile_filename.empty()) {
+      std::cout << "Error: a bitcode source is only linked and lowered, it "
+                   "cannot be combined with --stream, --interp, profiles or "
+                   "the bytecode modes"
+                << std::endl;
+      exit(1);
+    }
+    convert_bitcode(prog_filename, out_filename);
+    exit(0);
+  }
+
   cout << "prog_filename = " << prog_filename << endl;
   yyin = fopen(prog_filename.c_str(), "r");
   assert(yyin);
+
+  if (stream) {
+    printf("Streaming declarations\n");
+    root = new TranslationUnitNode();
+    codeGenerator.resetAllContext();
+    streamed_source = prog_filename;
+    stream_declaration = compile_streamed_declaration;
+    node_pool = &declaration_pool;
+  }
+
+  phase_times.begin("parse");
   int ret = yyparse();
 
+  node_pool = nullptr;
+
   printf("retv = %d\n", ret);
 
   if (ret != 0) {
@@ -77,11 +1118,22 @@ int main(int argc, char **argv) {
   }
 
   printf("Parsing successful\n");
+  phase_times.end();
+
+  if (stream) {
+    if (optimise) {
+      report_optimisations();
+    }
+    write_output(out_filename);
+    report_phases();
+    exit(0);
+  }
 
-  string ast_dump = root->dump_ast();
   if (dump_ast) {
-    printf("AST:\n\n");
-    std::cout << ast_dump << std::endl;
+    dump_tree(root, "AST", prog_filename, false);
+  }
+  if (bench_ast) {
+    bench_ast_walks(root);
   }
 
   if (skipSemantics) {
@@ -89,34 +1141,63 @@ int main(int argc, char **argv) {
 
   } else {
     printf("Checking semantics\n");
+    phase_times.begin("semantics");
     bool scoping = root->check_semantics();
     if (!scoping) {
       printf("Scoping Failed\n");
       exit(1);
     }
+    phase_times.end();
   }
 
+  // Bitcode is meant to be linked with other translation units
+  if (bitcode_output) {
+    call_sites.external(exported_functions(root));
+  }
   if (optimise) {
-    ASTNode *old = new NullPtrNode();
-    string old_dump = old->dump_ast();
-    int i = 0;
-    while (old_dump != root->dump_ast()) {
-      old_dump = root->dump_ast();
-      root = root->optimise();
-      if (i > 100) {
-        break;
-      }
-      i++;
-    }
+    phase_times.begin("optimise");
+    root = optimise_to_fixed_point(root, optimise_translation_unit);
+    phase_times.end();
+    report_optimisations();
   }
 
   if (dump_ast) {
-    printf("AST->After optimise:\n\n");
-    std::cout << root->dump_ast() << std::endl;
+    dump_tree(root, "AST->After optimise", prog_filename, true);
+  }
+
+  if (interpret) {
+    run_main("interp", program_stdout, start, []() {
+      return (int)interpreter.run([]() { return root->interpret(); }).i;
+    });
+  }
+
+  if (run_vm || emit_bytecode) {
+    unique_ptr<BcImage> image;
+    try {
+      phase_times.begin("bytecode");
+      root->compileBytecode();
+      image = BcImage::fromBytes(bytecodeCompiler.image());
+      phase_times.end();
+    } catch (const std::exception &e) {
+      std::cerr << "bytecode: " << e.what() << std::endl;
+      exit(1);
+    }
+    if (emit_bytecode) {
+      if (dump_bytecode) {
+        std::cout << bc_disassemble(*image);
+      }
+      image->write(out_filename);
+      report_phases();
+      exit(0);
+    }
+    run_image(*image, program_stdout, start);
   }
 
+  phase_times.begin("codegen");
   root->codegen();
-  root->dump_llvm(out_filename);
+  phase_times.end();
+  write_output(out_filename);
+  report_phases();
   exit(0);
 }
 
@@ -2,6 +2,7 @@
 #define INCLUDE_CC_CODEGEN_H_
 
 #include "AST_enums.hpp"
+#include "flow.h"
 #include "scoper.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LLVMContext.h"
@@ -70,9 +71,14 @@ public:
 
   map<string, llvm::Function *> declared_functions;
 
-  CodeGenerator() {
-    constant_prop = true;
+  // Globals created for string literals by StringNode
+  vector<llvm::GlobalVariable *> string_literals;
+
+  // Calls of findSymbol(), and the scopes they searched in vain (--stats)
+  uint64_t symbol_lookups = 0;
+  uint64_t symbol_misses = 0;
 
+  CodeGenerator() {
     unique_ptr<llvm::LLVMContext> global_context =
         make_unique<llvm::LLVMContext>();
     builder = make_unique<llvm::IRBuilder<>>(*global_context);
@@ -81,8 +87,32 @@ public:
     symbol_tables.push_back(make_unique<m_Context>(m_Context(true)));
   }
 
+  // The module is torn down only at process exit, where LLVM's teardown of
+  // half-built functions can double free; let the OS reclaim it instead.
+  ~CodeGenerator() {
+    global_module.release();
+    builder.release();
+    for (auto &context : contexts)
+      context.release();
+  }
+
   llvm::IRBuilder<> &getBuilder() { return *builder; }
 
+  // Hands over the module built so far and starts `name` in the same
+  // context (--whole-program). The string literals of the module become
+  // private, so that those of several modules can be linked.
+  unique_ptr<llvm::Module> takeModule(const string &name) {
+    for (auto literal : string_literals) {
+      literal->setLinkage(llvm::GlobalValue::PrivateLinkage);
+    }
+    string_literals.clear();
+    declared_functions.clear();
+    resetAllContext();
+    unique_ptr<llvm::Module> module = std::move(global_module);
+    global_module = make_unique<llvm::Module>(name, getContext());
+    return module;
+  }
+
   bool isFunctionDeclaredButNotDefined(string name) {
     return declared_functions.find(name) != declared_functions.end();
   }
@@ -121,6 +151,7 @@ public:
   m_Context &getsymbolTable() { return *symbol_tables.back(); }
 
   llvm::Value *findSymbol(string name) {
+    symbol_lookups++;
 
     for (auto it = symbol_tables.rbegin(); it != symbol_tables.rend(); ++it) {
       auto &x = *it; // Dereference the reverse iterator to get the element
@@ -129,12 +160,54 @@ public:
       if (x->variables.find(name) != x->variables.end()) {
         return x->variables[name]; // Return the value if found
       }
+      symbol_misses++;
     }
 
     throw std::runtime_error("Variable " + name + " not found");
   }
+};
 
-  bool constant_prop;
+// Constant-propagation scopes used by the AST optimiser. Each thread owns
+// one, so function bodies can be optimised concurrently. Locals are
+// propagated by `flow` inside function bodies; the scope tables keep
+// global initialisers and memory (array elements, dereferences).
+class OptimisationContext {
+public:
+  vector<unique_ptr<m_Context>> symbol_tables;
+
+  FlowAnalysis flow;
+
+  bool constant_prop = true;
+
+  // Calls of get_mval(), and those that found no constant (--stats)
+  uint64_t lookups = 0;
+  uint64_t misses = 0;
+
+  OptimisationContext() {
+    symbol_tables.push_back(make_unique<m_Context>(m_Context(true)));
+  }
+
+  // Fresh scopes for a function body, seeded with the global constants
+  explicit OptimisationContext(const map<string, m_Value> &globals)
+      : OptimisationContext() {
+    symbol_tables.back()->values = globals;
+  }
+
+  const map<string, m_Value> &globalValues() const {
+    return symbol_tables.front()->values;
+  }
+
+  void pushContext() {
+    m_Context &current_symbol_table = *symbol_tables.back();
+
+    current_symbol_table.clean_for_optimisation = false;
+
+    unique_ptr<m_Context> new_symbol_table =
+        make_unique<m_Context>(current_symbol_table);
+    symbol_tables.push_back(std::move(new_symbol_table));
+  }
+
+  void popContext() { symbol_tables.pop_back(); }
 
   m_Value get_mval(string key) {
 
@@ -142,6 +215,7 @@ public:
       return m_Value();
     }
 
+    lookups++;
     for (auto it = symbol_tables.rbegin(); it != symbol_tables.rend(); ++it) {
       auto &x = *it; // Dereference the reverse iterator to get the element
       // Check if the variable exists in the current symbol_table
@@ -150,10 +224,12 @@ public:
           return x->values[key];
 
         } else {
+          misses++;
           return m_Value();
         }
       }
     }
+    misses++;
     return m_Value();
   }
 
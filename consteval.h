@@ -0,0 +1,235 @@
+#ifndef INCLUDE_CC_CONSTEVAL_H_
+#define INCLUDE_CC_CONSTEVAL_H_
+
+#include "flow.h"
+#include "scoper.h"
+#include <climits>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+using namespace std;
+
+class ASTNode;
+
+// Compile-time evaluation of calls (FunctionCallNode::get_value_if_possible).
+//
+// A function is pure for the optimiser when it takes and returns int,
+// float or double and its body, on the path a call takes, only uses its
+// parameters and locals of those types, arithmetic, if/while/do/for and
+// calls to other pure functions. Such a call with constant arguments is
+// run by ASTNode::evaluate() and replaced by its result. Anything else
+// (globals, memory, pointers, unknown functions) raises ConstEvalError and
+// the call is left alone, as is one that runs out of fuel.
+
+struct ConstEvalError : public std::runtime_error {
+  using std::runtime_error::runtime_error;
+};
+
+// State of one top-level evaluation: the locals of the calls in progress
+// and the fuel left
+class ConstEvaluation {
+public:
+  enum Flow { NORMAL, BREAK, CONTINUE, RETURN };
+
+  static constexpr unsigned long FUEL = 1000000;
+  static constexpr size_t MAX_DEPTH = 256;
+
+  Flow flow = NORMAL;
+  m_Value return_value;
+
+  // Kind of the variables being declared by the current declaration
+  FlowAnalysis::Kind declaring = FlowAnalysis::UNTRACKED;
+
+  // Charged for every loop iteration and call
+  void step() {
+    if (fuel == 0) {
+      throw ConstEvalError("Out of fuel");
+    }
+    fuel--;
+  }
+
+  // An operation without a value (e.g. a division by zero) is not folded
+  m_Value check(const m_Value &value) const {
+    if (value.type != ActualValueType::INTEGER &&
+        value.type != ActualValueType::FLOATING) {
+      throw ConstEvalError("Not a constant");
+    }
+    return value;
+  }
+
+  bool truth(const m_Value &value) const {
+    check(value);
+    return value.type == ActualValueType::INTEGER ? value.i != 0
+                                                  : value.f != 0;
+  }
+
+  // The one integer division that traps besides a zero divisor
+  m_Value divisor(const m_Value &lhs, const m_Value &rhs) const {
+    if (lhs.type == ActualValueType::INTEGER &&
+        rhs.type == ActualValueType::INTEGER && lhs.i == INT_MIN &&
+        rhs.i == -1) {
+      throw ConstEvalError("Division overflows");
+    }
+    return rhs;
+  }
+
+  // A call sees only its own locals
+  size_t enterFrame() {
+    step();
+    if (++depth > MAX_DEPTH) {
+      throw ConstEvalError("Recursion too deep");
+    }
+    size_t saved = frame;
+    frame = variables.size();
+    return saved;
+  }
+
+  void leaveFrame(size_t saved) {
+    variables.resize(frame);
+    frame = saved;
+    depth--;
+    flow = NORMAL;
+  }
+
+  // Shift counts outside the width of an int are undefined
+  m_Value shift(const m_Value &count) const {
+    if (count.type != ActualValueType::INTEGER || count.i < 0 ||
+        count.i > 31) {
+      throw ConstEvalError("Shift out of range");
+    }
+    return count;
+  }
+
+  // After each run of a loop body; returns whether the loop is left
+  bool endIteration() {
+    if (flow == CONTINUE) {
+      flow = NORMAL;
+    }
+    if (flow == BREAK) {
+      flow = NORMAL;
+      return true;
+    }
+    return flow == RETURN;
+  }
+
+  size_t enterScope() const { return variables.size(); }
+  void leaveScope(size_t mark) { variables.resize(mark); }
+
+  // `value` is NO_VALUE for a variable declared without an initialiser
+  void declare(const string &name, FlowAnalysis::Kind kind,
+               const m_Value &value) {
+    if (kind == FlowAnalysis::UNTRACKED) {
+      throw ConstEvalError("Unsupported type for " + name);
+    }
+    variables.push_back({name, kind, m_Value()});
+    if (value.type != ActualValueType::NO_VALUE) {
+      variables.back().value = convert(kind, check(value));
+    }
+  }
+
+  m_Value load(const string &name) { return check(find(name).value); }
+
+  // Returns the value stored, converted to the variable's type
+  m_Value store(const string &name, const m_Value &value) {
+    Variable &variable = find(name);
+    variable.value = convert(variable.kind, check(value));
+    return variable.value;
+  }
+
+  static m_Value convert(FlowAnalysis::Kind kind, const m_Value &value) {
+    if (kind == FlowAnalysis::INT && value.type == ActualValueType::FLOATING) {
+      return m_Value((int)value.f);
+    }
+    if (kind == FlowAnalysis::DOUBLE &&
+        value.type == ActualValueType::INTEGER) {
+      return m_Value((double)value.i);
+    }
+    return value;
+  }
+
+private:
+  struct Variable {
+    string name;
+    FlowAnalysis::Kind kind;
+    m_Value value;
+  };
+
+  vector<Variable> variables;
+  size_t frame = 0;
+  size_t depth = 0;
+  unsigned long fuel = FUEL;
+
+  Variable &find(const string &name) {
+    for (size_t i = variables.size(); i > frame; i--) {
+      if (variables[i - 1].name == name) {
+        return variables[i - 1];
+      }
+    }
+    throw ConstEvalError(name + " is not a local");
+  }
+};
+
+// The function definitions of the current optimiser round and the results
+// of the calls evaluated so far. Shared by the optimiser threads.
+class PureFunctions {
+public:
+  void define(map<string, const ASTNode *> functions) {
+    lock_guard<mutex> guard(lock);
+    definitions = std::move(functions);
+  }
+
+  const ASTNode *definition(const string &name) {
+    lock_guard<mutex> guard(lock);
+    auto it = definitions.find(name);
+    return it == definitions.end() ? nullptr : it->second;
+  }
+
+  // A failure (NO_VALUE) is only taken as the answer with `failures` set:
+  // inside an evaluation it may be down to the fuel the caller had left
+  bool remembered(const string &key, m_Value &result, bool failures) {
+    lock_guard<mutex> guard(lock);
+    auto it = results.find(key);
+    if (it == results.end() ||
+        (!failures && it->second.type == ActualValueType::NO_VALUE)) {
+      return false;
+    }
+    result = it->second;
+    return true;
+  }
+
+  void remember(const string &key, const m_Value &result) {
+    lock_guard<mutex> guard(lock);
+    results[key] = result;
+  }
+
+  // Forgets the results, before the next translation unit is optimised
+  void reset() {
+    lock_guard<mutex> guard(lock);
+    definitions.clear();
+    results.clear();
+  }
+
+  static string callKey(const string &name, const vector<m_Value> &args) {
+    string key = name;
+    char buffer[32];
+    for (const m_Value &arg : args) {
+      if (arg.type == ActualValueType::INTEGER) {
+        snprintf(buffer, sizeof(buffer), ",%d", arg.i);
+      } else {
+        snprintf(buffer, sizeof(buffer), ",%a", arg.f);
+      }
+      key += buffer;
+    }
+    return key;
+  }
+
+private:
+  mutex lock;
+  map<string, const ASTNode *> definitions;
+  map<string, m_Value> results;
+};
+
+#endif // INCLUDE_CC_CONSTEVAL_H_
@@ -0,0 +1,168 @@
+#ifndef INCLUDE_CC_FLATAST_H_
+#define INCLUDE_CC_FLATAST_H_
+
+#include "astdump.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+// A compact, read-only copy of an AST. Nodes are numbered in pre-order and
+// held in parallel arrays indexed by 32-bit ids, so a walk is a linear scan
+// instead of a chase through heap objects and virtual calls. The subtree of
+// node n is the id range [n, end(n)): its first child is n + 1 and each
+// child's next sibling starts at that child's end. Values (names, constants)
+// and properties (operators, variadic) are strings interned once per tree.
+//
+// It is built from the events of ASTNode::dump() (see FlatAstBuilder), so
+// it records exactly what --dump-ast shows.
+class FlatAst {
+public:
+  typedef uint32_t Id;
+  static constexpr Id NONE = UINT32_MAX;
+
+  // The children of a node, as the range of their ids
+  class Children {
+  public:
+    class iterator {
+    public:
+      iterator(const FlatAst &ast, Id id) : ast(ast), id(id) {}
+      Id operator*() const { return id; }
+      iterator &operator++() {
+        id = ast.end(id);
+        return *this;
+      }
+      bool operator!=(const iterator &other) const { return id != other.id; }
+
+    private:
+      const FlatAst &ast;
+      Id id;
+    };
+
+    Children(const FlatAst &ast, Id node) : ast(ast), node(node) {}
+    iterator begin() const { return iterator(ast, node + 1); }
+    iterator end() const { return iterator(ast, ast.end(node)); }
+
+  private:
+    const FlatAst &ast;
+    Id node;
+  };
+
+  size_t size() const { return types.size(); }
+  NodeType type(Id n) const { return (NodeType)types[n]; }
+  Id end(Id n) const { return ends[n]; }
+  bool isList(Id n) const { return flags[n] & LIST; }
+  bool isLeaf(Id n) const { return flags[n] & LEAF; }
+  Children children(Id n) const { return Children(*this, n); }
+
+  // The value of a leaf ("" when it has none)
+  const string &value(Id n) const {
+    static const string none;
+    return values[n] == NONE ? none : strings[values[n]];
+  }
+
+  // Replays the tree as the events it was built from
+  void write(AstWriter &out) const {
+    vector<Id> open;
+    size_t property = 0;
+    for (Id n = 0; n < size(); n++) {
+      for (; !open.empty() && open.back() == n; open.pop_back()) {
+        out.close();
+      }
+      if (isLeaf(n)) {
+        out.leaf(type(n), value(n));
+        continue;
+      }
+      out.open(type(n), isList(n));
+      for (; property < properties.size() && properties[property].node == n;
+           property++) {
+        out.property(strings[properties[property].name],
+                     strings[properties[property].value]);
+      }
+      open.push_back(end(n));
+    }
+    for (; !open.empty(); open.pop_back()) {
+      out.close();
+    }
+  }
+
+  bool operator==(const FlatAst &other) const {
+    return types == other.types && ends == other.ends &&
+           flags == other.flags && values == other.values &&
+           properties == other.properties && strings == other.strings;
+  }
+  bool operator!=(const FlatAst &other) const { return !(*this == other); }
+
+private:
+  enum : uint8_t { LIST = 1, LEAF = 2 };
+
+  struct Property {
+    Id node, name, value;
+    bool operator==(const Property &other) const {
+      return node == other.node && name == other.name &&
+             value == other.value;
+    }
+  };
+
+  vector<uint8_t> types;
+  vector<Id> ends;
+  vector<uint8_t> flags;
+  vector<Id> values;
+  vector<Property> properties;
+  vector<string> strings;
+
+  friend class FlatAstBuilder;
+};
+
+// Lays out the nodes a tree dumps to it as a FlatAst
+class FlatAstBuilder : public AstWriter {
+public:
+  void open(NodeType type, bool is_list) {
+    open_nodes.push_back(add(type, is_list ? FlatAst::LIST : 0, FlatAst::NONE));
+  }
+
+  void close() {
+    ast.ends[open_nodes.back()] = ast.size();
+    open_nodes.pop_back();
+  }
+
+  void leaf(NodeType type, const string &value) {
+    FlatAst::Id n =
+        add(type, FlatAst::LEAF, value.empty() ? FlatAst::NONE : intern(value));
+    ast.ends[n] = n + 1;
+  }
+
+  void property(const string &name, const string &value) {
+    ast.properties.push_back({open_nodes.back(), intern(name), intern(value)});
+  }
+
+  FlatAst take() { return std::move(ast); }
+
+private:
+  FlatAst::Id add(NodeType type, uint8_t flags, FlatAst::Id value) {
+    FlatAst::Id n = ast.size();
+    ast.types.push_back((uint8_t)type);
+    ast.ends.push_back(n + 1);
+    ast.flags.push_back(flags);
+    ast.values.push_back(value);
+    return n;
+  }
+
+  FlatAst::Id intern(const string &text) {
+    auto found = interned.find(text);
+    if (found != interned.end()) {
+      return found->second;
+    }
+    FlatAst::Id id = ast.strings.size();
+    ast.strings.push_back(text);
+    interned.emplace(text, id);
+    return id;
+  }
+
+  FlatAst ast;
+  vector<FlatAst::Id> open_nodes;
+  unordered_map<string, FlatAst::Id> interned;
+};
+
+#endif // INCLUDE_CC_FLATAST_H_
@@ -0,0 +1,777 @@
+#ifndef INCLUDE_CC_FLOW_H_
+#define INCLUDE_CC_FLOW_H_
+
+#include "scoper.h"
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+class ASTNode;
+
+// Abstract value of a tracked variable: not assigned on any path seen yet,
+// one constant on every path, or anything
+struct FlowValue {
+  enum Kind { UNDEFINED, CONSTANT, VARYING };
+
+  Kind kind = UNDEFINED;
+  m_Value value;
+
+  static FlowValue of(const m_Value &value) {
+    FlowValue ret;
+    if (value.type == ActualValueType::INTEGER ||
+        value.type == ActualValueType::FLOATING) {
+      ret.kind = CONSTANT;
+      ret.value = value;
+    } else {
+      ret.kind = VARYING;
+    }
+    return ret;
+  }
+
+  // Returns whether this value changed
+  bool meet(const FlowValue &other) {
+    if (other.kind == UNDEFINED || kind == VARYING) {
+      return false;
+    }
+    if (kind == UNDEFINED) {
+      *this = other;
+      return true;
+    }
+    if (other.kind == CONSTANT && same(value, other.value)) {
+      return false;
+    }
+    kind = VARYING;
+    value = m_Value();
+    return true;
+  }
+
+  static bool same(const m_Value &a, const m_Value &b) {
+    if (a.type != b.type) {
+      return false;
+    }
+    return a.type == ActualValueType::INTEGER ? a.i == b.i : a.f == b.f;
+  }
+};
+
+// What the optimiser removed as dead code, over every round and thread
+struct DeadCodeStats {
+  atomic<unsigned> unreachable{0};
+  atomic<unsigned> unused{0};
+  atomic<unsigned> stores{0};
+  atomic<unsigned> locals{0};
+};
+
+// Loops the optimiser unrolled fully, and the copies of their bodies
+struct UnrollStats {
+  atomic<unsigned> loops{0};
+  atomic<unsigned> iterations{0};
+};
+
+// Flow-sensitive constant propagation for the AST optimiser.
+//
+// A function body is lowered by ASTNode::buildFlow() into a control-flow
+// graph whose blocks hold the expressions the body evaluates, in order, and
+// end in a jump, a branch, a switch dispatch or nothing (return). Sparse
+// conditional constant propagation then runs over it: a block is only
+// visited once an edge into it can be taken, so a branch whose condition is
+// constant only feeds the side it goes to, and the variables of a loop stay
+// constant when every iteration keeps them so.
+//
+// The expressions are evaluated by the AST itself (ASTNode::flow()), which
+// calls back into read() and write(). Once the graph is solved, every
+// reachable block is evaluated once more to record the constant each
+// identifier reads; optimise() folds those reads, and the branches and
+// statements they make unreachable.
+//
+// The same pass records where each variable is read and stored, and a
+// backward liveness pass over the graph finds the stores whose value is
+// never read. Blocks that are never reached are evaluated too, only to see
+// which variables they mention.
+//
+// Only int and floating locals whose address is never taken are tracked;
+// globals, parameters and memory are left to the scope tables.
+class FlowAnalysis {
+public:
+  enum Kind { UNTRACKED, INT, DOUBLE };
+
+  // Kind of the variables being declared by the current declaration
+  Kind declaring = UNTRACKED;
+
+  // Side effects evaluated so far (assignments, increments, calls)
+  size_t effects = 0;
+
+  // Conditional arms being evaluated; a store in one may not happen
+  int conditional = 0;
+
+  bool active() const { return is_active; }
+
+  // Builds the graph with `build` and solves it, evaluating expressions
+  // with `evaluate`. Rebuilt whenever a tracked variable turns out to have
+  // its address taken.
+  void analyse(const std::function<void()> &build,
+               const std::function<m_Value(const ASTNode *)> &evaluate) {
+    escaped.clear();
+    is_active = true;
+    do {
+      reset();
+      build();
+      retry = false;
+      solve(evaluate);
+    } while (retry);
+
+    // Record what every reachable expression reads, and what the others
+    // mention
+    facts.clear();
+    events.assign(blocks.size(), {});
+    reads.assign(variables.size(), 0);
+    writes.assign(variables.size(), 0);
+    stores.clear();
+    statements.clear();
+    for (size_t b = 0; b < blocks.size(); b++) {
+      recording = reached[b];
+      scanning = !reached[b];
+      run(b, evaluate);
+    }
+    recording = scanning = false;
+    liveness();
+
+    // A statement goes when it has no effects, or only dead stores
+    pure_items.clear();
+    for (const FlowStatement &statement : statements) {
+      size_t stored = 0;
+      bool dead = true;
+      for (size_t i = statement.first; i < statement.last; i++) {
+        const FlowEvent &event = events[statement.block][i];
+        if (event.store) {
+          stored++;
+          dead = dead && dead_stores.count(event.store);
+        }
+      }
+      if (statement.effects == 0) {
+        pure_items.insert(statement.node);
+      } else if (statement.effects == stored && dead) {
+        dead_stores.insert(statement.node);
+      }
+    }
+  }
+
+  void clear() {
+    reset();
+    facts.clear();
+    escaped.clear();
+    events.clear();
+    stores.clear();
+    statements.clear();
+    pure_items.clear();
+    dead_stores.clear();
+    is_active = false;
+  }
+
+  // Building
+
+  int newBlock() {
+    blocks.emplace_back();
+    return blocks.size() - 1;
+  }
+
+  void setBlock(int block) { current = block; }
+
+  // Appends an expression evaluated by the current block
+  void add(const ASTNode *node) {
+    blocks[current].items.push_back({node, scope});
+  }
+
+  void jump(int target) {
+    blocks[current].successors.push_back(target);
+    current = newBlock();
+  }
+
+  void branch(const ASTNode *condition, int if_true, int if_false) {
+    FlowBlock &block = blocks[current];
+    block.exit = FlowBlock::BRANCH;
+    block.condition = {condition, scope};
+    block.successors = {if_true, if_false};
+    current = newBlock();
+  }
+
+  // Ends the current block with a switch on `value`; the cases are added
+  // with addCase() and the dispatch is completed by endSwitch()
+  int beginSwitch(const ASTNode *value) {
+    FlowBlock &block = blocks[current];
+    block.exit = FlowBlock::SWITCH;
+    block.condition = {value, scope};
+    int dispatch = current;
+    current = newBlock();
+    return dispatch;
+  }
+
+  void addCase(int dispatch, const m_Value &value, int target) {
+    blocks[dispatch].cases.push_back(value);
+    blocks[dispatch].successors.push_back(target);
+  }
+
+  // The last successor of a switch is taken when no case matches
+  void endSwitch(int dispatch, int otherwise) {
+    blocks[dispatch].successors.push_back(otherwise);
+  }
+
+  void stop() { current = newBlock(); }
+
+  int labelBlock(const string &name) {
+    auto it = labels.find(name);
+    if (it != labels.end()) {
+      return it->second;
+    }
+    return labels[name] = newBlock();
+  }
+
+  void pushLoop(int break_target, int continue_target) {
+    targets.push_back({break_target, continue_target});
+  }
+
+  // A switch takes breaks but passes continues on to the enclosing loop
+  void pushSwitch(int break_target) {
+    targets.push_back(
+        {break_target, targets.empty() ? -1 : targets.back().second});
+  }
+
+  void popTarget() { targets.pop_back(); }
+
+  int breakTarget() const { return targets.empty() ? -1 : targets.back().first; }
+  int continueTarget() const {
+    return targets.empty() ? -1 : targets.back().second;
+  }
+
+  size_t currentScope() const { return scope; }
+  void restoreScope(size_t saved) { scope = saved; }
+
+  void declare(const string &name, Kind kind) {
+    int variable = variables.size();
+    variables.push_back(kind);
+    if (kind == UNTRACKED || escaped.count(variable)) {
+      variable = -1;
+    }
+    bindings.push_back({name, scope, variable});
+    scope = bindings.size();
+  }
+
+  // Declares a parameter that holds `value` on entry, the constant every
+  // call passes it
+  void parameter(const string &name, Kind kind, const m_Value &value) {
+    declare(name, kind);
+    int variable = bindings.back().variable;
+    if (variable >= 0) {
+      entry.push_back({variable, FlowValue::of(convert(kind, value))});
+    }
+  }
+
+  // Statement spans, so that optimise() can tell dead statements
+  pair<int, int> mark() const { return {current, (int)blocks.size()}; }
+
+  void span(const ASTNode *statement, pair<int, int> mark) {
+    spans[statement] = {mark.first, mark.second, (int)blocks.size()};
+  }
+
+  // The body of for loop `loop` is built from block `first` on and falls
+  // through to `step`; `variable` is the one its initialisation sets
+  void loop(const ASTNode *loop, const string &variable, int first, int step) {
+    loops[loop] = {variable.empty() ? -1 : lookup(variable, scope), first,
+                   current, (int)blocks.size(), step};
+  }
+
+  // Evaluation
+
+  // The constant `name` holds at this point, recorded as what `node` reads
+  m_Value read(const ASTNode *node, const string &name) {
+    int variable = lookup(name);
+    if (variable < 0) {
+      return m_Value();
+    }
+    kinds[node] = variables[variable];
+    use(variable);
+    if (scanning) {
+      return m_Value();
+    }
+    FlowValue value = env[variable];
+    if (value.kind == FlowValue::UNDEFINED) {
+      value = FlowValue::of(m_Value());
+    }
+    if (recording && facts.count(node)) {
+      facts[node].meet(value);
+    } else {
+      facts[node] = value;
+    }
+    return value.kind == FlowValue::CONSTANT ? value.value : m_Value();
+  }
+
+  // Same as read() for a variable that is about to be updated in place
+  m_Value current_value(const string &name) {
+    int variable = lookup(name);
+    if (variable < 0) {
+      return m_Value();
+    }
+    use(variable);
+    if (env[variable].kind != FlowValue::CONSTANT) {
+      return m_Value();
+    }
+    return env[variable].value;
+  }
+
+  // Returns the value stored, converted to the variable's type. `store` is
+  // the node optimise() may drop when the value is never read, or null when
+  // dropping it would lose other effects.
+  m_Value write(const string &name, m_Value value,
+                const ASTNode *store = nullptr) {
+    int variable = lookup(name);
+    if (variable < 0) {
+      return m_Value();
+    }
+    if (recording || scanning) {
+      writes[variable]++;
+    }
+    if (recording) {
+      events[running].push_back({variable, store, conditional == 0, true});
+      if (store) {
+        stores[store] = variable;
+      }
+    }
+    value = convert(variables[variable], value);
+    env[variable] = FlowValue::of(value);
+    return env[variable].kind == FlowValue::CONSTANT ? value : m_Value();
+  }
+
+  void escape(const string &name) {
+    int variable = lookup(name);
+    if (variable >= 0 && scanning) {
+      use(variable);
+    } else if (variable >= 0) {
+      escaped.insert(variable);
+      env[variable] = FlowValue::of(m_Value());
+      retry = true;
+    }
+  }
+
+  // An evaluation the analysis knows nothing about may change anything
+  void clobber() {
+    for (FlowValue &value : env) {
+      value = FlowValue::of(m_Value());
+    }
+    effects++;
+    if (recording) {
+      events[running].push_back({-1, nullptr, false, false});
+    }
+  }
+
+  // Records a value computed by `node` itself, e.g. the value an
+  // assignment stores
+  void note(const ASTNode *node, const m_Value &value) {
+    if (scanning) {
+      return;
+    }
+    FlowValue fact = FlowValue::of(value);
+    if (recording && facts.count(node)) {
+      facts[node].meet(fact);
+    } else {
+      facts[node] = fact;
+    }
+  }
+
+  // Conditional evaluation: snapshot() before each arm, join() after the
+  // second one merges it with the first
+  vector<FlowValue> snapshot() const { return env; }
+  void restore(const vector<FlowValue> &saved) { env = saved; }
+  void join(const vector<FlowValue> &other) {
+    for (size_t i = 0; i < env.size(); i++) {
+      env[i].meet(other[i]);
+    }
+  }
+
+  // Results
+
+  // The constant `node` was found to read or compute, if any
+  m_Value fact(const ASTNode *node) const {
+    auto it = facts.find(node);
+    if (it == facts.end() || it->second.kind != FlowValue::CONSTANT) {
+      return m_Value();
+    }
+    return it->second.value;
+  }
+
+  // The kind of the tracked variable `node` reads, if any
+  Kind kind(const ASTNode *node) const {
+    auto it = kinds.find(node);
+    return is_active && it != kinds.end() ? it->second : UNTRACKED;
+  }
+
+  // Whether no execution reaches any part of the statement
+  bool dead(const ASTNode *statement) const {
+    auto it = spans.find(statement);
+    if (!is_active || it == spans.end()) {
+      return false;
+    }
+    if (reached[it->second.start]) {
+      return false;
+    }
+    for (int b = it->second.first; b < it->second.last; b++) {
+      if (reached[b]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Whether the expression statement was evaluated without side effects
+  bool pure(const ASTNode *statement) const {
+    return is_active && pure_items.count(statement);
+  }
+
+  // Whether the value `store` writes is never read; for a statement,
+  // whether all it does is such stores
+  bool dead_store(const ASTNode *store) const {
+    return is_active && dead_stores.count(store);
+  }
+
+  // Whether the body of for loop `loop` can be repeated in its place: it
+  // only leaves by falling through to the step, holds no loop or label and
+  // never writes the variable the initialisation sets, which is tracked.
+  // Gives the kind of that variable and the number of expressions the body
+  // evaluates.
+  bool unrollable(const ASTNode *loop, Kind &kind, size_t &size) const {
+    auto it = loops.find(loop);
+    if (!is_active || it == loops.end() || it->second.variable < 0) {
+      return false;
+    }
+    const FlowLoop &body = it->second;
+    for (auto &label : labels) {
+      if (label.second >= body.first && label.second < body.last) {
+        return false;
+      }
+    }
+    size = 0;
+    for (int b = body.first; b < body.last; b++) {
+      size += blocks[b].items.size() + (blocks[b].exit != FlowBlock::JUMP);
+      for (int next : blocks[b].successors) {
+        bool forward = next > b && next < body.last;
+        if (!forward && !(b == body.tail && next == body.step)) {
+          return false;
+        }
+      }
+      for (const FlowEvent &event : events[b]) {
+        if (event.variable == body.variable && event.write) {
+          return false;
+        }
+      }
+    }
+    kind = variables[body.variable];
+    return true;
+  }
+
+  // Number of expressions and conditions in the graph
+  size_t size() const {
+    size_t size = 0;
+    for (const FlowBlock &block : blocks) {
+      size += block.items.size() + (block.exit != FlowBlock::JUMP);
+    }
+    return size;
+  }
+
+  // Whether expressions are being evaluated for the last time, from the
+  // solved state of a reachable block
+  bool replaying() const { return recording; }
+
+  // Whether `store` declares a variable nothing else reads or writes
+  bool unused_variable(const ASTNode *store) const {
+    auto it = stores.find(store);
+    return is_active && it != stores.end() && reads[it->second] == 0 &&
+           writes[it->second] == 1;
+  }
+
+private:
+  struct FlowItem {
+    const ASTNode *node = nullptr;
+    size_t scope = 0;
+  };
+
+  struct FlowBlock {
+    enum Exit { JUMP, BRANCH, SWITCH };
+
+    vector<FlowItem> items;
+    Exit exit = JUMP;
+    FlowItem condition;
+    vector<m_Value> cases;
+    vector<int> successors;
+  };
+
+  // A name in scope; `parent` is the scope it was declared in, so each
+  // declaration opens a scope of its own
+  struct FlowBinding {
+    string name;
+    size_t parent;
+    int variable;
+  };
+
+  struct FlowSpan {
+    int start;
+    int first;
+    int last;
+  };
+
+  // A read (null store) or store of a variable; variable -1 reads them all
+  struct FlowEvent {
+    int variable;
+    const ASTNode *store;
+    bool kills;
+    bool write;
+  };
+
+  struct FlowLoop {
+    int variable;
+    int first;
+    int tail;
+    int last;
+    int step;
+  };
+
+  // The events of an expression evaluated by block `block`, and the number
+  // of side effects it had
+  struct FlowStatement {
+    const ASTNode *node;
+    int block;
+    size_t first;
+    size_t last;
+    size_t effects;
+  };
+
+  vector<FlowBlock> blocks;
+  int current = 0;
+  map<string, int> labels;
+  vector<pair<int, int>> targets;
+
+  vector<Kind> variables;
+  vector<FlowBinding> bindings;
+  size_t scope = 0;
+  set<int> escaped;
+  bool retry = false;
+
+  vector<pair<int, FlowValue>> entry;
+
+  vector<vector<FlowValue>> in;
+  vector<bool> reached;
+  vector<FlowValue> env;
+  size_t eval_scope = 0;
+
+  bool is_active = false;
+  bool recording = false;
+  bool scanning = false;
+  int running = 0;
+  unordered_map<const ASTNode *, FlowValue> facts;
+  unordered_map<const ASTNode *, Kind> kinds;
+  unordered_map<const ASTNode *, FlowSpan> spans;
+  unordered_map<const ASTNode *, FlowLoop> loops;
+
+  vector<vector<FlowEvent>> events;
+  vector<unsigned> reads;
+  vector<unsigned> writes;
+  unordered_map<const ASTNode *, int> stores;
+  vector<FlowStatement> statements;
+  set<const ASTNode *> pure_items;
+  set<const ASTNode *> dead_stores;
+
+  void reset() {
+    blocks.clear();
+    labels.clear();
+    targets.clear();
+    variables.clear();
+    bindings.clear();
+    spans.clear();
+    loops.clear();
+    kinds.clear();
+    entry.clear();
+    scope = 0;
+    current = newBlock();
+    declaring = UNTRACKED;
+    effects = 0;
+    conditional = 0;
+  }
+
+  void use(int variable) {
+    if (recording || scanning) {
+      reads[variable]++;
+    }
+    if (recording) {
+      events[running].push_back({variable, nullptr, false, false});
+    }
+  }
+
+  // A value stored in a variable of kind `kind`
+  static m_Value convert(Kind kind, m_Value value) {
+    if (kind == INT && value.type == ActualValueType::FLOATING) {
+      value = m_Value((int)value.f);
+    } else if (kind == DOUBLE && value.type == ActualValueType::INTEGER) {
+      value = m_Value((double)value.i);
+    }
+    // Folded reads become FConstantNodes, which hold a float
+    if (value.type == ActualValueType::FLOATING) {
+      value = m_Value((float)value.f);
+    }
+    return value;
+  }
+
+  int lookup(const string &name) const { return lookup(name, eval_scope); }
+
+  int lookup(const string &name, size_t from) const {
+    for (size_t at = from; at > 0; at = bindings[at - 1].parent) {
+      if (bindings[at - 1].name == name) {
+        return bindings[at - 1].variable;
+      }
+    }
+    return -1;
+  }
+
+  m_Value evaluate_item(const FlowItem &item,
+                        const std::function<m_Value(const ASTNode *)> &evaluate) {
+    eval_scope = item.scope;
+    return evaluate(item.node);
+  }
+
+  // Evaluates block `b` from its entry state; returns the successors its
+  // exit can take
+  vector<int> run(int b, const std::function<m_Value(const ASTNode *)> &evaluate) {
+    env = in[b];
+    running = b;
+    for (const FlowItem &item : blocks[b].items) {
+      size_t before = effects;
+      size_t first = recording ? events[b].size() : 0;
+      evaluate_item(item, evaluate);
+      if (recording) {
+        statements.push_back(
+            {item.node, b, first, events[b].size(), effects - before});
+      }
+    }
+
+    const FlowBlock &block = blocks[b];
+    if (block.exit == FlowBlock::JUMP) {
+      return block.successors;
+    }
+
+    m_Value value = evaluate_item(block.condition, evaluate);
+    bool known = FlowValue::of(value).kind == FlowValue::CONSTANT;
+    if (block.exit == FlowBlock::BRANCH) {
+      if (!known) {
+        return block.successors;
+      }
+      bool taken = value.type == ActualValueType::INTEGER ? value.i != 0
+                                                          : value.f != 0;
+      return {block.successors[taken ? 0 : 1]};
+    }
+
+    // Cases are tried in order and the first match wins
+    vector<int> taken;
+    for (size_t i = 0; i < block.cases.size(); i++) {
+      m_Value label = block.cases[i];
+      if (!known || FlowValue::of(label).kind != FlowValue::CONSTANT) {
+        taken.push_back(block.successors[i]);
+        continue;
+      }
+      m_Value equal = value == label;
+      if (equal.type == ActualValueType::INTEGER && equal.i) {
+        taken.push_back(block.successors[i]);
+        return taken;
+      }
+    }
+    taken.push_back(block.successors.back());
+    return taken;
+  }
+
+  void solve(const std::function<m_Value(const ASTNode *)> &evaluate) {
+    in.assign(blocks.size(), vector<FlowValue>(variables.size()));
+    for (auto &value : entry) {
+      in[0][value.first] = value.second;
+    }
+    reached.assign(blocks.size(), false);
+    vector<bool> queued(blocks.size(), false);
+    deque<int> work = {0};
+    reached[0] = queued[0] = true;
+
+    while (!work.empty() && !retry) {
+      int b = work.front();
+      work.pop_front();
+      queued[b] = false;
+
+      for (int next : run(b, evaluate)) {
+        bool changed = !reached[next];
+        reached[next] = true;
+        for (size_t i = 0; i < env.size(); i++) {
+          changed |= in[next][i].meet(env[i]);
+        }
+        if (changed && !queued[next]) {
+          queued[next] = true;
+          work.push_back(next);
+        }
+      }
+    }
+  }
+
+  // Variables live on entry to block `b`, given those live at its exit;
+  // with `mark` set, the stores found dead on the way are recorded
+  vector<bool> live_before(int b, vector<bool> live, bool mark) {
+    const vector<FlowEvent> &block = events[b];
+    for (auto it = block.rbegin(); it != block.rend(); ++it) {
+      if (it->variable < 0) {
+        live.assign(live.size(), true);
+      } else if (!it->kills && !it->store) {
+        live[it->variable] = true;
+      } else if (it->kills) {
+        if (mark && it->store && !live[it->variable]) {
+          dead_stores.insert(it->store);
+        }
+        live[it->variable] = false;
+      }
+    }
+    return live;
+  }
+
+  // Backward liveness over the reachable blocks
+  void liveness() {
+    dead_stores.clear();
+    vector<vector<bool>> live_in(blocks.size(),
+                                 vector<bool>(variables.size(), false));
+    auto live_out = [&](int b) {
+      vector<bool> live(variables.size(), false);
+      for (int next : blocks[b].successors) {
+        for (size_t i = 0; i < live.size(); i++) {
+          live[i] = live[i] || live_in[next][i];
+        }
+      }
+      return live;
+    };
+
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (int b = blocks.size() - 1; b >= 0; b--) {
+        if (!reached[b]) {
+          continue;
+        }
+        vector<bool> live = live_before(b, live_out(b), false);
+        if (live != live_in[b]) {
+          live_in[b] = std::move(live);
+          changed = true;
+        }
+      }
+    }
+    for (size_t b = 0; b < blocks.size(); b++) {
+      if (reached[b]) {
+        live_before(b, live_out(b), true);
+      }
+    }
+  }
+};
+
+#endif // INCLUDE_CC_FLOW_H_
@@ -0,0 +1,74 @@
+#ifndef INCLUDE_CC_HASHCONS_H_
+#define INCLUDE_CC_HASHCONS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+// Hash-consing of expression shapes. An expression's id is interned from
+// its node type, its own payload (operator, constant or name) and the ids
+// of its operands, so structurally equal expressions share an id without
+// their subtrees being compared or printed. Expressions with side effects
+// take a fresh id instead, which nothing else is equal to.
+//
+// Shared by the optimiser threads, hence the lock.
+class ExprTable {
+public:
+  uint32_t intern(int type, int64_t payload, const string &name,
+                  const vector<uint32_t> &operands) {
+    Shape shape = {type, payload, name, operands};
+    lock_guard<mutex> guard(lock);
+    auto it = shapes.find(shape);
+    if (it != shapes.end()) {
+      return it->second;
+    }
+    uint32_t id = unique();
+    shapes.emplace(std::move(shape), id);
+    return id;
+  }
+
+  uint32_t intern(int type, const vector<uint32_t> &operands) {
+    return intern(type, 0, "", operands);
+  }
+
+  uint32_t unique() { return next_id.fetch_add(1, memory_order_relaxed); }
+
+private:
+  struct Shape {
+    int type;
+    int64_t payload;
+    string name;
+    vector<uint32_t> operands;
+
+    bool operator==(const Shape &other) const {
+      return type == other.type && payload == other.payload &&
+             name == other.name && operands == other.operands;
+    }
+  };
+
+  struct ShapeHash {
+    size_t operator()(const Shape &shape) const {
+      size_t h = std::hash<int>()(shape.type);
+      auto mix = [&h](size_t v) {
+        h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+      };
+      mix(std::hash<int64_t>()(shape.payload));
+      mix(std::hash<string>()(shape.name));
+      for (uint32_t operand : shape.operands) {
+        mix(operand);
+      }
+      return h;
+    }
+  };
+
+  mutex lock;
+  unordered_map<Shape, uint32_t, ShapeHash> shapes;
+  atomic<uint32_t> next_id{1};
+};
+
+#endif // INCLUDE_CC_HASHCONS_H_
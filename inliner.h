@@ -0,0 +1,97 @@
+#ifndef INCLUDE_CC_INLINER_H_
+#define INCLUDE_CC_INLINER_H_
+
+#include "flow.h"
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+using namespace std;
+
+class ASTNode;
+
+// Inlining of small functions (FunctionCallNode::optimise).
+//
+// A function is inlined when its body is `return e;`, where e only names
+// the function's parameters and is built from int constants, arithmetic,
+// comparisons, `?:` and reads through `int *` parameters (`p[i]`, `*p`).
+// Such an e has no side effects and calls nothing, so the function is not
+// recursive. The function has to return int, and its other parameters
+// have to be ints too.
+//
+// A call is replaced by a copy of e with the parameters replaced by the
+// arguments (ASTNode::inlined()), which the next optimiser round folds
+// into the caller. Without casts in the language, argument conversions
+// cannot be written out: an int parameter needs an argument known to be an
+// int, and a pointer parameter a variable. An argument goes where the
+// parameter is used, so one the body uses more than once has to be a
+// constant or a variable.
+//
+// Bodies are inlined up to --inline-size nodes, and whatever their size
+// for functions declared `inline`.
+
+struct InlineParam {
+  string name;
+  // INT for an int, or the type pointed to for a pointer
+  FlowAnalysis::Kind kind = FlowAnalysis::UNTRACKED;
+  bool pointer = false;
+  // Uses of the parameter in the body
+  unsigned uses = 0;
+};
+
+// The call being inlined: the parameters of the callee, the arguments that
+// replace them (null while the body is only being sized) and the nodes
+// copied so far
+struct InlineFrame {
+  vector<InlineParam> params;
+  vector<ASTNode *> args;
+  size_t size = 0;
+
+  InlineParam *find(const string &name, ASTNode *&arg) {
+    for (size_t i = 0; i < params.size(); i++) {
+      if (params[i].name == name) {
+        arg = i < args.size() ? args[i] : nullptr;
+        return &params[i];
+      }
+    }
+    return nullptr;
+  }
+};
+
+// The functions of the current optimiser round that can be inlined, and
+// the calls inlined so far. Shared by the optimiser threads.
+class Inliner {
+public:
+  struct Function {
+    vector<InlineParam> params;
+    const ASTNode *body = nullptr;
+  };
+
+  void define(map<string, Function> functions) {
+    lock_guard<mutex> guard(lock);
+    candidates = std::move(functions);
+  }
+
+  bool find(const string &name, Function &function) {
+    lock_guard<mutex> guard(lock);
+    auto it = candidates.find(name);
+    if (it == candidates.end()) {
+      return false;
+    }
+    function = it->second;
+    return true;
+  }
+
+  void inlined() { calls++; }
+
+  void report() const { printf("Calls inlined: %u\n", calls.load()); }
+
+private:
+  mutex lock;
+  map<string, Function> candidates;
+  atomic<unsigned> calls{0};
+};
+
+#endif // INCLUDE_CC_INLINER_H_
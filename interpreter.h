@@ -0,0 +1,721 @@
+#ifndef INCLUDE_CC_INTERPRETER_H_
+#define INCLUDE_CC_INTERPRETER_H_
+
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Type.h"
+#include <cstdint>
+#include <cstring>
+#include <dlfcn.h>
+#include <exception>
+#include <ffi.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <pthread.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+using namespace std;
+
+class ASTNode;
+
+// A value produced while interpreting the AST. LLVM types are only used as
+// the vocabulary for C types here; no IR is built. Integers are kept
+// sign-extended from their width (i1 as 0/1).
+struct RValue {
+  llvm::Type *type = nullptr;
+  union {
+    int64_t i;
+    double f;
+    char *p;
+  };
+
+  RValue() : i(0) {}
+  RValue(llvm::Type *type, int64_t i) : type(type), i(i) {}
+
+  static RValue floating(llvm::Type *type, double f) {
+    RValue v(type, 0);
+    v.f = f;
+    return v;
+  }
+
+  static RValue pointer(llvm::Type *type, char *p) {
+    RValue v(type, 0);
+    v.p = p;
+    return v;
+  }
+};
+
+enum class InterpOp {
+  ADD,
+  SUB,
+  MUL,
+  DIV,
+  MOD,
+  SHL,
+  SHR,
+  AND,
+  OR,
+  XOR,
+  EQ,
+  NE,
+  LT,
+  GT,
+  LE,
+  GE
+};
+
+// Host layout; the interpreter shares memory with libc, so it has to match.
+static const llvm::DataLayout &interp_layout() {
+  static const llvm::DataLayout layout(
+      "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128");
+  return layout;
+}
+
+static uint64_t interp_size(llvm::Type *type) {
+  // Scalars are by far the most common; skip the DataLayout walk for them
+  if (type->isIntegerTy()) {
+    return (type->getIntegerBitWidth() + 7) / 8;
+  }
+  if (type->isPointerTy() || type->isDoubleTy()) {
+    return 8;
+  }
+  return interp_layout().getTypeAllocSize(type);
+}
+
+static int64_t interp_wrap(int64_t v, llvm::Type *type) {
+  unsigned bits = type->getIntegerBitWidth();
+  if (bits == 1) {
+    return v & 1;
+  }
+  if (bits >= 64) {
+    return v;
+  }
+  return (int64_t)((uint64_t)v << (64 - bits)) >> (64 - bits);
+}
+
+static RValue interp_zero(llvm::Type *type) {
+  if (type->isDoubleTy() || type->isFloatTy()) {
+    return RValue::floating(type, 0);
+  }
+  return RValue(type, 0);
+}
+
+static RValue interp_load(char *addr, llvm::Type *type) {
+  // Arrays are used through a pointer to their first element
+  if (type->isArrayTy()) {
+    return RValue::pointer(
+        llvm::PointerType::get(type->getArrayElementType(), 0), addr);
+  }
+  if (type->isPointerTy()) {
+    char *p;
+    memcpy(&p, addr, sizeof(p));
+    return RValue::pointer(type, p);
+  }
+  if (type->isDoubleTy()) {
+    double f;
+    memcpy(&f, addr, sizeof(f));
+    return RValue::floating(type, f);
+  }
+  if (type->isFloatTy()) {
+    float f;
+    memcpy(&f, addr, sizeof(f));
+    return RValue::floating(type, f);
+  }
+  if (type->isIntegerTy()) {
+    switch (type->getIntegerBitWidth()) {
+    case 1:
+      return RValue(type, *(uint8_t *)addr & 1);
+    case 8:
+      return RValue(type, *(int8_t *)addr);
+    case 16: {
+      int16_t v;
+      memcpy(&v, addr, sizeof(v));
+      return RValue(type, v);
+    }
+    case 32: {
+      int32_t v;
+      memcpy(&v, addr, sizeof(v));
+      return RValue(type, v);
+    }
+    case 64: {
+      int64_t v;
+      memcpy(&v, addr, sizeof(v));
+      return RValue(type, v);
+    }
+    }
+  }
+  throw std::runtime_error("Cannot load a value of this type");
+}
+
+static void interp_store(char *addr, const RValue &v) {
+  llvm::Type *type = v.type;
+  if (type->isPointerTy()) {
+    memcpy(addr, &v.p, sizeof(v.p));
+  } else if (type->isDoubleTy()) {
+    memcpy(addr, &v.f, sizeof(v.f));
+  } else if (type->isFloatTy()) {
+    float f = v.f;
+    memcpy(addr, &f, sizeof(f));
+  } else if (type->isIntegerTy()) {
+    switch (type->getIntegerBitWidth()) {
+    case 1:
+    case 8:
+      *(int8_t *)addr = v.i;
+      return;
+    case 16: {
+      int16_t i = v.i;
+      memcpy(addr, &i, sizeof(i));
+      return;
+    }
+    case 32: {
+      int32_t i = v.i;
+      memcpy(addr, &i, sizeof(i));
+      return;
+    }
+    case 64:
+      memcpy(addr, &v.i, sizeof(v.i));
+      return;
+    }
+    throw std::runtime_error("Cannot store a value of this type");
+  } else {
+    throw std::runtime_error("Cannot store a value of this type");
+  }
+}
+
+// BitOrPointerCast and friends, on values
+static RValue interp_cast(const RValue &v, llvm::Type *to, bool sign = true) {
+  if (v.type == to) {
+    return v;
+  }
+  bool from_fp = v.type->isDoubleTy() || v.type->isFloatTy();
+  bool to_fp = to->isDoubleTy() || to->isFloatTy();
+  if (from_fp && to_fp) {
+    return RValue::floating(to, v.f);
+  }
+  if (from_fp) {
+    return RValue(to, to->isIntegerTy() ? interp_wrap((int64_t)v.f, to) : 0);
+  }
+  if (to_fp) {
+    return RValue::floating(to, (double)v.i);
+  }
+  if (to->isPointerTy()) {
+    return RValue::pointer(to, v.type->isPointerTy() ? v.p : (char *)v.i);
+  }
+  if (to->isIntegerTy()) {
+    int64_t i = v.type->isPointerTy() ? (int64_t)v.p : v.i;
+    if (!sign && v.type->isIntegerTy() && v.type->getIntegerBitWidth() < 64) {
+      i &= (int64_t)((uint64_t(1) << v.type->getIntegerBitWidth()) - 1);
+    }
+    return RValue(to, interp_wrap(i, to));
+  }
+  throw std::runtime_error("Cannot convert between these types");
+}
+
+static bool interp_is_fp(const RValue &v) {
+  return v.type->isDoubleTy() || v.type->isFloatTy();
+}
+
+// Same conversions as make_bool
+static void interp_make_bool(RValue &v) {
+  llvm::Type *i1 = llvm::Type::getInt1Ty(v.type->getContext());
+  if (v.type->isIntegerTy()) {
+    v = RValue(i1, v.i != 0);
+  } else if (interp_is_fp(v)) {
+    v = RValue(i1, v.f != 0);
+  }
+}
+
+static bool interp_truthy(RValue v) {
+  interp_make_bool(v);
+  return v.type->isPointerTy() ? v.p != nullptr : v.i != 0;
+}
+
+// Same conversions as make_store_compatible
+static void interp_make_store_compatible(llvm::Type *dest, RValue &v) {
+  if (dest->isIntegerTy() && v.type->isIntegerTy()) {
+    v = interp_cast(v, dest, false);
+  } else {
+    v = interp_cast(v, dest);
+  }
+}
+
+// Same conversions as make_lhs_rhs_compatible
+static void interp_make_lhs_rhs_compatible(RValue &lhs, RValue &rhs) {
+  if (interp_is_fp(lhs) || interp_is_fp(rhs)) {
+    llvm::Type *d = llvm::Type::getDoubleTy(lhs.type->getContext());
+    lhs = interp_cast(lhs, d);
+    rhs = interp_cast(rhs, d);
+    return;
+  }
+
+  if (lhs.type->isIntegerTy() && rhs.type->isIntegerTy()) {
+    unsigned lhs_bits = lhs.type->getIntegerBitWidth();
+    unsigned rhs_bits = rhs.type->getIntegerBitWidth();
+    if (lhs_bits < rhs_bits) {
+      lhs = interp_cast(lhs, rhs.type, lhs_bits != 1);
+    } else if (rhs_bits < lhs_bits) {
+      rhs = interp_cast(rhs, lhs.type, rhs_bits != 1);
+    }
+  }
+  if (lhs.type != rhs.type) {
+    rhs = interp_cast(rhs, lhs.type);
+  }
+}
+
+// Byte size of what a pointer-typed value points at (1 for void *)
+static int64_t interp_stride(llvm::Type *pointer_type) {
+  llvm::Type *element = pointer_type->getPointerElementType();
+  return element->isSized() ? interp_size(element) : 1;
+}
+
+static RValue interp_binary(InterpOp op, RValue lhs, RValue rhs) {
+  llvm::LLVMContext &context = lhs.type->getContext();
+
+  // Pointer arithmetic scales by the element size, as in C
+  if (op == InterpOp::ADD || op == InterpOp::SUB) {
+    if (lhs.type->isPointerTy() && rhs.type->isIntegerTy()) {
+      int64_t offset = rhs.i * interp_stride(lhs.type);
+      return RValue::pointer(lhs.type, lhs.p + (op == InterpOp::ADD ? offset
+                                                                    : -offset));
+    }
+    if (op == InterpOp::ADD && lhs.type->isIntegerTy() &&
+        rhs.type->isPointerTy()) {
+      return RValue::pointer(rhs.type, rhs.p + lhs.i * interp_stride(rhs.type));
+    }
+    if (op == InterpOp::SUB && lhs.type->isPointerTy() &&
+        rhs.type->isPointerTy()) {
+      return RValue(llvm::Type::getInt64Ty(context),
+                    (lhs.p - rhs.p) / interp_stride(lhs.type));
+    }
+  }
+
+  bool bitwise = op == InterpOp::SHL || op == InterpOp::SHR ||
+                 op == InterpOp::AND || op == InterpOp::OR ||
+                 op == InterpOp::XOR || op == InterpOp::MOD;
+  if (bitwise && (!lhs.type->isIntegerTy() || !rhs.type->isIntegerTy())) {
+    throw std::runtime_error("lhs or rhs is not an integer");
+  }
+
+  if (op == InterpOp::SHL || op == InterpOp::SHR) {
+    int64_t amount = rhs.i & 63;
+    int64_t v = op == InterpOp::SHL ? (int64_t)((uint64_t)lhs.i << amount)
+                                    : lhs.i >> amount;
+    return RValue(lhs.type, interp_wrap(v, lhs.type));
+  }
+
+  interp_make_lhs_rhs_compatible(lhs, rhs);
+  llvm::Type *i1 = llvm::Type::getInt1Ty(context);
+
+  if (lhs.type->isPointerTy()) {
+    uintptr_t a = (uintptr_t)lhs.p, b = (uintptr_t)rhs.p;
+    switch (op) {
+    case InterpOp::EQ:
+      return RValue(i1, a == b);
+    case InterpOp::NE:
+      return RValue(i1, a != b);
+    case InterpOp::LT:
+      return RValue(i1, a < b);
+    case InterpOp::GT:
+      return RValue(i1, a > b);
+    case InterpOp::LE:
+      return RValue(i1, a <= b);
+    case InterpOp::GE:
+      return RValue(i1, a >= b);
+    default:
+      throw std::runtime_error("Unsupported operation on pointers");
+    }
+  }
+
+  if (interp_is_fp(lhs)) {
+    double a = lhs.f, b = rhs.f;
+    switch (op) {
+    case InterpOp::ADD:
+      return RValue::floating(lhs.type, a + b);
+    case InterpOp::SUB:
+      return RValue::floating(lhs.type, a - b);
+    case InterpOp::MUL:
+      return RValue::floating(lhs.type, a * b);
+    case InterpOp::DIV:
+      return RValue::floating(lhs.type, a / b);
+    case InterpOp::EQ:
+      return RValue(i1, a == b);
+    case InterpOp::NE:
+      return RValue(i1, a < b || a > b);
+    case InterpOp::LT:
+      return RValue(i1, a < b);
+    case InterpOp::GT:
+      return RValue(i1, a > b);
+    case InterpOp::LE:
+      return RValue(i1, a <= b);
+    case InterpOp::GE:
+      return RValue(i1, a >= b);
+    default:
+      throw std::runtime_error("Unsupported operation on doubles");
+    }
+  }
+
+  int64_t a = lhs.i, b = rhs.i;
+  uint64_t ua = a, ub = b;
+  switch (op) {
+  case InterpOp::ADD:
+    return RValue(lhs.type, interp_wrap(ua + ub, lhs.type));
+  case InterpOp::SUB:
+    return RValue(lhs.type, interp_wrap(ua - ub, lhs.type));
+  case InterpOp::MUL:
+    return RValue(lhs.type, interp_wrap(ua * ub, lhs.type));
+  case InterpOp::DIV:
+  case InterpOp::MOD:
+    if (b == 0) {
+      throw std::runtime_error("Division by zero");
+    }
+    if (b == -1) {
+      return RValue(lhs.type,
+                    op == InterpOp::DIV ? interp_wrap(0 - ua, lhs.type) : 0);
+    }
+    return RValue(lhs.type, op == InterpOp::DIV ? a / b : a % b);
+  case InterpOp::AND:
+    return RValue(lhs.type, a & b);
+  case InterpOp::OR:
+    return RValue(lhs.type, a | b);
+  case InterpOp::XOR:
+    return RValue(lhs.type, a ^ b);
+  case InterpOp::EQ:
+    return RValue(i1, a == b);
+  case InterpOp::NE:
+    return RValue(i1, a != b);
+  case InterpOp::LT:
+    return RValue(i1, a < b);
+  case InterpOp::GT:
+    return RValue(i1, a > b);
+  case InterpOp::LE:
+    return RValue(i1, a <= b);
+  case InterpOp::GE:
+    return RValue(i1, a >= b);
+  default:
+    throw std::runtime_error("Unsupported integer operation");
+  }
+}
+
+// ++ and -- on a loaded value; pointers move by one element
+static RValue interp_step(const RValue &v, int delta) {
+  if (v.type->isPointerTy()) {
+    return RValue::pointer(v.type, v.p + delta * interp_stride(v.type));
+  }
+  if (interp_is_fp(v)) {
+    return RValue::floating(v.type, v.f + delta);
+  }
+  return RValue(v.type, interp_wrap(v.i + delta, v.type));
+}
+
+enum class InterpFlow { NORMAL, BREAK, CONTINUE, RETURN, GOTO };
+
+struct InterpVariable {
+  char *addr;
+  llvm::Type *type;
+  llvm::Type *address_type;
+};
+
+struct InterpFunction {
+  llvm::FunctionType *type = nullptr;
+  // Null for functions that are only declared; those are looked up in the
+  // host process and called through libffi.
+  ASTNode *definition = nullptr;
+  // Interned parameter names and their types
+  vector<pair<size_t, llvm::Type *>> params;
+  void *native = nullptr;
+};
+
+// Runtime state of `cc --interp`: variables live in host memory (globals on
+// the heap, locals on a bump-allocated stack released when their scope
+// ends), so pointers can be handed to libc unchanged.
+class Interpreter {
+public:
+  InterpFlow flow = InterpFlow::NORMAL;
+  RValue return_value;
+  llvm::Type *return_type = nullptr;
+  string goto_label;
+
+  map<string, InterpFunction> functions;
+
+  // Filled by collectFunctionParams()
+  vector<pair<string, llvm::Type *>> pending_params;
+
+  Interpreter() : stack_size(64 << 20) {}
+
+  // Runs `program` on a thread with a host stack as large as the baseline
+  // backend's: evaluation recurses on the host stack for every call and
+  // nested expression. Its exceptions are rethrown here.
+  RValue run(const std::function<RValue()> &program) {
+    const size_t host_stack_size = 256 << 20;
+    void *host_stack = mmap(nullptr, host_stack_size, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (host_stack == MAP_FAILED) {
+      throw std::runtime_error("Cannot map the interpreter stack");
+    }
+    // Natives and the deepest expressions still have room below the limit
+    host_stack_limit = (uintptr_t)host_stack + (4 << 20);
+
+    Run run{program, RValue(), nullptr};
+    pthread_attr_t attr;
+    pthread_t thread;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, host_stack, host_stack_size);
+    int status = pthread_create(&thread, &attr, &Interpreter::start, &run);
+    pthread_attr_destroy(&attr);
+    if (status == 0) {
+      pthread_join(thread, nullptr);
+    }
+    munmap(host_stack, host_stack_size);
+    host_stack_limit = 0;
+    if (status != 0) {
+      throw std::runtime_error("Cannot start the interpreter thread");
+    }
+    if (run.error) {
+      std::rethrow_exception(run.error);
+    }
+    return run.result;
+  }
+
+  // On entry to every interpreted function: recursion too deep for the
+  // host stack is an error of the program, not a crash
+  void checkStack() const {
+    if (host_stack_limit &&
+        (uintptr_t)__builtin_frame_address(0) < host_stack_limit) {
+      throw std::runtime_error("Interpreter stack overflow");
+    }
+  }
+
+  // Variable names are interned once, so lookups compare integers
+  size_t intern(const string &name) {
+    auto it = ids.find(name);
+    if (it != ids.end()) {
+      return it->second;
+    }
+    size_t id = ids.size();
+    ids.emplace(name, id);
+    return id;
+  }
+
+  void pushScope() { marks.push_back({bindings.size(), stack_top}); }
+
+  void popScope() {
+    bindings.resize(marks.back().first);
+    stack_top = marks.back().second;
+    marks.pop_back();
+  }
+
+  // Locals of the caller are not visible from the callee
+  size_t enterFrame() {
+    size_t saved = frame_base;
+    frame_base = bindings.size();
+    pushScope();
+    return saved;
+  }
+
+  void leaveFrame(size_t saved) {
+    popScope();
+    frame_base = saved;
+  }
+
+  // Consumes a break or continue left by a loop body; true when the loop
+  // has to stop (break, return or an unresolved goto)
+  bool loopExits() {
+    if (flow == InterpFlow::CONTINUE) {
+      flow = InterpFlow::NORMAL;
+    }
+    if (flow == InterpFlow::BREAK) {
+      flow = InterpFlow::NORMAL;
+      return true;
+    }
+    return flow != InterpFlow::NORMAL;
+  }
+
+  // Outside of any scope the variable is a global
+  char *declare(size_t id, llvm::Type *type) {
+    size_t size = type->isSized() ? interp_size(type) : 0;
+    char *addr;
+    if (marks.empty()) {
+      global_storage.push_back(make_unique<char[]>(size ? size : 1));
+      addr = global_storage.back().get();
+      if (id >= globals.size()) {
+        globals.resize(id + 1, {nullptr, nullptr, nullptr});
+      }
+      globals[id] = {addr, type, llvm::PointerType::get(type, 0)};
+      return addr;
+    }
+
+    // Not make_unique: zero-filling the whole stack up front would dominate
+    // the run time of small programs
+    if (!stack) {
+      stack.reset(new char[stack_size]);
+    }
+    size_t aligned = (stack_top + 15) & ~size_t(15);
+    if (aligned + size > stack_size) {
+      throw std::runtime_error("Interpreter stack overflow");
+    }
+    addr = stack.get() + aligned;
+    stack_top = aligned + size;
+    memset(addr, 0, size);
+    bindings.push_back({id, {addr, type, llvm::PointerType::get(type, 0)}});
+    return addr;
+  }
+
+  const InterpVariable *find(size_t id) const {
+    for (size_t i = bindings.size(); i-- > frame_base;) {
+      if (bindings[i].first == id) {
+        return &bindings[i].second;
+      }
+    }
+    if (id < globals.size() && globals[id].addr) {
+      return &globals[id];
+    }
+    return nullptr;
+  }
+
+  InterpFunction *findFunction(const string &name) {
+    auto it = functions.find(name);
+    return it == functions.end() ? nullptr : &it->second;
+  }
+
+  // Calls a function of the host process (printf, strlen, ...). Fixed
+  // arguments are converted to the declared parameter types, variadic ones
+  // get the default argument promotions.
+  RValue callNative(const string &name, InterpFunction &function,
+                    vector<RValue> args) {
+    if (!function.native) {
+      function.native = dlsym(RTLD_DEFAULT, name.c_str());
+      if (!function.native) {
+        throw std::runtime_error("Function " + name + " is not defined.");
+      }
+    }
+
+    llvm::FunctionType *type = function.type;
+    unsigned fixed = type->getNumParams();
+    if (args.size() < fixed) {
+      throw std::runtime_error("Function " + name +
+                               " called with too few arguments.");
+    }
+
+    llvm::LLVMContext &context = type->getContext();
+    vector<ffi_type *> arg_types;
+    vector<void *> arg_values;
+    for (size_t i = 0; i < args.size(); i++) {
+      if (i < fixed) {
+        interp_make_store_compatible(type->getParamType(i), args[i]);
+      } else if (args[i].type->isIntegerTy() &&
+                 args[i].type->getIntegerBitWidth() < 32) {
+        args[i] = interp_cast(args[i], llvm::Type::getInt32Ty(context),
+                              args[i].type->getIntegerBitWidth() != 1);
+      } else if (args[i].type->isFloatTy()) {
+        args[i] = interp_cast(args[i], llvm::Type::getDoubleTy(context));
+      }
+      arg_types.push_back(ffiType(args[i].type));
+      // Little-endian: the low bytes of the union hold narrower integers
+      arg_values.push_back(&args[i].i);
+    }
+
+    ffi_cif cif;
+    ffi_type *ret_type = ffiType(type->getReturnType());
+    ffi_status status =
+        type->isVarArg()
+            ? ffi_prep_cif_var(&cif, FFI_DEFAULT_ABI, fixed, args.size(),
+                               ret_type, arg_types.data())
+            : ffi_prep_cif(&cif, FFI_DEFAULT_ABI, args.size(), ret_type,
+                           arg_types.data());
+    if (status != FFI_OK) {
+      throw std::runtime_error("Cannot call " + name + " through libffi");
+    }
+
+    union {
+      ffi_arg i;
+      double f;
+      float s;
+      void *p;
+    } result;
+    ffi_call(&cif, FFI_FN(function.native), &result, arg_values.data());
+
+    llvm::Type *rtype = type->getReturnType();
+    if (rtype->isIntegerTy()) {
+      return RValue(rtype, interp_wrap((int64_t)result.i, rtype));
+    }
+    if (rtype->isDoubleTy()) {
+      return RValue::floating(rtype, result.f);
+    }
+    if (rtype->isFloatTy()) {
+      return RValue::floating(rtype, result.s);
+    }
+    if (rtype->isPointerTy()) {
+      return RValue::pointer(rtype, (char *)result.p);
+    }
+    return RValue(rtype, 0);
+  }
+
+private:
+  struct Run {
+    const std::function<RValue()> &program;
+    RValue result;
+    std::exception_ptr error;
+  };
+
+  static void *start(void *argument) {
+    Run &run = *(Run *)argument;
+    try {
+      run.result = run.program();
+    } catch (...) {
+      run.error = std::current_exception();
+    }
+    return nullptr;
+  }
+
+  unordered_map<string, size_t> ids;
+
+  // Visible locals, innermost last; each scope remembers where its
+  // bindings and its stack memory start
+  vector<pair<size_t, InterpVariable>> bindings;
+  vector<pair<size_t, size_t>> marks;
+  size_t frame_base = 0;
+
+  unique_ptr<char[]> stack;
+  size_t stack_size;
+  size_t stack_top = 0;
+  uintptr_t host_stack_limit = 0;
+
+  vector<InterpVariable> globals;
+  vector<unique_ptr<char[]>> global_storage;
+
+  static ffi_type *ffiType(llvm::Type *type) {
+    if (type->isVoidTy()) {
+      return &ffi_type_void;
+    }
+    if (type->isPointerTy()) {
+      return &ffi_type_pointer;
+    }
+    if (type->isDoubleTy()) {
+      return &ffi_type_double;
+    }
+    if (type->isFloatTy()) {
+      return &ffi_type_float;
+    }
+    if (type->isIntegerTy()) {
+      switch (type->getIntegerBitWidth()) {
+      case 1:
+      case 8:
+        return &ffi_type_sint8;
+      case 16:
+        return &ffi_type_sint16;
+      case 32:
+        return &ffi_type_sint32;
+      case 64:
+        return &ffi_type_sint64;
+      }
+    }
+    throw std::runtime_error("Type cannot be passed to a native function");
+  }
+};
+
+#endif // INCLUDE_CC_INTERPRETER_H_
@@ -0,0 +1,321 @@
+#ifndef INCLUDE_CC_INTERPROC_H_
+#define INCLUDE_CC_INTERPROC_H_
+
+#include "flow.h"
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Interprocedural constant propagation and function specialisation.
+//
+// Every optimiser round records the arguments of each direct call the flow
+// analysis reaches. The next round (TranslationUnitNode::optimise) uses
+// them in two ways:
+//  - a parameter that got the same constant at every call site is seeded
+//    into the flow analysis of the callee's body;
+//  - an argument tuple with constants that recurs at several call sites
+//    gets a clone of the callee, whose parameters are seeded with those
+//    constants, and the matching calls are redirected to it. Clones are
+//    limited by a budget on the expressions they copy.
+//
+// The translation unit is taken to be the whole program. main is never
+// seeded, and neither is a function whose name is used other than as a
+// callee or one that other translation units call (--whole-program); the
+// latter can still be cloned.
+class CallSites {
+public:
+  // A clone of `function` for the constants in `args` (NO_VALUE elsewhere)
+  struct Specialisation {
+    string function;
+    string clone;
+    vector<m_Value> args;
+  };
+
+  static constexpr unsigned MAX_CLONES = 4;
+
+  // Records the size in expressions of `function`, whose parameters can be
+  // seeded
+  void define(const string &function, size_t size) {
+    lock_guard<mutex> guard(lock);
+    recorded[function].size = size;
+  }
+
+  void call(const string &function, const vector<m_Value> &args) {
+    lock_guard<mutex> guard(lock);
+    if (!defined.count(function)) {
+      return;
+    }
+    Function &f = recorded[function];
+    if (f.sites++ == 0) {
+      f.args.assign(args.size(), FlowValue());
+    } else if (f.args.size() != args.size()) {
+      f.escaped = true;
+    }
+    for (size_t i = 0; i < args.size() && i < f.args.size(); i++) {
+      f.args[i].meet(FlowValue::of(args[i]));
+    }
+    f.tuples[key(args)].count++;
+    f.tuples[key(args)].args = args;
+  }
+
+  // `function` is named somewhere else than as a callee. A call whose
+  // arguments do not match the first one's in number escapes it too.
+  void escape(const string &function) {
+    lock_guard<mutex> guard(lock);
+    if (defined.count(function)) {
+      recorded[function].escaped = true;
+    }
+  }
+
+  // Functions of the translation unit that other translation units call
+  void external(const set<string> &functions) {
+    lock_guard<mutex> guard(lock);
+    outside = functions;
+  }
+
+  // Forgets the translation unit, before the next one is optimised; only
+  // the totals reported are kept
+  void reset() {
+    lock_guard<mutex> guard(lock);
+    earlier_params += seeded();
+    earlier_clones += clone_of.size();
+    defined.clear();
+    recorded.clear();
+    seen.clear();
+    seeds.clear();
+    clones.clear();
+    clone_of.clear();
+    specialised.clear();
+    outside.clear();
+    copied = 0;
+    budget = 0;
+  }
+
+  // Starts a round over the functions defined in the translation unit;
+  // returns the clones to add to it. `budget` bounds the expressions all
+  // clones copy, over every round.
+  vector<Specialisation> beginRound(const set<string> &functions,
+                                    size_t budget) {
+    lock_guard<mutex> guard(lock);
+    defined = functions;
+    seen = std::move(recorded);
+    recorded.clear();
+    seeds = plan(seen);
+
+    vector<Specialisation> added = candidates(seen, budget);
+    for (Specialisation &s : added) {
+      s.clone = s.function + ".spec" + to_string(clones[s.function].size());
+      specialised.insert(s.function + "(" + key(s.args));
+      clones[s.function].push_back(s);
+      clone_of[s.clone] = s.args;
+      copied += seen[s.function].size;
+    }
+    seeds = plan(seen);
+    this->budget = budget;
+    return added;
+  }
+
+  // Whether the calls recorded this round would seed or specialise
+  // differently from what this round did, in which case another round is
+  // due
+  bool pending() {
+    lock_guard<mutex> guard(lock);
+    return !same(plan(recorded), seeds) ||
+           !candidates(recorded, budget).empty();
+  }
+
+  // The constants to seed into the parameters of `function`
+  vector<m_Value> seedsFor(const string &function) {
+    lock_guard<mutex> guard(lock);
+    auto it = seeds.find(function);
+    return it == seeds.end() ? vector<m_Value>() : it->second;
+  }
+
+  // The clone a call of `function` with `args` can be redirected to, if any
+  string cloneFor(const string &function, const vector<m_Value> &args) {
+    lock_guard<mutex> guard(lock);
+    auto it = clones.find(function);
+    if (it == clones.end()) {
+      return "";
+    }
+    for (const Specialisation &s : it->second) {
+      if (matches(s.args, args)) {
+        return s.clone;
+      }
+    }
+    return "";
+  }
+
+  void report() {
+    lock_guard<mutex> guard(lock);
+    printf("Interprocedural: %u constant parameters, %zu specialised "
+           "clones\n",
+           earlier_params + seeded(), earlier_clones + clone_of.size());
+  }
+
+private:
+  struct Tuple {
+    unsigned count = 0;
+    vector<m_Value> args;
+  };
+
+  struct Function {
+    unsigned sites = 0;
+    bool escaped = false;
+    size_t size = 0;
+    vector<FlowValue> args;
+    map<string, Tuple> tuples;
+  };
+
+  mutex lock;
+  set<string> defined;
+  map<string, Function> recorded;
+  map<string, Function> seen;
+  map<string, vector<m_Value>> seeds;
+
+  map<string, vector<Specialisation>> clones;
+  map<string, vector<m_Value>> clone_of;
+  set<string> specialised;
+  set<string> outside;
+  size_t copied = 0;
+  size_t budget = 0;
+  unsigned earlier_params = 0;
+  size_t earlier_clones = 0;
+
+  unsigned seeded() const {
+    unsigned params = 0;
+    for (auto &entry : seeds) {
+      for (const m_Value &value : entry.second) {
+        params += value.type != ActualValueType::NO_VALUE;
+      }
+    }
+    return params;
+  }
+
+  // Seeds for every function, from the calls in `calls`: the constants of
+  // a clone's tuple, and the parameters constant at every call site
+  map<string, vector<m_Value>> plan(const map<string, Function> &calls) const {
+    map<string, vector<m_Value>> result;
+    for (auto &entry : clone_of) {
+      result[entry.first] = entry.second;
+    }
+    for (auto &entry : calls) {
+      const Function &f = entry.second;
+      if (!defined.count(entry.first) || entry.first == "main" || f.escaped ||
+          f.sites == 0 || outside.count(entry.first)) {
+        continue;
+      }
+      vector<m_Value> &values = result[entry.first];
+      values.resize(f.args.size());
+      for (size_t i = 0; i < f.args.size(); i++) {
+        if (values[i].type == ActualValueType::NO_VALUE &&
+            f.args[i].kind == FlowValue::CONSTANT) {
+          values[i] = f.args[i].value;
+        }
+      }
+    }
+    return result;
+  }
+
+  // The tuples worth a clone: seen at two call sites at least, fixing a
+  // parameter that is not seeded anyway, within the limits. Functions that
+  // escape or whose parameters cannot be seeded are left alone.
+  vector<Specialisation> candidates(const map<string, Function> &calls,
+                                    size_t budget) const {
+    vector<Specialisation> result;
+    size_t total = copied;
+    for (auto &entry : calls) {
+      const string &name = entry.first;
+      const Function &f = entry.second;
+      if (!defined.count(name) || name == "main" || clone_of.count(name) ||
+          f.escaped || f.size == 0) {
+        continue;
+      }
+      auto existing = clones.find(name);
+      size_t count = existing == clones.end() ? 0 : existing->second.size();
+      for (auto &tuple : f.tuples) {
+        if (tuple.second.count < 2 || count >= MAX_CLONES ||
+            specialised.count(name + "(" + tuple.first) ||
+            total + f.size > budget || !worthwhile(name, tuple.second.args)) {
+          continue;
+        }
+        Specialisation s;
+        s.function = name;
+        s.args = tuple.second.args;
+        result.push_back(s);
+        total += f.size;
+        count++;
+      }
+    }
+    return result;
+  }
+
+  static bool same(const map<string, vector<m_Value>> &a,
+                   const map<string, vector<m_Value>> &b) {
+    if (a.size() != b.size()) {
+      return false;
+    }
+    for (auto i = a.begin(), j = b.begin(); i != a.end(); ++i, ++j) {
+      if (i->first != j->first || i->second.size() != j->second.size()) {
+        return false;
+      }
+      for (size_t k = 0; k < i->second.size(); k++) {
+        const m_Value &x = i->second[k], &y = j->second[k];
+        if (x.type != y.type ||
+            (x.type != ActualValueType::NO_VALUE && !FlowValue::same(x, y))) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  // A clone only pays when it fixes a parameter that is not constant anyway
+  bool worthwhile(const string &function, const vector<m_Value> &args) const {
+    auto it = seeds.find(function);
+    for (size_t i = 0; i < args.size(); i++) {
+      bool seeded = it != seeds.end() && i < it->second.size() &&
+                    it->second[i].type != ActualValueType::NO_VALUE;
+      if (args[i].type != ActualValueType::NO_VALUE && !seeded) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static bool matches(const vector<m_Value> &pattern,
+                      const vector<m_Value> &args) {
+    if (pattern.size() != args.size()) {
+      return false;
+    }
+    for (size_t i = 0; i < pattern.size(); i++) {
+      if (pattern[i].type != ActualValueType::NO_VALUE &&
+          !FlowValue::same(pattern[i], args[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static string key(const vector<m_Value> &args) {
+    string key;
+    char buffer[32];
+    for (const m_Value &arg : args) {
+      if (arg.type == ActualValueType::INTEGER) {
+        snprintf(buffer, sizeof(buffer), "%d,", arg.i);
+      } else if (arg.type == ActualValueType::FLOATING) {
+        snprintf(buffer, sizeof(buffer), "%a,", arg.f);
+      } else {
+        snprintf(buffer, sizeof(buffer), "*,");
+      }
+      key += buffer;
+    }
+    return key;
+  }
+};
+
+#endif // INCLUDE_CC_INTERPROC_H_
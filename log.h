@@ -0,0 +1,57 @@
+#ifndef INCLUDE_CC_LOG_H_
+#define INCLUDE_CC_LOG_H_
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+using namespace std;
+
+// Tracing of the compiler's own work, for debugging cc (--log). Each
+// message belongs to a category and is only formatted when that category
+// is switched on in `log_categories`, so the normal path does no I/O.
+// Building with -DCC_NO_LOG compiles every message out. Messages go to
+// stderr and are not flushed.
+enum LogCategory : unsigned {
+  LOG_CODEGEN = 1 << 0, // declarations, array accesses and literals lowered
+  LOG_TYPES = 1 << 1,   // specifiers and declarators resolved to LLVM types
+  LOG_CASTS = 1 << 2,   // conversions inserted to store a value
+  LOG_ALL = LOG_CODEGEN | LOG_TYPES | LOG_CASTS
+};
+
+#ifdef CC_NO_LOG
+#define CC_LOG(category, message)                                              \
+  do {                                                                         \
+  } while (0)
+#else
+#define CC_LOG(category, message)                                              \
+  do {                                                                         \
+    if (log_categories & (category)) {                                         \
+      std::cerr << message << '\n';                                            \
+    }                                                                          \
+  } while (0)
+#endif
+
+// The mask of a comma-separated list of categories ("codegen,casts", or
+// "all"); throws runtime_error on an unknown one
+static unsigned parse_log_categories(const string &list) {
+  unsigned mask = 0;
+  stringstream names(list);
+  string name;
+  while (getline(names, name, ',')) {
+    if (name == "codegen") {
+      mask |= LOG_CODEGEN;
+    } else if (name == "types") {
+      mask |= LOG_TYPES;
+    } else if (name == "casts") {
+      mask |= LOG_CASTS;
+    } else if (name == "all") {
+      mask |= LOG_ALL;
+    } else {
+      throw std::runtime_error("Unknown log category " + name);
+    }
+  }
+  return mask;
+}
+
+#endif // INCLUDE_CC_LOG_H_
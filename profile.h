@@ -0,0 +1,276 @@
+#ifndef INCLUDE_CC_PROFILE_H_
+#define INCLUDE_CC_PROFILE_H_
+
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Transforms/Utils/ModuleUtils.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Profile-guided optimisation (--profile-generate, --profile-use).
+//
+// An instrumented build counts the calls of every function definition and
+// the outcomes of every branch of an if, loop, switch or ?:, in i64
+// globals, and the program writes them to the profile file when it exits
+// (from llvm.global_dtors). A two-way branch counts how often its condition
+// was true and false; a switch how often it ran and each case was taken.
+//
+// A build using the profile turns the counts back into function entry
+// counts and branch_weights. Counters are numbered in codegen order within
+// each function, so a profile only fits a program built from the same
+// source with the same options; a function whose number of counters does
+// not match its profile is left without annotations.
+class Profiler {
+public:
+  enum Mode { OFF, GENERATE, USE };
+
+  Mode mode() const { return current_mode; }
+
+  void generate(const string &file) {
+    current_mode = GENERATE;
+    path = file;
+  }
+
+  // Throws runtime_error if `file` is not a profile
+  void use(const string &file) {
+    ifstream in(file);
+    string line;
+    if (!in || !getline(in, line) || line != HEADER) {
+      throw std::runtime_error(file + " is not a profile");
+    }
+    while (getline(in, line)) {
+      istringstream fields(line);
+      string name;
+      size_t size;
+      if (!(fields >> name >> size)) {
+        continue;
+      }
+      vector<uint64_t> &counts = profile[name];
+      counts.resize(size);
+      for (uint64_t &count : counts) {
+        if (!(fields >> count)) {
+          throw std::runtime_error(file + ": short counts for " + name);
+        }
+      }
+    }
+    current_mode = USE;
+    path = file;
+  }
+
+  // Called once the entry block of `function` has its parameters
+  void beginFunction(llvm::IRBuilder<> &builder, llvm::Function *function) {
+    this->function = function;
+    next = 0;
+    if (current_mode == GENERATE) {
+      counters.push_back({function->getName().str(), {}});
+      increment(builder, builder.getInt64(1));
+    } else if (current_mode == USE) {
+      auto it = profile.find(function->getName().str());
+      counts = it == profile.end() ? nullptr : &it->second;
+      next = 1;
+    }
+  }
+
+  void endFunction() {
+    if (current_mode != USE || !counts) {
+      return;
+    }
+    if (next != counts->size()) {
+      for (llvm::BasicBlock &block : *function) {
+        for (llvm::Instruction &instruction : block) {
+          instruction.setMetadata(llvm::LLVMContext::MD_prof, nullptr);
+        }
+      }
+      stale++;
+    } else {
+      function->setEntryCount((*counts)[0]);
+      annotated++;
+    }
+    counts = nullptr;
+  }
+
+  // A branch on the i1 `condition`, about to be emitted: counts it, or
+  // returns the weights of its true and false successors (null if unknown)
+  llvm::MDNode *branch(llvm::IRBuilder<> &builder, llvm::Value *condition) {
+    if (current_mode == GENERATE) {
+      llvm::Value *taken =
+          builder.CreateZExt(condition, builder.getInt64Ty(), "prof.taken");
+      increment(builder, taken);
+      increment(builder,
+                builder.CreateSub(builder.getInt64(1), taken, "prof.else"));
+      return nullptr;
+    }
+    uint64_t taken = take();
+    uint64_t not_taken = take();
+    return weights(builder, {taken, not_taken});
+  }
+
+  // A switch on `condition` with `cases`, about to be emitted: counts it,
+  // or returns the weights of its default and then its cases
+  llvm::MDNode *switchCases(llvm::IRBuilder<> &builder, llvm::Value *condition,
+                            const vector<llvm::ConstantInt *> &cases) {
+    if (current_mode == GENERATE) {
+      increment(builder, builder.getInt64(1));
+      for (llvm::ConstantInt *value : cases) {
+        llvm::Value *match =
+            builder.CreateICmpEQ(condition, value, "prof.match");
+        increment(builder, builder.CreateZExt(match, builder.getInt64Ty(),
+                                              "prof.case"));
+      }
+      return nullptr;
+    }
+    vector<uint64_t> counts(1, take());
+    uint64_t rest = counts[0];
+    for (size_t i = 0; i < cases.size(); i++) {
+      counts.push_back(take());
+      rest -= std::min(rest, counts.back());
+    }
+    counts[0] = rest;
+    return weights(builder, counts);
+  }
+
+  // Adds the function writing the profile at exit to an instrumented
+  // module. Its strings are added to `literals`, like those of the program.
+  void finish(llvm::Module &module,
+              vector<llvm::GlobalVariable *> &literals) {
+    if (current_mode != GENERATE || counters.empty()) {
+      return;
+    }
+    llvm::LLVMContext &context = module.getContext();
+    llvm::IRBuilder<> builder(context);
+    llvm::Type *string_type = builder.getInt8PtrTy();
+    auto literal = [&](const string &text) {
+      llvm::Constant *value = llvm::ConstantDataArray::getString(context, text);
+      auto *global = new llvm::GlobalVariable(
+          module, value->getType(), false, llvm::GlobalValue::ExternalLinkage,
+          value, "__cc_prof.str");
+      literals.push_back(global);
+      return llvm::ConstantExpr::getPointerCast(global, string_type);
+    };
+    llvm::FunctionCallee fopen = module.getOrInsertFunction(
+        "fopen", string_type, string_type, string_type);
+    llvm::FunctionCallee fprintf = module.getOrInsertFunction(
+        "fprintf",
+        llvm::FunctionType::get(builder.getInt32Ty(), {string_type}, true));
+    llvm::FunctionCallee fclose =
+        module.getOrInsertFunction("fclose", builder.getInt32Ty(), string_type);
+
+    llvm::Function *write = llvm::Function::Create(
+        llvm::FunctionType::get(builder.getVoidTy(), false),
+        llvm::Function::InternalLinkage, "__cc_profile_write", module);
+    llvm::BasicBlock *entry = llvm::BasicBlock::Create(context, "entry", write);
+    llvm::BasicBlock *body = llvm::BasicBlock::Create(context, "write", write);
+    llvm::BasicBlock *done = llvm::BasicBlock::Create(context, "done", write);
+
+    builder.SetInsertPoint(entry);
+    llvm::Value *file =
+        builder.CreateCall(fopen, {literal(path), literal("w")});
+    builder.CreateCondBr(builder.CreateIsNull(file), done, body);
+
+    builder.SetInsertPoint(body);
+    builder.CreateCall(fprintf, {file, literal(HEADER + "\n")});
+    llvm::Value *count_format = literal(" %llu");
+    llvm::Value *newline = literal("\n");
+    for (Counters &function : counters) {
+      builder.CreateCall(
+          fprintf, {file, literal(function.name + " " +
+                                  to_string(function.counters.size()))});
+      for (llvm::GlobalVariable *counter : function.counters) {
+        builder.CreateCall(fprintf,
+                           {file, count_format,
+                            builder.CreateLoad(builder.getInt64Ty(), counter)});
+      }
+      builder.CreateCall(fprintf, {file, newline});
+    }
+    builder.CreateCall(fclose, {file});
+    builder.CreateBr(done);
+
+    builder.SetInsertPoint(done);
+    builder.CreateRetVoid();
+
+    llvm::appendToGlobalDtors(module, write, 0);
+  }
+
+  void report() const {
+    if (current_mode == GENERATE) {
+      printf("Profile: %zu functions instrumented, written to %s at exit\n",
+             counters.size(), path.c_str());
+    } else if (current_mode == USE) {
+      printf("Profile: %u functions annotated from %s, %u out of date\n",
+             annotated, path.c_str(), stale);
+    }
+  }
+
+private:
+  struct Counters {
+    string name;
+    vector<llvm::GlobalVariable *> counters;
+  };
+
+  const string HEADER = "# cc profile";
+
+  Mode current_mode = OFF;
+  string path;
+
+  // The function being generated, and its next counter
+  llvm::Function *function = nullptr;
+  size_t next = 0;
+
+  // GENERATE: the counters of every function so far
+  vector<Counters> counters;
+
+  // USE: the counts read, those of the current function (if any) and how
+  // the functions fared
+  map<string, vector<uint64_t>> profile;
+  const vector<uint64_t> *counts = nullptr;
+  unsigned annotated = 0;
+  unsigned stale = 0;
+
+  // Adds `amount` to a new counter of the current function
+  void increment(llvm::IRBuilder<> &builder, llvm::Value *amount) {
+    Counters &current = counters.back();
+    auto *counter = new llvm::GlobalVariable(
+        *function->getParent(), builder.getInt64Ty(), false,
+        llvm::GlobalValue::InternalLinkage, builder.getInt64(0),
+        "__cc_prof." + current.name);
+    current.counters.push_back(counter);
+    llvm::Value *count =
+        builder.CreateLoad(builder.getInt64Ty(), counter, "prof.count");
+    builder.CreateStore(builder.CreateAdd(count, amount, "prof.add"), counter);
+  }
+
+  // The next count of the current function (0 past its end)
+  uint64_t take() {
+    size_t index = next++;
+    return counts && index < counts->size() ? (*counts)[index] : 0;
+  }
+
+  // Branch weights are 32 bits wide, so large counts are scaled down
+  llvm::MDNode *weights(llvm::IRBuilder<> &builder,
+                        const vector<uint64_t> &counts) const {
+    if (!this->counts) {
+      return nullptr;
+    }
+    uint64_t largest = *std::max_element(counts.begin(), counts.end());
+    if (largest == 0) {
+      return nullptr;
+    }
+    uint64_t scale = largest / UINT32_MAX + 1;
+    vector<uint32_t> result;
+    for (uint64_t count : counts) {
+      result.push_back(count / scale);
+    }
+    return llvm::MDBuilder(builder.getContext()).createBranchWeights(result);
+  }
+};
+
+#endif // INCLUDE_CC_PROFILE_H_
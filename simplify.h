@@ -0,0 +1,323 @@
+#ifndef INCLUDE_CC_SIMPLIFY_H_
+#define INCLUDE_CC_SIMPLIFY_H_
+
+#include "AST_enums.hpp"
+#include "scoper.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+using namespace std;
+
+class ASTNode;
+
+// Algebraic simplification of arithmetic nodes whose operands are not both
+// constant (simplify_binary() in AST.hpp). Each rule looks at one operator
+// and what is known of its two operands, and either declines or says what
+// the expression becomes. Rules are tried in table order; the first that
+// applies wins and its hit counter goes up.
+//
+// There is no unsigned arithmetic in this compiler (every division lowers
+// to sdiv/srem), so divisions by powers of two only become shifts and masks
+// when the dividend is known not to be negative.
+
+// What the rules know of an operand
+struct Operand {
+  ASTNode *node = nullptr;
+  // Constant value, if any
+  m_Value value;
+  // ASTNode::expr_id(), or 0 when the operand has side effects
+  uint32_t id = 0;
+  bool integral = false;
+  bool nonnegative = false;
+  // Set when the operand is itself `inner op inner_value`
+  NodeType op = NodeType::Unimplemented;
+  ASTNode *inner = nullptr;
+  m_Value inner_value;
+
+  bool is(int v) const { return value.type == INTEGER && value.i == v; }
+  bool constant() const { return value.type == INTEGER; }
+  bool pure() const { return id != 0; }
+
+  // log2 of a constant power of two greater than one, or -1
+  int power_of_two() const {
+    if (!constant() || value.i < 2 || (value.i & (value.i - 1)) != 0) {
+      return -1;
+    }
+    int k = 0;
+    while ((1 << k) != value.i) {
+      k++;
+    }
+    return k;
+  }
+
+  // `inner op c` with an integral inner operand and integer constant c
+  bool chain(NodeType of) const {
+    return op == of && integral && inner_value.type == INTEGER;
+  }
+};
+
+// What a rule rewrites `lhs op rhs` to: nothing, one of the operand nodes,
+// a constant, or `node op value`
+struct Rewrite {
+  enum Kind { NONE, OPERAND, CONSTANT, BINARY };
+
+  Kind kind = NONE;
+  ASTNode *node = nullptr;
+  NodeType op = NodeType::Unimplemented;
+  m_Value value;
+
+  static Rewrite operand(const Operand &o) {
+    Rewrite r;
+    r.kind = OPERAND;
+    r.node = o.node;
+    return r;
+  }
+
+  static Rewrite constant(int v) {
+    Rewrite r;
+    r.kind = CONSTANT;
+    r.value = m_Value(v);
+    return r;
+  }
+
+  static Rewrite binary(NodeType op, ASTNode *node, int v) {
+    Rewrite r;
+    r.kind = BINARY;
+    r.op = op;
+    r.node = node;
+    r.value = m_Value(v);
+    return r;
+  }
+};
+
+struct SimplifyRule {
+  const char *name;
+  NodeType op;
+  Rewrite (*apply)(const Operand &lhs, const Operand &rhs);
+};
+
+class Simplifier {
+public:
+  Simplifier()
+      : rules(table()), hits(new atomic<unsigned>[rules.size()]) {
+    for (size_t i = 0; i < rules.size(); i++) {
+      hits[i] = 0;
+    }
+  }
+
+  Rewrite simplify(NodeType op, const Operand &lhs, const Operand &rhs) {
+    for (size_t i = 0; i < rules.size(); i++) {
+      if (rules[i].op != op) {
+        continue;
+      }
+      Rewrite rewrite = rules[i].apply(lhs, rhs);
+      if (rewrite.kind != Rewrite::NONE) {
+        hits[i]++;
+        return rewrite;
+      }
+    }
+    return Rewrite();
+  }
+
+  // One line with the rules that applied, over every round and thread
+  void report() const {
+    unsigned total = 0;
+    for (size_t i = 0; i < rules.size(); i++) {
+      total += hits[i].load();
+    }
+    printf("Algebraic simplifications: %u", total);
+    const char *separator = " (";
+    for (size_t i = 0; i < rules.size(); i++) {
+      if (hits[i].load()) {
+        printf("%s%s %u", separator, rules[i].name, hits[i].load());
+        separator = ", ";
+      }
+    }
+    printf("%s\n", total ? ")" : "");
+  }
+
+private:
+  vector<SimplifyRule> rules;
+  unique_ptr<atomic<unsigned>[]> hits;
+
+  // Reassociation and strength reduction need integer operands: neither
+  // holds for doubles, and pointer arithmetic scales by the element size
+  static vector<SimplifyRule> table() {
+    typedef const Operand &O;
+    return {
+        {"add-zero", NodeType::AdditiveExpression,
+         [](O l, O r) {
+           return r.is(0)   ? Rewrite::operand(l)
+                  : l.is(0) ? Rewrite::operand(r)
+                            : Rewrite();
+         }},
+        {"add-chain", NodeType::AdditiveExpression,
+         [](O l, O r) {
+           if (!r.constant()) {
+             return Rewrite();
+           }
+           if (l.chain(NodeType::AdditiveExpression)) {
+             return Rewrite::binary(NodeType::AdditiveExpression, l.inner,
+                                    l.inner_value.i + r.value.i);
+           }
+           if (l.chain(NodeType::SubExpression)) {
+             return Rewrite::binary(NodeType::AdditiveExpression, l.inner,
+                                    r.value.i - l.inner_value.i);
+           }
+           return Rewrite();
+         }},
+        {"sub-zero", NodeType::SubExpression,
+         [](O l, O r) { return r.is(0) ? Rewrite::operand(l) : Rewrite(); }},
+        {"sub-self", NodeType::SubExpression,
+         [](O l, O r) {
+           return l.pure() && l.id == r.id && l.integral ? Rewrite::constant(0)
+                                                         : Rewrite();
+         }},
+        {"sub-chain", NodeType::SubExpression,
+         [](O l, O r) {
+           if (!r.constant()) {
+             return Rewrite();
+           }
+           if (l.chain(NodeType::AdditiveExpression)) {
+             return Rewrite::binary(NodeType::AdditiveExpression, l.inner,
+                                    l.inner_value.i - r.value.i);
+           }
+           if (l.chain(NodeType::SubExpression)) {
+             return Rewrite::binary(NodeType::SubExpression, l.inner,
+                                    l.inner_value.i + r.value.i);
+           }
+           return Rewrite();
+         }},
+        {"mul-one", NodeType::MultiplicativeExpression,
+         [](O l, O r) {
+           return r.is(1)   ? Rewrite::operand(l)
+                  : l.is(1) ? Rewrite::operand(r)
+                            : Rewrite();
+         }},
+        {"mul-pow2-shl", NodeType::MultiplicativeExpression,
+         [](O l, O r) {
+           if (l.integral && r.power_of_two() > 0) {
+             return Rewrite::binary(NodeType::LeftShiftExpression, l.node,
+                                    r.power_of_two());
+           }
+           if (r.integral && l.power_of_two() > 0) {
+             return Rewrite::binary(NodeType::LeftShiftExpression, r.node,
+                                    l.power_of_two());
+           }
+           return Rewrite();
+         }},
+        {"mul-chain", NodeType::MultiplicativeExpression,
+         [](O l, O r) {
+           return r.constant() && l.chain(NodeType::MultiplicativeExpression)
+                      ? Rewrite::binary(NodeType::MultiplicativeExpression,
+                                        l.inner, l.inner_value.i * r.value.i)
+                      : Rewrite();
+         }},
+        {"div-one", NodeType::DivExpression,
+         [](O l, O r) { return r.is(1) ? Rewrite::operand(l) : Rewrite(); }},
+        {"div-pow2-shr", NodeType::DivExpression,
+         [](O l, O r) {
+           return l.integral && l.nonnegative && r.power_of_two() > 0
+                      ? Rewrite::binary(NodeType::RightShiftExpression, l.node,
+                                        r.power_of_two())
+                      : Rewrite();
+         }},
+        {"mod-one", NodeType::ModExpression,
+         [](O l, O r) {
+           return (r.is(1) || r.is(-1)) && l.pure() && l.integral
+                      ? Rewrite::constant(0)
+                      : Rewrite();
+         }},
+        {"mod-pow2-mask", NodeType::ModExpression,
+         [](O l, O r) {
+           return l.integral && l.nonnegative && r.power_of_two() > 0
+                      ? Rewrite::binary(NodeType::AndExpression, l.node,
+                                        r.value.i - 1)
+                      : Rewrite();
+         }},
+        {"shl-zero", NodeType::LeftShiftExpression,
+         [](O l, O r) { return r.is(0) ? Rewrite::operand(l) : Rewrite(); }},
+        {"shl-chain", NodeType::LeftShiftExpression,
+         [](O l, O r) {
+           return r.constant() && l.chain(NodeType::LeftShiftExpression) &&
+                          r.value.i >= 0 && l.inner_value.i >= 0 &&
+                          l.inner_value.i + r.value.i < 32
+                      ? Rewrite::binary(NodeType::LeftShiftExpression, l.inner,
+                                        l.inner_value.i + r.value.i)
+                      : Rewrite();
+         }},
+        {"shr-zero", NodeType::RightShiftExpression,
+         [](O l, O r) { return r.is(0) ? Rewrite::operand(l) : Rewrite(); }},
+        {"shr-chain", NodeType::RightShiftExpression,
+         [](O l, O r) {
+           return r.constant() && l.chain(NodeType::RightShiftExpression) &&
+                          r.value.i >= 0 && l.inner_value.i >= 0 &&
+                          l.inner_value.i + r.value.i < 32
+                      ? Rewrite::binary(NodeType::RightShiftExpression, l.inner,
+                                        l.inner_value.i + r.value.i)
+                      : Rewrite();
+         }},
+        {"and-self", NodeType::AndExpression,
+         [](O l, O r) {
+           return l.pure() && l.id == r.id ? Rewrite::operand(l) : Rewrite();
+         }},
+        {"and-ones", NodeType::AndExpression,
+         [](O l, O r) {
+           return r.is(-1)   ? Rewrite::operand(l)
+                  : l.is(-1) ? Rewrite::operand(r)
+                             : Rewrite();
+         }},
+        {"and-zero", NodeType::AndExpression,
+         [](O l, O r) {
+           return (r.is(0) && l.pure()) || (l.is(0) && r.pure())
+                      ? Rewrite::constant(0)
+                      : Rewrite();
+         }},
+        {"and-chain", NodeType::AndExpression,
+         [](O l, O r) {
+           return r.constant() && l.chain(NodeType::AndExpression)
+                      ? Rewrite::binary(NodeType::AndExpression, l.inner,
+                                        l.inner_value.i & r.value.i)
+                      : Rewrite();
+         }},
+        {"or-self", NodeType::InclusiveOrExpression,
+         [](O l, O r) {
+           return l.pure() && l.id == r.id ? Rewrite::operand(l) : Rewrite();
+         }},
+        {"or-zero", NodeType::InclusiveOrExpression,
+         [](O l, O r) {
+           return r.is(0)   ? Rewrite::operand(l)
+                  : l.is(0) ? Rewrite::operand(r)
+                            : Rewrite();
+         }},
+        {"or-chain", NodeType::InclusiveOrExpression,
+         [](O l, O r) {
+           return r.constant() && l.chain(NodeType::InclusiveOrExpression)
+                      ? Rewrite::binary(NodeType::InclusiveOrExpression,
+                                        l.inner, l.inner_value.i | r.value.i)
+                      : Rewrite();
+         }},
+        {"xor-self", NodeType::ExclusiveOrExpression,
+         [](O l, O r) {
+           return l.pure() && l.id == r.id ? Rewrite::constant(0) : Rewrite();
+         }},
+        {"xor-zero", NodeType::ExclusiveOrExpression,
+         [](O l, O r) {
+           return r.is(0)   ? Rewrite::operand(l)
+                  : l.is(0) ? Rewrite::operand(r)
+                            : Rewrite();
+         }},
+        {"xor-chain", NodeType::ExclusiveOrExpression,
+         [](O l, O r) {
+           return r.constant() && l.chain(NodeType::ExclusiveOrExpression)
+                      ? Rewrite::binary(NodeType::ExclusiveOrExpression,
+                                        l.inner, l.inner_value.i ^ r.value.i)
+                      : Rewrite();
+         }},
+    };
+  }
+};
+
+#endif // INCLUDE_CC_SIMPLIFY_H_
@@ -0,0 +1,62 @@
+#ifndef INCLUDE_CC_STATS_H_
+#define INCLUDE_CC_STATS_H_
+
+#include "AST_enums.hpp"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Counters for --stats, over every round and thread. They only count while
+// `enabled`; cc snapshots them around each phase and writes the report.
+struct CompileStats {
+  static constexpr size_t KINDS = (size_t)NodeType::String + 1;
+
+  bool enabled = false;
+
+  // Nodes constructed, by NodeType
+  atomic<uint64_t> nodes[KINDS];
+
+  // Expressions optimise() replaced by a constant, by their NodeType
+  atomic<uint64_t> folds[KINDS];
+
+  // Lookups in the constant-propagation scopes of the optimiser, and those
+  // that found nothing
+  atomic<uint64_t> value_lookups{0};
+  atomic<uint64_t> value_misses{0};
+
+  void node(NodeType type) {
+    if (enabled) {
+      nodes[(size_t)type].fetch_add(1, memory_order_relaxed);
+    }
+  }
+
+  void fold(NodeType type) {
+    if (enabled) {
+      folds[(size_t)type].fetch_add(1, memory_order_relaxed);
+    }
+  }
+
+  vector<uint64_t> nodeCounts() const {
+    vector<uint64_t> counts(KINDS);
+    for (size_t i = 0; i < KINDS; i++) {
+      counts[i] = nodes[i].load(memory_order_relaxed);
+    }
+    return counts;
+  }
+};
+
+// `{"Kind": count, ...}` of the non-zero counts, by NodeType
+static string stats_by_kind(const vector<uint64_t> &counts) {
+  string json = "{";
+  for (size_t i = 0; i < counts.size(); i++) {
+    if (counts[i]) {
+      json += (json.size() > 1 ? ", \"" : "\"") +
+              nodeTypeToString((NodeType)i) + "\": " + to_string(counts[i]);
+    }
+  }
+  return json + "}";
+}
+
+#endif // INCLUDE_CC_STATS_H_
@@ -0,0 +1,84 @@
+#include <stdio.h>
+
+int loop_carried(int n) {
+  int x = 1;
+  int y = 5;
+  int i;
+  for (i = 0; i < n; i++) {
+    y = x + 4;
+    x = x + 1;
+  }
+  return x * 10 + y;
+}
+
+int constant_in_loop(int n) {
+  int k = 7;
+  int s = 0;
+  int i = 0;
+  while (i < n) {
+    s = s + k;
+    i++;
+  }
+  return s + k;
+}
+
+int goto_back(int n) {
+  int x = 0;
+  int count = 0;
+again:
+  count++;
+  if (x < n) {
+    x = x + 3;
+    goto again;
+  }
+  return x * 100 + count;
+}
+
+int goto_over(int flag) {
+  int v = 1;
+  if (flag) {
+    goto skip;
+  }
+  v = 2;
+skip:
+  return v;
+}
+
+int goto_into_dead(int n) {
+  int v = 10;
+  goto middle;
+  v = 20;
+middle:
+  v = v + n;
+  return v;
+}
+
+int break_continue(int n) {
+  int v = 3;
+  int i;
+  for (i = 0; i < n; i++) {
+    if (i == 2) {
+      continue;
+    }
+    if (i == 4) {
+      v = 9;
+      break;
+    }
+  }
+  return v;
+}
+
+int main() {
+  printf("%d\n", loop_carried(0));
+  printf("%d\n", loop_carried(3));
+  printf("%d\n", constant_in_loop(0));
+  printf("%d\n", constant_in_loop(4));
+  printf("%d\n", goto_back(0));
+  printf("%d\n", goto_back(7));
+  printf("%d\n", goto_over(0));
+  printf("%d\n", goto_over(1));
+  printf("%d\n", goto_into_dead(5));
+  printf("%d\n", break_continue(3));
+  printf("%d\n", break_continue(10));
+  return 0;
+}
@@ -0,0 +1,76 @@
+#include <stdio.h>
+
+int g;
+int calls;
+
+int bump() {
+  calls++;
+  return calls;
+}
+
+int dead_stores(int n) {
+  int x = 1;
+  x = 2;
+  x = n + 3;
+  int unused = n * 9;
+  n + 1;
+  return x;
+}
+
+int read_next_iteration(int n) {
+  int last = 0;
+  int prev = 0;
+  int i;
+  for (i = 0; i < n; i++) {
+    prev = last;
+    last = i * 2;
+  }
+  return prev;
+}
+
+int through_pointer(int n) {
+  int x = 0;
+  int *p = &x;
+  x = n;
+  *p = *p + 1;
+  return x;
+}
+
+int global_store(int n) {
+  g = n;
+  g = g * 2;
+  return 0;
+}
+
+int side_effects(int n) {
+  int unused = bump();
+  bump();
+  int also = 0;
+  also = bump() + n;
+  return n;
+}
+
+int store_before_goto(int n) {
+  int v = 1;
+  if (n > 0) {
+    v = 5;
+    goto out;
+  }
+  v = 7;
+out:
+  return v;
+}
+
+int main() {
+  printf("%d\n", dead_stores(4));
+  printf("%d\n", read_next_iteration(1));
+  printf("%d\n", read_next_iteration(5));
+  printf("%d\n", through_pointer(41));
+  global_store(6);
+  printf("%d\n", g);
+  printf("%d\n", side_effects(3));
+  printf("%d\n", calls);
+  printf("%d\n", store_before_goto(1));
+  printf("%d\n", store_before_goto(0));
+  return 0;
+}
@@ -0,0 +1,63 @@
+#include <stdio.h>
+
+int counter;
+int scale = 3;
+
+int fib(int n) {
+  if (n < 2) {
+    return n;
+  }
+  return fib(n - 1) + fib(n - 2);
+}
+
+int gcd(int a, int b) {
+  while (b != 0) {
+    int t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+int reads_global(int n) { return n * scale; }
+
+int writes_global(int n) {
+  counter = counter + n;
+  return counter;
+}
+
+int through_pointer(int *p) { return *p + 1; }
+
+int long_running(int n) {
+  int s = 0;
+  int i;
+  for (i = 0; i < n; i++) {
+    s = (s + i) % 1000003;
+  }
+  return s;
+}
+
+int divide(int a, int b) {
+  if (b == 0) {
+    return -1;
+  }
+  return a / b;
+}
+
+int main() {
+  int local = 9;
+  printf("%d\n", fib(15));
+  printf("%d\n", gcd(1071, 462));
+  printf("%d\n", divide(7, 0));
+  printf("%d\n", divide(-7, 2));
+  printf("%d\n", reads_global(4));
+  scale = 5;
+  printf("%d\n", reads_global(4));
+  printf("%d\n", writes_global(2));
+  printf("%d\n", writes_global(2));
+  printf("%d\n", through_pointer(&local));
+  local = 20;
+  printf("%d\n", through_pointer(&local));
+  printf("%d\n", long_running(3000000));
+  return 0;
+}
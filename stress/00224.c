@@ -0,0 +1,99 @@
+#include <stdio.h>
+
+int at_limit() {
+  int s = 0;
+  int i;
+  for (i = 0; i < 64; i++) {
+    s = s + i;
+  }
+  return s;
+}
+
+int past_limit() {
+  int s = 0;
+  int i;
+  for (i = 0; i < 65; i++) {
+    s = s + i;
+  }
+  return s;
+}
+
+int inclusive_at_limit() {
+  int s = 0;
+  int i;
+  for (i = 1; i <= 64; i++) {
+    s = s + i * i;
+  }
+  return s;
+}
+
+int two_statements_at_limit() {
+  int s = 0;
+  int t = 0;
+  int i;
+  for (i = 0; i < 32; i++) {
+    s = s + i;
+    t = t ^ i;
+  }
+  return s * 1000 + t;
+}
+
+int two_statements_past_limit() {
+  int s = 0;
+  int t = 0;
+  int i;
+  for (i = 0; i < 33; i++) {
+    s = s + i;
+    t = t ^ i;
+  }
+  return s * 1000 + t;
+}
+
+int counting_down() {
+  int s = 0;
+  int i;
+  for (i = 64; i > 0; i = i - 1) {
+    s = (s * 3 + i) % 10007;
+  }
+  return s;
+}
+
+int stepping_by_two() {
+  int s = 0;
+  int i;
+  for (i = 0; i < 129; i = i + 2) {
+    s = s + i;
+  }
+  return s;
+}
+
+int no_trips() {
+  int s = 5;
+  int i;
+  for (i = 10; i < 10; i++) {
+    s = 0;
+  }
+  return s + i;
+}
+
+int induction_used_after() {
+  int i;
+  int s = 0;
+  for (i = 0; i < 64; i++) {
+    s = s + 1;
+  }
+  return i * 100 + s;
+}
+
+int main() {
+  printf("%d\n", at_limit());
+  printf("%d\n", past_limit());
+  printf("%d\n", inclusive_at_limit());
+  printf("%d\n", two_statements_at_limit());
+  printf("%d\n", two_statements_past_limit());
+  printf("%d\n", counting_down());
+  printf("%d\n", stepping_by_two());
+  printf("%d\n", no_trips());
+  printf("%d\n", induction_used_after());
+  return 0;
+}
@@ -0,0 +1,67 @@
+#include <stdio.h>
+
+int reads;
+
+// Keeps arguments unknown at compile time so the rules see variables
+int opaque(int x) {
+  reads = reads + 1;
+  return x;
+}
+
+int div_pow2(int x) { return x / 4; }
+int mod_pow2(int x) { return x % 8; }
+int div_then_mod(int x) { return (x / 2) * 100 + x % 2; }
+int mul_pow2(int x) { return x * 16; }
+
+int known_negative() {
+  int x = -13;
+  return x / 4 * 100 + x % 4;
+}
+
+int masked_positive(int x) {
+  int y = x & 1023;
+  return y / 8 * 100 + y % 8;
+}
+
+int shl_chain(int x) { return (x << 15) << 15; }
+int shl_chain_31(int x) { return (x << 16) << 15; }
+int shl_chain_32(int x) { return (x << 16) << 16; }
+int shr_chain(int x) { return (x >> 15) >> 15; }
+int shr_chain_31(int x) { return (x >> 16) >> 15; }
+int shr_chain_32(int x) { return (x >> 16) >> 16; }
+int shr_chain_three(int x) { return ((x >> 10) >> 10) >> 11; }
+
+int main() {
+  int p13 = opaque(13);
+  int n13 = opaque(-13);
+  int n4 = opaque(-4);
+  int n3 = opaque(-3);
+  int n8 = opaque(-8);
+  int n1 = opaque(-1);
+  int n7 = opaque(-7);
+  int p7 = opaque(7);
+  int p1 = opaque(1);
+  int p2 = opaque(2);
+  int n5 = opaque(-5);
+  int p77 = opaque(77);
+  int big = opaque(2147483647);
+  int p30 = opaque(1073741824);
+  int n30 = opaque(-1073741824);
+  printf("%d %d %d %d\n", div_pow2(p13), div_pow2(n13), div_pow2(n4),
+         div_pow2(n3));
+  printf("%d %d %d %d\n", mod_pow2(p13), mod_pow2(n13), mod_pow2(n8),
+         mod_pow2(n1));
+  printf("%d %d\n", div_then_mod(n7), div_then_mod(p7));
+  printf("%d %d\n", mul_pow2(n3), mul_pow2(p7));
+  printf("%d\n", known_negative());
+  printf("%d %d\n", masked_positive(n13), masked_positive(p77));
+  printf("%d %d\n", shl_chain(p1), shl_chain(n1));
+  printf("%d %d\n", shl_chain_31(p1), shl_chain_31(p2));
+  printf("%d %d\n", shl_chain_32(p1), shl_chain_32(n1));
+  printf("%d %d\n", shr_chain(p30), shr_chain(n30));
+  printf("%d %d\n", shr_chain_31(n5), shr_chain_31(big));
+  printf("%d %d\n", shr_chain_32(n5), shr_chain_32(big));
+  printf("%d %d\n", shr_chain_three(n1), shr_chain_three(big));
+  printf("%d\n", reads);
+  return 0;
+}
@@ -0,0 +1,51 @@
+#include <stdio.h>
+
+int reads;
+
+int opaque(int x) {
+  reads = reads + 1;
+  return x;
+}
+
+int weighted(int scale, int n, int offset) {
+  int s = 0;
+  int i;
+  for (i = 0; i < n; i++) {
+    if (i % 3 == 0) {
+      s = s + i * scale;
+    } else {
+      s = s - offset;
+    }
+  }
+  return s + offset * scale;
+}
+
+int pick(int mode, int x) {
+  int r = 0;
+  int i;
+  for (i = 0; i < x; i++) {
+    if (mode == 0) {
+      r = r + i;
+    } else if (mode == 1) {
+      r = r * 2 % 1000;
+    } else {
+      r = r - mode;
+    }
+  }
+  return r;
+}
+
+int main() {
+  int n = opaque(10);
+  int m = opaque(7);
+  printf("%d\n", weighted(3, n, 2));
+  printf("%d\n", weighted(3, m, 2));
+  printf("%d\n", weighted(3, n, m));
+  printf("%d\n", weighted(m, 5, 2));
+  printf("%d\n", weighted(n, m, n));
+  printf("%d\n", weighted(3, 5, 2));
+  printf("%d %d %d\n", pick(0, n), pick(1, n), pick(2, n));
+  printf("%d %d\n", pick(m, n), pick(0, 4));
+  printf("%d\n", reads);
+  return 0;
+}
@@ -0,0 +1,48 @@
+#include <stdio.h>
+
+int calls;
+
+int next() {
+  calls = calls + 1;
+  return calls;
+}
+
+int twice(int x) { return x + x; }
+int square(int x) { return x * x; }
+int first_or_second(int x, int y) { return x > 0 ? x : y; }
+int shadow(int x) {
+  int y = x;
+  x = x + 1;
+  return x * 10 + y;
+}
+int nested(int x) { return twice(x) + square(x); }
+
+int main() {
+  int i = 3;
+  int a = twice(i++);
+  printf("%d %d\n", a, i);
+  int b = square(i++);
+  printf("%d %d\n", b, i);
+  int c = square(next());
+  printf("%d %d\n", c, calls);
+  int d = twice(next()) + twice(next());
+  printf("%d %d\n", d, calls);
+  int e = first_or_second(i--, 100);
+  printf("%d %d\n", e, i);
+  int f = shadow(i);
+  printf("%d %d\n", f, i);
+  int g = nested(++i);
+  printf("%d %d\n", g, i);
+  int h = nested(next());
+  printf("%d %d\n", h, calls);
+  int j = 0;
+  int k = square(j = j + 5);
+  printf("%d %d\n", k, j);
+  int v = next();
+  int l = twice(v) + square(v) + shadow(v) + nested(v);
+  printf("%d %d\n", l, v);
+  int w = twice(v++);
+  w = w * 100 + square(v--);
+  printf("%d %d\n", w, v);
+  return 0;
+}
@@ -0,0 +1,19 @@
+#include <stdio.h>
+
+/* Locals whose only use is the operand of sizeof keep their declarations
+   when dead code is removed */
+int main() {
+  int b;
+  double d;
+  int e = 0;
+  int c;
+
+  printf("%d\n", sizeof(b));
+  printf("%d\n", sizeof d);
+  e = 3;
+  printf("%d\n", sizeof((e)));
+  c = sizeof(b) + sizeof(d);
+  printf("%d\n", c);
+  printf("%d\n", sizeof(b + 1));
+  return 0;
+}
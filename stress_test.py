@@ -1,7 +1,14 @@
 import os
+import re
+import struct
 import subprocess
+import sys
 import unittest
 
+# How a program is run: compiled to a.ll and lowered by llc, or by one of
+# cc's execution modes, which print the program's output on stdout
+MODES = ['llvm', 'interp', 'vm', 'tiered', 'baseline']
+
 
 class TestCPrograms(unittest.TestCase):
 
@@ -9,7 +16,11 @@ class TestCPrograms(unittest.TestCase):
         # Ensure that 'make cc' is available in the path
         subprocess.run(['make', 'cc'], check=True)
 
-    def generate_test(self, c_file, expected_output_file):
+    def generate_test(self, c_file, expected_output_file, mode='llvm'):
+        if mode != 'llvm':
+            return self.generate_mode_test(c_file, expected_output_file,
+                                           mode)
+
         # Define the test method
         def dynamic_test_method(self):
             executable_name = "a"
@@ -48,8 +59,174 @@ class TestCPrograms(unittest.TestCase):
 
         return dynamic_test_method
 
+    def generate_mode_test(self, c_file, expected_output_file, mode):
+        def dynamic_test_method(self):
+            process = subprocess.run(['./cc', c_file, '--' + mode],
+                                     capture_output=True, timeout=60)
+
+            with open(expected_output_file, 'r') as expected_file:
+                expected_output = expected_file.read()
+
+            self.assertEqual(process.returncode, 0,
+                             f"Return code for {c_file} --{mode} is not 0: "
+                             f"{process.stderr.decode(errors='replace')}")
+            self.assertEqual(
+                process.stdout.decode(errors='replace').strip(),
+                expected_output.strip(),
+                f"Output for {c_file} --{mode} does not match expected output")
+
+        return dynamic_test_method
+
+
+class TestOptimiserReport(unittest.TestCase):
+    # The fixture of each optimisation must not only print the right output
+    # but make its pass fire: the least count the report cc prints must
+    # reach, by a pattern whose group is the count. Flow constant
+    # propagation and compile-time calls have no line of their own; their
+    # folds are counted by kind in the --stats report.
+    REPORTS = {
+        '00221.c': [(r'"constant_folds": \{[^}]*"Identifier": (\d+)', 5)],
+        '00222.c': [(r'Dead code removed: .* (\d+) unused expressions', 1),
+                    (r'Dead code removed: .* (\d+) dead stores', 4),
+                    (r'Dead code removed: .* (\d+) unused locals', 1)],
+        '00223.c': [(r'"constant_folds": \{[^}]*"FunctionCall": (\d+)', 4)],
+        '00224.c': [(r'Loops unrolled: (\d+)', 5),
+                    (r'Loops unrolled: \d+, (\d+) iterations', 288)],
+        '00225.c': [(r'Algebraic simplifications: (\d+)', 14)],
+        '00226.c': [(r'Interprocedural: .* (\d+) specialised clones', 1)],
+        '00227.c': [(r'Calls inlined: (\d+)', 2)],
+    }
+
+    def setUp(self):
+        subprocess.run(['make', 'cc'], check=True)
+
+    def tearDown(self):
+        for f in ['report_test.ll', 'report_test.stats.json']:
+            if os.path.exists(f):
+                os.remove(f)
+
+    def test_passes_fire_on_their_fixtures(self):
+        for c_file, counts in sorted(self.REPORTS.items()):
+            with self.subTest(c_file):
+                process = subprocess.run(
+                    ['./cc', os.path.join('./stress/', c_file),
+                     '--stats=report_test.stats.json', '-o', 'report_test.ll'],
+                    capture_output=True, timeout=60)
+                self.assertEqual(process.returncode, 0, c_file)
+                with open('report_test.stats.json') as f:
+                    report = process.stdout.decode(errors='replace') + f.read()
+                for pattern, least in counts:
+                    found = re.search(pattern, report)
+                    self.assertIsNotNone(found, f'{c_file}: no {pattern}')
+                    self.assertGreaterEqual(int(found.group(1)), least,
+                                            f'{c_file}: {pattern}')
+
+
+class TestBytecodeImage(unittest.TestCase):
+    # A corrupted .ccbc image must be rejected when it is loaded, with an
+    # error rather than a crash of the VM: by its checksum, and by the
+    # structural checks when the checksum has been recomputed to match
+
+    PROGRAM = """int printf(const char *format, ...);
+int seed;
+int next() {
+  seed = seed + 1;
+  return seed;
+}
+int main() {
+  int a = next();
+  int b = next();
+  printf("%d\\n", a * b + a);
+  return 0;
+}
+"""
+
+    def setUp(self):
+        subprocess.run(['make', 'cc'], check=True)
+        with open('bytecode_test.c', 'w') as f:
+            f.write(self.PROGRAM)
+        subprocess.run(['./cc', 'bytecode_test.c', '--emit-bytecode', '-o',
+                        'bytecode_test.ccbc'], stdout=subprocess.DEVNULL,
+                       check=True)
+        with open('bytecode_test.ccbc', 'rb') as f:
+            self.image = f.read()
+        with open('bytecode.h') as f:
+            opcodes = f.read().split('#define BC_OPCODES(X)')[1]
+        self.opcodes = re.findall(r'X\((\w+)\)',
+                                  opcodes.split('enum BcOp')[0])
+
+    def tearDown(self):
+        for f in ['bytecode_test.c', 'bytecode_test.ccbc', 'corrupt.ccbc']:
+            if os.path.exists(f):
+                os.remove(f)
+
+    # FNV-1a over the 64-bit words of the image, as bc_checksum() computes
+    # it, skipping the checksum itself at offset 120
+    @staticmethod
+    def checksum(image):
+        value = 0xcbf29ce484222325
+        for at in range(0, len(image), 8):
+            if at != 120:
+                value ^= struct.unpack_from('<Q', image, at)[0]
+                value = value * 0x100000001b3 & 0xffffffffffffffff
+        return value
+
+    # Sets operand `field` (a, b or c) of the first `op` in the code, and
+    # updates the checksum to match unless `keep_checksum`
+    def corrupt(self, op, field, value, keep_checksum=False):
+        code_offset, code_count = struct.unpack_from('<QQ', self.image, 56)
+        image = bytearray(self.image)
+        for i in range(code_count):
+            insn = code_offset + 8 * i
+            if struct.unpack_from('<H', image, insn)[0] == \
+                    self.opcodes.index(op):
+                struct.pack_into('<H', image, insn + 2 * ' abc'.index(field),
+                                 value)
+                break
+        else:
+            self.fail(f'No {op} in the image')
+        if not keep_checksum:
+            struct.pack_into('<Q', image, 120, self.checksum(image))
+        with open('corrupt.ccbc', 'wb') as f:
+            f.write(image)
+        return subprocess.run(['./cc', 'corrupt.ccbc', '--run-bytecode'],
+                              capture_output=True, timeout=30)
+
+    def test_valid_image_runs(self):
+        with open('corrupt.ccbc', 'wb') as f:
+            f.write(self.image)
+        result = subprocess.run(['./cc', 'corrupt.ccbc', '--run-bytecode'],
+                                capture_output=True, timeout=30)
+        self.assertEqual(result.returncode, 0)
+        self.assertEqual(result.stdout.decode().strip(), '3')
+
+    def test_bad_register_operands_are_rejected(self):
+        for op, field in [('LD32', 'b'), ('MULW', 'c'), ('MOV', 'b'),
+                          ('ST32', 'a'), ('ADDW', 'a')]:
+            result = self.corrupt(op, field, 0x7001)
+            self.assertEqual(result.returncode, 1, f'{op} {field}')
+            self.assertIn(b'Bad register in bytecode image', result.stderr,
+                          f'{op} {field}')
+
+    def test_corrupted_offsets_are_rejected(self):
+        # The displacement of a load or store is not a register, only the
+        # checksum can tell it was changed
+        for op in ['LD32', 'ST32']:
+            result = self.corrupt(op, 'c', 0x7001, keep_checksum=True)
+            self.assertEqual(result.returncode, 1, op)
+            self.assertIn(b'Bytecode image is corrupted', result.stderr, op)
+
 
 if __name__ == '__main__':
+    # python3 stress_test.py [mode ...]: the llvm path by default, "all"
+    # for every mode
+    modes = sys.argv[1:] or ['llvm']
+    if modes == ['all']:
+        modes = MODES
+    for mode in modes:
+        if mode not in MODES:
+            sys.exit(f"Unknown mode {mode}, expected one of {MODES} or all")
+
     # Get all .c files in the stress directory
     c_files = [
         filename for filename in os.listdir('./stress/')
@@ -59,12 +236,14 @@ if __name__ == '__main__':
     skip_if_has = [
         'struct', 'union', 'enum', '#define', "#if", "typedef", "sizeof"
     ]
+    # Fixtures that use one of those on purpose, and are run anyway
+    always_run = ['00228.c']
     for file in c_files:
         with open(os.path.join('./stress/', file), 'r') as f:
             content = f.read()
 
             for s in skip_if_has:
-                if s in content:
+                if s in content and file not in always_run:
                     print(f"Skipping {file} because of {s}")
                     break
             else:
@@ -93,6 +272,17 @@ if __name__ == '__main__':
 
     c_files = [file for file in c_files if file not in to_skip]
 
+    # Programs the execution modes get wrong on top of those: the front end
+    # miscompiles the first ones on every path, and the interpreter cannot
+    # goto into a nested block
+    front_end = [185, 186, 193, 197, 207, 213, 220]
+    mode_skip = {
+        'interp': front_end + [199],
+        'vm': front_end,
+        'tiered': front_end,
+        'baseline': front_end,
+    }
+
     c_files = sorted(c_files)
     # random.shuffle(c_files)
     print(c_files)
@@ -104,20 +294,35 @@ if __name__ == '__main__':
     test_case = TestCPrograms()
 
     subprocess.run(['make', 'clean'], check=True)
-    # Dynamically generate a test method for each .c file
-    for c_file in c_files:
-        expected_output_file = os.path.join('./stress/', c_file + '.expected')
-        c_inp_file = os.path.join('./stress/', c_file)
-        test_name = 'test_' + c_file[:-2]  # Remove the '.c' extension
+    # Dynamically generate a test method for each .c file in each mode
+    for mode in modes:
+        skipped = [("000000" + str(i))[-5:] + ".c"
+                   for i in mode_skip.get(mode, [])]
+        for c_file in c_files:
+            if c_file in skipped:
+                continue
+            expected_output_file = os.path.join('./stress/',
+                                                c_file + '.expected')
+            c_inp_file = os.path.join('./stress/', c_file)
+            # Remove the '.c' extension
+            test_name = 'test_' + c_file[:-2]
+            if mode != 'llvm':
+                test_name += '_' + mode
+
+            # Generate the test method
+            test_method = test_case.generate_test(c_inp_file,
+                                                  expected_output_file, mode)
 
-        # Generate the test method
-        test_method = test_case.generate_test(c_inp_file, expected_output_file)
+            # Add the test method to the TestCPrograms class
+            setattr(TestCPrograms, test_name, test_method)
 
-        # Add the test method to the TestCPrograms class
-        setattr(TestCPrograms, test_name, test_method)
+            # Add the test method to the TestSuite
+            suite.addTest(TestCPrograms(test_name))
 
-        # Add the test method to the TestSuite
-        suite.addTest(TestCPrograms(test_name))
+    suite.addTest(unittest.defaultTestLoader.loadTestsFromTestCase(
+        TestOptimiserReport))
+    suite.addTest(unittest.defaultTestLoader.loadTestsFromTestCase(
+        TestBytecodeImage))
 
     # Run the test suite
     unittest.TextTestRunner(failfast=True).run(suite)
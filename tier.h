@@ -0,0 +1,281 @@
+#ifndef INCLUDE_CC_TIER_H_
+#define INCLUDE_CC_TIER_H_
+
+#include "backend.h"
+#include "bytecode.h"
+#include "vm.h"
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Passes/PassBuilder.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+using namespace std;
+
+// Tiered execution (--tiered). The program starts on the bytecode VM at
+// once; functions the VM reports as hot are compiled to native code with
+// LLVM's ORC JIT on a background thread and published back to the VM, so
+// their next calls run natively.
+//
+// The LLVM module is only generated once something gets hot, so short
+// runs never pay for it. Every compile reads the module back from bitcode
+// into its own context and keeps the bodies of the hot function and of the
+// functions it reaches that are not native yet. Global variables are bound
+// to the VM's globals block, so both tiers share them.
+class TierCompiler {
+public:
+  // `lower` generates the LLVM module of the whole program; it runs on the
+  // compile thread
+  TierCompiler(BytecodeVM &vm, const BytecodeCompiler &compiler,
+               std::function<llvm::Module &()> lower)
+      : vm(vm), functions(compiler.functionList()),
+        global_offsets(compiler.globalOffsets()), lower(std::move(lower)) {}
+
+  ~TierCompiler() { stop(); }
+
+  // Called by the VM, on its own thread
+  void hot(uint32_t function) {
+    {
+      lock_guard<mutex> guard(lock);
+      if (stopping) {
+        return;
+      }
+      queue.push_back(function);
+    }
+    if (!worker.joinable()) {
+      worker = thread([this]() { work(); });
+    }
+    wake.notify_one();
+  }
+
+  // Waits for a compile in progress; queued ones are dropped
+  void stop() {
+    {
+      lock_guard<mutex> guard(lock);
+      stopping = true;
+    }
+    wake.notify_one();
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+
+private:
+  BytecodeVM &vm;
+  const vector<BcFunction> &functions;
+  map<string, uint32_t> global_offsets;
+  std::function<llvm::Module &()> lower;
+
+  mutex lock;
+  condition_variable wake;
+  deque<uint32_t> queue;
+  bool stopping = false;
+  thread worker;
+
+  // Compile thread only
+  bool prepared = false;
+  bool broken = false;
+  llvm::SmallString<0> bitcode;
+  unique_ptr<llvm::orc::LLJIT> jit;
+  set<string> native;
+
+  void work() {
+    for (;;) {
+      uint32_t function;
+      {
+        unique_lock<mutex> guard(lock);
+        wake.wait(guard, [this]() { return stopping || !queue.empty(); });
+        if (stopping) {
+          return;
+        }
+        function = queue.front();
+        queue.pop_front();
+      }
+
+      // The global initialisers are not a function of the module
+      if (broken || !functions[function].type ||
+          native.count(functions[function].name)) {
+        continue;
+      }
+      try {
+        if (!prepared) {
+          prepared = true;
+          prepare();
+        }
+        compile(function);
+      } catch (const std::exception &e) {
+        // The function stays on the VM; a module that cannot be generated
+        // disables the tier altogether
+        fprintf(stderr, "tier: %s: %s\n", functions[function].name.c_str(),
+                e.what());
+        broken = !jit;
+      }
+    }
+  }
+
+  void prepare() {
+    llvm::Module &module = lower();
+    drop_code_after_terminators(module);
+    string errors;
+    llvm::raw_string_ostream errors_out(errors);
+    if (llvm::verifyModule(module, &errors_out)) {
+      throw std::runtime_error("Generated module is invalid: " +
+                               errors_out.str());
+    }
+    llvm::raw_svector_ostream bitcode_out(bitcode);
+    llvm::WriteBitcodeToFile(module, bitcode_out);
+
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+    auto created = llvm::orc::LLJITBuilder().create();
+    if (!created) {
+      throw std::runtime_error("Cannot create the JIT: " +
+                               llvm::toString(created.takeError()));
+    }
+    unique_ptr<llvm::orc::LLJIT> created_jit = std::move(*created);
+
+    llvm::orc::JITDylib &dylib = created_jit->getMainJITDylib();
+    dylib.addGenerator(llvm::cantFail(
+        llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+            created_jit->getDataLayout().getGlobalPrefix())));
+
+    llvm::orc::SymbolMap globals;
+    for (auto &global : global_offsets) {
+      globals[created_jit->mangleAndIntern(global.first)] =
+          llvm::JITEvaluatedSymbol(
+              llvm::pointerToJITTargetAddress(vm.globalsBase() +
+                                              global.second),
+              llvm::JITSymbolFlags::Exported);
+    }
+    if (llvm::Error error =
+            dylib.define(llvm::orc::absoluteSymbols(std::move(globals)))) {
+      throw std::runtime_error("Cannot bind globals: " +
+                               llvm::toString(std::move(error)));
+    }
+    jit = std::move(created_jit);
+  }
+
+  void compile(uint32_t function) {
+    auto start = std::chrono::steady_clock::now();
+    const string &name = functions[function].name;
+
+    auto context = make_unique<llvm::LLVMContext>();
+    llvm::Expected<unique_ptr<llvm::Module>> parsed = llvm::parseBitcodeFile(
+        llvm::MemoryBufferRef(bitcode.str(), "tier"), *context);
+    if (!parsed) {
+      throw std::runtime_error("Cannot reload the module: " +
+                               llvm::toString(parsed.takeError()));
+    }
+    unique_ptr<llvm::Module> module = std::move(*parsed);
+
+    llvm::Function *hot_function = module->getFunction(name);
+    if (!hot_function || hot_function->isDeclaration()) {
+      throw std::runtime_error("Not in the generated module");
+    }
+
+    // The hot function and everything it calls that is not native yet
+    set<llvm::Function *> keep;
+    vector<llvm::Function *> pending = {hot_function};
+    while (!pending.empty()) {
+      llvm::Function *f = pending.back();
+      pending.pop_back();
+      if (f->isDeclaration() || native.count(f->getName().str()) ||
+          !keep.insert(f).second) {
+        continue;
+      }
+      for (auto &block : *f) {
+        for (auto &instruction : block) {
+          if (auto *call = llvm::dyn_cast<llvm::CallInst>(&instruction)) {
+            if (llvm::Function *callee = call->getCalledFunction()) {
+              pending.push_back(callee);
+            }
+          }
+        }
+      }
+    }
+
+    for (auto &f : *module) {
+      if (!f.isDeclaration() && !keep.count(&f)) {
+        f.deleteBody();
+      }
+    }
+    for (auto &global : module->globals()) {
+      if (global_offsets.count(global.getName().str())) {
+        global.setInitializer(nullptr);
+        global.setLinkage(llvm::GlobalValue::ExternalLinkage);
+      } else {
+        // String literals; every compile has its own copies
+        global.setLinkage(llvm::GlobalValue::PrivateLinkage);
+      }
+    }
+
+    module->setDataLayout(jit->getDataLayout());
+    module->setTargetTriple(jit->getTargetTriple().str());
+    optimise(*module);
+
+    vector<string> names;
+    for (llvm::Function *f : keep) {
+      names.push_back(f->getName().str());
+    }
+    if (llvm::Error error = jit->addIRModule(llvm::orc::ThreadSafeModule(
+            std::move(module), std::move(context)))) {
+      throw std::runtime_error(llvm::toString(std::move(error)));
+    }
+
+    for (const string &compiled : names) {
+      llvm::Expected<llvm::JITEvaluatedSymbol> symbol = jit->lookup(compiled);
+      if (!symbol) {
+        throw std::runtime_error(llvm::toString(symbol.takeError()));
+      }
+      native.insert(compiled);
+      publish(compiled, (void *)symbol->getAddress());
+    }
+
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    fprintf(stderr, "tier: %s is native (%zu function%s, %.3f ms)\n",
+            name.c_str(), names.size(), names.size() == 1 ? "" : "s",
+            elapsed.count());
+  }
+
+  void publish(const string &name, void *address) {
+    for (size_t i = 0; i < functions.size(); i++) {
+      if (functions[i].name != name) {
+        continue;
+      }
+      llvm::FunctionType *type = functions[i].type;
+      string kinds(1, (char)bc_kind(type->getReturnType()));
+      for (llvm::Type *param : type->params()) {
+        kinds += (char)bc_kind(param);
+      }
+      vm.publish(i, address, kinds);
+      return;
+    }
+  }
+
+  static void optimise(llvm::Module &module) {
+    llvm::LoopAnalysisManager loops;
+    llvm::FunctionAnalysisManager functions;
+    llvm::CGSCCAnalysisManager cgscc;
+    llvm::ModuleAnalysisManager modules;
+    llvm::PassBuilder builder;
+    builder.registerModuleAnalyses(modules);
+    builder.registerCGSCCAnalyses(cgscc);
+    builder.registerFunctionAnalyses(functions);
+    builder.registerLoopAnalyses(loops);
+    builder.crossRegisterProxies(loops, functions, cgscc, modules);
+    builder.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O2)
+        .run(module, modules);
+  }
+};
+
+#endif // INCLUDE_CC_TIER_H_
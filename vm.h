@@ -0,0 +1,586 @@
+#ifndef INCLUDE_CC_VM_H_
+#define INCLUDE_CC_VM_H_
+
+#include "bytecode.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <dlfcn.h>
+#include <ffi.h>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+using namespace std;
+
+union BcSlot {
+  int64_t i;
+  double f;
+  char *p;
+};
+
+// Runs a bytecode image. Each call gets a window of the register file
+// starting at its first argument, so arguments are never copied, and a
+// block of frame memory for arrays and variables whose address is taken.
+// Dispatch jumps from handler to handler through a table of label
+// addresses (GCC's computed goto) instead of returning to a switch.
+class BytecodeVM {
+public:
+  explicit BytecodeVM(const BcImage &image)
+      : image(image), register_capacity(1 << 20), stack_size(64 << 20) {
+    const BcHeader &header = image.header();
+    globals = make_unique<char[]>(header.globals_size ? header.globals_size
+                                                      : 1);
+    // Not make_unique: registers and frames are written before they are read
+    registers.reset(new BcSlot[register_capacity]);
+    stack.reset(new char[stack_size]);
+
+    natives.resize(header.import_count);
+    for (uint32_t i = 0; i < header.import_count; i++) {
+      const BcImportEntry &import = image.imports()[i];
+      natives[i].name = image.string(import.name);
+      prepareNative(natives[i], image.string(import.kinds), import.arg_count,
+                    import.fixed_count, import.variadic);
+    }
+
+    heat.resize(header.function_count);
+    compiled.reset(new std::atomic<Native *>[header.function_count]);
+    for (uint32_t i = 0; i < header.function_count; i++) {
+      compiled[i].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  // Runs the global initialisers, then main; returns main's result
+  int64_t run() {
+    if (on_hot) {
+      execute<true>(image.header().init_function);
+      return execute<true>(image.header().main_function);
+    }
+    execute<false>(image.header().init_function);
+    return execute<false>(image.header().main_function);
+  }
+
+  char *globalsBase() const { return globals.get(); }
+
+  // Tiered execution: calls and backward jumps are counted per function,
+  // and `hot` is told once a function reaches `threshold` of them
+  void countHeat(uint32_t threshold, std::function<void(uint32_t)> hot) {
+    hot_threshold = threshold ? threshold : 1;
+    on_hot = std::move(hot);
+  }
+
+  // From then on calls of `function` go to native code at `address`, whose
+  // signature is given as value kinds (return kind, then the arguments).
+  // May be called from another thread while the program runs; a call that
+  // is already executing finishes in the VM.
+  void publish(uint32_t function, void *address, const string &kinds) {
+    auto native = make_unique<Native>();
+    native->name = image.string(image.functions()[function].name);
+    native->function = address;
+    prepareNative(*native, kinds.c_str(), kinds.size() - 1, kinds.size() - 1,
+                  false);
+    compiled[function].store(native.get(), std::memory_order_release);
+    published.push_back(std::move(native));
+  }
+
+private:
+  struct Native {
+    const char *name;
+    string kinds; // return kind, then one per argument
+    uint16_t arg_count;
+    void *function = nullptr;
+    ffi_cif cif;
+    vector<ffi_type *> types;
+    vector<void *> values;
+  };
+
+  struct Frame {
+    const BcInsn *ip;
+    BcSlot *regs;
+    char *fp;
+    uint32_t *heat;
+    uint16_t dest;
+  };
+
+  const BcImage &image;
+  size_t register_capacity;
+  size_t stack_size;
+  unique_ptr<char[]> globals;
+  unique_ptr<BcSlot[]> registers;
+  unique_ptr<char[]> stack;
+  vector<Native> natives;
+
+  vector<uint32_t> heat;
+  uint32_t hot_threshold = 0;
+  std::function<void(uint32_t)> on_hot;
+  unique_ptr<std::atomic<Native *>[]> compiled;
+  vector<unique_ptr<Native>> published;
+
+  static ffi_type *ffiType(uint8_t kind) {
+    switch (kind) {
+    case BK_VOID:
+      return &ffi_type_void;
+    case BK_I1:
+    case BK_I8:
+      return &ffi_type_sint8;
+    case BK_I16:
+      return &ffi_type_sint16;
+    case BK_I32:
+      return &ffi_type_sint32;
+    case BK_I64:
+      return &ffi_type_sint64;
+    case BK_PTR:
+      return &ffi_type_pointer;
+    case BK_F64:
+      return &ffi_type_double;
+    }
+    throw std::runtime_error("Bad value kind in bytecode image");
+  }
+
+  void prepareNative(Native &native, const char *kinds, uint16_t arg_count,
+                     uint16_t fixed_count, bool variadic) {
+    native.kinds.assign(kinds, arg_count + 1);
+    native.arg_count = arg_count;
+    for (uint16_t i = 0; i < arg_count; i++) {
+      native.types.push_back(ffiType(native.kinds[i + 1]));
+    }
+    native.values.resize(arg_count);
+
+    ffi_type *ret_type = ffiType(native.kinds[0]);
+    ffi_status status =
+        variadic ? ffi_prep_cif_var(&native.cif, FFI_DEFAULT_ABI, fixed_count,
+                                    arg_count, ret_type, native.types.data())
+                 : ffi_prep_cif(&native.cif, FFI_DEFAULT_ABI, arg_count,
+                                ret_type, native.types.data());
+    if (status != FFI_OK) {
+      throw std::runtime_error("Cannot call " + string(native.name) +
+                               " through libffi");
+    }
+  }
+
+  // Natives are looked up in the host process on first use, as in the
+  // interpreter
+  void callNative(Native &native, BcSlot *args, BcSlot &result) {
+    if (!native.function) {
+      native.function = dlsym(RTLD_DEFAULT, native.name);
+      if (!native.function) {
+        throw std::runtime_error("Function " + string(native.name) +
+                                 " is not defined.");
+      }
+    }
+
+    // Little-endian: the low bytes of a slot hold narrower integers
+    for (uint16_t i = 0; i < native.arg_count; i++) {
+      native.values[i] = &args[i].i;
+    }
+
+    union {
+      ffi_arg i;
+      double f;
+      void *p;
+    } ret;
+    ffi_call(&native.cif, FFI_FN(native.function), &ret,
+             native.values.data());
+
+    switch ((uint8_t)native.kinds[0]) {
+    case BK_I1:
+      result.i = ret.i & 1;
+      break;
+    case BK_I8:
+      result.i = (int8_t)ret.i;
+      break;
+    case BK_I16:
+      result.i = (int16_t)ret.i;
+      break;
+    case BK_I32:
+      result.i = (int32_t)ret.i;
+      break;
+    case BK_I64:
+      result.i = (int64_t)ret.i;
+      break;
+    case BK_PTR:
+      result.p = (char *)ret.p;
+      break;
+    case BK_F64:
+      result.f = ret.f;
+      break;
+    default:
+      result.i = 0;
+    }
+  }
+
+  static size_t frameBytes(const BcFunctionEntry &function) {
+    return (function.frame_size + 15) & ~size_t(15);
+  }
+
+  // `tiered` compiles the heat counting and native switch-over in; plain
+  // --vm runs without them
+  template <bool tiered> int64_t execute(uint32_t entry) {
+    static void *const dispatch[] = {
+#define BC_LABEL(name) &&op_##name,
+        BC_OPCODES(BC_LABEL)
+#undef BC_LABEL
+    };
+
+    const BcInsn *code = image.code();
+    const BcFunctionEntry *functions = image.functions();
+    const int64_t *constants = image.constants();
+    char *data = image.data();
+    char *globals_base = globals.get();
+    BcSlot *regs_end = registers.get() + register_capacity;
+    char *stack_end = stack.get() + stack_size;
+
+    vector<Frame> frames;
+    BcSlot *r = registers.get();
+    char *fp = stack.get();
+    char *sp = fp + frameBytes(functions[entry]);
+    const BcInsn *ip = code + functions[entry].code_start;
+    const BcInsn *insn;
+    BcSlot result;
+    uint32_t *heat_here = tiered ? &heat[entry] : nullptr;
+
+    if (functions[entry].register_count > register_capacity ||
+        sp > stack_end) {
+      throw std::runtime_error("VM stack overflow");
+    }
+
+#define NEXT()                                                                 \
+  do {                                                                         \
+    insn = ip++;                                                               \
+    goto *dispatch[insn->op];                                                  \
+  } while (0)
+#define RA r[insn->a]
+#define RB r[insn->b]
+#define RC r[insn->c]
+#define IMM insn->imm()
+#define SIMM16 ((int64_t)(int16_t)insn->c)
+#define BACK_EDGE(offset)                                                      \
+  if (tiered && (offset) < 0 && ++*heat_here == hot_threshold) {               \
+    on_hot(heat_here - heat.data());                                           \
+  }
+
+    NEXT();
+
+  op_MOV:
+    RA = RB;
+    NEXT();
+  op_LOADI:
+    RA.i = IMM;
+    NEXT();
+  op_LOADK:
+    RA.i = constants[IMM];
+    NEXT();
+  op_GADDR:
+    RA.p = globals_base + IMM;
+    NEXT();
+  op_DADDR:
+    RA.p = data + IMM;
+    NEXT();
+  op_FADDR:
+    RA.p = fp + IMM;
+    NEXT();
+  op_ZERO:
+    memset(RA.p, 0, (uint32_t)IMM);
+    NEXT();
+
+  op_ADD:
+    RA.i = (int64_t)((uint64_t)RB.i + (uint64_t)RC.i);
+    NEXT();
+  op_SUB:
+    RA.i = (int64_t)((uint64_t)RB.i - (uint64_t)RC.i);
+    NEXT();
+  op_MUL:
+    RA.i = (int64_t)((uint64_t)RB.i * (uint64_t)RC.i);
+    NEXT();
+  op_DIV:
+    if (RC.i == 0) {
+      throw std::runtime_error("Division by zero");
+    }
+    RA.i = RC.i == -1 ? (int64_t)(0 - (uint64_t)RB.i) : RB.i / RC.i;
+    NEXT();
+  op_MOD:
+    if (RC.i == 0) {
+      throw std::runtime_error("Division by zero");
+    }
+    RA.i = RC.i == -1 ? 0 : RB.i % RC.i;
+    NEXT();
+  op_ADDW:
+    RA.i = (int32_t)((uint32_t)RB.i + (uint32_t)RC.i);
+    NEXT();
+  op_SUBW:
+    RA.i = (int32_t)((uint32_t)RB.i - (uint32_t)RC.i);
+    NEXT();
+  op_MULW:
+    RA.i = (int32_t)((uint32_t)RB.i * (uint32_t)RC.i);
+    NEXT();
+  op_ADDI:
+    RA.i = (int64_t)((uint64_t)RB.i + (uint64_t)SIMM16);
+    NEXT();
+  op_ADDIW:
+    RA.i = (int32_t)((uint32_t)RB.i + (uint32_t)SIMM16);
+    NEXT();
+  op_MULI:
+    RA.i = (int64_t)((uint64_t)RB.i * (uint64_t)SIMM16);
+    NEXT();
+  op_AND:
+    RA.i = RB.i & RC.i;
+    NEXT();
+  op_OR:
+    RA.i = RB.i | RC.i;
+    NEXT();
+  op_XOR:
+    RA.i = RB.i ^ RC.i;
+    NEXT();
+  op_SHL:
+    RA.i = (int64_t)((uint64_t)RB.i << (RC.i & 63));
+    NEXT();
+  op_SHR:
+    RA.i = RB.i >> (RC.i & 63);
+    NEXT();
+  op_NOT:
+    RA.i = ~RB.i;
+    NEXT();
+
+  op_SEXT8:
+    RA.i = (int8_t)RB.i;
+    NEXT();
+  op_SEXT16:
+    RA.i = (int16_t)RB.i;
+    NEXT();
+  op_SEXT32:
+    RA.i = (int32_t)RB.i;
+    NEXT();
+  op_ZEXT8:
+    RA.i = (uint8_t)RB.i;
+    NEXT();
+  op_ZEXT16:
+    RA.i = (uint16_t)RB.i;
+    NEXT();
+  op_ZEXT32:
+    RA.i = (uint32_t)RB.i;
+    NEXT();
+  op_TRUNC1:
+    RA.i = RB.i & 1;
+    NEXT();
+
+  op_EQ:
+    RA.i = RB.i == RC.i;
+    NEXT();
+  op_NE:
+    RA.i = RB.i != RC.i;
+    NEXT();
+  op_LT:
+    RA.i = RB.i < RC.i;
+    NEXT();
+  op_GT:
+    RA.i = RB.i > RC.i;
+    NEXT();
+  op_LE:
+    RA.i = RB.i <= RC.i;
+    NEXT();
+  op_GE:
+    RA.i = RB.i >= RC.i;
+    NEXT();
+  op_LTU:
+    RA.i = (uint64_t)RB.i < (uint64_t)RC.i;
+    NEXT();
+  op_GTU:
+    RA.i = (uint64_t)RB.i > (uint64_t)RC.i;
+    NEXT();
+  op_LEU:
+    RA.i = (uint64_t)RB.i <= (uint64_t)RC.i;
+    NEXT();
+  op_GEU:
+    RA.i = (uint64_t)RB.i >= (uint64_t)RC.i;
+    NEXT();
+  op_EQZ:
+    RA.i = RB.i == 0;
+    NEXT();
+  op_NEZ:
+    RA.i = RB.i != 0;
+    NEXT();
+
+  op_FADD:
+    RA.f = RB.f + RC.f;
+    NEXT();
+  op_FSUB:
+    RA.f = RB.f - RC.f;
+    NEXT();
+  op_FMUL:
+    RA.f = RB.f * RC.f;
+    NEXT();
+  op_FDIV:
+    RA.f = RB.f / RC.f;
+    NEXT();
+  op_FEQ:
+    RA.i = RB.f == RC.f;
+    NEXT();
+  op_FNE:
+    RA.i = RB.f < RC.f || RB.f > RC.f;
+    NEXT();
+  op_FLT:
+    RA.i = RB.f < RC.f;
+    NEXT();
+  op_FGT:
+    RA.i = RB.f > RC.f;
+    NEXT();
+  op_FLE:
+    RA.i = RB.f <= RC.f;
+    NEXT();
+  op_FGE:
+    RA.i = RB.f >= RC.f;
+    NEXT();
+  op_FNEZ:
+    RA.i = RB.f != 0;
+    NEXT();
+  op_I2F:
+    RA.f = (double)RB.i;
+    NEXT();
+  op_F2I:
+    RA.i = (int64_t)RB.f;
+    NEXT();
+
+  op_LD1:
+    RA.i = *(uint8_t *)(RB.p + insn->c) & 1;
+    NEXT();
+  op_LD8:
+    RA.i = *(int8_t *)(RB.p + insn->c);
+    NEXT();
+  op_LD16: {
+    int16_t v;
+    memcpy(&v, RB.p + insn->c, sizeof(v));
+    RA.i = v;
+    NEXT();
+  }
+  op_LD32: {
+    int32_t v;
+    memcpy(&v, RB.p + insn->c, sizeof(v));
+    RA.i = v;
+    NEXT();
+  }
+  op_LD64:
+    memcpy(&RA, RB.p + insn->c, sizeof(BcSlot));
+    NEXT();
+  op_ST8:
+    *(int8_t *)(RB.p + insn->c) = (int8_t)RA.i;
+    NEXT();
+  op_ST16: {
+    int16_t v = (int16_t)RA.i;
+    memcpy(RB.p + insn->c, &v, sizeof(v));
+    NEXT();
+  }
+  op_ST32: {
+    int32_t v = (int32_t)RA.i;
+    memcpy(RB.p + insn->c, &v, sizeof(v));
+    NEXT();
+  }
+  op_ST64:
+    memcpy(RB.p + insn->c, &RA, sizeof(BcSlot));
+    NEXT();
+
+  op_JMP:
+    BACK_EDGE(IMM)
+    ip = insn + IMM;
+    NEXT();
+  op_JZ:
+    if (RA.i == 0) {
+      BACK_EDGE(IMM)
+      ip = insn + IMM;
+    }
+    NEXT();
+  op_JNZ:
+    if (RA.i != 0) {
+      BACK_EDGE(IMM)
+      ip = insn + IMM;
+    }
+    NEXT();
+
+    // ip points at the extension word holding the offset
+#define FUSED_BRANCH(cond)                                                     \
+  if (cond) {                                                                  \
+    BACK_EDGE(ip->imm())                                                       \
+    ip = insn + ip->imm();                                                     \
+  } else {                                                                     \
+    ip++;                                                                      \
+  }                                                                            \
+  NEXT();
+  op_JEQ:
+    FUSED_BRANCH(RA.i == RB.i)
+  op_JNE:
+    FUSED_BRANCH(RA.i != RB.i)
+  op_JLT:
+    FUSED_BRANCH(RA.i < RB.i)
+  op_JGT:
+    FUSED_BRANCH(RA.i > RB.i)
+  op_JLE:
+    FUSED_BRANCH(RA.i <= RB.i)
+  op_JGE:
+    FUSED_BRANCH(RA.i >= RB.i)
+#undef FUSED_BRANCH
+
+  op_CALL: {
+    if (tiered) {
+      Native *native = compiled[insn->c].load(std::memory_order_acquire);
+      if (native) {
+        callNative(*native, r + insn->b, RA);
+        NEXT();
+      }
+      if (++heat[insn->c] == hot_threshold) {
+        on_hot(insn->c);
+      }
+    }
+    const BcFunctionEntry &function = functions[insn->c];
+    BcSlot *window = r + insn->b;
+    size_t frame = frameBytes(function);
+    if (window + function.register_count > regs_end ||
+        frame > (size_t)(stack_end - sp)) {
+      throw std::runtime_error("VM stack overflow");
+    }
+    frames.push_back({ip, r, fp, heat_here, insn->a});
+    if (tiered) {
+      heat_here = &heat[insn->c];
+    }
+    r = window;
+    fp = sp;
+    sp += frame;
+    ip = code + function.code_start;
+    NEXT();
+  }
+  op_CALLN:
+    callNative(natives[insn->c], r + insn->b, RA);
+    NEXT();
+  op_RET:
+    result = RA;
+    goto do_return;
+  op_RETZ:
+    result.i = 0;
+    goto do_return;
+  do_return: {
+    if (frames.empty()) {
+      return result.i;
+    }
+    const Frame &frame = frames.back();
+    sp = fp;
+    fp = frame.fp;
+    r = frame.regs;
+    ip = frame.ip;
+    heat_here = frame.heat;
+    r[frame.dest] = result;
+    frames.pop_back();
+    NEXT();
+  }
+  op_TRAP:
+    throw std::runtime_error(image.string(IMM));
+
+#undef NEXT
+#undef RA
+#undef RB
+#undef RC
+#undef IMM
+#undef SIMM16
+#undef BACK_EDGE
+  }
+};
+
+#endif // INCLUDE_CC_VM_H_
@@ -0,0 +1,118 @@
+#ifndef INCLUDE_CC_WORKPOOL_H_
+#define INCLUDE_CC_WORKPOOL_H_
+
+#include "llvm/Support/TimeProfiler.h"
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// Shortest event kept in a time trace, in microseconds
+static const unsigned time_trace_granularity = 10;
+
+// Work-stealing pool for independent tasks. Tasks are dealt round-robin
+// into one deque per worker; a worker runs its own newest task and, once
+// its deque is empty, steals the oldest task of a sibling. With a single
+// thread every task runs inline, in submission order.
+//
+// Workers record into the time trace (-ftime-trace) when the thread that
+// waits for them does.
+class WorkPool {
+public:
+  explicit WorkPool(unsigned threads) : queues(threads ? threads : 1) {}
+
+  ~WorkPool() { wait(); }
+
+  void submit(function<void()> task) {
+    if (queues.size() == 1) {
+      task();
+      return;
+    }
+    queues[next_queue].tasks.push_back(std::move(task));
+    next_queue = (next_queue + 1) % queues.size();
+  }
+
+  // Runs everything submitted so far and rethrows the first failure.
+  void wait() {
+    if (queues.size() > 1) {
+      vector<thread> workers;
+      bool traced = llvm::timeTraceProfilerEnabled();
+      for (size_t i = 0; i < queues.size(); i++) {
+        workers.emplace_back([this, i, traced]() {
+          if (traced) {
+            llvm::timeTraceProfilerInitialize(time_trace_granularity, "cc");
+          }
+          work(i);
+          if (traced) {
+            llvm::timeTraceProfilerFinishThread();
+          }
+        });
+      }
+      for (auto &worker : workers) {
+        worker.join();
+      }
+    }
+
+    if (failure) {
+      exception_ptr rethrow = failure;
+      failure = nullptr;
+      rethrow_exception(rethrow);
+    }
+  }
+
+private:
+  struct Queue {
+    mutex lock;
+    deque<function<void()>> tasks;
+  };
+
+  vector<Queue> queues;
+  size_t next_queue = 0;
+
+  mutex failure_lock;
+  exception_ptr failure;
+
+  bool take(size_t i, bool steal, function<void()> &task) {
+    lock_guard<mutex> guard(queues[i].lock);
+    if (queues[i].tasks.empty()) {
+      return false;
+    }
+    if (steal) {
+      task = std::move(queues[i].tasks.front());
+      queues[i].tasks.pop_front();
+    } else {
+      task = std::move(queues[i].tasks.back());
+      queues[i].tasks.pop_back();
+    }
+    return true;
+  }
+
+  void work(size_t self) {
+    function<void()> task;
+    while (true) {
+      bool found = take(self, false, task);
+      for (size_t i = 1; !found && i < queues.size(); i++) {
+        found = take((self + i) % queues.size(), true, task);
+      }
+      // Tasks never submit more tasks, so empty deques mean we are done
+      if (!found) {
+        return;
+      }
+
+      try {
+        task();
+      } catch (...) {
+        lock_guard<mutex> guard(failure_lock);
+        if (!failure) {
+          failure = current_exception();
+        }
+      }
+    }
+  }
+};
+
+#endif // INCLUDE_CC_WORKPOOL_H_